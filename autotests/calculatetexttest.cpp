@@ -23,6 +23,7 @@ private Q_SLOTS:
     void cleanupTestCase();
 
     void testSimpleCalculate();
+    void testDependentCalculate();
 
 private:
     Okular::Document *m_document;
@@ -112,5 +113,55 @@ void CalculateTextTest::testSimpleCalculate()
     QCOMPARE(fields[QStringLiteral("Sum")]->text(), QStringLiteral("40"));
 }
 
+void CalculateTextTest::testDependentCalculate()
+{
+    // Start from a fresh document rather than from what testSimpleCalculate() left
+    m_document->closeDocument();
+    const QString testFile = QStringLiteral(KDESRCDIR "data/dependentCalculate.pdf");
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile(testFile);
+    QCOMPARE(m_document->openDocument(testFile, QUrl(), mime), Okular::Document::OpenSuccess);
+
+    const Okular::Page *page = m_document->page(0);
+
+    // Field names in test document are:
+    // a, b, fromA (calculated as a), runs (reads b, adds one to itself each time it is calculated)
+    QMap<QString, Okular::FormFieldText *> fields;
+    const QList<Okular::FormField *> pageFormFields = page->formFields();
+    for (Okular::FormField *ff : pageFormFields) {
+        fields.insert(ff->name(), static_cast<Okular::FormFieldText *>(ff));
+    }
+
+    Okular::FormFieldText *a = fields[QStringLiteral("a")];
+    Okular::FormFieldText *b = fields[QStringLiteral("b")];
+    Okular::FormFieldText *fromA = fields[QStringLiteral("fromA")];
+    Okular::FormFieldText *runs = fields[QStringLiteral("runs")];
+    QVERIFY(a);
+    QVERIFY(b);
+    QVERIFY(fromA);
+    QVERIFY(runs);
+    QCOMPARE(runs->text(), QStringLiteral("0"));
+
+    // None of the calculate actions ran yet, so the first commit runs all of them
+    a->setText(QStringLiteral("5"));
+    m_document->processKVCFActions(a);
+    QCOMPARE(fromA->text(), QStringLiteral("5"));
+    QCOMPARE(runs->text(), QStringLiteral("1"));
+
+    // runs does not read a, committing a again must not run its calculate action
+    a->setText(QStringLiteral("7"));
+    m_document->processKVCFActions(a);
+    QCOMPARE(fromA->text(), QStringLiteral("7"));
+    QCOMPARE(runs->text(), QStringLiteral("1"));
+
+    // but committing b does, and leaves fromA alone
+    b->setText(QStringLiteral("3"));
+    m_document->processKVCFActions(b);
+    QCOMPARE(runs->text(), QStringLiteral("2"));
+    QCOMPARE(fromA->text(), QStringLiteral("7"));
+
+    m_document->closeDocument();
+}
+
 QTEST_MAIN(CalculateTextTest)
 #include "calculatetexttest.moc"
@@ -8,6 +8,7 @@
 */
 
 #include <QMimeDatabase>
+#include <QSignalSpy>
 #include <QTemporaryFile>
 #include <QTest>
 
@@ -29,6 +30,7 @@ class DocumentTest : public QObject
 private Q_SLOTS:
     void testCloseDuringRotationJob();
     void testDocdataMigration();
+    void testOpenDocumentAsync();
     void testEvaluateKeystrokeEventChange_data();
     void testEvaluateKeystrokeEventChange();
 };
@@ -130,6 +132,81 @@ void DocumentTest::testDocdataMigration()
     delete m_document;
 }
 
+// Test that an asynchronous opening shows the pages before restoring the
+// annotations from docdata, and that stopping it does not lose them
+void DocumentTest::testOpenDocumentAsync()
+{
+    Okular::SettingsCore::instance(QStringLiteral("documenttest"));
+
+    const QUrl testFileUrl = QUrl::fromLocalFile(QStringLiteral(KDESRCDIR "data/file1.pdf"));
+    const QString testFilePath = testFileUrl.toLocalFile();
+    const qint64 testFileSize = QFileInfo(testFilePath).size();
+
+    const QString docDataPath = Okular::DocumentPrivate::docDataFileName(testFileUrl, testFileSize);
+    QFile::remove(docDataPath);
+    QVERIFY(QFile::copy(QStringLiteral(KDESRCDIR "data/file1-docdata.xml"), docDataPath));
+
+    Okular::Document *m_document = new Okular::Document(nullptr);
+    QSignalSpy openedSpy(m_document, &Okular::Document::documentOpened);
+    QSignalSpy finishedSpy(m_document, &Okular::Document::openFinished);
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile(testFilePath);
+
+    // Nothing happens before the event loop runs
+    m_document->openDocumentAsync(testFilePath, testFileUrl, mime);
+    QVERIFY(m_document->isOpening());
+    QVERIFY(!m_document->isOpened());
+    QCOMPARE(openedSpy.count(), 0);
+
+    QVERIFY(finishedSpy.wait());
+    QCOMPARE(openedSpy.count(), 1);
+    QCOMPARE(openedSpy.at(0).at(0).value<Okular::Document::OpenResult>(), Okular::Document::OpenSuccess);
+    QVERIFY(!m_document->isOpening());
+    QVERIFY(m_document->pages() > 0);
+    QCOMPARE(m_document->page(0)->annotations().size(), 1);
+    QVERIFY(m_document->isDocdataMigrationNeeded());
+    m_document->closeDocument();
+
+    // Closing right after the pages are set up keeps the annotations of docdata
+    openedSpy.clear();
+    m_document->openDocumentAsync(testFilePath, testFileUrl, mime);
+    QVERIFY(openedSpy.wait());
+    m_document->closeDocument();
+
+    // Closing while loading doesn't emit anything
+    openedSpy.clear();
+    m_document->openDocumentAsync(testFilePath, testFileUrl, mime);
+    m_document->closeDocument();
+    QVERIFY(!m_document->isOpening());
+    QTest::qWait(10);
+    QCOMPARE(openedSpy.count(), 0);
+
+    // Opening again while the stopped load still runs starts once it ended
+    m_document->openDocumentAsync(testFilePath, testFileUrl, mime);
+    m_document->closeDocument();
+    m_document->openDocumentAsync(testFilePath, testFileUrl, mime);
+    QVERIFY(openedSpy.wait());
+    QCOMPARE(openedSpy.count(), 1);
+    QCOMPARE(openedSpy.at(0).at(0).value<Okular::Document::OpenResult>(), Okular::Document::OpenSuccess);
+    QTRY_VERIFY(!m_document->isOpening());
+    QCOMPARE(m_document->page(0)->annotations().size(), 1);
+    m_document->closeDocument();
+
+    QCOMPARE(m_document->openDocument(testFilePath, testFileUrl, mime), Okular::Document::OpenSuccess);
+    QCOMPARE(m_document->page(0)->annotations().size(), 1);
+    m_document->closeDocument();
+
+    // A file that can't be opened is reported too
+    openedSpy.clear();
+    m_document->openDocumentAsync(QStringLiteral(KDESRCDIR "data/nonexistent.pdf"), QUrl::fromLocalFile(QStringLiteral(KDESRCDIR "data/nonexistent.pdf")), mime);
+    QVERIFY(openedSpy.wait());
+    QCOMPARE(openedSpy.at(0).at(0).value<Okular::Document::OpenResult>(), Okular::Document::OpenError);
+    QVERIFY(!m_document->isOpened());
+
+    delete m_document;
+    QFile::remove(docDataPath);
+}
+
 void DocumentTest::testEvaluateKeystrokeEventChange_data()
 {
     QTest::addColumn<QString>("oldVal");
@@ -36,6 +36,7 @@ private Q_SLOTS:
     void testPercentFormat_data();
     void testDateFormat();
     void testDateFormat_data();
+    void benchmarkNumberTyping();
 
 private:
     Okular::Document *m_document;
@@ -294,6 +295,30 @@ void FormatTest::testDateFormat_data()
     QTest::newRow("d/m/yyyy HH:MM with datetime including seconds") << QStringLiteral("data24") << QStringLiteral("13/10/1966 13:13:13") << QStringLiteral("13/10/1966 13:13");
 }
 
+void FormatTest::benchmarkNumberTyping()
+{
+    // The scripts run for each character typed in a number field
+    Okular::FormField *ff = m_fields[QStringLiteral("number1")];
+    Okular::FormFieldText *fft = static_cast<Okular::FormFieldText *>(ff);
+    const Okular::Action *keystrokeAction = ff->additionalAction(Okular::FormField::FieldModified);
+    const Okular::Action *formatAction = ff->additionalAction(Okular::FormField::FormatField);
+    QVERIFY(formatAction);
+
+    const QString typed = QStringLiteral("1234.20");
+    QBENCHMARK {
+        for (int i = 1; i <= typed.size(); ++i) {
+            const QString text = typed.left(i);
+            if (keystrokeAction) {
+                m_document->processKeystrokeAction(keystrokeAction, ff, text, i - 1, i - 1);
+            }
+            fft->setText(text);
+            m_document->processFormatAction(formatAction, ff);
+        }
+    }
+
+    QCOMPARE(m_formattedText, QStringLiteral("€ 1,234.20"));
+}
+
 void FormatTest::cleanupTestCase()
 {
     m_document->closeDocument();
@@ -275,6 +275,7 @@ void MainShellTest::testShell()
         Okular::Part *part = s->findChild<Okular::Part *>();
         QVERIFY(part);
         QCOMPARE(part->url().url(), QStringLiteral("file://%1").arg(paths[0]));
+        QTRY_VERIFY(!partDocument(part)->isOpening());
         QCOMPARE(partDocument(part)->currentPage(), expectedPage);
         // Testing if the bar is shown or hidden as expected
         QCOMPARE(findWidget(part)->isHidden(), externalProcessExpectFind.isEmpty());
@@ -291,7 +292,9 @@ void MainShellTest::testShell()
             Okular::Part *part2 = dynamic_cast<Okular::Part *>(s->m_tabs[1].part);
             QCOMPARE(part->url().url(), QStringLiteral("file://%1").arg(paths[0]));
             QCOMPARE(part2->url().url(), QStringLiteral("file://%1").arg(paths[1]));
+            QTRY_VERIFY(!partDocument(part)->isOpening());
             QCOMPARE(partDocument(part)->currentPage(), expectedPage);
+            QTRY_VERIFY(!partDocument(part2)->isOpening());
             QCOMPARE(partDocument(part2)->currentPage(), expectedPage);
         } else {
             QSet<QString> openUrls;
@@ -300,6 +303,7 @@ void MainShellTest::testShell()
             QCOMPARE(s->m_tabs.count(), 1);
             Okular::Part *part = s->findChild<Okular::Part *>();
             QVERIFY(part);
+            QTRY_VERIFY(!partDocument(part)->isOpening());
             QCOMPARE(partDocument(part)->currentPage(), expectedPage);
             openUrls << part->url().url();
 
@@ -308,6 +312,7 @@ void MainShellTest::testShell()
             QCOMPARE(s2->m_tabs.count(), 1);
             Okular::Part *part2 = s2->findChild<Okular::Part *>();
             QVERIFY(part2);
+            QTRY_VERIFY(!partDocument(part2)->isOpening());
             QCOMPARE(partDocument(part2)->currentPage(), expectedPage);
             openUrls << part2->url().url();
 
@@ -349,12 +354,14 @@ void MainShellTest::testShell()
                 // It is unique so part got "overwritten"
                 QCOMPARE(s->m_tabs.count(), 1);
                 QCOMPARE(part->url().url(), QStringLiteral("file://%1").arg(externalProcessPath));
+                QTRY_VERIFY(!partDocument(part)->isOpening());
                 QCOMPARE(partDocument(part)->currentPage(), externalProcessExpectedPage);
             } else {
                 // It is attaching to us so a second tab is there
                 QCOMPARE(s->m_tabs.count(), 2);
                 Okular::Part *part2 = dynamic_cast<Okular::Part *>(s->m_tabs[1].part);
                 QCOMPARE(part2->url().url(), QStringLiteral("file://%1").arg(externalProcessPath));
+                QTRY_VERIFY(!partDocument(part2)->isOpening());
                 QCOMPARE(partDocument(part2)->currentPage(), externalProcessExpectedPage);
             }
         } else {
@@ -440,6 +447,7 @@ void MainShellTest::testFileRemembersPagePosition()
     Okular::Part *part = s->findChild<Okular::Part *>();
     QVERIFY(part);
     QCOMPARE(part->url().url(), QStringLiteral("file://%1").arg(paths[0]));
+    QTRY_VERIFY(!partDocument(part)->isOpening());
     QCOMPARE(partDocument(part)->currentPage(), 0u);
     partDocument(part)->setViewportPage(3);
     QCOMPARE(partDocument(part)->currentPage(), 3u);
@@ -471,6 +479,7 @@ void MainShellTest::testFileRemembersPagePosition()
     part = s->findChild<Okular::Part *>();
     QVERIFY(part);
     QCOMPARE(part->url().url(), QStringLiteral("file://%1").arg(paths[0]));
+    QTRY_VERIFY(!partDocument(part)->isOpening());
     QCOMPARE(partDocument(part)->currentPage(), 3u);
 }
 
@@ -0,0 +1,178 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QImage>
+#include <QPainter>
+#include <QPixmap>
+#include <QTest>
+
+#include "../core/annotations.h"
+#include "../core/observer.h"
+#include "../core/page.h"
+#include "../gui/pagepainter.h"
+#include "../settings.h"
+
+class PagePainterTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testScaledPixmap();
+    void testCroppedScaledPixmap();
+    void testAnnotationOverlay();
+    void benchmarkContinuousZoom_data();
+    void benchmarkContinuousZoom();
+
+private:
+    void paint(QImage *target, int scaledWidth, int scaledHeight, const QRect limits, const Okular::NormalizedRect &crop);
+
+    Okular::DocumentObserver m_observer;
+    Okular::Page *m_page = nullptr;
+};
+
+// The page pixmap: the left half red, the right half blue
+static const int pixmapWidth = 600;
+static const int pixmapHeight = 800;
+
+void PagePainterTest::initTestCase()
+{
+    Okular::Settings::instance(QStringLiteral("pagepaintertest"));
+}
+
+void PagePainterTest::init()
+{
+    QPixmap *pixmap = new QPixmap(pixmapWidth, pixmapHeight);
+    pixmap->fill(Qt::red);
+    QPainter p(pixmap);
+    p.fillRect(pixmapWidth / 2, 0, pixmapWidth / 2, pixmapHeight, Qt::blue);
+    p.end();
+
+    m_page = new Okular::Page(0, pixmapWidth, pixmapHeight, Okular::Rotation0);
+    m_page->setPixmap(&m_observer, pixmap);
+}
+
+void PagePainterTest::cleanup()
+{
+    delete m_page;
+    m_page = nullptr;
+}
+
+void PagePainterTest::paint(QImage *target, int scaledWidth, int scaledHeight, const QRect limits, const Okular::NormalizedRect &crop)
+{
+    QPainter p(target);
+    PagePainter::paintCroppedPageOnPainter(&p, m_page, &m_observer, 0, scaledWidth, scaledHeight, limits, crop, nullptr);
+}
+
+void PagePainterTest::testScaledPixmap()
+{
+    // Twice the size of the pixmap, painting the area around the middle of the page
+    const QRect limits(500, 700, 200, 200);
+    QImage target(limits.size(), QImage::Format_ARGB32_Premultiplied);
+    target.fill(Qt::white);
+
+    QPainter p(&target);
+    p.translate(-limits.topLeft());
+    PagePainter::paintPageOnPainter(&p, m_page, &m_observer, 0, pixmapWidth * 2, pixmapHeight * 2, limits);
+    p.end();
+
+    QCOMPARE(target.pixelColor(10, 100), QColor(Qt::red));
+    QCOMPARE(target.pixelColor(90, 100), QColor(Qt::red));
+    QCOMPARE(target.pixelColor(110, 100), QColor(Qt::blue));
+    QCOMPARE(target.pixelColor(190, 100), QColor(Qt::blue));
+}
+
+void PagePainterTest::testCroppedScaledPixmap()
+{
+    // Only the right half of the page, scaled down
+    const Okular::NormalizedRect crop(0.5, 0, 1, 1);
+    const QRect limits(0, 0, 150, 400);
+    QImage target(limits.size(), QImage::Format_ARGB32_Premultiplied);
+    target.fill(Qt::white);
+
+    paint(&target, pixmapWidth / 2, pixmapHeight / 2, limits, crop);
+
+    QCOMPARE(target.pixelColor(0, 0), QColor(Qt::blue));
+    QCOMPARE(target.pixelColor(149, 399), QColor(Qt::blue));
+}
+
+/**
+ * A highlight of @p color over the normalized rect @p rect.
+ */
+static Okular::HighlightAnnotation *highlight(const QColor &color, const Okular::NormalizedRect &rect)
+{
+    Okular::HighlightAnnotation *annotation = new Okular::HighlightAnnotation();
+    annotation->style().setColor(color);
+    annotation->setBoundingRectangle(rect);
+    Okular::HighlightAnnotation::Quad quad;
+    quad.setPoint(Okular::NormalizedPoint(rect.left, rect.top), 0);
+    quad.setPoint(Okular::NormalizedPoint(rect.right, rect.top), 1);
+    quad.setPoint(Okular::NormalizedPoint(rect.right, rect.bottom), 2);
+    quad.setPoint(Okular::NormalizedPoint(rect.left, rect.bottom), 3);
+    annotation->highlightQuads().append(quad);
+    return annotation;
+}
+
+void PagePainterTest::testAnnotationOverlay()
+{
+    const QRect limits(0, 0, pixmapWidth, pixmapHeight);
+    QImage target(limits.size(), QImage::Format_ARGB32_Premultiplied);
+    const auto paintAnnotations = [this, &target, limits] {
+        target.fill(Qt::white);
+        QPainter p(&target);
+        PagePainter::paintPageOnPainter(&p, m_page, &m_observer, PagePainter::Annotations, pixmapWidth, pixmapHeight, limits);
+    };
+
+    // Yellow multiplied with blue is black, red is left alone
+    m_page->addAnnotation(highlight(Qt::yellow, Okular::NormalizedRect(0.5, 0, 1, 0.5)));
+    paintAnnotations();
+    QCOMPARE(target.pixelColor(450, 200), QColor(Qt::black));
+    QCOMPARE(target.pixelColor(450, 600), QColor(Qt::blue));
+    QCOMPARE(target.pixelColor(150, 200), QColor(Qt::red));
+
+    // Painting again uses the overlay of the page
+    paintAnnotations();
+    QCOMPARE(target.pixelColor(450, 200), QColor(Qt::black));
+    QCOMPARE(target.pixelColor(150, 200), QColor(Qt::red));
+
+    // Adding an annotation makes the overlay be drawn again
+    m_page->addAnnotation(highlight(Qt::cyan, Okular::NormalizedRect(0, 0, 0.5, 0.5)));
+    paintAnnotations();
+    QCOMPARE(target.pixelColor(450, 200), QColor(Qt::black));
+    QCOMPARE(target.pixelColor(150, 200), QColor(Qt::black));
+    QCOMPARE(target.pixelColor(150, 600), QColor(Qt::red));
+}
+
+void PagePainterTest::benchmarkContinuousZoom_data()
+{
+    QTest::addColumn<double>("zoom");
+
+    QTest::newRow("1x") << 1.0;
+    QTest::newRow("2x") << 2.0;
+    QTest::newRow("4x") << 4.0;
+    QTest::newRow("8x") << 8.0;
+}
+
+void PagePainterTest::benchmarkContinuousZoom()
+{
+    QFETCH(double, zoom);
+
+    // While zooming the view keeps painting the same viewport with the pixmap of the previous zoom level
+    const QRect limits(0, 0, 800, 600);
+    QImage target(limits.size(), QImage::Format_ARGB32_Premultiplied);
+
+    QBENCHMARK {
+        for (int step = 0; step < 10; ++step) {
+            const double stepZoom = zoom * (1 + step / 100.0);
+            paint(&target, pixmapWidth * stepZoom, pixmapHeight * stepZoom, limits, Okular::NormalizedRect(0, 0, 1, 1));
+        }
+    }
+}
+
+QTEST_MAIN(PagePainterTest)
+#include "pagepaintertest.moc"
@@ -0,0 +1,87 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QCheckBox>
+#include <QDir>
+#include <QMimeDatabase>
+#include <QPrinter>
+#include <QTemporaryFile>
+#include <QTest>
+
+#include <poppler-qt6.h>
+
+#include "../core/annotations.h"
+#include "../core/document.h"
+#include "../settings_core.h"
+
+class RasterPrintTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testPrintUnsavedAnnotation();
+};
+
+void RasterPrintTest::initTestCase()
+{
+    Okular::SettingsCore::instance(QStringLiteral("rasterprinttest"));
+}
+
+// An annotation added in memory but not saved to the file gets printed
+void RasterPrintTest::testPrintUnsavedAnnotation()
+{
+    Okular::Document document(nullptr);
+    const QString testFile = QStringLiteral(KDESRCDIR "data/file1.pdf");
+    QMimeDatabase db;
+    QCOMPARE(document.openDocument(testFile, QUrl::fromLocalFile(testFile), db.mimeTypeForFile(testFile)), Okular::Document::OpenSuccess);
+
+    // A red square over the whole page
+    Okular::GeomAnnotation *annotation = new Okular::GeomAnnotation();
+    annotation->setGeometricalType(Okular::GeomAnnotation::InscribedSquare);
+    annotation->setGeometricalInnerColor(Qt::red);
+    annotation->style().setColor(Qt::red);
+    annotation->setBoundingRectangle(Okular::NormalizedRect(0, 0, 1, 1));
+    document.addPageAnnotation(0, annotation);
+
+    // Force the rasterization through the print options
+    QWidget *options = document.printConfigurationWidget();
+    QVERIFY(options);
+    bool forcedRaster = false;
+    const QList<QCheckBox *> checkBoxes = options->findChildren<QCheckBox *>();
+    for (QCheckBox *checkBox : checkBoxes) {
+        if (checkBox->text().contains(QLatin1String("rasterization"))) {
+            checkBox->setChecked(true);
+            forcedRaster = true;
+        }
+    }
+    QVERIFY(forcedRaster);
+
+    QTemporaryFile output(QDir::tempPath() + QStringLiteral("/rasterprinttestXXXXXX.pdf"));
+    QVERIFY(output.open());
+    output.close();
+
+    QPrinter printer(QPrinter::HighResolution);
+    printer.setOutputFormat(QPrinter::PdfFormat);
+    printer.setOutputFileName(output.fileName());
+    printer.setPrintRange(QPrinter::PageRange);
+    printer.setFromTo(1, 1);
+    QCOMPARE(document.print(printer), Okular::Document::NoPrintError);
+    document.closeDocument();
+
+    std::unique_ptr<Poppler::Document> printed = Poppler::Document::load(output.fileName());
+    QVERIFY(printed);
+    QCOMPARE(printed->numPages(), 1);
+    const QImage image = printed->page(0)->renderToImage(36, 36);
+    QVERIFY(!image.isNull());
+
+    // The page is scaled to the printable area from the top left corner, its middle is printed well inside the paper
+    const QColor color = image.pixelColor(image.width() * 0.4, image.height() * 0.4);
+    QVERIFY2(color.red() > 200 && color.green() < 80 && color.blue() < 80, qPrintable(color.name()));
+}
+
+QTEST_MAIN(RasterPrintTest)
+#include "rasterprinttest.moc"
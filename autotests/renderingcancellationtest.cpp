@@ -0,0 +1,96 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QElapsedTimer>
+#include <QMimeDatabase>
+#include <QTest>
+
+#include "../core/document.h"
+#include "../core/generator.h"
+#include "../core/observer.h"
+#include "../core/page.h"
+#include "../settings_core.h"
+
+class RenderingCancellationTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testCancelledRender();
+    void testTimeToFirstPixel();
+};
+
+static const int pageWidth = 1200;
+static const int pageHeight = 1600;
+
+static const QString testFile = QStringLiteral(KDESRCDIR "data/simple-multipage.pdf");
+
+void RenderingCancellationTest::initTestCase()
+{
+    Okular::SettingsCore::instance(QStringLiteral("renderingcancellationtest"));
+}
+
+// Asks for a big pixmap of a page and right away for another page only, which
+// cancels the first render: it must stop without giving its page a pixmap and
+// let the other page be rendered.
+void RenderingCancellationTest::testCancelledRender()
+{
+    Okular::DocumentObserver observer;
+    Okular::Document document(nullptr);
+    document.addObserver(&observer);
+
+    QMimeDatabase db;
+    QCOMPARE(document.openDocument(testFile, QUrl(), db.mimeTypeForFile(testFile)), Okular::Document::OpenSuccess);
+    QVERIFY(document.pages() > 1);
+
+    auto bigRequest = new Okular::PixmapRequest(&observer, 0, pageWidth * 3, pageHeight * 3, 1, 1, Okular::PixmapRequest::Asynchronous);
+    document.requestPixmaps({bigRequest}, Okular::Document::RemoveAllPrevious);
+    QCOMPARE(document.memoryStatistics().executingRequests, 1);
+
+    auto request = new Okular::PixmapRequest(&observer, 1, pageWidth, pageHeight, 1, 1, Okular::PixmapRequest::Asynchronous);
+    document.requestPixmaps({request}, Okular::Document::RemoveAllPrevious);
+
+    QTRY_VERIFY_WITH_TIMEOUT(document.page(1)->hasPixmap(&observer, pageWidth, pageHeight), 5000);
+    QVERIFY(!document.page(0)->hasPixmap(&observer));
+    QCOMPARE(document.memoryStatistics().abortedPixmaps, 1);
+    QCOMPARE(document.memoryStatistics().renderedPixmaps, 1);
+
+    document.closeDocument();
+    document.removeObserver(&observer);
+}
+
+// Scrolls quickly through the document, each frame asking for the page in view
+// only, and measures how long the page the scrolling stopped at takes to arrive.
+// The renders of the pages scrolled past are cancelled, so they don't hold it up.
+void RenderingCancellationTest::testTimeToFirstPixel()
+{
+    Okular::DocumentObserver observer;
+    Okular::Document document(nullptr);
+    document.addObserver(&observer);
+
+    QMimeDatabase db;
+    QCOMPARE(document.openDocument(testFile, QUrl(), db.mimeTypeForFile(testFile)), Okular::Document::OpenSuccess);
+    const int lastPage = qMin<int>(20, document.pages() - 1);
+    QVERIFY(lastPage > 1);
+
+    for (int page = 0; page <= lastPage; ++page) {
+        auto request = new Okular::PixmapRequest(&observer, page, pageWidth, pageHeight, 1, 1, Okular::PixmapRequest::Asynchronous);
+        document.requestPixmaps({request}, Okular::Document::RemoveAllPrevious);
+        QTest::qWait(5);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QTRY_VERIFY_WITH_TIMEOUT(document.page(lastPage)->hasPixmap(&observer, pageWidth, pageHeight), 10000);
+    QTest::setBenchmarkResult(timer.elapsed(), QTest::WalltimeMilliseconds);
+
+    document.closeDocument();
+    document.removeObserver(&observer);
+}
+
+QTEST_MAIN(RenderingCancellationTest)
+#include "renderingcancellationtest.moc"
@@ -0,0 +1,118 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include <QRandomGenerator>
+#include <QTest>
+
+#include "../core/area.h"
+#include "../core/page.h"
+#include "../core/textpage.h"
+
+class TextOrderTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testColumnOrder_data();
+    void testColumnOrder();
+    void benchmarkCorrectTextOrder_data();
+    void benchmarkCorrectTextOrder();
+};
+
+static const double pageWidth = 612;
+static const double pageHeight = 792;
+
+/**
+ * A page of text in @p columns columns, given character by character from the
+ * bottom to the top as generators may do. The characters of column n are the
+ * letter 'a' + n, so that the reading order can be checked.
+ */
+static Okular::TextEntity::List multiColumnPage(int columns, int lines)
+{
+    // Deterministic, so that all the runs lay out the same page
+    QRandomGenerator random(columns * 1000 + lines);
+
+    const double margin = 0.06;
+    const double gutter = 0.06;
+    const double columnWidth = (1 - 2 * margin - (columns - 1) * gutter) / columns;
+    const double charWidth = 6 / pageWidth;
+    const double charHeight = 9 / pageHeight;
+    const double lineHeight = (1 - 2 * margin) / lines;
+
+    Okular::TextEntity::List characters;
+    for (int line = lines - 1; line >= 0; --line) {
+        const double top = margin + line * lineHeight;
+        for (int column = 0; column < columns; ++column) {
+            const QString letter = QChar(QLatin1Char('a' + column));
+            const double columnLeft = margin + column * (columnWidth + gutter);
+            double left = columnLeft;
+            // words of random length, so that the spaces are not aligned from a line to the next
+            while (true) {
+                const int wordLength = random.bounded(2, 9);
+                if (left + wordLength * charWidth > columnLeft + columnWidth) {
+                    break;
+                }
+                for (int i = 0; i < wordLength; ++i) {
+                    characters.append(Okular::TextEntity(letter, Okular::NormalizedRect(left, top, left + charWidth, top + charHeight)));
+                    left += charWidth;
+                }
+                left += charWidth;
+            }
+        }
+    }
+    return characters;
+}
+
+void TextOrderTest::testColumnOrder_data()
+{
+    QTest::addColumn<int>("columns");
+
+    QTest::newRow("one column") << 1;
+    QTest::newRow("two columns") << 2;
+    QTest::newRow("three columns") << 3;
+}
+
+void TextOrderTest::testColumnOrder()
+{
+    QFETCH(int, columns);
+
+    Okular::Page page(0, pageWidth, pageHeight, Okular::Rotation0);
+    page.setTextPage(new Okular::TextPage(multiColumnPage(columns, 50)));
+
+    // Each column is read whole before the next one
+    const QString text = page.text(nullptr);
+    QVERIFY(!text.isEmpty());
+    for (int column = 1; column < columns; ++column) {
+        QVERIFY(text.lastIndexOf(QLatin1Char('a' + column - 1)) < text.indexOf(QLatin1Char('a' + column)));
+    }
+}
+
+void TextOrderTest::benchmarkCorrectTextOrder_data()
+{
+    QTest::addColumn<int>("columns");
+    QTest::addColumn<int>("lines");
+
+    QTest::newRow("one column") << 1 << 50;
+    QTest::newRow("two columns") << 2 << 70;
+    QTest::newRow("three columns, dense") << 3 << 100;
+}
+
+void TextOrderTest::benchmarkCorrectTextOrder()
+{
+    QFETCH(int, columns);
+    QFETCH(int, lines);
+
+    const Okular::TextEntity::List characters = multiColumnPage(columns, lines);
+    Okular::Page page(0, pageWidth, pageHeight, Okular::Rotation0);
+
+    // setTextPage() reconstructs the reading order
+    QBENCHMARK {
+        page.setTextPage(new Okular::TextPage(characters));
+    }
+}
+
+QTEST_GUILESS_MAIN(TextOrderTest)
+#include "textordertest.moc"
@@ -15,6 +15,7 @@
 #include <algorithm>
 #include <limits.h>
 #include <memory>
+#include <utility>
 #ifdef Q_OS_WIN
 #include <qt_windows.h>
 #elif defined(Q_OS_FREEBSD)
@@ -43,6 +44,7 @@
 #include <QStandardPaths>
 #include <QTemporaryFile>
 #include <QTextStream>
+#include <QThread>
 #include <QTimer>
 #include <QUndoCommand>
 #include <QWindow>
@@ -88,8 +90,10 @@
 #include "sourcereference.h"
 #include "sourcereference_p.h"
 #include "texteditors_p.h"
+#include "textexporter_p.h"
 #include "tile.h"
 #include "tilesmanager_p.h"
+#include "tracing_p.h"
 #include "utils.h"
 #include "utils_p.h"
 #include "view.h"
@@ -165,6 +169,13 @@ constexpr int kMemCheckTime = 2000; // in msec
 // getFreeMemory is called every two seconds when checking to see if the system is low on memory. If this timeout was left at kMemCheckTime, half of these checks are useless (when okular is idle) since the cache is used when the cache is
 // <=2 seconds old. This means that after the system is out of memory, up to 4 seconds (instead of 2) could go by before okular starts to free memory.
 constexpr int kFreeMemCacheTimeout = kMemCheckTime - 100;
+// how long a document stays in the background before keeping only a few pixmaps, see Document::setInBackground()
+constexpr int kHibernationDelay = 30000; // in msec
+// the memory a hibernated document may keep besides the visible pixmaps
+constexpr qulonglong kHibernatedMemory = 16 * 1024 * 1024;
+
+// all the documents of the process, sharing the memory budget of calculateMemoryToFree()
+Q_GLOBAL_STATIC(QList<DocumentPrivate *>, allDocuments)
 
 /***** Document ******/
 
@@ -248,40 +259,52 @@ QString DocumentPrivate::localizedSize(const QSizeF size) const
     }
 }
 
+qulonglong DocumentPrivate::sharedAllocatedMemory()
+{
+    qulonglong memory = 0;
+    for (const DocumentPrivate *document : std::as_const(*allDocuments)) {
+        memory += document->m_allocatedPixmapsTotalMemory + document->m_allocatedTextPagesTotalMemory;
+    }
+    return memory;
+}
+
 qulonglong DocumentPrivate::calculateMemoryToFree()
 {
     // [MEM] choose memory parameters based on configuration profile
     qulonglong clipValue = 0;
     qulonglong memoryToFree = 0;
+    // the budget is for all the documents together, not for each of them
+    const qulonglong allocatedMemory = sharedAllocatedMemory();
 
     switch (SettingsCore::memoryLevel()) {
     case SettingsCore::EnumMemoryLevel::Low:
+        // text pages are already few in this profile, see calculateMaxTextPages()
         memoryToFree = m_allocatedPixmapsTotalMemory;
         break;
 
     case SettingsCore::EnumMemoryLevel::Normal: {
         qulonglong thirdTotalMemory = getTotalMemory() / 3;
         qulonglong freeMemory = getFreeMemory();
-        if (m_allocatedPixmapsTotalMemory > thirdTotalMemory) {
-            memoryToFree = m_allocatedPixmapsTotalMemory - thirdTotalMemory;
+        if (allocatedMemory > thirdTotalMemory) {
+            memoryToFree = allocatedMemory - thirdTotalMemory;
         }
-        if (m_allocatedPixmapsTotalMemory > freeMemory) {
-            clipValue = (m_allocatedPixmapsTotalMemory - freeMemory) / 2;
+        if (allocatedMemory > freeMemory) {
+            clipValue = (allocatedMemory - freeMemory) / 2;
         }
     } break;
 
     case SettingsCore::EnumMemoryLevel::Aggressive: {
         qulonglong freeMemory = getFreeMemory();
-        if (m_allocatedPixmapsTotalMemory > freeMemory) {
-            clipValue = (m_allocatedPixmapsTotalMemory - freeMemory) / 2;
+        if (allocatedMemory > freeMemory) {
+            clipValue = (allocatedMemory - freeMemory) / 2;
         }
     } break;
     case SettingsCore::EnumMemoryLevel::Greedy: {
         qulonglong freeSwap;
         qulonglong freeMemory = getFreeMemory(&freeSwap);
         const qulonglong memoryLimit = qMin(qMax(freeMemory, getTotalMemory() / 2), freeMemory + freeSwap);
-        if (m_allocatedPixmapsTotalMemory > memoryLimit) {
-            clipValue = (m_allocatedPixmapsTotalMemory - memoryLimit) / 2;
+        if (allocatedMemory > memoryLimit) {
+            clipValue = (allocatedMemory - memoryLimit) / 2;
         }
     } break;
     }
@@ -304,6 +327,28 @@ void DocumentPrivate::cleanupPixmapMemory(qulonglong memoryToFree)
         return;
     }
 
+    // The documents in the background give back their memory first
+    if (SettingsCore::memoryLevel() != SettingsCore::EnumMemoryLevel::Low) {
+        for (DocumentPrivate *document : std::as_const(*allDocuments)) {
+            if (document == this || !document->m_inBackground || memoryToFree < 1) {
+                continue;
+            }
+            const qulonglong allocatedMemory = document->m_allocatedPixmapsTotalMemory + document->m_allocatedTextPagesTotalMemory;
+            document->cleanupOwnPixmapMemory(qMin(memoryToFree, allocatedMemory));
+            const qulonglong freedMemory = allocatedMemory - (document->m_allocatedPixmapsTotalMemory + document->m_allocatedTextPagesTotalMemory);
+            memoryToFree = freedMemory < memoryToFree ? memoryToFree - freedMemory : 0;
+        }
+    }
+
+    cleanupOwnPixmapMemory(memoryToFree);
+}
+
+void DocumentPrivate::cleanupOwnPixmapMemory(qulonglong memoryToFree)
+{
+    if (memoryToFree < 1) {
+        return;
+    }
+
     const int currentViewportPage = (*m_viewportIterator).pageNumber;
 
     // Create a QMap of visible rects, indexed by page number
@@ -312,15 +357,34 @@ void DocumentPrivate::cleanupPixmapMemory(qulonglong memoryToFree)
         visibleRects.insert(it->pageNumber, it);
     }
 
+    // In the low profile all the pixmaps are freed each time, text pages are limited by count only
+    const bool keepTextPages = SettingsCore::memoryLevel() == SettingsCore::EnumMemoryLevel::Low;
+
     // Free memory starting from pages that are farthest from the current one
     int pagesFreed = 0;
     while (memoryToFree > 0) {
+        // Text pages go together with the pixmaps, at the same distance the text goes first
+        const int textPage = keepTextPages ? -1 : searchLowestPriorityTextPage();
+        if (textPage != -1) {
+            const AllocatedPixmap *farthestPixmap = searchLowestPriorityPixmap(true);
+            if (!farthestPixmap || qAbs(textPage - currentViewportPage) >= qAbs(farthestPixmap->page - currentViewportPage)) {
+                qCDebug(OkularCoreDebug) << "Evicting text page" << textPage;
+
+                const qulonglong memory = m_allocatedTextPages.value(textPage);
+                Tracing::instant("memory", "evict text page", {{"page", textPage}, {"bytes", qint64(memory)}});
+                memoryToFree = (memory < memoryToFree) ? (memoryToFree - memory) : 0;
+                releaseTextPage(textPage);
+                continue;
+            }
+        }
+
         AllocatedPixmap *p = searchLowestPriorityPixmap(true, true);
         if (!p) { // No pixmap to remove
             break;
         }
 
         qCDebug(OkularCoreDebug).nospace() << "Evicting cache pixmap observer=" << p->observer << " page=" << p->page;
+        Tracing::instant("memory", "evict pixmap", {{"page", p->page}, {"bytes", qint64(p->memory)}});
 
         // m_allocatedPixmapsTotalMemory can't underflow because we always add or remove
         // the memory used by the AllocatedPixmap so at most it can reach zero
@@ -428,6 +492,43 @@ AllocatedPixmap *DocumentPrivate::searchLowestPriorityPixmap(bool unloadableOnly
     return selectedPixmap;
 }
 
+/* Returns the page whose text page should be evicted first, the one
+ * farthest from the current viewport that is not visible, or -1 if none.
+ * The text pages holding the point a search continues from are kept, the
+ * next "find next" would start over from the beginning of the page otherwise
+ */
+int DocumentPrivate::searchLowestPriorityTextPage() const
+{
+    const int currentViewportPage = m_viewportIterator->pageNumber;
+
+    QSet<int> searchPages;
+    for (const RunningSearch *search : m_searches) {
+        if (search->continueOnPage != -1) {
+            searchPages.insert(search->continueOnPage);
+        }
+    }
+
+    int farthestPage = -1;
+    int maxDistance = -1;
+    for (auto it = m_allocatedTextPages.constBegin(); it != m_allocatedTextPages.constEnd(); ++it) {
+        const int distance = qAbs(it.key() - currentViewportPage);
+        if (distance > maxDistance && !searchPages.contains(it.key()) && !std::ranges::any_of(m_pageRects, [&it](const VisiblePageRect *r) { return r->pageNumber == it.key(); })) {
+            maxDistance = distance;
+            farthestPage = it.key();
+        }
+    }
+    return farthestPage;
+}
+
+/* Deletes the text page of the given page, it is generated again by whoever
+ * needs it next
+ */
+void DocumentPrivate::releaseTextPage(int page)
+{
+    m_allocatedTextPagesTotalMemory -= m_allocatedTextPages.take(page);
+    m_pagesVector.at(page)->setTextPage(nullptr); // deletes the textpage
+}
+
 qulonglong DocumentPrivate::getTotalMemory()
 {
     static qulonglong cachedValue = 0;
@@ -625,6 +726,7 @@ bool DocumentPrivate::loadDocumentInfo(QFile &infoFile, LoadDocumentInfoFlags lo
 
         // Restore page attributes (bookmark, annotations, ...) from the DOM
         if (catName == QLatin1String("pageList") && (loadWhat & LoadPageInfo)) {
+            m_pageElementsBeyondPages.clear();
             QDomNode pageNode = topLevelNode.firstChild();
             while (pageNode.isElement()) {
                 QDomElement pageElement = pageNode.toElement();
@@ -638,6 +740,10 @@ bool DocumentPrivate::loadDocumentInfo(QFile &infoFile, LoadDocumentInfoFlags lo
                         if (m_pagesVector[pageNumber]->d->restoreLocalContents(pageElement)) {
                             loadedAnything = true;
                         }
+                    } else if (ok && pageNumber >= (int)m_pagesVector.count() && pageElement.hasChildNodes()) {
+                        // for a page the generator has not loaded yet, see appendPages()
+                        m_pageElementsBeyondPages.append(pageElement);
+                        loadedAnything = true;
                     }
                 }
                 pageNode = pageNode.nextSibling();
@@ -889,73 +995,186 @@ SaveInterface *DocumentPrivate::generatorSave(GeneratorInfo &info)
     return qobject_cast<Okular::SaveInterface *>(info.generator);
 }
 
-Document::OpenResult DocumentPrivate::openDocumentInternal(const KPluginMetaData &offer, bool isstdin, const QString &docFile, const QByteArray &filedata, const QString &password)
+bool DocumentPrivate::prepareOpen(OpenRequest *request, const QString &docFile, const QUrl &url, const QMimeType &mime, const QString &password)
+{
+    QMimeDatabase db;
+    request->docFile = docFile;
+    request->url = url;
+    request->mime = mime;
+    request->password = password;
+    int fd = -1;
+    if (url.scheme() == QLatin1String("fd")) {
+        bool ok;
+        fd = QStringView {url.path()}.mid(1).toInt(&ok);
+        if (!ok) {
+            return false;
+        }
+    } else if (url.fileName() == QLatin1String("-")) {
+        fd = 0;
+    }
+    if (fd < 0) {
+        if (!request->mime.isValid()) {
+            return false;
+        }
+
+        m_url = url;
+        m_docFileName = docFile;
+
+        if (!updateMetadataXmlNameAndDocSize()) {
+            return false;
+        }
+    } else {
+        QFile qstdin;
+        const bool ret = qstdin.open(fd, QIODevice::ReadOnly, QFileDevice::AutoCloseHandle);
+        if (!ret) {
+            qWarning() << "failed to read" << url << request->filedata;
+            return false;
+        }
+
+        request->filedata = qstdin.readAll();
+        request->mime = db.mimeTypeForData(request->filedata);
+        if (!request->mime.isValid() || request->mime.isDefault()) {
+            return false;
+        }
+        m_docSize = request->filedata.size();
+        request->triedMimeFromFileContent = true;
+    }
+
+    request->fromFileDescriptor = fd >= 0;
+
+    // 0. load Generator
+    // request only valid non-disabled plugins suitable for the mimetype
+    request->offer = DocumentPrivate::generatorForMimeType(request->mime, m_widget);
+    if (!request->offer.isValid() && !request->triedMimeFromFileContent) {
+        QMimeType newmime = db.mimeTypeForFile(docFile, QMimeDatabase::MatchContent);
+        request->triedMimeFromFileContent = true;
+        if (newmime != request->mime) {
+            request->mime = newmime;
+            request->offer = DocumentPrivate::generatorForMimeType(request->mime, m_widget);
+        }
+        if (!request->offer.isValid()) {
+            // There's still no offers, do a final mime search based on the filename
+            // We need this because sometimes (e.g. when downloading from a webserver) the mimetype we
+            // use is the one fed by the server, that may be wrong
+            newmime = db.mimeTypeForUrl(url);
+
+            if (!newmime.isDefault() && newmime != request->mime) {
+                request->mime = newmime;
+                request->offer = DocumentPrivate::generatorForMimeType(request->mime, m_widget);
+            }
+        }
+    }
+    if (!request->offer.isValid()) {
+        m_openError = i18n("Can not find a plugin which is able to handle the document being passed.");
+        Q_EMIT m_parent->error(m_openError, -1);
+        qCWarning(OkularCoreDebug).nospace() << "No plugin for mimetype '" << request->mime.name() << "'.";
+        return false;
+    }
+
+    return true;
+}
+
+bool DocumentPrivate::nextOpenOffer(OpenRequest *request)
 {
-    QString propName = offer.pluginId();
+    request->triedOffers << request->offer;
+    request->offer = DocumentPrivate::generatorForMimeType(request->mime, m_widget, request->triedOffers);
+
+    if (!request->offer.isValid() && !request->triedMimeFromFileContent) {
+        QMimeDatabase db;
+        const QMimeType newmime = db.mimeTypeForFile(request->docFile, QMimeDatabase::MatchContent);
+        request->triedMimeFromFileContent = true;
+        if (newmime != request->mime) {
+            request->mime = newmime;
+            request->offer = DocumentPrivate::generatorForMimeType(request->mime, m_widget, request->triedOffers);
+        }
+    }
+
+    return request->offer.isValid();
+}
+
+Generator *DocumentPrivate::prepareGenerator(const OpenRequest &request)
+{
+    QString propName = request.offer.pluginId();
     QHash<QString, GeneratorInfo>::const_iterator genIt = m_loadedGenerators.constFind(propName);
     m_walletGenerator = nullptr;
+    Generator *generator;
     if (genIt != m_loadedGenerators.constEnd()) {
-        m_generator = genIt.value().generator;
+        generator = genIt.value().generator;
     } else {
-        m_generator = loadGeneratorLibrary(offer);
-        if (!m_generator) {
-            return Document::OpenError;
+        generator = loadGeneratorLibrary(request.offer);
+        if (!generator) {
+            return nullptr;
         }
         genIt = m_loadedGenerators.constFind(propName);
         Q_ASSERT(genIt != m_loadedGenerators.constEnd());
     }
-    Q_ASSERT_X(m_generator, "Document::load()", "null generator?!");
+    Q_ASSERT_X(generator, "Document::load()", "null generator?!");
 
-    m_generator->d_func()->m_document = this;
+    generator->d_func()->m_document = this;
 
     // connect error reporting signals
     m_openError.clear();
-    QMetaObject::Connection errorToOpenErrorConnection = QObject::connect(m_generator, &Generator::error, m_parent, [this](const QString &message) { m_openError = message; });
-    QObject::connect(m_generator, &Generator::warning, m_parent, &Document::warning);
-    QObject::connect(m_generator, &Generator::notice, m_parent, &Document::notice);
-
-    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QObject::connect(generator, &Generator::error, m_parent, [this](const QString &message) { m_openError = message; });
+    QObject::connect(generator, &Generator::warning, m_parent, &Document::warning);
+    QObject::connect(generator, &Generator::notice, m_parent, &Document::notice);
 
     const QWindow *window = m_widget && m_widget->window() ? m_widget->window()->windowHandle() : nullptr;
     const QSizeF dpi = Utils::realDpi(window);
     qCDebug(OkularCoreDebug) << "Output DPI:" << dpi;
-    m_generator->setDPI(dpi);
-
-    Document::OpenResult openResult = Document::OpenError;
-    if (!isstdin) {
-        openResult = m_generator->loadDocumentWithPassword(docFile, m_pagesVector, password);
-    } else if (!filedata.isEmpty()) {
-        if (m_generator->hasFeature(Generator::ReadRawData)) {
-            openResult = m_generator->loadDocumentFromDataWithPassword(filedata, m_pagesVector, password);
+    generator->setDPI(dpi);
+
+    // generators that can't read raw data get it through a temporary file
+    if (request.fromFileDescriptor && !request.filedata.isEmpty() && !generator->hasFeature(Generator::ReadRawData)) {
+        m_tempFile = new QTemporaryFile();
+        if (!m_tempFile->open()) {
+            delete m_tempFile;
+            m_tempFile = nullptr;
         } else {
-            m_tempFile = new QTemporaryFile();
-            if (!m_tempFile->open()) {
-                delete m_tempFile;
-                m_tempFile = nullptr;
-            } else {
-                m_tempFile->write(filedata);
-                QString tmpFileName = m_tempFile->fileName();
-                m_tempFile->close();
-                openResult = m_generator->loadDocumentWithPassword(tmpFileName, m_pagesVector, password);
-            }
+            m_tempFile->write(request.filedata);
+            m_tempFile->close();
         }
     }
 
-    QApplication::restoreOverrideCursor();
-    if (openResult != Document::OpenSuccess || m_pagesVector.size() <= 0) {
-        m_generator->d_func()->m_document = nullptr;
-        QObject::disconnect(m_generator, nullptr, m_parent, nullptr);
+    return generator;
+}
+
+Generator *DocumentPrivate::loadedGeneratorFor(const OpenRequest &request) const
+{
+    const auto genIt = m_loadedGenerators.constFind(request.offer.pluginId());
+    return genIt != m_loadedGenerators.constEnd() ? genIt.value().generator : nullptr;
+}
+
+Document::OpenResult DocumentPrivate::loadDocumentWith(Generator *generator, const OpenRequest &request, QTemporaryFile *tempFile, QList<Page *> &pagesVector)
+{
+    const Tracing::Scope scope("document", "load document");
+
+    if (!request.fromFileDescriptor) {
+        return generator->loadDocumentWithPassword(request.docFile, pagesVector, request.password);
+    } else if (!request.filedata.isEmpty()) {
+        if (generator->hasFeature(Generator::ReadRawData)) {
+            return generator->loadDocumentFromDataWithPassword(request.filedata, pagesVector, request.password);
+        } else if (tempFile) {
+            return generator->loadDocumentWithPassword(tempFile->fileName(), pagesVector, request.password);
+        }
+    }
+    return Document::OpenError;
+}
+
+Document::OpenResult DocumentPrivate::finishOpenDocumentInternal(Generator *generator, Document::OpenResult openResult, QList<Page *> &pagesVector)
+{
+    if (openResult != Document::OpenSuccess || pagesVector.size() <= 0) {
+        generator->d_func()->m_document = nullptr;
+        QObject::disconnect(generator, nullptr, m_parent, nullptr);
 
         // TODO this is a bit of a hack, since basically means that
         // you can only call walletDataForFile after calling openDocument
         // but since in reality it's what happens I've decided not to refactor/break API
         // One solution is just kill walletDataForFile and make OpenResult be an object
         // where the wallet data is also returned when OpenNeedsPassword
-        m_walletGenerator = m_generator;
-        m_generator = nullptr;
+        m_walletGenerator = generator;
 
-        qDeleteAll(m_pagesVector);
-        m_pagesVector.clear();
+        qDeleteAll(pagesVector);
+        pagesVector.clear();
         delete m_tempFile;
         m_tempFile = nullptr;
 
@@ -969,13 +1188,42 @@ Document::OpenResult DocumentPrivate::openDocumentInternal(const KPluginMetaData
          * we can now connect the error reporting signal directly to the parent
          */
 
-        QObject::disconnect(errorToOpenErrorConnection);
-        QObject::connect(m_generator, &Generator::error, m_parent, &Document::error);
+        QObject::disconnect(generator, &Generator::error, m_parent, nullptr);
+        QObject::connect(generator, &Generator::error, m_parent, &Document::error);
+
+        // the generators that may load in a thread read their settings here, in the GUI thread
+        if (generator->hasFeature(Generator::ThreadedLoading)) {
+            if (Okular::ConfigInterface *iface = qobject_cast<Okular::ConfigInterface *>(generator)) {
+                iface->reparseConfig();
+            }
+        }
+
+        m_generator = generator;
+        m_pagesVector = std::move(pagesVector);
+        pagesVector.clear();
     }
 
     return openResult;
 }
 
+Document::OpenResult DocumentPrivate::openDocumentInternal(const OpenRequest &request)
+{
+    // a stopped asynchronous opening may still be loading with the generator
+    waitForAsyncLoad(loadedGeneratorFor(request));
+
+    Generator *generator = prepareGenerator(request);
+    if (!generator) {
+        return Document::OpenError;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    QList<Page *> pagesVector;
+    const Document::OpenResult openResult = loadDocumentWith(generator, request, m_tempFile, pagesVector);
+    QApplication::restoreOverrideCursor();
+
+    return finishOpenDocumentInternal(generator, openResult, pagesVector);
+}
+
 bool DocumentPrivate::savePageDocumentInfo(QTemporaryFile *infoFile, int what) const
 {
     if (infoFile->open()) {
@@ -1158,69 +1406,151 @@ void DocumentPrivate::performSetAnnotationContents(const QString &newContents, A
 }
 
 void DocumentPrivate::recalculateForms()
+{
+    recalculateForms(nullptr);
+}
+
+void DocumentPrivate::recalculateFormsDependingOn(const QList<FormField *> &forms)
+{
+    QSet<QString> changedForms;
+    for (const FormField *form : forms) {
+        changedForms.insert(form->fullyQualifiedName());
+    }
+    recalculateForms(&changedForms);
+}
+
+void DocumentPrivate::recalculateForms(QSet<QString> *changedForms)
+{
+    if (!m_calculatedFormsBuilt) {
+        buildCalculatedForms();
+    }
+
+    // a calculate action may also write other fields through Field.value
+    QSet<QString> *const previousChangedForms = std::exchange(m_changedFormFields, changedForms);
+
+    QSet<int> pagesToRefresh;
+    // by index, a calculate action may change a field and recalculate forms again
+    for (int i = 0; i < m_calculatedForms.count(); ++i) {
+        const CalculatedForm &calculatedForm = m_calculatedForms.at(i);
+        // the fields that never ran may depend on anything
+        if (changedForms && calculatedForm.calculated && !calculatedForm.dependencies.intersects(*changedForms)) {
+            continue;
+        }
+
+        FormField *form = calculatedForm.form;
+        Page *page = calculatedForm.page;
+        QSet<QString> readForms;
+        bool pageNeedsRefresh = false;
+        const bool changed = calculateForm(form, page, &readForms, &pageNeedsRefresh);
+
+        if (i < m_calculatedForms.count() && m_calculatedForms.at(i).form == form) {
+            m_calculatedForms[i].dependencies = readForms;
+            m_calculatedForms[i].calculated = true;
+        }
+        if (changed && changedForms) {
+            changedForms->insert(form->fullyQualifiedName());
+        }
+        if (pageNeedsRefresh) {
+            pagesToRefresh.insert(page->number());
+        }
+    }
+
+    // what changed in a recalculation run from a calculate action matters to the one running it
+    m_changedFormFields = previousChangedForms;
+    if (previousChangedForms && changedForms) {
+        previousChangedForms->unite(*changedForms);
+    }
+
+    for (int pageNumber : std::as_const(pagesToRefresh)) {
+        refreshPixmaps(pageNumber);
+    }
+}
+
+bool DocumentPrivate::calculateForm(FormField *form, Page *page, QSet<QString> *readForms, bool *pageNeedsRefresh)
+{
+    const Action *action = form->additionalAction(FormField::CalculateField);
+    if (!action) {
+        qWarning() << "Form that is part of calculate order doesn't have a calculate action";
+        return false;
+    }
+    if (!dynamic_cast<FormFieldText *>(form) && !dynamic_cast<FormFieldChoice *>(form)) {
+        return false;
+    }
+
+    // Prepare text calculate event
+    std::shared_ptr<Event> event = Event::createFormCalculateEvent(form, page);
+    const ScriptAction *linkscript = static_cast<const ScriptAction *>(action);
+    QSet<QString> *const previousReadForms = std::exchange(m_readFormFields, readForms);
+    executeScriptEvent(event, *linkscript);
+    m_readFormFields = previousReadForms;
+    // The value maybe changed in javascript so save it first.
+    QString oldVal = form->value().toString();
+
+    if (!event) {
+        return false;
+    }
+
+    // Update text field from calculate
+    const QString newVal = event->value().toString();
+    if (newVal == oldVal) {
+        return false;
+    }
+
+    form->setValue(QVariant(newVal));
+    form->setAppearanceValue(QVariant(newVal));
+    bool returnCode = true;
+    if (form->additionalAction(Okular::FormField::FieldModified) && !form->isReadOnly()) {
+        m_parent->processKeystrokeCommitAction(form->additionalAction(Okular::FormField::FieldModified), form, returnCode);
+    }
+    if (const Okular::Action *validateAction = form->additionalAction(Okular::FormField::ValidateField)) {
+        if (returnCode) {
+            m_parent->processValidateAction(validateAction, form, returnCode);
+        }
+    }
+    if (!returnCode) {
+        return true;
+    } else {
+        form->commitValue(form->value().toString());
+    }
+    if (const Okular::Action *formatAction = form->additionalAction(Okular::FormField::FormatField)) {
+        // The format action handles the refresh.
+        m_parent->processFormatAction(formatAction, form);
+    } else {
+        form->commitFormattedValue(form->value().toString());
+        Q_EMIT m_parent->refreshFormWidget(form);
+        *pageNeedsRefresh = true;
+    }
+    return true;
+}
+
+void DocumentPrivate::buildCalculatedForms()
 {
     const QVariant fco = m_parent->metaData(QStringLiteral("FormCalculateOrder"));
     const QList<int> formCalculateOrder = fco.value<QList<int>>();
-    for (int formId : formCalculateOrder) {
-        for (Page *const page : std::as_const(m_pagesVector)) {
-            if (page) {
-                bool pageNeedsRefresh = false;
-                const QList<Okular::FormField *> forms = page->formFields();
-                for (FormField *form : forms) {
-                    if (form->id() == formId) {
-                        const Action *action = form->additionalAction(FormField::CalculateField);
-                        if (action) {
-                            std::shared_ptr<Event> event;
-                            if (dynamic_cast<FormFieldText *>(form) || dynamic_cast<FormFieldChoice *>(form)) {
-                                // Prepare text calculate event
-                                event = Event::createFormCalculateEvent(form, page);
-                                const ScriptAction *linkscript = static_cast<const ScriptAction *>(action);
-                                executeScriptEvent(event, *linkscript);
-                                // The value maybe changed in javascript so save it first.
-                                QString oldVal = form->value().toString();
-
-                                if (event) {
-                                    // Update text field from calculate
-                                    const QString newVal = event->value().toString();
-                                    if (newVal != oldVal) {
-                                        form->setValue(QVariant(newVal));
-                                        form->setAppearanceValue(QVariant(newVal));
-                                        bool returnCode = true;
-                                        if (form->additionalAction(Okular::FormField::FieldModified) && !form->isReadOnly()) {
-                                            m_parent->processKeystrokeCommitAction(form->additionalAction(Okular::FormField::FieldModified), form, returnCode);
-                                        }
-                                        if (const Okular::Action *validateAction = form->additionalAction(Okular::FormField::ValidateField)) {
-                                            if (returnCode) {
-                                                m_parent->processValidateAction(validateAction, form, returnCode);
-                                            }
-                                        }
-                                        if (!returnCode) {
-                                            continue;
-                                        } else {
-                                            form->commitValue(form->value().toString());
-                                        }
-                                        if (const Okular::Action *formatAction = form->additionalAction(Okular::FormField::FormatField)) {
-                                            // The format action handles the refresh.
-                                            m_parent->processFormatAction(formatAction, form);
-                                        } else {
-                                            form->commitFormattedValue(form->value().toString());
-                                            Q_EMIT m_parent->refreshFormWidget(form);
-                                            pageNeedsRefresh = true;
-                                        }
-                                    }
-                                }
-                            }
-                        } else {
-                            qWarning() << "Form that is part of calculate order doesn't have a calculate action";
-                        }
-                    }
-                }
-                if (pageNeedsRefresh) {
-                    refreshPixmaps(page->number());
-                }
+    const QSet<int> calculatedIds(formCalculateOrder.cbegin(), formCalculateOrder.cend());
+
+    // one pass over the fields of the document rather than one per calculated field
+    QHash<int, QList<CalculatedForm>> formsById;
+    for (Page *const page : std::as_const(m_pagesVector)) {
+        const QList<Okular::FormField *> forms = page->formFields();
+        for (FormField *form : forms) {
+            if (calculatedIds.contains(form->id())) {
+                formsById[form->id()].append({form, page, {}, false});
             }
         }
     }
+
+    m_calculatedForms.clear();
+    for (int formId : formCalculateOrder) {
+        m_calculatedForms.append(formsById.value(formId));
+    }
+    m_calculatedFormsBuilt = true;
+}
+
+void DocumentPrivate::clearCalculatedForms()
+{
+    m_calculatedForms.clear();
+    m_calculatedFormsBuilt = false;
 }
 
 void DocumentPrivate::saveDocumentInfo() const
@@ -1259,6 +1589,10 @@ void DocumentPrivate::saveDocumentInfo() const
         for (Page *const page : std::as_const(m_pagesVector)) {
             page->d->saveLocalContents(pageList, doc, saveWhat);
         }
+        // and those of the pages the generator has not loaded yet, as they were
+        for (const QDomElement &pageElement : std::as_const(m_pageElementsBeyondPages)) {
+            pageList.appendChild(doc.importNode(pageElement, true));
+        }
     }
 
     // 2.2. Save document info (current viewport, history, ... ) to DOM
@@ -1313,10 +1647,20 @@ void DocumentPrivate::saveDocumentInfo() const
     infoFile.close();
 }
 
+void DocumentPrivate::hibernate()
+{
+    const qulonglong allocatedMemory = m_allocatedPixmapsTotalMemory + m_allocatedTextPagesTotalMemory;
+    if (allocatedMemory > kHibernatedMemory) {
+        qCDebug(OkularCoreDebug) << "Hibernating, releasing" << allocatedMemory - kHibernatedMemory << "bytes";
+        cleanupOwnPixmapMemory(allocatedMemory - kHibernatedMemory);
+    }
+    m_hibernated = true;
+}
+
 void DocumentPrivate::slotTimedMemoryCheck()
 {
     // [MEM] clean memory (for 'free mem dependent' profiles only)
-    if (SettingsCore::memoryLevel() != SettingsCore::EnumMemoryLevel::Low && m_allocatedPixmapsTotalMemory > 1024 * 1024) {
+    if (SettingsCore::memoryLevel() != SettingsCore::EnumMemoryLevel::Low && m_allocatedPixmapsTotalMemory + m_allocatedTextPagesTotalMemory > 1024 * 1024) {
         cleanupPixmapMemory();
     }
 }
@@ -1498,6 +1842,8 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
         // we can not really know if the generator can do async requests
         m_executingPixmapRequests.push_back(request);
         m_pixmapRequestsMutex.unlock();
+        Tracing::asyncBegin("render", "pixmap request", request, {{"page", request->pageNumber()}, {"width", requestRect.width()}, {"height", requestRect.height()}, {"tile", request->isTile()}});
+        request->d->mSentTimer.start();
         m_generator->generatePixmap(request);
     } else {
         m_pixmapRequestsMutex.unlock();
@@ -1636,9 +1982,12 @@ void DocumentPrivate::_o_configChanged()
 {
     // free text pages if needed
     calculateMaxTextPages();
-    while (m_allocatedTextPagesFifo.count() > m_maxAllocatedTextPages) {
-        int pageToKick = m_allocatedTextPagesFifo.takeFirst();
-        m_pagesVector.at(pageToKick)->setTextPage(nullptr); // deletes the textpage
+    while (m_allocatedTextPages.count() > m_maxAllocatedTextPages) {
+        const int pageToKick = searchLowestPriorityTextPage();
+        if (pageToKick == -1) {
+            break;
+        }
+        releaseTextPage(pageToKick);
     }
 }
 
@@ -1680,6 +2029,7 @@ void DocumentPrivate::doContinueDirectionMatchSearch(DoContinueDirectionMatchSea
     if (doContinue) {
         // get page
         const Page *page = m_pagesVector[searchStruct->currentPage];
+        const Tracing::Scope scope("search", "search page", {{"page", searchStruct->currentPage}});
         // request search page if needed
         if (!page->hasTextPage()) {
             m_parent->requestTextPage(page->number());
@@ -1785,6 +2135,7 @@ void DocumentPrivate::doContinueAllDocumentSearch(QSet<int> *pagesToNotify, QHas
     if (currentPage < m_pagesVector.count()) {
         // get page (from the first to the last)
         Page *page = m_pagesVector.at(currentPage);
+        const Tracing::Scope scope("search", "search page", {{"page", currentPage}});
 
         // request search page if needed
         if (!page->hasTextPage()) {
@@ -1883,6 +2234,7 @@ void DocumentPrivate::doContinueGooglesDocumentSearch(QSet<int> *pagesToNotify,
     if (currentPage < m_pagesVector.count()) {
         // get page (from the first to the last)
         Page *page = m_pagesVector.at(currentPage);
+        const Tracing::Scope scope("search", "search page", {{"page", currentPage}});
 
         // request search page if needed
         if (!page->hasTextPage()) {
@@ -2025,115 +2377,65 @@ bool DocumentPrivate::isNormalizedRectangleFullyVisible(const Okular::Normalized
     });
 }
 
-struct pdfsyncpoint {
-    QString file;
-    qlonglong x;
-    qlonglong y;
-    int row;
-    int column;
-    int page;
-};
-
-void DocumentPrivate::loadSyncFile(const QString &filePath)
+void DocumentPrivate::startSyncIndexBuild(const QString &docFile, bool pdfSync)
 {
-    QFile f(filePath + QLatin1String("sync"));
-    if (!f.open(QIODevice::ReadOnly)) {
-        return;
-    }
-
-    QTextStream ts(&f);
-    // first row: core name of the pdf output
-    const QString coreName = ts.readLine();
-    // second row: version string, in the form 'Version %u'
-    const QString versionstr = ts.readLine();
-    // anchor the pattern with \A and \z to match the entire subject string
-    // TODO: with Qt 5.12 QRegularExpression::anchoredPattern() can be used instead
-    static QRegularExpression versionre(QStringLiteral("\\AVersion \\d+\\z"), QRegularExpression::CaseInsensitiveOption);
-    QRegularExpressionMatch match = versionre.match(versionstr);
-    if (!match.hasMatch()) {
-        return;
-    }
-
-    QHash<int, pdfsyncpoint> points;
-    QStack<QString> fileStack;
-    int currentpage = -1;
-    const QLatin1String texStr(".tex");
-    const QChar spaceChar = QChar::fromLatin1(' ');
+    stopSyncIndexBuild();
 
-    fileStack.push(coreName + texStr);
-
-    const QSizeF dpi = m_generator->dpi();
+    auto result = std::make_shared<std::unique_ptr<SyncIndex>>();
+    m_syncIndexAbort = false;
+    const std::atomic<bool> &abort = m_syncIndexAbort;
+    const int pageCount = m_pagesVector.count();
+    m_syncIndexThread = QThread::create([docFile, pdfSync, pageCount, result, &abort] {
+        *result = pdfSync ? SyncIndex::fromPdfSync(docFile, pageCount, abort) : SyncIndex::fromSyncTeX(docFile, pageCount, abort);
+    });
 
-    QString line;
-    while (!ts.atEnd()) {
-        line = ts.readLine();
-        const QStringList tokens = line.split(spaceChar, Qt::SkipEmptyParts);
-        const int tokenSize = tokens.count();
-        if (tokenSize < 1) {
-            continue;
+    const QPointer<QThread> thread = m_syncIndexThread;
+    QObject::connect(m_syncIndexThread, &QThread::finished, m_parent, [this, thread, result, pdfSync] {
+        // stopSyncIndexBuild() deletes the threads it waited for
+        if (!thread) {
+            return;
         }
-        if (tokens.first() == QLatin1String("l") && tokenSize >= 3) {
-            int id = tokens.at(1).toInt();
-            QHash<int, pdfsyncpoint>::const_iterator it = points.constFind(id);
-            if (it == points.constEnd()) {
-                pdfsyncpoint pt;
-                pt.x = 0;
-                pt.y = 0;
-                pt.row = tokens.at(2).toInt();
-                pt.column = 0; // TODO
-                pt.page = -1;
-                pt.file = fileStack.top();
-                points[id] = pt;
-            }
-        } else if (tokens.first() == QLatin1String("s") && tokenSize >= 2) {
-            currentpage = tokens.at(1).toInt() - 1;
-        } else if (tokens.first() == QLatin1String("p*") && tokenSize >= 4) {
-            // TODO
-            qCDebug(OkularCoreDebug) << "PdfSync: 'p*' line ignored";
-        } else if (tokens.first() == QLatin1String("p") && tokenSize >= 4) {
-            int id = tokens.at(1).toInt();
-            QHash<int, pdfsyncpoint>::iterator it = points.find(id);
-            if (it != points.end()) {
-                it->x = tokens.at(2).toInt();
-                it->y = tokens.at(3).toInt();
-                it->page = currentpage;
-            }
-        } else if (line.startsWith(QLatin1Char('(')) && tokenSize == 1) {
-            QString newfile = line;
-            // chop the leading '('
-            newfile.remove(0, 1);
-            if (!newfile.endsWith(texStr)) {
-                newfile += texStr;
-            }
-            fileStack.push(newfile);
-        } else if (line == QLatin1String(")")) {
-            if (!fileStack.isEmpty()) {
-                fileStack.pop();
-            } else {
-                qCDebug(OkularCoreDebug) << "PdfSync: going one level down too much";
-            }
-        } else {
-            qCDebug(OkularCoreDebug).nospace() << "PdfSync: unknown line format: '" << line << "'";
+        thread->deleteLater();
+        m_syncIndexThread = nullptr;
+        m_syncIndex = std::move(*result);
+        if (m_syncIndex && pdfSync) {
+            applyPdfSyncSourceReferences();
         }
+    });
+    m_syncIndexThread->start(QThread::LowPriority);
+}
+
+void DocumentPrivate::stopSyncIndexBuild()
+{
+    if (m_syncIndexThread) {
+        m_syncIndexAbort = true;
+        m_syncIndexThread->wait();
+        delete m_syncIndexThread;
+        m_syncIndexThread = nullptr;
     }
+    m_syncIndex.reset();
+}
 
-    QList<QList<Okular::SourceRefObjectRect *>> refRects(m_pagesVector.size());
-    for (const pdfsyncpoint &pt : std::as_const(points)) {
-        // drop pdfsync points not completely valid
-        if (pt.page < 0 || pt.page >= m_pagesVector.size()) {
+void DocumentPrivate::applyPdfSyncSourceReferences()
+{
+    const QSizeF dpi = m_generator->dpi();
+    const double unitsPerInch = m_syncIndex->unitsPerInch();
+    const int pageCount = std::min<int>(m_pagesVector.size(), m_syncIndex->pageCount());
+    for (int i = 0; i < pageCount; ++i) {
+        const QList<SyncIndex::Point> points = m_syncIndex->pointsOnPage(i);
+        if (points.isEmpty()) {
             continue;
         }
 
-        // magic numbers for TeX's RSU's (Ridiculously Small Units) conversion to pixels
-        Okular::NormalizedPoint p((pt.x * dpi.width()) / (72.27 * 65536.0 * m_pagesVector[pt.page]->width()), (pt.y * dpi.height()) / (72.27 * 65536.0 * m_pagesVector[pt.page]->height()));
-        QString file = pt.file;
-        Okular::SourceReference *sourceRef = new Okular::SourceReference(file, pt.row, pt.column);
-        refRects[pt.page].append(new Okular::SourceRefObjectRect(p, sourceRef));
-    }
-    for (int i = 0; i < refRects.size(); ++i) {
-        if (!refRects.at(i).isEmpty()) {
-            m_pagesVector[i]->setSourceReferences(refRects.at(i));
+        Page *page = m_pagesVector[i];
+        QList<Okular::SourceRefObjectRect *> refRects;
+        refRects.reserve(points.size());
+        for (const SyncIndex::Point &pt : points) {
+            Okular::NormalizedPoint p((pt.h * dpi.width()) / (unitsPerInch * page->width()), (pt.v * dpi.height()) / (unitsPerInch * page->height()));
+            Okular::SourceReference *sourceRef = new Okular::SourceReference(m_syncIndex->fileName(pt.file), pt.line, pt.column);
+            refRects.append(new Okular::SourceRefObjectRect(p, sourceRef));
         }
+        page->setSourceReferences(refRects);
     }
 }
 
@@ -2204,6 +2506,7 @@ Document::Document(QWidget *widget)
     d->m_bookmarkManager = new BookmarkManager(d);
     d->m_viewportIterator = d->m_viewportHistory.insert(d->m_viewportHistory.end(), DocumentViewport());
     d->m_undoStack = new QUndoStack(this);
+    allDocuments->append(d);
 
     connect(SettingsCore::self(), &SettingsCore::configChanged, this, [this] { d->_o_configChanged(); });
     connect(d->m_undoStack, &QUndoStack::canUndoChanged, this, &Document::canUndoChanged);
@@ -2225,12 +2528,22 @@ Document::~Document()
     // delete the bookmark manager
     delete d->m_bookmarkManager;
 
+    // the stopped openings may still be loading with them
+    const QList<Generator *> loadingGenerators = d->m_stoppedAsyncLoads.keys();
+    for (Generator *generator : loadingGenerators) {
+        d->waitForAsyncLoad(generator);
+    }
+
     // delete the loaded generators
     for (auto &generator : d->m_loadedGenerators) {
         delete generator.generator;
     }
     d->m_loadedGenerators.clear();
 
+    if (!allDocuments.isDestroyed()) {
+        allDocuments->removeOne(d);
+    }
+
     // delete the private structure
     delete d;
 }
@@ -2324,210 +2637,327 @@ KPluginMetaData DocumentPrivate::generatorForMimeType(const QMimeType &type, QWi
     return offers.at(hRank);
 }
 
-Document::OpenResult Document::openDocument(const QString &docFile, const QUrl &url, const QMimeType &_mime, const QString &password)
+Document::OpenResult Document::openDocument(const QString &docFile, const QUrl &url, const QMimeType &mime, const QString &password)
 {
-    QMimeDatabase db;
-    QMimeType mime = _mime;
-    QByteArray filedata;
-    int fd = -1;
-    if (url.scheme() == QLatin1String("fd")) {
-        bool ok;
-        fd = QStringView {url.path()}.mid(1).toInt(&ok);
-        if (!ok) {
-            return OpenError;
-        }
-    } else if (url.fileName() == QLatin1String("-")) {
-        fd = 0;
-    }
-    bool triedMimeFromFileContent = false;
-    if (fd < 0) {
-        if (!mime.isValid()) {
-            return OpenError;
-        }
+    d->stopOpenDocumentAsync();
 
-        d->m_url = url;
-        d->m_docFileName = docFile;
+    OpenRequest request;
+    if (!d->prepareOpen(&request, docFile, url, mime, password)) {
+        return OpenError;
+    }
 
-        if (!d->updateMetadataXmlNameAndDocSize()) {
-            return OpenError;
-        }
-    } else {
-        QFile qstdin;
-        const bool ret = qstdin.open(fd, QIODevice::ReadOnly, QFileDevice::AutoCloseHandle);
-        if (!ret) {
-            qWarning() << "failed to read" << url << filedata;
-            return OpenError;
-        }
+    // 1. load Document
+    OpenResult openResult = d->openDocumentInternal(request);
+    while (openResult == OpenError && d->nextOpenOffer(&request)) {
+        openResult = d->openDocumentInternal(request);
+    }
+    if (openResult != OpenSuccess) {
+        return openResult;
+    }
 
-        filedata = qstdin.readAll();
-        mime = db.mimeTypeForData(filedata);
-        if (!mime.isValid() || mime.isDefault()) {
-            return OpenError;
-        }
-        d->m_docSize = filedata.size();
-        triedMimeFromFileContent = true;
+    if (!request.triedOffers.isEmpty()) {
+        // Clear errors, since we're trying various generators, maybe one of them errored out
+        // but we finally succeeded
+        // TODO one can still see the error message animating out but since this is a very rare
+        //      condition we can leave this for future work
+        Q_EMIT error(QString(), -1);
     }
 
-    const bool fromFileDescriptor = fd >= 0;
+    d->setupOpenedDocument(request, false);
 
-    // 0. load Generator
-    // request only valid non-disabled plugins suitable for the mimetype
-    KPluginMetaData offer = DocumentPrivate::generatorForMimeType(mime, d->m_widget);
-    if (!offer.isValid() && !triedMimeFromFileContent) {
-        QMimeType newmime = db.mimeTypeForFile(docFile, QMimeDatabase::MatchContent);
-        triedMimeFromFileContent = true;
-        if (newmime != mime) {
-            mime = newmime;
-            offer = DocumentPrivate::generatorForMimeType(mime, d->m_widget);
-        }
-        if (!offer.isValid()) {
-            // There's still no offers, do a final mime search based on the filename
-            // We need this because sometimes (e.g. when downloading from a webserver) the mimetype we
-            // use is the one fed by the server, that may be wrong
-            newmime = db.mimeTypeForUrl(url);
+    return OpenSuccess;
+}
+
+void Document::openDocumentAsync(const QString &docFile, const QUrl &url, const QMimeType &mime, const QString &password)
+{
+    d->stopOpenDocumentAsync();
 
-            if (!newmime.isDefault() && newmime != mime) {
-                mime = newmime;
-                offer = DocumentPrivate::generatorForMimeType(mime, d->m_widget);
+    auto request = std::make_unique<OpenRequest>();
+    const bool prepared = d->prepareOpen(request.get(), docFile, url, mime, password);
+    d->m_asyncOpen = std::move(request);
+    if (prepared) {
+        d->startOpenDocumentAsync();
+    } else {
+        const int serial = d->m_asyncOpenSerial;
+        QTimer::singleShot(0, this, [this, serial] {
+            if (serial == d->m_asyncOpenSerial) {
+                d->m_asyncOpen.reset();
+                Q_EMIT documentOpened(OpenError);
             }
-        }
+        });
     }
-    if (!offer.isValid()) {
-        d->m_openError = i18n("Can not find a plugin which is able to handle the document being passed.");
-        Q_EMIT error(d->m_openError, -1);
-        qCWarning(OkularCoreDebug).nospace() << "No plugin for mimetype '" << mime.name() << "'.";
-        return OpenError;
+}
+
+bool Document::isOpening() const
+{
+    return d->m_asyncOpen != nullptr;
+}
+
+void DocumentPrivate::startOpenDocumentAsync()
+{
+    const OpenRequest &request = *m_asyncOpen;
+    Q_EMIT m_parent->openProgress(i18n("Loading the document…"));
+
+    // a stopped opening may still be loading with the generator, this one starts once it is done
+    if (Generator *generator = loadedGeneratorFor(request); generator && m_stoppedAsyncLoads.contains(generator)) {
+        m_asyncOpenWaiting = true;
+        return;
     }
 
-    // 1. load Document
-    OpenResult openResult = d->openDocumentInternal(offer, fromFileDescriptor, docFile, filedata, password);
-    if (openResult == OpenError) {
-        QList<KPluginMetaData> triedOffers;
-        triedOffers << offer;
-        offer = DocumentPrivate::generatorForMimeType(mime, d->m_widget, triedOffers);
-
-        while (offer.isValid()) {
-            openResult = d->openDocumentInternal(offer, fromFileDescriptor, docFile, filedata, password);
-
-            if (openResult == OpenError) {
-                triedOffers << offer;
-                offer = DocumentPrivate::generatorForMimeType(mime, d->m_widget, triedOffers);
-            } else {
-                break;
+    m_asyncOpenGenerator = prepareGenerator(request);
+    m_asyncOpenResult = Document::OpenError;
+    const int serial = m_asyncOpenSerial;
+
+    if (m_asyncOpenGenerator && m_asyncOpenGenerator->hasFeature(Generator::ThreadedLoading)) {
+        auto load = std::make_shared<AsyncLoad>();
+        load->generator = m_asyncOpenGenerator;
+        load->request = request;
+        load->tempFile = std::exchange(m_tempFile, nullptr);
+        load->thread = QThread::create([load] { load->result = loadDocumentWith(load->generator, load->request, load->tempFile, load->pages); });
+        QObject::connect(load->thread, &QThread::finished, m_parent, [this, serial, load] {
+            if (serial != m_asyncOpenSerial) {
+                // the opening was stopped meanwhile, unless waitForAsyncLoad() got to it first
+                if (m_stoppedAsyncLoads.value(load->generator) == load) {
+                    m_stoppedAsyncLoads.remove(load->generator);
+                    discardAsyncLoad(load.get());
+                }
+                return;
             }
-        }
+            m_asyncOpenLoad.reset();
+            m_asyncOpenResult = load->result;
+            m_asyncOpenPages = std::move(load->pages);
+            m_tempFile = load->tempFile;
+            openDocumentAsyncLoaded();
+        });
+        // after the handler above, the load may still be around when the document is gone
+        QObject::connect(load->thread, &QThread::finished, load->thread, &QObject::deleteLater);
+        m_asyncOpenLoad = load;
+        load->thread->start();
+    } else {
+        // the generator has to load in the GUI thread, still let the caller return first
+        QTimer::singleShot(0, m_parent, [this, serial] {
+            if (serial != m_asyncOpenSerial) {
+                return;
+            }
+            if (m_asyncOpenGenerator) {
+                QApplication::setOverrideCursor(Qt::WaitCursor);
+                m_asyncOpenResult = loadDocumentWith(m_asyncOpenGenerator, *m_asyncOpen, m_tempFile, m_asyncOpenPages);
+                QApplication::restoreOverrideCursor();
+            }
+            openDocumentAsyncLoaded();
+        });
+    }
+}
 
-        if (openResult == OpenError && !triedMimeFromFileContent) {
-            QMimeType newmime = db.mimeTypeForFile(docFile, QMimeDatabase::MatchContent);
-            triedMimeFromFileContent = true;
-            if (newmime != mime) {
-                mime = newmime;
-                offer = DocumentPrivate::generatorForMimeType(mime, d->m_widget, triedOffers);
-                while (offer.isValid()) {
-                    openResult = d->openDocumentInternal(offer, fromFileDescriptor, docFile, filedata, password);
+void DocumentPrivate::openDocumentAsyncLoaded()
+{
+    Document::OpenResult openResult = Document::OpenError;
+    if (m_asyncOpenGenerator) {
+        openResult = finishOpenDocumentInternal(m_asyncOpenGenerator, m_asyncOpenResult, m_asyncOpenPages);
+        m_asyncOpenGenerator = nullptr;
+    }
 
-                    if (openResult == OpenError) {
-                        triedOffers << offer;
-                        offer = DocumentPrivate::generatorForMimeType(mime, d->m_widget, triedOffers);
-                    } else {
-                        break;
-                    }
-                }
+    if (openResult == Document::OpenError && nextOpenOffer(m_asyncOpen.get())) {
+        startOpenDocumentAsync();
+        return;
+    }
+
+    if (openResult != Document::OpenSuccess) {
+        m_asyncOpen.reset();
+        Q_EMIT m_parent->documentOpened(openResult);
+        return;
+    }
+
+    if (!m_asyncOpen->triedOffers.isEmpty()) {
+        // some of the generators tried before may have errored out
+        Q_EMIT m_parent->error(QString(), -1);
+    }
+
+    // show the pages right away, what was saved about them comes next
+    setupOpenedDocument(*m_asyncOpen, true);
+    Q_EMIT m_parent->openProgress(i18n("Restoring annotations and forms…"));
+    Q_EMIT m_parent->documentOpened(Document::OpenSuccess);
+
+    const int serial = m_asyncOpenSerial;
+    QTimer::singleShot(0, m_parent, [this, serial] {
+        if (serial == m_asyncOpenSerial) {
+            finishOpenDocumentAsync();
+        }
+    });
+}
+
+void DocumentPrivate::finishOpenDocumentAsync()
+{
+    if (loadPageInfo()) {
+        // the views show the forms already, with the values they had in the file
+        for (Page *page : std::as_const(m_pagesVector)) {
+            const QList<FormField *> forms = page->formFields();
+            for (FormField *form : forms) {
+                Q_EMIT m_parent->refreshFormWidget(form);
             }
         }
+    }
+
+    executeDocumentOpenScripts();
+
+    m_asyncOpen.reset();
+    Q_EMIT m_parent->openFinished();
+}
+
+void DocumentPrivate::stopOpenDocumentAsync()
+{
+    if (!m_asyncOpen) {
+        return;
+    }
 
-        if (openResult == OpenSuccess) {
-            // Clear errors, since we're trying various generators, maybe one of them errored out
-            // but we finally succeeded
-            // TODO one can still see the error message animating out but since this is a very rare
-            //      condition we can leave this for future work
-            Q_EMIT error(QString(), -1);
+    ++m_asyncOpenSerial;
+    m_asyncOpenWaiting = false;
+    if (m_asyncOpenLoad) {
+        // generators can't be interrupted while loading, the load is discarded once it ends
+        Generator *generator = m_asyncOpenLoad->generator;
+        QObject::disconnect(generator, nullptr, m_parent, nullptr);
+        m_stoppedAsyncLoads.insert(generator, std::move(m_asyncOpenLoad));
+        m_asyncOpenGenerator = nullptr;
+    } else if (m_asyncOpenGenerator) {
+        if (m_asyncOpenResult == Document::OpenSuccess) {
+            m_asyncOpenGenerator->closeDocument();
         }
+        finishOpenDocumentInternal(m_asyncOpenGenerator, Document::OpenError, m_asyncOpenPages);
+        m_asyncOpenGenerator = nullptr;
+    } else if (m_generator) {
+        // the document is set up already, its annotations and forms have to be
+        // restored before the document info gets saved again
+        loadPageInfo();
     }
-    if (openResult != OpenSuccess) {
-        return openResult;
+    m_asyncOpen.reset();
+}
+
+void DocumentPrivate::discardAsyncLoad(AsyncLoad *load)
+{
+    if (load->result == Document::OpenSuccess) {
+        load->generator->closeDocument();
+    }
+    load->generator->d_func()->m_document = nullptr;
+    qDeleteAll(load->pages);
+    load->pages.clear();
+    delete load->tempFile;
+    load->tempFile = nullptr;
+
+    if (m_asyncOpenWaiting) {
+        m_asyncOpenWaiting = false;
+        startOpenDocumentAsync();
     }
+}
 
+void DocumentPrivate::waitForAsyncLoad(Generator *generator)
+{
+    const std::shared_ptr<AsyncLoad> load = m_stoppedAsyncLoads.take(generator);
+    if (load) {
+        load->thread->wait();
+        discardAsyncLoad(load.get());
+    }
+}
+
+void DocumentPrivate::setupOpenedDocument(const OpenRequest &request, bool deferPageInfo)
+{
     // no need to check for the existence of a synctex file, no parser will be
-    // created if none exists
-    d->m_synctex_scanner = synctex_scanner_new_with_output_file(QFile::encodeName(docFile).constData(), nullptr, 1);
-    if (!d->m_synctex_scanner && QFile::exists(docFile + QLatin1String("sync"))) {
-        d->loadSyncFile(docFile);
+    // created if none exists. Parsing happens on the first query, or in the
+    // background when building the sync index
+    m_synctex_scanner = synctex_scanner_new_with_output_file(QFile::encodeName(request.docFile).constData(), nullptr, 0);
+    if (m_synctex_scanner) {
+        startSyncIndexBuild(request.docFile, false);
+    } else if (QFile::exists(request.docFile + QLatin1String("sync"))) {
+        startSyncIndexBuild(request.docFile, true);
     }
 
-    d->m_generatorName = offer.pluginId();
-    d->m_pageController = new PageController();
-    connect(d->m_pageController, &PageController::rotationFinished, this, [this](int p, Okular::Page *op) { d->rotationFinished(p, op); });
+    m_generatorName = request.offer.pluginId();
+    m_pageController = new PageController();
+    QObject::connect(m_pageController, &PageController::rotationFinished, m_parent, [this](int p, Okular::Page *op) { rotationFinished(p, op); });
 
-    for (Page *p : std::as_const(d->m_pagesVector)) {
-        p->d->m_doc = d;
+    for (Page *p : std::as_const(m_pagesVector)) {
+        p->d->m_doc = this;
     }
 
-    d->m_docdataMigrationNeeded = false;
+    m_docdataMigrationNeeded = false;
 
     // 2. load Additional Data (bookmarks, local annotations and metadata) about the document
-    if (d->m_archiveData) {
-        // QTemporaryFile is weird and will return false in exists if fileName wasn't called before
-        d->m_archiveData->metadataFile.fileName();
-        d->loadDocumentInfo(d->m_archiveData->metadataFile, LoadPageInfo);
-        d->loadDocumentInfo(LoadGeneralInfo);
-    } else {
-        if (d->loadDocumentInfo(LoadPageInfo)) {
-            d->m_docdataMigrationNeeded = true;
-        }
-        d->loadDocumentInfo(LoadGeneralInfo);
+    if (!deferPageInfo) {
+        loadPageInfo();
     }
+    loadDocumentInfo(LoadGeneralInfo);
 
-    d->m_bookmarkManager->setUrl(d->m_url);
+    m_bookmarkManager->setUrl(m_url);
 
     // 3. setup observers internal lists and data
-    foreachObserver(notifySetup(d->m_pagesVector, DocumentObserver::DocumentChanged | DocumentObserver::UrlChanged));
+    foreachObserverD(notifySetup(m_pagesVector, DocumentObserver::DocumentChanged | DocumentObserver::UrlChanged));
 
     // 4. set initial page (restoring the page saved in xml if loaded)
-    DocumentViewport loadedViewport = (*d->m_viewportIterator);
+    DocumentViewport loadedViewport = (*m_viewportIterator);
     if (loadedViewport.isValid()) {
-        (*d->m_viewportIterator) = DocumentViewport();
-        if (loadedViewport.pageNumber >= (int)d->m_pagesVector.size()) {
-            loadedViewport.pageNumber = d->m_pagesVector.size() - 1;
+        (*m_viewportIterator) = DocumentViewport();
+        if (loadedViewport.pageNumber >= (int)m_pagesVector.size()) {
+            m_viewportBeyondPages = loadedViewport;
+            loadedViewport.pageNumber = m_pagesVector.size() - 1;
+            m_viewportBeyondPagesShownPage = loadedViewport.pageNumber;
         }
     } else {
         loadedViewport.pageNumber = 0;
     }
-    setViewport(loadedViewport);
+    m_parent->setViewport(loadedViewport);
 
     // start bookmark saver timer
-    if (!d->m_saveBookmarksTimer) {
-        d->m_saveBookmarksTimer = new QTimer(this);
-        connect(d->m_saveBookmarksTimer, &QTimer::timeout, this, [this] { d->saveDocumentInfo(); });
+    if (!m_saveBookmarksTimer) {
+        m_saveBookmarksTimer = new QTimer(m_parent);
+        QObject::connect(m_saveBookmarksTimer, &QTimer::timeout, m_parent, [this] { saveDocumentInfo(); });
     }
-    d->m_saveBookmarksTimer->start(5 * 60 * 1000);
+    m_saveBookmarksTimer->start(5 * 60 * 1000);
 
     // start memory check timer
-    if (!d->m_memCheckTimer) {
-        d->m_memCheckTimer = new QTimer(this);
-        connect(d->m_memCheckTimer, &QTimer::timeout, this, [this] { d->slotTimedMemoryCheck(); });
+    if (!m_memCheckTimer) {
+        m_memCheckTimer = new QTimer(m_parent);
+        QObject::connect(m_memCheckTimer, &QTimer::timeout, m_parent, [this] { slotTimedMemoryCheck(); });
     }
-    d->m_memCheckTimer->start(kMemCheckTime);
+    m_memCheckTimer->start(kMemCheckTime);
 
-    const DocumentViewport nextViewport = d->nextDocumentViewport();
+    const DocumentViewport nextViewport = nextDocumentViewport();
     if (nextViewport.isValid()) {
-        setViewport(nextViewport);
-        d->m_nextDocumentViewport = DocumentViewport();
-        d->m_nextDocumentDestination = QString();
+        m_parent->setViewport(nextViewport);
+        m_nextDocumentViewport = DocumentViewport();
+        m_nextDocumentDestination = QString();
+    }
+
+    AudioPlayer::instance()->setDocument(request.fromFileDescriptor ? QUrl() : m_url, m_parent);
+
+    if (!deferPageInfo) {
+        executeDocumentOpenScripts();
     }
+}
 
-    AudioPlayer::instance()->setDocument(fromFileDescriptor ? QUrl() : d->m_url, this);
+bool DocumentPrivate::loadPageInfo()
+{
+    if (m_archiveData) {
+        // QTemporaryFile is weird and will return false in exists if fileName wasn't called before
+        m_archiveData->metadataFile.fileName();
+        return loadDocumentInfo(m_archiveData->metadataFile, LoadPageInfo);
+    }
+
+    if (loadDocumentInfo(LoadPageInfo)) {
+        m_docdataMigrationNeeded = true;
+        return true;
+    }
+    return false;
+}
 
-    const QStringList docScripts = d->m_generator->metaData(QStringLiteral("DocumentScripts"), QStringLiteral("JavaScript")).toStringList();
+void DocumentPrivate::executeDocumentOpenScripts()
+{
+    const QStringList docScripts = m_generator->metaData(QStringLiteral("DocumentScripts"), QStringLiteral("JavaScript")).toStringList();
     if (!docScripts.isEmpty()) {
-        d->m_scripter = new Scripter(d);
+        m_scripter = new Scripter(this);
         for (const QString &docscript : docScripts) {
             std::shared_ptr<Event> event = Event::createDocEvent(Event::DocOpen);
-            d->executeScriptEvent(event, Okular::JavaScript, docscript);
+            executeScriptEvent(event, Okular::JavaScript, docscript);
         }
     }
-
-    return OpenSuccess;
 }
 
 bool DocumentPrivate::updateMetadataXmlNameAndDocSize()
@@ -2566,11 +2996,16 @@ KXMLGUIClient *Document::guiClient()
 
 void Document::closeDocument()
 {
+    d->stopOpenDocumentAsync();
+
     // check if there's anything to close...
     if (!d->m_generator) {
         return;
     }
 
+    // no more pages while closing, the docdata keeps those not loaded yet
+    d->m_generator->d_func()->stopLoading();
+
     if (const Okular::Action *action = d->m_generator->additionalDocumentAction(CloseDocument)) {
         processDocumentAction(action, CloseDocument);
     }
@@ -2633,6 +3068,7 @@ void Document::closeDocument()
         d->m_generator->closeDocument();
     }
 
+    d->stopSyncIndexBuild();
     if (d->m_synctex_scanner) {
         synctex_scanner_free(d->m_synctex_scanner);
         d->m_synctex_scanner = nullptr;
@@ -2678,6 +3114,7 @@ void Document::closeDocument()
     // delete pages and clear 'd->m_pagesVector' container
     qDeleteAll(d->m_pagesVector);
     d->m_pagesVector.clear();
+    d->clearCalculatedForms();
 
     // clear 'memory allocation' descriptors
     qDeleteAll(d->m_allocatedPixmaps);
@@ -2697,8 +3134,15 @@ void Document::closeDocument()
     d->m_viewportHistory.clear();
     d->m_viewportHistory.emplace_back();
     d->m_viewportIterator = d->m_viewportHistory.begin();
+    d->m_viewportBeyondPages = DocumentViewport();
+    d->m_pageElementsBeyondPages.clear();
     d->m_allocatedPixmapsTotalMemory = 0;
-    d->m_allocatedTextPagesFifo.clear();
+    d->m_allocatedTextPages.clear();
+    d->m_allocatedTextPagesTotalMemory = 0;
+    d->m_renderedPixmaps = 0;
+    d->m_renderTime = 0;
+    d->m_abortedPixmaps = 0;
+    d->m_hibernated = false;
     d->m_pageSize = PageSize();
     d->m_pageSizes.clear();
 
@@ -2833,6 +3277,77 @@ QString Document::editorCommandOverride() const
     return d->editorCommandOverride;
 }
 
+void Document::setInBackground(bool background)
+{
+    if (d->m_inBackground == background) {
+        return;
+    }
+    d->m_inBackground = background;
+
+    if (background) {
+        if (!d->m_hibernationTimer) {
+            d->m_hibernationTimer = new QTimer(this);
+            d->m_hibernationTimer->setSingleShot(true);
+            d->m_hibernationTimer->setInterval(kHibernationDelay);
+            connect(d->m_hibernationTimer, &QTimer::timeout, this, [this] { d->hibernate(); });
+        }
+        d->m_hibernationTimer->start();
+    } else {
+        if (d->m_hibernationTimer) {
+            d->m_hibernationTimer->stop();
+        }
+        if (d->m_hibernated) {
+            d->m_hibernated = false;
+            // the views ask again for their visible pixmaps first, and then preload the others
+            foreachObserver(notifyContentsCleared(DocumentObserver::Pixmap));
+        }
+    }
+}
+
+bool Document::isInBackground() const
+{
+    return d->m_inBackground;
+}
+
+MemoryStatistics Document::memoryStatistics() const
+{
+    MemoryStatistics statistics;
+
+    QHash<DocumentObserver *, MemoryStatistics::ObserverMemory> observers;
+    for (const AllocatedPixmap *p : d->m_allocatedPixmaps) {
+        MemoryStatistics::ObserverMemory &memory = observers[p->observer];
+        memory.observer = p->observer;
+        if (d->m_pagesVector.at(p->page)->d->tilesManager(p->observer)) {
+            memory.tileBytes += p->memory;
+        } else {
+            memory.pixmapBytes += p->memory;
+        }
+    }
+    statistics.observers = observers.values();
+
+    statistics.textPages = d->m_allocatedTextPages.count();
+    statistics.textPageBytes = d->m_allocatedTextPagesTotalMemory;
+
+    if (d->m_generator) {
+        const QVariantMap caches = d->m_generator->metaData(QStringLiteral("MemoryCaches"), QVariant()).toMap();
+        for (auto it = caches.cbegin(); it != caches.cend(); ++it) {
+            statistics.generatorCaches.insert(it.key(), it.value().toULongLong());
+        }
+    }
+
+    d->m_pixmapRequestsMutex.lock();
+    statistics.queuedRequests = d->m_pixmapRequestsStack.size();
+    statistics.executingRequests = d->m_executingPixmapRequests.size();
+    d->m_pixmapRequestsMutex.unlock();
+
+    statistics.generatorName = d->m_generatorName;
+    statistics.renderedPixmaps = d->m_renderedPixmaps;
+    statistics.averageRenderTime = d->m_renderedPixmaps > 0 ? d->m_renderTime / 1e6 / d->m_renderedPixmaps : 0;
+    statistics.abortedPixmaps = d->m_abortedPixmaps;
+
+    return statistics;
+}
+
 DocumentInfo Document::documentInfo() const
 {
     QSet<DocumentInfo::Key> keys;
@@ -3030,7 +3545,7 @@ bool Document::canExportToText() const
     }
 
     d->cacheExportFormats();
-    return !d->m_exportToText.isNull();
+    return !d->m_exportToText.isNull() || d->m_generator->hasFeature(Generator::TextExtraction);
 }
 
 bool Document::exportToText(const QString &fileName) const
@@ -3040,11 +3555,22 @@ bool Document::exportToText(const QString &fileName) const
     }
 
     d->cacheExportFormats();
-    if (d->m_exportToText.isNull()) {
+    if (!d->m_exportToText.isNull()) {
+        return d->m_generator->exportTo(fileName, d->m_exportToText);
+    }
+
+    // Without an export of its own, build the text from the text pages of the generator
+    if (!d->m_generator->hasFeature(Generator::TextExtraction)) {
         return false;
     }
 
-    return d->m_generator->exportTo(fileName, d->m_exportToText);
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    TextExporter exporter(d->m_generator, d->m_pagesVector);
+    return exporter.exportTo(&f);
 }
 
 ExportFormat::List Document::exportFormats() const
@@ -3076,7 +3602,7 @@ QVariant Document::metaData(const QString &key, const QVariant &option) const
 {
     // if option starts with "src:" assume that we are handling a
     // source reference
-    if (key == QLatin1String("NamedViewport") && option.toString().startsWith(QLatin1String("src:"), Qt::CaseInsensitive) && d->m_synctex_scanner) {
+    if (key == QLatin1String("NamedViewport") && option.toString().startsWith(QLatin1String("src:"), Qt::CaseInsensitive) && (d->m_synctex_scanner || d->m_syncIndex)) {
         const QString reference = option.toString();
 
         // The reference is of form "src:1111Filename", where "1111"
@@ -3107,8 +3633,24 @@ QVariant Document::metaData(const QString &key, const QVariant &option) const
             line = -1;
         }
 
-        // Use column == -1 for now.
-        if (synctex_display_query(d->m_synctex_scanner, QFile::encodeName(name).constData(), line, -1, 0) > 0) {
+        if (d->m_syncIndex) {
+            const SyncIndex::Point *point = d->m_syncIndex->findOutput(name, line);
+            if (point && point->page < int(d->m_pagesVector.size())) {
+                Okular::DocumentViewport view;
+                view.pageNumber = point->page;
+
+                const QSizeF dpi = d->m_generator->dpi();
+                const double unitsPerInch = d->m_syncIndex->unitsPerInch();
+                double px = (point->h * dpi.width()) / unitsPerInch;
+                double py = (point->v * dpi.height()) / unitsPerInch;
+                view.rePos.normalizedX = px / page(view.pageNumber)->width();
+                view.rePos.normalizedY = (py + 0.5) / page(view.pageNumber)->height();
+                view.rePos.enabled = true;
+                view.rePos.pos = Okular::DocumentViewport::Center;
+
+                return view.toString();
+            }
+        } else if (synctex_display_query(d->m_synctex_scanner, QFile::encodeName(name).constData(), line, -1, 0) > 0) {
             synctex_node_p node;
             // For now use the first hit. Could possibly be made smarter
             // in case there are multiple hits.
@@ -3294,18 +3836,26 @@ void Document::requestPixmaps(const QList<PixmapRequest *> &requests, PixmapRequ
     }
 
     // 1.B [PREPROCESS REQUESTS] tweak some values of the requests
+    QList<PixmapRequest *> pendingRequests;
+    QList<PixmapRequest *> downscaledRequests;
     for (PixmapRequest *request : requests) {
         // set the 'page field' (see PixmapRequest) and check if it is valid
         qCDebug(OkularCoreDebug).nospace() << "request observer=" << request->observer() << " " << request->width() << "x" << request->height() << "@" << request->pageNumber();
         if (d->m_pagesVector.value(request->pageNumber()) == nullptr) {
             // skip requests referencing an invalid page (must not happen)
             delete request;
-            request = nullptr;
             continue;
         }
 
         request->d->mPage = d->m_pagesVector.value(request->pageNumber());
 
+        // serve it right away if the page already has a good enough pixmap for someone else
+        if (d->downscaleExistingPixmap(request)) {
+            downscaledRequests.append(request);
+            continue;
+        }
+        pendingRequests.append(request);
+
         if (request->isTile()) {
             // Change the current request rect so that only invalid tiles are
             // requested. Also make sure the rect is tile-aligned.
@@ -3334,7 +3884,7 @@ void Document::requestPixmaps(const QList<PixmapRequest *> &requests, PixmapRequ
         for (PixmapRequest *executingRequest : std::as_const(d->m_executingPixmapRequests)) {
             bool newRequestsContainExecutingRequestPage = false;
             bool requestCancelled = false;
-            for (PixmapRequest *newRequest : requests) {
+            for (PixmapRequest *newRequest : std::as_const(pendingRequests)) {
                 if (newRequest->pageNumber() == executingRequest->pageNumber() && requesterObserver == executingRequest->observer()) {
                     newRequestsContainExecutingRequestPage = true;
                 }
@@ -3356,7 +3906,8 @@ void Document::requestPixmaps(const QList<PixmapRequest *> &requests, PixmapRequ
     }
 
     // 2. [ADD TO STACK] add requests to stack
-    for (PixmapRequest *request : requests) {
+    for (PixmapRequest *request : std::as_const(pendingRequests)) {
+        Tracing::instant("render", "request queued", {{"page", request->pageNumber()}, {"width", request->width()}, {"height", request->height()}, {"priority", request->priority()}});
         // add request to the 'stack' at the right place
         if (request->priority() == 0) {
             // add priority zero requests to the top of the stack
@@ -3371,6 +3922,11 @@ void Document::requestPixmaps(const QList<PixmapRequest *> &requests, PixmapRequ
     }
     d->m_pixmapRequestsMutex.unlock();
 
+    // 2.B [DOWNSCALED] account and notify the requests served from existing pixmaps
+    for (PixmapRequest *request : std::as_const(downscaledRequests)) {
+        d->requestDone(request);
+    }
+
     // 3. [START FIRST GENERATION] if <NO>generator is ready, start a new generation,
     // or else (if gen is running) it will be started when the new contents will
     // come from generator (in requestDone())</NO>
@@ -3397,12 +3953,50 @@ void Document::requestTextPage(uint pageNumber)
 
 void DocumentPrivate::notifyAnnotationChanges(int page)
 {
+    m_pagesVector[page]->d->annotationsChanged();
     foreachObserverD(notifyPageChanged(page, DocumentObserver::Annotations));
 }
 
-void DocumentPrivate::notifyFormChanges(int /*page*/)
+void DocumentPrivate::notifyFormChanges(const QList<FormField *> &forms)
 {
-    recalculateForms();
+    recalculateFormsDependingOn(forms);
+}
+
+void DocumentPrivate::appendPages(const QList<Page *> &pages)
+{
+    if (pages.isEmpty()) {
+        return;
+    }
+
+    for (Page *p : pages) {
+        p->d->m_doc = this;
+        m_pagesVector.append(p);
+    }
+    // the new pages may have calculated fields
+    clearCalculatedForms();
+
+    // restore the annotations and forms of the new pages, read when opening the document
+    QList<QDomElement> pageElementsBeyondPages;
+    for (const QDomElement &pageElement : std::as_const(m_pageElementsBeyondPages)) {
+        const int pageNumber = pageElement.attribute(QStringLiteral("number")).toInt();
+        if (pageNumber < m_pagesVector.count()) {
+            m_pagesVector[pageNumber]->d->restoreLocalContents(pageElement);
+        } else {
+            pageElementsBeyondPages.append(pageElement);
+        }
+    }
+    m_pageElementsBeyondPages = pageElementsBeyondPages;
+
+    foreachObserverD(notifySetup(m_pagesVector, DocumentObserver::PagesAppended));
+
+    // the document was left at a page that was not loaded yet when opening it,
+    // go there unless the user moved meanwhile
+    if (m_viewportBeyondPages.isValid() && m_viewportBeyondPages.pageNumber < m_pagesVector.count()) {
+        if ((*m_viewportIterator).pageNumber == m_viewportBeyondPagesShownPage) {
+            m_parent->setViewport(m_viewportBeyondPages);
+        }
+        m_viewportBeyondPages = DocumentViewport();
+    }
 }
 
 void Document::recalculateForms()
@@ -4550,7 +5144,7 @@ void Document::processKVCFActions(Okular::FormField *ff)
         ff->commitValue(ff->value().toString());
     }
 
-    recalculateForms();
+    d->recalculateFormsDependingOn({ff});
 
     if (const Okular::Action *action = ff->additionalAction(Okular::FormField::FormatField)) {
         processFormatAction(action, ff);
@@ -4732,12 +5326,21 @@ void Document::processSourceReference(const SourceReference &ref)
 
 const SourceReference *Document::dynamicSourceReference(int pageNr, double absX, double absY)
 {
+    const QSizeF dpi = d->m_generator->dpi();
+
+    if (d->m_syncIndex) {
+        const double unitsPerInch = d->m_syncIndex->unitsPerInch();
+        const SyncIndex::Point *point = d->m_syncIndex->findSource(pageNr, absX * unitsPerInch / dpi.width(), absY * unitsPerInch / dpi.height());
+        if (!point) {
+            return nullptr;
+        }
+        return new Okular::SourceReference(d->m_syncIndex->fileName(point->file), point->line, point->column);
+    }
+
     if (!d->m_synctex_scanner) {
         return nullptr;
     }
 
-    const QSizeF dpi = d->m_generator->dpi();
-
     if (synctex_edit_query(d->m_synctex_scanner, pageNr + 1, absX * 72. / dpi.width(), absY * 72. / dpi.height()) > 0) {
         synctex_node_p node;
         // TODO what should we do if there is really more than one node?
@@ -4999,6 +5602,8 @@ bool Document::swapBackingFile(const QString &newFileName, const QUrl &url)
             }
             qDeleteAll(newPagesVector);
             newPagesVector.clear();
+            // the form fields were replaced too
+            d->clearCalculatedForms();
         }
 
         d->m_url = url;
@@ -5010,9 +5615,13 @@ bool Document::swapBackingFile(const QString &newFileName, const QUrl &url)
 
         if (d->m_synctex_scanner) {
             synctex_scanner_free(d->m_synctex_scanner);
-            d->m_synctex_scanner = synctex_scanner_new_with_output_file(QFile::encodeName(newFileName).constData(), nullptr, 1);
-            if (!d->m_synctex_scanner && QFile::exists(newFileName + QLatin1String("sync"))) {
-                d->loadSyncFile(newFileName);
+            d->m_synctex_scanner = synctex_scanner_new_with_output_file(QFile::encodeName(newFileName).constData(), nullptr, 0);
+            if (d->m_synctex_scanner) {
+                d->startSyncIndexBuild(newFileName, false);
+            } else if (QFile::exists(newFileName + QLatin1String("sync"))) {
+                d->startSyncIndexBuild(newFileName, true);
+            } else {
+                d->stopSyncIndexBuild();
             }
         }
 
@@ -5495,6 +6104,40 @@ void DocumentPrivate::executeScript(const QString &function)
     m_scripter->execute(nullptr, JavaScript, function);
 }
 
+bool DocumentPrivate::downscaleExistingPixmap(PixmapRequest *request)
+{
+    if (!(request->d->mFeatures & PixmapRequest::AllowDownscale) || request->isTile() || !request->normalizedRect().isNull()) {
+        return false;
+    }
+
+    // setPixmap() would rotate the already rotated pixmaps of the other observers again
+    const Page *page = request->d->mPage;
+    if (page->rotation() != Rotation0) {
+        return false;
+    }
+
+    // pick the smallest complete pixmap that is not smaller than the request, never upscale
+    const QPixmap *source = nullptr;
+    for (auto it = page->d->m_pixmaps.cbegin(), end = page->d->m_pixmaps.cend(); it != end; ++it) {
+        const QPixmap *pixmap = it.value().m_pixmap;
+        if (it.key() == request->observer() || !pixmap || it.value().m_isPartialPixmap) {
+            continue;
+        }
+        if (pixmap->width() < request->width() || pixmap->height() < request->height()) {
+            continue;
+        }
+        if (!source || pixmap->width() < source->width()) {
+            source = pixmap;
+        }
+    }
+    if (!source) {
+        return false;
+    }
+
+    request->d->mPage->setPixmap(request->observer(), new QPixmap(source->scaled(request->width(), request->height(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation)));
+    return true;
+}
+
 void DocumentPrivate::requestDone(PixmapRequest *req)
 {
     if (!req) {
@@ -5560,8 +6203,17 @@ void DocumentPrivate::requestDone(PixmapRequest *req)
 
     // 3. delete request
     m_pixmapRequestsMutex.lock();
-    m_executingPixmapRequests.remove(req);
+    const bool executing = m_executingPixmapRequests.remove(req) > 0;
     m_pixmapRequestsMutex.unlock();
+    if (executing) {
+        Tracing::asyncEnd("render", "pixmap request", req, {{"aborted", req->shouldAbortRender()}});
+        if (!req->shouldAbortRender()) {
+            ++m_renderedPixmaps;
+            m_renderTime += req->d->mSentTimer.nsecsElapsed();
+        } else {
+            ++m_abortedPixmaps;
+        }
+    }
 
     delete req;
     req = nullptr;
@@ -5624,17 +6276,22 @@ void DocumentPrivate::textGenerationDone(Page *page)
         return;
     }
 
-    // 1. If we reached the cache limit, delete the first text page from the fifo
-    if (m_allocatedTextPagesFifo.size() == m_maxAllocatedTextPages) {
-        int pageToKick = m_allocatedTextPagesFifo.takeFirst();
-        if (pageToKick != page->number()) // this should never happen but better be safe than sorry
-        {
-            m_pagesVector.at(pageToKick)->setTextPage(nullptr); // deletes the textpage
+    // 1. A text page generated again replaces the previous one, otherwise
+    // if we reached the cache limit delete the one farthest from the viewport
+    const auto it = m_allocatedTextPages.constFind(page->number());
+    if (it != m_allocatedTextPages.constEnd()) {
+        m_allocatedTextPagesTotalMemory -= it.value();
+    } else if (m_allocatedTextPages.count() >= m_maxAllocatedTextPages) {
+        const int pageToKick = searchLowestPriorityTextPage();
+        if (pageToKick != -1) {
+            releaseTextPage(pageToKick);
         }
     }
 
-    // 2. Add the page to the fifo of generated text pages
-    m_allocatedTextPagesFifo.append(page->number());
+    // 2. Account for the memory of the new text page
+    const qulonglong memory = page->d->textPageMemory();
+    m_allocatedTextPages.insert(page->number(), memory);
+    m_allocatedTextPagesTotalMemory += memory;
 }
 
 void Document::setRotation(int r)
@@ -6070,6 +6727,19 @@ VisiblePageRect::VisiblePageRect(int page, const NormalizedRect &rectangle)
 {
 }
 
+/** MemoryStatistics **/
+
+MemoryStatistics::MemoryStatistics()
+    : textPages(0)
+    , textPageBytes(0)
+    , queuedRequests(0)
+    , executingRequests(0)
+    , renderedPixmaps(0)
+    , averageRenderTime(0)
+    , abortedPixmaps(0)
+{
+}
+
 /** NewSignatureData **/
 
 struct Okular::NewSignatureDataPrivate {
@@ -19,6 +19,7 @@
 
 #include <QDomDocument>
 #include <QList>
+#include <QMap>
 #include <QObject>
 #include <QPrinter>
 #include <QStringList>
@@ -53,6 +54,7 @@ class FormFieldChoice;
 class Generator;
 class Action;
 class MovieAction;
+class MemoryStatistics;
 class Page;
 class PixmapRequest;
 class RenditionAction;
@@ -220,6 +222,30 @@ public:
      */
     OpenResult openDocument(const QString &docFile, const QUrl &url, const QMimeType &mime, const QString &password = QString());
 
+    /**
+     * Opens the document without blocking the GUI thread.
+     *
+     * Generators with the Generator::ThreadedLoading feature load the document
+     * in a thread of their own, the others once the event loop runs again.
+     * openProgress() tells how the opening goes, and documentOpened() is emitted
+     * as soon as the pages are set up, so that the visible ones can be rendered
+     * while the annotations and forms saved for the document are restored and
+     * the document scripts run. openFinished() is emitted after that.
+     *
+     * Closing the document or opening another one stops the opening, without
+     * documentOpened() or openFinished() being emitted for it.
+     *
+     * @since 26.12
+     */
+    void openDocumentAsync(const QString &docFile, const QUrl &url, const QMimeType &mime, const QString &password = QString());
+
+    /**
+     * Returns whether an opening started with openDocumentAsync() has not finished yet.
+     *
+     * @since 26.12
+     */
+    bool isOpening() const;
+
     /**
      * Closes the document.
      */
@@ -1145,6 +1171,35 @@ public:
      */
     QString editorCommandOverride() const;
 
+    /**
+     * Returns what the document holds in memory right now, and how fast
+     * its pixmaps are rendered.
+     *
+     * @since 26.12
+     */
+    MemoryStatistics memoryStatistics() const;
+
+    /**
+     * Sets whether the document is in the @p background, like in a tab that
+     * is not shown.
+     *
+     * The documents of the process share a memory budget. Those in the
+     * background give back their memory first, and after a while they keep
+     * only their visible pixmaps and a few others. Once back in the
+     * foreground, the observers are asked to request their visible pixmaps
+     * again.
+     *
+     * @since 26.12
+     */
+    void setInBackground(bool background);
+
+    /**
+     * Returns whether the document is in the background.
+     *
+     * @since 26.12
+     */
+    bool isInBackground() const;
+
 public Q_SLOTS:
     /**
      * This slot is called whenever the user changes the @p rotation of
@@ -1239,6 +1294,30 @@ public Q_SLOTS:
     void refreshPixmaps(int pageNumber);
 
 Q_SIGNALS:
+    /**
+     * This signal is emitted while openDocumentAsync() opens a document,
+     * with a @p message describing what it is doing.
+     *
+     * @since 26.12
+     */
+    void openProgress(const QString &message);
+
+    /**
+     * This signal is emitted when openDocumentAsync() has set up the pages of
+     * the document, or failed to open it according to @p result.
+     *
+     * @since 26.12
+     */
+    void documentOpened(Okular::Document::OpenResult result);
+
+    /**
+     * This signal is emitted after documentOpened() once the annotations and
+     * forms saved for the document are restored and the document scripts ran.
+     *
+     * @since 26.12
+     */
+    void openFinished();
+
     /**
      * This signal is emitted whenever the document is about to close.
      * @since 1.5.3
@@ -1647,6 +1726,63 @@ public:
     NormalizedRect rect;
 };
 
+/**
+ * @short What a document holds in memory, see Document::memoryStatistics()
+ *
+ * @since 26.12
+ */
+class OKULARCORE_EXPORT MemoryStatistics
+{
+public:
+    MemoryStatistics();
+
+    /**
+     * The memory used by the pixmaps of an observer.
+     */
+    struct ObserverMemory {
+        DocumentObserver *observer = nullptr;
+        qulonglong pixmapBytes = 0; // whole page pixmaps
+        qulonglong tileBytes = 0; // pixmaps of pages rendered in tiles
+    };
+
+    /**
+     * The observers holding pixmaps.
+     */
+    QList<ObserverMemory> observers;
+
+    /**
+     * The number of text pages and the memory they use.
+     */
+    int textPages;
+    qulonglong textPageBytes;
+
+    /**
+     * The caches of the generator, by name, and the memory they use.
+     * Generators report them as the "MemoryCaches" meta data.
+     */
+    QMap<QString, qulonglong> generatorCaches;
+
+    /**
+     * The pixmap requests waiting for the generator, and being rendered by it.
+     */
+    int queuedRequests;
+    int executingRequests;
+
+    /**
+     * The generator of the document, and the number of pixmaps it rendered
+     * with the average time from sending a request to getting its pixmap.
+     */
+    QString generatorName;
+    int renderedPixmaps;
+    double averageRenderTime; // in milliseconds
+
+    /**
+     * The pixmap requests cancelled while the generator was rendering them,
+     * see PixmapRequest::shouldAbortRender().
+     */
+    int abortedPixmaps;
+};
+
 /**
  * @short Data needed to create a new signature
  *
@@ -12,6 +12,7 @@
 #include "script/event_p.h"
 
 #include "synctex/synctex_parser.h"
+#include <atomic>
 #include <memory>
 
 // qt/kde/system includes
@@ -19,6 +20,7 @@
 #include <KPluginMetaData>
 #include <QHash>
 #include <QMap>
+#include <QMimeType>
 #include <QMutex>
 #include <QPointer>
 #include <QUrl>
@@ -26,7 +28,9 @@
 // local includes
 #include "fontinfo.h"
 #include "generator.h"
+#include "syncindex_p.h"
 
+class QThread;
 class QUndoStack;
 class QEventLoop;
 class QFile;
@@ -40,6 +44,7 @@ struct RunningSearch;
 
 namespace Okular
 {
+class FormField;
 class ScriptAction;
 class ConfigInterface;
 class PageController;
@@ -79,6 +84,36 @@ enum LoadDocumentInfoFlag {
 };
 Q_DECLARE_FLAGS(LoadDocumentInfoFlags, LoadDocumentInfoFlag)
 
+/**
+ * A document being opened: the file, and the generator to try it with
+ * after the ones that failed already.
+ */
+struct OpenRequest {
+    QString docFile;
+    QUrl url;
+    QMimeType mime;
+    QString password;
+    QByteArray filedata; // the contents of the file descriptor
+    bool fromFileDescriptor = false;
+    bool triedMimeFromFileContent = false;
+    KPluginMetaData offer;
+    QList<KPluginMetaData> triedOffers;
+};
+
+/**
+ * A generator loading a document in a thread for Document::openDocumentAsync().
+ * The thread owns what it loads with: when the opening is stopped, the load is
+ * left to end on its own and what it loaded is discarded then.
+ */
+struct AsyncLoad {
+    Generator *generator = nullptr;
+    OpenRequest request;
+    QTemporaryFile *tempFile = nullptr;
+    QThread *thread = nullptr;
+    QList<Page *> pages;
+    Document::OpenResult result = Document::OpenError;
+};
+
 class DocumentPrivate
 {
 public:
@@ -88,6 +123,7 @@ public:
         , m_tempFile(nullptr)
         , m_docSize(-1)
         , m_allocatedPixmapsTotalMemory(0)
+        , m_allocatedTextPagesTotalMemory(0)
         , m_maxAllocatedTextPages(0)
         , m_warnedOutOfMemory(false)
         , m_rotation(Rotation0)
@@ -117,10 +153,22 @@ public:
     QString pagesSizeString() const;
     QString namePaperSize(double inchesWidth, double inchesHeight) const;
     QString localizedSize(const QSizeF size) const;
+    static qulonglong sharedAllocatedMemory();
     qulonglong calculateMemoryToFree();
     void cleanupPixmapMemory();
     void cleanupPixmapMemory(qulonglong memoryToFree);
+    /**
+     * Frees @p memoryToFree bytes of this document only, while cleanupPixmapMemory()
+     * first takes them from the documents in the background.
+     */
+    void cleanupOwnPixmapMemory(qulonglong memoryToFree);
+    /**
+     * Keeps only the visible pixmaps and a few others of a document in the background.
+     */
+    void hibernate();
     AllocatedPixmap *searchLowestPriorityPixmap(bool unloadableOnly = false, bool thenRemoveIt = false, DocumentObserver *observer = nullptr /* any */);
+    int searchLowestPriorityTextPage() const;
+    void releaseTextPage(int page);
     void calculateMaxTextPages();
     qulonglong getTotalMemory();
     qulonglong getFreeMemory(qulonglong *freeSwap = nullptr);
@@ -142,17 +190,43 @@ public:
     void setRotationInternal(int r, bool notify);
     ConfigInterface *generatorConfig(GeneratorInfo &info);
     SaveInterface *generatorSave(GeneratorInfo &info);
-    Document::OpenResult openDocumentInternal(const KPluginMetaData &offer, bool isstdin, const QString &docFile, const QByteArray &filedata, const QString &password);
+    bool prepareOpen(OpenRequest *request, const QString &docFile, const QUrl &url, const QMimeType &mime, const QString &password);
+    bool nextOpenOffer(OpenRequest *request);
+    Generator *prepareGenerator(const OpenRequest &request);
+    Generator *loadedGeneratorFor(const OpenRequest &request) const;
+    /**
+     * Lets @p generator load the document of @p request into @p pagesVector, through
+     * @p tempFile for the generators that can't read raw data.
+     * Runs in a thread of its own for the generators with the ThreadedLoading feature.
+     */
+    static Document::OpenResult loadDocumentWith(Generator *generator, const OpenRequest &request, QTemporaryFile *tempFile, QList<Page *> &pagesVector);
+    Document::OpenResult finishOpenDocumentInternal(Generator *generator, Document::OpenResult openResult, QList<Page *> &pagesVector);
+    Document::OpenResult openDocumentInternal(const OpenRequest &request);
+    /**
+     * Sets up the document that was just opened and the observers. The annotations
+     * and forms saved for it and the document scripts are left for later if
+     * @p deferPageInfo is true, see finishOpenDocument().
+     */
+    void setupOpenedDocument(const OpenRequest &request, bool deferPageInfo);
+    bool loadPageInfo();
+    void executeDocumentOpenScripts();
+    void startOpenDocumentAsync();
+    void openDocumentAsyncLoaded();
+    void finishOpenDocumentAsync();
+    void stopOpenDocumentAsync();
+    void discardAsyncLoad(AsyncLoad *load);
+    void waitForAsyncLoad(Generator *generator);
     static ArchiveData *unpackDocumentArchive(const QString &archivePath);
     bool savePageDocumentInfo(QTemporaryFile *infoFile, int what) const;
     DocumentViewport nextDocumentViewport() const;
     void notifyAnnotationChanges(int page);
-    void notifyFormChanges(int page);
+    void notifyFormChanges(const QList<FormField *> &forms);
     bool canAddAnnotationsNatively() const;
     bool canModifyExternalAnnotations() const;
     bool canRemoveExternalAnnotations() const;
     OKULARCORE_EXPORT static QString docDataFileName(const QUrl &url, qint64 document_size);
     bool cancelRenderingBecauseOf(PixmapRequest *executingRequest, PixmapRequest *newRequest);
+    bool downscaleExistingPixmap(PixmapRequest *request);
 
     // Methods that implement functionality needed by undo commands
     void performAddPageAnnotation(int page, Annotation *annotation);
@@ -161,6 +235,22 @@ public:
     void performSetAnnotationContents(const QString &newContents, Annotation *annot, int pageNumber);
 
     void recalculateForms();
+    /**
+     * Recalculates the form fields whose calculate action read the value
+     * of one of @p forms the last time it ran, and then the ones depending
+     * on those, and so on.
+     */
+    void recalculateFormsDependingOn(const QList<FormField *> &forms);
+    void recalculateForms(QSet<QString> *changedForms);
+    bool calculateForm(FormField *form, Page *page, QSet<QString> *readForms, bool *pageNeedsRefresh);
+    void buildCalculatedForms();
+    void clearCalculatedForms();
+
+    /**
+     * Adds @p pages at the end of the document, for generators that go on
+     * loading the document after it was opened.
+     */
+    void appendPages(const QList<Page *> &pages);
 
     // private slots
     void saveDocumentInfo() const;
@@ -212,7 +302,9 @@ public:
     bool isNormalizedRectangleFullyVisible(const Okular::NormalizedRect &rectOfInterest, int rectPage);
 
     // For sync files
-    void loadSyncFile(const QString &filePath);
+    void startSyncIndexBuild(const QString &docFile, bool pdfSync);
+    void stopSyncIndexBuild();
+    void applyPdfSyncSourceReferences();
 
     void clearAndWaitForRequests();
 
@@ -251,6 +343,11 @@ public:
     std::list<DocumentViewport> m_viewportHistory;
     std::list<DocumentViewport>::iterator m_viewportIterator;
     DocumentViewport m_nextDocumentViewport; // see Link::Goto for an explanation
+    // restored viewport on a page not loaded yet and the page shown meanwhile, see appendPages()
+    DocumentViewport m_viewportBeyondPages;
+    int m_viewportBeyondPagesShownPage = -1;
+    // the docdata of the pages not loaded yet, restored by appendPages() or saved back as they were
+    QList<QDomElement> m_pageElementsBeyondPages;
     QString m_nextDocumentDestination;
 
     // observers / requests / allocator stuff
@@ -261,9 +358,20 @@ public:
     QMutex m_pixmapRequestsMutex;
     std::list<AllocatedPixmap *> m_allocatedPixmaps;
     qulonglong m_allocatedPixmapsTotalMemory;
-    QList<int> m_allocatedTextPagesFifo;
+    // page number -> memory used by its text page
+    QMap<int, qulonglong> m_allocatedTextPages;
+    qulonglong m_allocatedTextPagesTotalMemory;
     int m_maxAllocatedTextPages;
     bool m_warnedOutOfMemory;
+    // pixmaps rendered by the generator, and the time it took from sending their requests
+    int m_renderedPixmaps = 0;
+    qint64 m_renderTime = 0; // in nanoseconds
+    // pixmap requests cancelled while the generator was rendering them
+    int m_abortedPixmaps = 0;
+    // whether the document is not shown, see Document::setInBackground()
+    bool m_inBackground = false;
+    bool m_hibernated = false;
+    QTimer *m_hibernationTimer = nullptr;
 
     // the rotation applied to the document
     Rotation m_rotation;
@@ -300,6 +408,21 @@ public:
 
     Scripter *m_scripter;
 
+    // the fields with a calculate action, in calculation order, and the
+    // fully qualified names of the fields whose value their action read
+    struct CalculatedForm {
+        FormField *form;
+        Page *page;
+        QSet<QString> dependencies;
+        bool calculated;
+    };
+    QList<CalculatedForm> m_calculatedForms;
+    bool m_calculatedFormsBuilt = false;
+    // where JSField notes the fields read by the calculate action running
+    QSet<QString> *m_readFormFields = nullptr;
+    // where JSField notes the fields written while recalculating only the changed ones
+    QSet<QString> *m_changedFormFields = nullptr;
+
     ArchiveData *m_archiveData;
     QString m_archivedFileName;
 
@@ -325,9 +448,28 @@ public:
     bool m_docdataMigrationNeeded;
 
     synctex_scanner_p m_synctex_scanner;
+    // Index of the SyncTeX/pdfsync file, built in the background after opening.
+    // Until it is ready lookups fall back to m_synctex_scanner
+    std::unique_ptr<SyncIndex> m_syncIndex;
+    QThread *m_syncIndexThread = nullptr;
+    std::atomic<bool> m_syncIndexAbort = false;
 
     QString m_openError;
 
+    // the document being opened by Document::openDocumentAsync(), until it is set up
+    // and its annotations and forms are restored
+    std::unique_ptr<OpenRequest> m_asyncOpen;
+    Generator *m_asyncOpenGenerator = nullptr;
+    QList<Page *> m_asyncOpenPages;
+    Document::OpenResult m_asyncOpenResult = Document::OpenError;
+    std::shared_ptr<AsyncLoad> m_asyncOpenLoad;
+    // whether the opening waits for its generator to end a load that was stopped
+    bool m_asyncOpenWaiting = false;
+    // the loads of the stopped openings still running, by generator
+    QHash<Generator *, std::shared_ptr<AsyncLoad>> m_stoppedAsyncLoads;
+    // bumped when an opening is stopped, so that what it left queued knows to do nothing
+    int m_asyncOpenSerial = 0;
+
     // generator selection
     static QList<KPluginMetaData> availableGenerators();
     static KPluginMetaData generatorForMimeType(const QMimeType &type, QWidget *widget, const QList<KPluginMetaData> &triedOffers = QList<KPluginMetaData>());
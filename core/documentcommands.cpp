@@ -499,7 +499,7 @@ void EditFormListCommand::undo()
     moveViewportIfBoundingRectNotFullyVisible(m_form->rect(), m_docPriv, m_pageNumber);
     m_form->setCurrentChoices(m_prevChoices);
     Q_EMIT m_docPriv->m_parent->formListChangedByUndoRedo(m_pageNumber, m_form, m_prevChoices);
-    m_docPriv->notifyFormChanges(m_pageNumber);
+    m_docPriv->notifyFormChanges({m_form});
 }
 
 void EditFormListCommand::redo()
@@ -507,7 +507,7 @@ void EditFormListCommand::redo()
     moveViewportIfBoundingRectNotFullyVisible(m_form->rect(), m_docPriv, m_pageNumber);
     m_form->setCurrentChoices(m_newChoices);
     Q_EMIT m_docPriv->m_parent->formListChangedByUndoRedo(m_pageNumber, m_form, m_newChoices);
-    m_docPriv->notifyFormChanges(m_pageNumber);
+    m_docPriv->notifyFormChanges({m_form});
 }
 
 bool EditFormListCommand::refreshInternalPageReferences(const QList<Page *> &newPagesVector)
@@ -605,47 +605,33 @@ EditFormButtonsCommand::EditFormButtonsCommand(Okular::DocumentPrivate *docPriv,
 void EditFormButtonsCommand::undo()
 {
     clearFormButtonStates();
-    QSet<int> extraPages;
     for (int i = 0; i < m_formButtons.size(); i++) {
         bool checked = m_prevButtonStates.at(i);
         if (checked) {
             m_formButtons.at(i)->setState(checked);
         }
-        if (m_pageNumbers.at(i) != m_pageNumber) {
-            extraPages << m_pageNumbers.at(i);
-        }
     }
 
     Okular::NormalizedRect boundingRect = buildBoundingRectangleForButtons(m_formButtons);
     moveViewportIfBoundingRectNotFullyVisible(boundingRect, m_docPriv, m_pageNumber);
     Q_EMIT m_docPriv->m_parent->formButtonsChangedByUndoRedo(m_pageNumber, m_formButtons);
-    m_docPriv->notifyFormChanges(m_pageNumber);
-    for (auto page : std::as_const(extraPages)) {
-        m_docPriv->notifyFormChanges(page);
-    }
+    m_docPriv->notifyFormChanges(QList<FormField *>(m_formButtons.cbegin(), m_formButtons.cend()));
 }
 
 void EditFormButtonsCommand::redo()
 {
     clearFormButtonStates();
-    QSet<int> extraPages;
     for (int i = 0; i < m_formButtons.size(); i++) {
         bool checked = m_newButtonStates.at(i);
         if (checked) {
             m_formButtons.at(i)->setState(checked);
         }
-        if (m_pageNumbers.at(i) != m_pageNumber) {
-            extraPages << m_pageNumbers.at(i);
-        }
     }
 
     Okular::NormalizedRect boundingRect = buildBoundingRectangleForButtons(m_formButtons);
     moveViewportIfBoundingRectNotFullyVisible(boundingRect, m_docPriv, m_pageNumber);
     Q_EMIT m_docPriv->m_parent->formButtonsChangedByUndoRedo(m_pageNumber, m_formButtons);
-    m_docPriv->notifyFormChanges(m_pageNumber);
-    for (auto page : std::as_const(extraPages)) {
-        m_docPriv->notifyFormChanges(page);
-    }
+    m_docPriv->notifyFormChanges(QList<FormField *>(m_formButtons.cbegin(), m_formButtons.cend()));
 }
 
 bool EditFormButtonsCommand::refreshInternalPageReferences(const QList<Okular::Page *> &newPagesVector)
@@ -32,6 +32,7 @@
 #include "page.h"
 #include "page_p.h"
 #include "textpage.h"
+#include "tracing_p.h"
 #include "utils.h"
 
 using namespace Okular;
@@ -169,6 +170,10 @@ QImage GeneratorPrivate::image(PixmapRequest *)
     return QImage();
 }
 
+void GeneratorPrivate::stopLoading()
+{
+}
+
 Generator::Generator(QObject *parent, const QVariantList &args)
     : Generator(*new GeneratorPrivate(), parent, args)
 {
@@ -314,7 +319,11 @@ void Generator::generatePixmap(PixmapRequest *request)
         return;
     }
 
-    const QImage &img = image(request);
+    QImage img;
+    {
+        const Tracing::Scope scope("render", "generate pixmap", {{"page", request->pageNumber()}, {"width", request->width()}, {"height", request->height()}, {"tile", request->isTile()}});
+        img = image(request);
+    }
     request->page()->setPixmap(request->observer(), new QPixmap(QPixmap::fromImage(img)), request->normalizedRect());
     const int pageNumber = request->page()->number();
 
@@ -334,6 +343,7 @@ bool Generator::canGenerateTextPage() const
 
 void Generator::generateTextPage(Page *page)
 {
+    const Tracing::Scope scope("text", "extract text", {{"page", page->number()}});
     TextRequest treq(page);
     TextPage *tp = textPage(&treq);
     page->setTextPage(tp);
@@ -482,6 +492,8 @@ void Generator::signalPartialPixmapRequest(PixmapRequest *request, const QImage
         return;
     }
 
+    Tracing::instant("render", "partial update", {{"page", request->pageNumber()}, {"width", request->width()}, {"height", request->height()}});
+
     PagePrivate *pagePrivate = PagePrivate::get(request->page());
     pagePrivate->setPixmap(request->observer(), new QPixmap(QPixmap::fromImage(image)), request->normalizedRect(), true /* isPartialPixmap */);
 
@@ -593,6 +605,48 @@ TextRequestPrivate *TextRequestPrivate::get(const TextRequest *req)
     return req->d;
 }
 
+// nothing is shown for renders shorter than this, like the Poppler generator does
+static const qint64 partialUpdateDelay = 500;
+// and after that, partial images are shown this often at most
+static const qint64 partialUpdateInterval = 250;
+
+PartialPixmapUpdater::PartialPixmapUpdater(Generator *generator, PixmapRequest *request)
+    : d(new PartialPixmapUpdaterPrivate)
+{
+    d->mGenerator = generator;
+    d->mRequest = request;
+    d->mLastUpdate = -partialUpdateInterval;
+    d->mTimer.start();
+}
+
+PartialPixmapUpdater::~PartialPixmapUpdater()
+{
+    delete d;
+}
+
+bool PartialPixmapUpdater::shouldUpdate() const
+{
+    if (!d->mRequest->partialUpdatesWanted() || d->mRequest->shouldAbortRender()) {
+        return false;
+    }
+
+    const qint64 elapsed = d->mTimer.elapsed();
+    return elapsed >= partialUpdateDelay && elapsed - d->mLastUpdate >= partialUpdateInterval;
+}
+
+void PartialPixmapUpdater::update(const QImage &image)
+{
+    if (!shouldUpdate()) {
+        return;
+    }
+
+    d->mLastUpdate = d->mTimer.elapsed();
+    // a deep copy, the generator is still painting on the image
+    // clang-format off
+    QMetaObject::invokeMethod(d->mGenerator, "signalPartialPixmapRequest", Qt::QueuedConnection, Q_ARG(Okular::PixmapRequest*, d->mRequest), Q_ARG(QImage, image.copy()));
+    // clang-format on
+}
+
 PixmapRequest::PixmapRequest(DocumentObserver *observer, int pageNumber, int width, int height, qreal dpr, int priority, PixmapRequestFeatures features)
     : d(new PixmapRequestPrivate)
 {
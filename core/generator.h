@@ -53,6 +53,7 @@ class TextPage;
 class TextRequest;
 class TextRequestPrivate;
 class NormalizedRect;
+class PartialPixmapUpdaterPrivate;
 
 /* Note: on contents generation and asynchronous queries.
  * Many observers may want to request data synchronously or asynchronously.
@@ -185,6 +186,7 @@ class OKULARCORE_EXPORT Generator : public QObject
     /// @cond PRIVATE
     friend class PixmapGenerationThread;
     friend class TextPageGenerationThread;
+    friend class TextExporter;
     /// @endcond
 
     Q_OBJECT
@@ -195,17 +197,18 @@ public:
      * provide.
      */
     enum GeneratorFeature {
-        Threaded,          ///< Whether the Generator supports asynchronous generation of pictures or text pages
-        TextExtraction,    ///< Whether the Generator can extract text from the document in the form of TextPage's
-        ReadRawData,       ///< Whether the Generator can read a document directly from its raw data.
-        FontInfo,          ///< Whether the Generator can provide information about the fonts used in the document
-        PageSizes,         ///< Whether the Generator can change the size of the document pages.
-        PrintNative,       ///< Whether the Generator supports native cross-platform printing (QPainter-based).
-        PrintPostscript,   ///< Whether the Generator supports postscript-based file printing.
-        PrintToFile,       ///< Whether the Generator supports export to PDF & PS through the Print Dialog
-        TiledRendering,    ///< Whether the Generator can render tiles @since 0.16 (KDE 4.10)
-        SwapBackingFile,   ///< Whether the Generator can hot-swap the file it's reading from @since 1.3
-        SupportsCancelling ///< Whether the Generator can cancel requests @since 1.4
+        Threaded,           ///< Whether the Generator supports asynchronous generation of pictures or text pages
+        TextExtraction,     ///< Whether the Generator can extract text from the document in the form of TextPage's
+        ReadRawData,        ///< Whether the Generator can read a document directly from its raw data.
+        FontInfo,           ///< Whether the Generator can provide information about the fonts used in the document
+        PageSizes,          ///< Whether the Generator can change the size of the document pages.
+        PrintNative,        ///< Whether the Generator supports native cross-platform printing (QPainter-based).
+        PrintPostscript,    ///< Whether the Generator supports postscript-based file printing.
+        PrintToFile,        ///< Whether the Generator supports export to PDF & PS through the Print Dialog
+        TiledRendering,     ///< Whether the Generator can render tiles @since 0.16 (KDE 4.10)
+        SwapBackingFile,    ///< Whether the Generator can hot-swap the file it's reading from @since 1.3
+        SupportsCancelling, ///< Whether the Generator can cancel requests @since 1.4
+        ThreadedLoading     ///< Whether the Generator can load documents outside of the GUI thread @since 26.12
     };
 
     /**
@@ -224,6 +227,11 @@ public:
      *
      * @note If you implement the WithPassword variants you don't need to implement this one
      *
+     * @note With the feature @ref ThreadedLoading enabled the loading happens in a thread
+     * other than the GUI one, so it must not create QObjects with the generator as parent
+     * nor read the settings, which the configuration dialog may change meanwhile: the
+     * Document calls ConfigInterface::reparseConfig() in the GUI thread once it is loaded.
+     *
      * @returns true on success, false otherwise.
      */
     virtual bool loadDocument(const QString &fileName, QList<Page *> &pagesVector);
@@ -444,6 +452,9 @@ public:
     /**
      * This method returns the meta data of the given @p key with the given @p option
      * of the document.
+     *
+     * Since 26.12 the "MemoryCaches" key asks for the internal caches of the
+     * generator, as a QVariantMap of their names to the bytes they use.
      */
     virtual QVariant metaData(const QString &key, const QVariant &option) const;
 
@@ -660,7 +671,11 @@ class OKULARCORE_EXPORT PixmapRequest
     friend class DocumentPrivate;
 
 public:
-    enum PixmapRequestFeature { NoFeature = 0, Asynchronous = 1, Preload = 2 };
+    /**
+     * @since 26.12 AllowDownscale: the request may be served by scaling down a bigger
+     *   pixmap another observer already has for the page, instead of asking the generator
+     */
+    enum PixmapRequestFeature { NoFeature = 0, Asynchronous = 1, Preload = 2, AllowDownscale = 4 };
     Q_DECLARE_FLAGS(PixmapRequestFeatures, PixmapRequestFeature)
 
     /**
@@ -822,6 +837,46 @@ private:
     TextRequestPrivate *const d;
 };
 
+/**
+ * @short Shows the page of a pixmap request while it is being rendered.
+ *
+ * Generators that render a page in steps (strips, tiles, batches of
+ * drawing operations) create one on the stack in Generator::image() and
+ * give it the image rendered so far after each step. The image is handed
+ * to the main thread through Generator::signalPartialPixmapRequest(), no
+ * sooner than half a second after the render started and then at most a
+ * few times per second, and only if the request wants partial updates.
+ *
+ * @since 26.12
+ */
+class OKULARCORE_EXPORT PartialPixmapUpdater
+{
+public:
+    /**
+     * Creates a new updater for @p request, rendered by @p generator.
+     */
+    PartialPixmapUpdater(Generator *generator, PixmapRequest *request);
+
+    ~PartialPixmapUpdater();
+
+    /**
+     * Whether update() would show an image now. Generators that need work to
+     * put the image rendered so far together can check this first.
+     */
+    bool shouldUpdate() const;
+
+    /**
+     * Shows @p image, the request rendered so far, if shouldUpdate().
+     * The image is copied, the generator can go on painting on it.
+     */
+    void update(const QImage &image);
+
+private:
+    Q_DISABLE_COPY(PartialPixmapUpdater)
+
+    PartialPixmapUpdaterPrivate *const d;
+};
+
 }
 
 Q_DECLARE_METATYPE(Okular::PixmapRequest *)
@@ -9,6 +9,7 @@
 #include <QDebug>
 
 #include "fontinfo.h"
+#include "tracing_p.h"
 #include "utils.h"
 
 using namespace Okular;
@@ -56,6 +57,12 @@ NormalizedRect PixmapGenerationThread::boundingBox() const
 void PixmapGenerationThread::run()
 {
     if (mRequest) {
+        // the request may have been cancelled before the thread got to it
+        if (mRequest->shouldAbortRender()) {
+            return;
+        }
+
+        const Tracing::Scope scope("render", "generate pixmap", {{"page", mRequest->pageNumber()}, {"width", mRequest->width()}, {"height", mRequest->height()}, {"tile", mRequest->isTile()}});
         PixmapRequestPrivate::get(mRequest)->mResultImage = mGenerator->image(mRequest);
 
         if (mCalcBoundingBox) {
@@ -124,6 +131,7 @@ void TextPageGenerationThread::run()
 
     Q_ASSERT(page());
 
+    const Tracing::Scope scope("text", "extract text", {{"page", page()->number()}});
     mTextPage = mGenerator->textPage(&mTextRequest);
 
     if (mTextRequest.shouldAbortExtraction()) {
@@ -12,6 +12,7 @@
 
 #include "area.h"
 
+#include <QElapsedTimer>
 #include <QImage>
 #include <QMutex>
 #include <QSet>
@@ -57,6 +58,8 @@ public:
 
     virtual QVariant metaData(const QString &key, const QVariant &option) const;
     virtual QImage image(PixmapRequest *);
+    // stops the loading going on after the document was opened, before closing it
+    virtual void stopLoading();
 
     DocumentPrivate *m_document;
     // NOTE: the following should be a QSet< GeneratorFeature >,
@@ -95,6 +98,7 @@ public:
     NormalizedRect mNormalizedRect;
     QAtomicInt mShouldAbortRender;
     QImage mResultImage;
+    QElapsedTimer mSentTimer; // started when sent to the generator
 };
 
 class TextRequestPrivate
@@ -106,6 +110,15 @@ public:
     QAtomicInt mShouldAbortExtraction;
 };
 
+class PartialPixmapUpdaterPrivate
+{
+public:
+    Generator *mGenerator;
+    PixmapRequest *mRequest;
+    QElapsedTimer mTimer;
+    qint64 mLastUpdate;
+};
+
 class PixmapGenerationThread : public QThread
 {
     Q_OBJECT
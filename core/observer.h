@@ -56,7 +56,8 @@ public:
     enum SetupFlags {
         DocumentChanged = 1,   ///< The document is a new document.
         NewLayoutForPages = 2, ///< All the pages have
-        UrlChanged = 4         ///< The URL has changed @since 1.3
+        UrlChanged = 4,        ///< The URL has changed @since 1.3
+        PagesAppended = 8      ///< Pages were added at the end of the document, which is still loading @since 26.12
     };
 
     /**
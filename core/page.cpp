@@ -42,6 +42,7 @@
 #include "tilesmanager_p.h"
 #include "utils_p.h"
 
+#include <atomic>
 #include <limits>
 
 #ifdef PAGE_PROFILE
@@ -65,6 +66,9 @@ static void deleteObjectRects(QList<ObjectRect *> &rects, const QSet<ObjectRect:
     }
 }
 
+// the last revision given to the annotations of a page
+static std::atomic<quint64> lastAnnotationsRevision = 0;
+
 PagePrivate::PagePrivate(Page *page, uint n, double w, double h, Rotation o)
     : m_page(page)
     , m_number(n)
@@ -80,6 +84,7 @@ PagePrivate::PagePrivate(Page *page, uint n, double w, double h, Rotation o)
     , m_openingAction(nullptr)
     , m_closingAction(nullptr)
     , m_duration(-1)
+    , m_annotationsRevision(++lastAnnotationsRevision)
     , m_isBoundingBoxKnown(false)
 {
     // avoid Division-By-Zero problems in the program
@@ -132,6 +137,20 @@ void PagePrivate::imageRotationDone(RotationJob *job)
     }
 }
 
+void PagePrivate::addObjectRects(const QList<ObjectRect *> &rects)
+{
+    /**
+     * Rotate the object rects of the page.
+     */
+    const QTransform matrix = rotationMatrix();
+
+    for (ObjectRect *r : rects) {
+        r->transform(matrix);
+    }
+
+    m_page->m_rects << rects;
+}
+
 void PagePrivate::addAnnotation(Annotation *annotation, bool isLastAnnotationChild)
 {
     annotation->d_ptr->m_page = this;
@@ -263,6 +282,20 @@ bool Page::hasPixmap(DocumentObserver *observer, int width, int height, const No
     return (pixmap->width() == width && pixmap->height() == height);
 }
 
+const QPixmap *Page::pixmap(DocumentObserver *observer) const
+{
+    if (d->tilesManager(observer)) {
+        return nullptr;
+    }
+
+    QMap<DocumentObserver *, PagePrivate::PixmapObject>::const_iterator it = d->m_pixmaps.constFind(observer);
+    if (it == d->m_pixmaps.constEnd() || it.value().m_isPartialPixmap) {
+        return nullptr;
+    }
+
+    return it.value().m_pixmap;
+}
+
 void Page::setPageSize(DocumentObserver *observer, int width, int height)
 {
     TilesManager *tm = d->tilesManager(observer);
@@ -407,6 +440,11 @@ TextEntity::List Page::words(const RegularAreaRect *area, TextPage::TextAreaIncl
     return ret;
 }
 
+void PagePrivate::annotationsChanged()
+{
+    m_annotationsRevision = ++lastAnnotationsRevision;
+}
+
 void PagePrivate::rotateAt(Rotation orientation)
 {
     if (orientation == m_rotation) {
@@ -414,6 +452,7 @@ void PagePrivate::rotateAt(Rotation orientation)
     }
 
     deleteTextSelections();
+    annotationsChanged();
 
     if (((int)m_orientation + (int)m_rotation) % 2 != ((int)m_orientation + (int)orientation) % 2) {
         std::swap(m_width, m_height);
@@ -621,22 +660,18 @@ void Page::setTextPage(TextPage *textPage)
     }
 }
 
+qulonglong PagePrivate::textPageMemory() const
+{
+    return m_text ? m_text->d->memoryUsage() : 0;
+}
+
 void Page::setObjectRects(const QList<ObjectRect *> &rects)
 {
     QSet<ObjectRect::ObjectType> which;
     which << ObjectRect::Action << ObjectRect::Image;
     deleteObjectRects(m_rects, which);
 
-    /**
-     * Rotate the object rects of the page.
-     */
-    const QTransform matrix = d->rotationMatrix();
-
-    for (ObjectRect *r : rects) {
-        r->transform(matrix);
-    }
-
-    m_rects << rects;
+    d->addObjectRects(rects);
 }
 
 const QList<ObjectRect *> &Page::objectRects() const
@@ -713,6 +748,7 @@ void Page::addAnnotation(Annotation *annotation)
             parent = child;
         }
     }
+    d->annotationsChanged();
 }
 
 bool Page::removeAnnotation(Annotation *annotation)
@@ -746,6 +782,7 @@ bool Page::removeAnnotation(Annotation *annotation)
             break;
         }
     }
+    d->annotationsChanged();
 
     return true;
 }
@@ -847,6 +884,7 @@ void Page::deleteAnnotations()
     // delete all stored annotations
     qDeleteAll(m_annotations);
     m_annotations.clear();
+    d->annotationsChanged();
 }
 
 bool PagePrivate::restoreLocalContents(const QDomNode &pageNode)
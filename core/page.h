@@ -141,6 +141,14 @@ public:
      */
     bool hasPixmap(DocumentObserver *observer, int width = -1, int height = -1, const NormalizedRect &rect = NormalizedRect()) const;
 
+    /**
+     * Returns the pixmap of the whole page for the given @p observer, or
+     * nullptr if it has none, only a partially rendered one or tiles.
+     *
+     * @since 26.12
+     */
+    const QPixmap *pixmap(DocumentObserver *observer) const;
+
     /**
      * Sets the size of the page (in screen pixels) if there is a TilesManager.
      */
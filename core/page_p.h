@@ -31,6 +31,7 @@ class DocumentObserver;
 class DocumentPrivate;
 class FormField;
 class HighlightAreaRect;
+class ObjectRect;
 class Page;
 class PageSize;
 class PageTransition;
@@ -123,6 +124,11 @@ public:
      */
     void setTilesManager(const DocumentObserver *observer, TilesManager *tm);
 
+    /**
+     * The number of bytes used by the text page, 0 if there is none.
+     */
+    qulonglong textPageMemory() const;
+
     /**
      * Moves contents that are generated from oldPage to this. And clears them from page
      * so it can be deleted fine.
@@ -134,6 +140,11 @@ public:
      */
     void addAnnotation(Annotation *annotation, bool isLastAnnotationChild);
 
+    /**
+     * Adds @p rects to the object rects of the page, keeping the ones already there.
+     */
+    void addObjectRects(const QList<ObjectRect *> &rects);
+
     /*
      * Tries to find an equivalent form field to oldField by looking into the rect, type and name
      */
@@ -141,6 +152,12 @@ public:
 
     void setPixmap(DocumentObserver *observer, QPixmap *pixmap, const NormalizedRect &rect, bool isPartialPixmap);
 
+    /**
+     * Gives the annotations of the page a new revision, for the ones
+     * caching how they look.
+     */
+    void annotationsChanged();
+
     class PixmapObject
     {
     public:
@@ -168,6 +185,9 @@ public:
     double m_duration;
     QString m_label;
 
+    // changes with the annotations of the page, unique among all the pages
+    quint64 m_annotationsRevision;
+
     bool m_isBoundingBoxKnown : 1;
     QDomDocument restoredLocalAnnotationList; // <annotationList>...</annotationList>
     QDomDocument restoredFormFieldList;       // <forms>...</forms>
@@ -25,6 +25,7 @@
 #include "js_util_p.h"
 
 #include <QDebug>
+#include <QHash>
 #include <QJSEngine>
 #include <QStack>
 #include <QThread>
@@ -50,10 +51,18 @@ public:
     void initTypes();
 
     void updateEvent();
+    QJSValue compiledScript(const QString &script);
 
     DocumentPrivate *m_doc;
     QJSEngine m_interpreter;
 
+    // the event object of the scripts, pointing at the event on top of m_events
+    JSEvent *m_jsEvent = nullptr;
+    QJSValue m_jsEventValue;
+
+    // the field scripts, compiled to functions the first time they run
+    QHash<QString, QJSValue> m_compiledScripts;
+
     QThread m_watchdogThread;
     QTimer *m_watchdogTimer = nullptr;
 
@@ -76,19 +85,52 @@ void ExecutorJSPrivate::initTypes()
     m_interpreter.globalObject().setProperty(QStringLiteral("spell"), m_interpreter.newQObject(new JSSpell));
     m_interpreter.globalObject().setProperty(QStringLiteral("util"), m_interpreter.newQObject(new JSUtil));
     m_interpreter.globalObject().setProperty(QStringLiteral("global"), m_interpreter.newQObject(new JSGlobal));
+
+    m_jsEvent = new JSEvent(nullptr);
+    m_jsEventValue = m_interpreter.newQObject(m_jsEvent);
 }
 
 void ExecutorJSPrivate::updateEvent()
 {
-    if (!m_events.isEmpty()) {
-        Event *event = m_events.top();
-        const auto eventVal = event ? m_interpreter.newQObject(new JSEvent(event)) : QJSValue(QJSValue::UndefinedValue);
-        m_interpreter.globalObject().setProperty(QStringLiteral("event"), eventVal);
-    } else {
-        m_interpreter.globalObject().setProperty(QStringLiteral("event"), QJSValue(QJSValue::UndefinedValue));
+    // the same object for all the events, so that the scripts nesting others still see theirs
+    Event *event = m_events.isEmpty() ? nullptr : m_events.top();
+    m_jsEvent->setEvent(event);
+    m_interpreter.globalObject().setProperty(QStringLiteral("event"), event ? m_jsEventValue : QJSValue(QJSValue::UndefinedValue));
+}
+
+// Whether the scripts of the event run often enough to be worth compiling, and don't need to
+// declare globals: the top level declarations of a compiled script are local to it.
+static bool isFieldEvent(const Event *event)
+{
+    if (!event) {
+        return false;
+    }
+
+    switch (event->eventType()) {
+    case Event::FieldCalculate:
+    case Event::FieldFormat:
+    case Event::FieldKeystroke:
+    case Event::FieldValidate:
+        return true;
+    default:
+        return false;
     }
 }
 
+QJSValue ExecutorJSPrivate::compiledScript(const QString &script)
+{
+    auto it = m_compiledScripts.constFind(script);
+    if (it == m_compiledScripts.constEnd()) {
+        QJSValue function = m_interpreter.evaluate(QLatin1String("(function() {\n") + script + QLatin1String("\n})"), QStringLiteral("okular.js"), 0);
+        if (!function.isCallable()) {
+            // e.g. a syntax error, evaluating the script reports it
+            function = QJSValue(QJSValue::UndefinedValue);
+        }
+        it = m_compiledScripts.insert(script, function);
+    }
+    return it.value();
+}
+
 ExecutorJS::ExecutorJS(DocumentPrivate *doc)
     : d(new ExecutorJSPrivate(doc))
 {
@@ -106,9 +148,11 @@ void ExecutorJS::execute(const QString &script, Event *event)
     d->m_events.push(event);
     d->updateEvent();
 
+    const QJSValue function = isFieldEvent(event) ? d->compiledScript(script) : QJSValue(QJSValue::UndefinedValue);
+
     QMetaObject::invokeMethod(d->m_watchdogTimer, qOverload<>(&QTimer::start));
     d->m_interpreter.setInterrupted(false);
-    auto result = d->m_interpreter.evaluate(script, QStringLiteral("okular.js"));
+    auto result = function.isCallable() ? function.callWithInstance(d->m_interpreter.globalObject()) : d->m_interpreter.evaluate(script, QStringLiteral("okular.js"));
     QMetaObject::invokeMethod(d->m_watchdogTimer, qOverload<>(&QTimer::stop));
 
     if (result.isError()) {
@@ -143,3 +143,8 @@ JSEvent::JSEvent(Event *event, QObject *parent)
 }
 
 JSEvent::~JSEvent() = default;
+
+void JSEvent::setEvent(Event *event)
+{
+    m_event = event;
+}
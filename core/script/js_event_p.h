@@ -34,6 +34,8 @@ public:
     explicit JSEvent(Event *event, QObject *parent = nullptr);
     ~JSEvent() override;
 
+    void setEvent(Event *event);
+
     QString name() const;
     QString type() const;
     QString targetName() const;
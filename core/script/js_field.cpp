@@ -42,6 +42,30 @@ static void updateField(FormField *field)
     }
 }
 
+// Helper for the form recalculation to know which fields a calculate action depends on
+static void noteFieldRead(FormField *field)
+{
+    Page *page = g_fieldCache->value(field);
+    if (page) {
+        DocumentPrivate *doc = PagePrivate::get(page)->m_doc;
+        if (doc->m_readFormFields) {
+            doc->m_readFormFields->insert(field->fullyQualifiedName());
+        }
+    }
+}
+
+// Helper for the form recalculation to know which fields a calculate action changed
+static void noteFieldWritten(FormField *field)
+{
+    Page *page = g_fieldCache->value(field);
+    if (page) {
+        DocumentPrivate *doc = PagePrivate::get(page)->m_doc;
+        if (doc->m_changedFormFields) {
+            doc->m_changedFormFields->insert(field->fullyQualifiedName());
+        }
+    }
+}
+
 static void syncRadioGroupVisibility(FormField *field)
 {
     if (!field || field->type() != FormField::FormButton) {
@@ -154,6 +178,8 @@ QString JSField::type() const
 
 QJSValue JSField::fieldGetValueCore(bool asString) const
 {
+    noteFieldRead(m_field);
+
     QJSValue result(QJSValue::UndefinedValue);
 
     switch (m_field->type()) {
@@ -222,6 +248,7 @@ QJSValue JSField::value() const
 void JSField::setValue(const QJSValue &value)
 {
     qCDebug(OkularCoreDebug) << "fieldSetValue: Field: " << m_field->fullyQualifiedName() << " Type: " << fieldGetTypeHelper(m_field) << " Value: " << value.toString();
+    noteFieldWritten(m_field);
     switch (m_field->type()) {
     case FormField::FormButton: {
         FormFieldButton *button = static_cast<FormFieldButton *>(m_field);
@@ -346,6 +373,8 @@ QJSValue JSField::numItems() const
 
 QJSValue JSField::currentValueIndices() const
 {
+    noteFieldRead(m_field);
+
     QJSValue result(QJSValue::UndefinedValue);
     if (m_field->type() == FormField::FormChoice) {
         const FormFieldChoice *choice = static_cast<const FormFieldChoice *>(m_field);
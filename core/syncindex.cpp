@@ -0,0 +1,507 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "syncindex_p.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStack>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+#include "debug_p.h"
+#include "synctex/synctex_parser.h"
+
+using namespace Okular;
+
+static const quint32 syncIndexCacheMagic = 0x4f4b5349; // "OKSI"
+static const quint32 syncIndexCacheVersion = 1;
+
+// the sizes in the cache of a point and of the smallest string, its length
+static const qint64 serializedPointSize = 4 * sizeof(qint32) + 5 * sizeof(float);
+static const qint64 serializedStringMinSize = sizeof(quint32);
+
+// TeX "scaled points" per TeX point, used by pdfsync coordinates
+static const double scaledPointsPerPoint = 65536.0;
+
+std::unique_ptr<SyncIndex> SyncIndex::fromSyncTeX(const QString &outputFile, int pageCount, const std::atomic<bool> &abort)
+{
+    // Only check for existence first, we may not need to parse it at all
+    synctex_scanner_p scanner = synctex_scanner_new_with_output_file(QFile::encodeName(outputFile).constData(), nullptr, 0);
+    if (!scanner) {
+        return nullptr;
+    }
+
+    const QString syncFile = QFile::decodeName(synctex_scanner_get_synctex(scanner));
+    std::unique_ptr<SyncIndex> index(new SyncIndex);
+    const QString cacheFile = cacheFileName(syncFile);
+    if (index->load(cacheFile, syncFile, pageCount)) {
+        synctex_scanner_free(scanner);
+        return index;
+    }
+
+    scanner = synctex_scanner_parse(scanner);
+    if (!scanner) {
+        return nullptr;
+    }
+
+    // The visible coordinates of the synctex API are in big points
+    index->m_unitsPerInch = 72.0;
+
+    std::vector<synctex_node_p> pending;
+    for (synctex_node_p sheet = synctex_sheet(scanner, 0); sheet && !abort; sheet = synctex_node_sibling(sheet)) {
+        const int page = synctex_node_page(sheet) - 1;
+        if (page < 0 || page >= pageCount) {
+            continue;
+        }
+
+        // Depth-first walk of the page, recording the leaves: they are the smallest
+        // boxes carrying a line number and what both kinds of queries resolve to
+        pending.clear();
+        synctex_node_p node = synctex_node_child(sheet);
+        while (node) {
+            synctex_node_p child = synctex_node_child(node);
+            synctex_node_p sibling = synctex_node_sibling(node);
+            if (!child) {
+                const int tag = synctex_node_tag(node);
+                const int line = synctex_node_line(node);
+                if (tag > 0 && line > 0) {
+                    const char *name = synctex_scanner_get_name(scanner, tag);
+                    if (name) {
+                        Point point;
+                        point.page = page;
+                        point.file = index->fileIndex(QFile::decodeName(name));
+                        point.line = line;
+                        point.column = std::max(synctex_node_column(node), 0);
+                        point.h = synctex_node_visible_h(node);
+                        point.v = synctex_node_visible_v(node);
+                        point.width = std::abs(synctex_node_visible_width(node));
+                        point.height = std::max(synctex_node_visible_height(node), 0.f);
+                        point.depth = std::max(synctex_node_visible_depth(node), 0.f);
+                        index->addPoint(point);
+                    }
+                }
+            }
+
+            if (child) {
+                if (sibling) {
+                    pending.push_back(sibling);
+                }
+                node = child;
+            } else if (sibling) {
+                node = sibling;
+            } else if (!pending.empty()) {
+                node = pending.back();
+                pending.pop_back();
+            } else {
+                node = nullptr;
+            }
+        }
+    }
+    synctex_scanner_free(scanner);
+
+    if (abort) {
+        return nullptr;
+    }
+
+    index->finalize();
+    index->save(cacheFile, syncFile);
+    return index;
+}
+
+std::unique_ptr<SyncIndex> SyncIndex::fromPdfSync(const QString &outputFile, int pageCount, const std::atomic<bool> &abort)
+{
+    const QString syncFile = outputFile + QLatin1String("sync");
+    QFile f(syncFile);
+    if (!f.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    std::unique_ptr<SyncIndex> index(new SyncIndex);
+    const QString cacheFile = cacheFileName(syncFile);
+    if (index->load(cacheFile, syncFile, pageCount)) {
+        return index;
+    }
+
+    // pdfsync coordinates are in TeX points once converted from scaled points
+    index->m_unitsPerInch = 72.27;
+
+    const QByteArray data = f.readAll();
+    f.close();
+
+    struct PendingPoint {
+        qint32 file;
+        qint32 line;
+        qint64 x = 0;
+        qint64 y = 0;
+        qint32 page = -1;
+    };
+    QHash<int, PendingPoint> points;
+    QStack<qint32> fileStack;
+    int currentPage = -1;
+    int lineNumber = 0;
+
+    const QByteArray texExtension = QByteArrayLiteral(".tex");
+
+    qsizetype pos = 0;
+    while (pos < data.size() && !abort) {
+        qsizetype end = data.indexOf('\n', pos);
+        if (end < 0) {
+            end = data.size();
+        }
+        QByteArrayView line(data.constData() + pos, end - pos);
+        pos = end + 1;
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        ++lineNumber;
+
+        // first row: core name of the pdf output
+        if (lineNumber == 1) {
+            fileStack.push(index->fileIndex(QString::fromUtf8(line) + QLatin1String(".tex")));
+            continue;
+        }
+        // second row: version string, in the form 'Version %u'
+        if (lineNumber == 2) {
+            if (!line.startsWith("Version ") && !line.startsWith("version ")) {
+                return nullptr;
+            }
+            continue;
+        }
+
+        // Tokenize in place, pdfsync lines have at most four fields we care about
+        QByteArrayView tokens[4];
+        int tokenCount = 0;
+        qsizetype t = 0;
+        while (t < line.size() && tokenCount < 4) {
+            while (t < line.size() && line.at(t) == ' ') {
+                ++t;
+            }
+            const qsizetype tokenStart = t;
+            while (t < line.size() && line.at(t) != ' ') {
+                ++t;
+            }
+            if (t > tokenStart) {
+                tokens[tokenCount++] = line.sliced(tokenStart, t - tokenStart);
+            }
+        }
+        if (tokenCount < 1) {
+            continue;
+        }
+
+        if (tokens[0] == "l" && tokenCount >= 3) {
+            const int id = tokens[1].toInt();
+            if (!points.contains(id) && !fileStack.isEmpty()) {
+                PendingPoint pt;
+                pt.file = fileStack.top();
+                pt.line = tokens[2].toInt();
+                points.insert(id, pt);
+            }
+        } else if (tokens[0] == "s" && tokenCount >= 2) {
+            currentPage = tokens[1].toInt() - 1;
+        } else if (tokens[0] == "p*" && tokenCount >= 4) {
+            // TODO
+        } else if (tokens[0] == "p" && tokenCount >= 4) {
+            auto it = points.find(tokens[1].toInt());
+            if (it != points.end()) {
+                it->x = tokens[2].toLongLong();
+                it->y = tokens[3].toLongLong();
+                it->page = currentPage;
+            }
+        } else if (line.startsWith('(') && tokenCount == 1) {
+            QByteArray newFile = line.sliced(1).toByteArray();
+            if (!newFile.endsWith(texExtension)) {
+                newFile += texExtension;
+            }
+            fileStack.push(index->fileIndex(QString::fromUtf8(newFile)));
+        } else if (line == ")") {
+            if (!fileStack.isEmpty()) {
+                fileStack.pop();
+            } else {
+                qCDebug(OkularCoreDebug) << "PdfSync: going one level down too much";
+            }
+        }
+    }
+
+    if (abort) {
+        return nullptr;
+    }
+
+    for (const PendingPoint &pt : std::as_const(points)) {
+        // drop pdfsync points not completely valid
+        if (pt.page < 0 || pt.page >= pageCount) {
+            continue;
+        }
+        Point point;
+        point.page = pt.page;
+        point.file = pt.file;
+        point.line = pt.line;
+        point.column = 0; // TODO
+        point.h = pt.x / scaledPointsPerPoint;
+        point.v = pt.y / scaledPointsPerPoint;
+        point.width = 0;
+        point.height = 0;
+        point.depth = 0;
+        index->addPoint(point);
+    }
+
+    index->finalize();
+    index->save(cacheFile, syncFile);
+    return index;
+}
+
+const SyncIndex::Point *SyncIndex::findSource(int page, double h, double v) const
+{
+    if (page < 0 || page >= pageCount()) {
+        return nullptr;
+    }
+
+    const auto begin = m_points.cbegin() + m_pageOffsets[page];
+    const auto end = m_points.cbegin() + m_pageOffsets[page + 1];
+    if (begin == end) {
+        return nullptr;
+    }
+
+    const double maxExtent = m_pageMaxExtent[page];
+    const Point *best = nullptr;
+    double bestDistance = std::numeric_limits<double>::max();
+    double bestArea = std::numeric_limits<double>::max();
+    auto consider = [&](const Point &p) {
+        const double dx = std::max({p.h - h, 0.0, h - (p.h + p.width)});
+        const double dy = std::max({(p.v - p.height) - v, 0.0, v - (p.v + p.depth)});
+        const double distance = std::hypot(dx, dy);
+        const double area = double(p.width) * (p.height + p.depth);
+        if (distance < bestDistance || (distance == bestDistance && area < bestArea)) {
+            best = &p;
+            bestDistance = distance;
+            bestArea = area;
+        }
+    };
+
+    // Points are sorted by baseline, no box extends further than maxExtent
+    // from its baseline so we can stop as soon as the baseline alone is too far
+    const auto pivot = std::lower_bound(begin, end, v, [](const Point &p, double value) { return p.v < value; });
+    for (auto it = pivot; it != end && it->v - v <= bestDistance + maxExtent; ++it) {
+        consider(*it);
+    }
+    for (auto it = pivot; it != begin;) {
+        --it;
+        if (v - it->v > bestDistance + maxExtent) {
+            break;
+        }
+        consider(*it);
+    }
+
+    return best;
+}
+
+const SyncIndex::Point *SyncIndex::findOutput(const QString &fileName, int line) const
+{
+    int file = m_fileIndices.value(fileName, -1);
+    if (file < 0) {
+        // Editors and TeX don't always agree on how to spell the same path
+        const QString cleanName = QDir::cleanPath(fileName);
+        const QString baseName = QFileInfo(cleanName).fileName();
+        for (int i = 0; i < m_fileNames.count() && file < 0; ++i) {
+            const QString candidate = QDir::cleanPath(m_fileNames.at(i));
+            if (candidate == cleanName || candidate.endsWith(QLatin1Char('/') + cleanName) || cleanName.endsWith(QLatin1Char('/') + candidate)) {
+                file = i;
+            }
+        }
+        for (int i = 0; i < m_fileNames.count() && file < 0; ++i) {
+            if (QFileInfo(m_fileNames.at(i)).fileName() == baseName) {
+                file = i;
+            }
+        }
+        if (file < 0) {
+            return nullptr;
+        }
+    }
+
+    auto bySourceLess = [this](qint32 pointIndex, std::pair<qint32, qint32> key) {
+        const Point &p = m_points[pointIndex];
+        return std::make_pair(p.file, p.line) < key;
+    };
+    auto it = std::lower_bound(m_bySource.cbegin(), m_bySource.cend(), std::make_pair(file, qint32(line)), bySourceLess);
+    if (it != m_bySource.cend() && m_points[*it].file == file) {
+        return &m_points[*it];
+    }
+    // Past the last line of the file with output, use the last one
+    if (it != m_bySource.cbegin() && m_points[*(it - 1)].file == file) {
+        return &m_points[*(it - 1)];
+    }
+    return nullptr;
+}
+
+QList<SyncIndex::Point> SyncIndex::pointsOnPage(int page) const
+{
+    if (page < 0 || page >= pageCount()) {
+        return {};
+    }
+    return QList<Point>(m_points.cbegin() + m_pageOffsets[page], m_points.cbegin() + m_pageOffsets[page + 1]);
+}
+
+QString SyncIndex::fileName(int file) const
+{
+    return m_fileNames.value(file);
+}
+
+double SyncIndex::unitsPerInch() const
+{
+    return m_unitsPerInch;
+}
+
+int SyncIndex::pageCount() const
+{
+    return m_pageOffsets.empty() ? 0 : int(m_pageOffsets.size()) - 1;
+}
+
+void SyncIndex::addPoint(const Point &point)
+{
+    m_points.push_back(point);
+}
+
+int SyncIndex::fileIndex(const QString &fileName)
+{
+    auto it = m_fileIndices.constFind(fileName);
+    if (it != m_fileIndices.constEnd()) {
+        return *it;
+    }
+    const int index = m_fileNames.count();
+    m_fileNames << fileName;
+    m_fileIndices.insert(fileName, index);
+    return index;
+}
+
+void SyncIndex::finalize()
+{
+    std::sort(m_points.begin(), m_points.end(), [](const Point &a, const Point &b) { return std::tie(a.page, a.v, a.h) < std::tie(b.page, b.v, b.h); });
+    m_points.shrink_to_fit();
+
+    const int pages = m_points.empty() ? 0 : m_points.back().page + 1;
+    m_pageOffsets.assign(pages + 1, 0);
+    m_pageMaxExtent.assign(pages, 0.f);
+    for (const Point &p : m_points) {
+        m_pageOffsets[p.page + 1]++;
+        m_pageMaxExtent[p.page] = std::max({m_pageMaxExtent[p.page], p.height, p.depth, p.width});
+    }
+    for (int i = 0; i < pages; ++i) {
+        m_pageOffsets[i + 1] += m_pageOffsets[i];
+    }
+
+    m_bySource.resize(m_points.size());
+    for (qint32 i = 0; i < qint32(m_points.size()); ++i) {
+        m_bySource[i] = i;
+    }
+    // m_points is already sorted by page and position, so a stable sort keeps the first output of each line first
+    std::stable_sort(m_bySource.begin(), m_bySource.end(), [this](qint32 a, qint32 b) {
+        const Point &pa = m_points[a];
+        const Point &pb = m_points[b];
+        return std::tie(pa.file, pa.line) < std::tie(pb.file, pb.line);
+    });
+}
+
+QString SyncIndex::cacheFileName(const QString &syncFile)
+{
+    const QByteArray key = QCryptographicHash::hash(QFileInfo(syncFile).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/syncindex/") + QString::fromLatin1(key);
+}
+
+bool SyncIndex::load(const QString &cacheFile, const QString &syncFile, int pageCount)
+{
+    QFile f(cacheFile);
+    if (!f.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const QFileInfo syncInfo(syncFile);
+    QDataStream stream(&f);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    quint32 magic, version;
+    QString cachedSyncFile;
+    qint64 cachedModified, cachedSize;
+    stream >> magic >> version;
+    if (magic != syncIndexCacheMagic || version != syncIndexCacheVersion) {
+        return false;
+    }
+    stream >> cachedSyncFile >> cachedModified >> cachedSize;
+    if (cachedSyncFile != syncInfo.absoluteFilePath() || cachedModified != syncInfo.lastModified().toMSecsSinceEpoch() || cachedSize != syncInfo.size()) {
+        return false;
+    }
+
+    // the counts are checked against what is left of the file before allocating anything,
+    // a corrupted cache must not make us allocate gigabytes
+    quint32 fileCount;
+    stream >> m_unitsPerInch >> fileCount;
+    if (stream.status() != QDataStream::Ok || qint64(fileCount) * serializedStringMinSize > f.size() - f.pos()) {
+        return false;
+    }
+    for (quint32 i = 0; i < fileCount && stream.status() == QDataStream::Ok; ++i) {
+        QString fileName;
+        stream >> fileName;
+        m_fileNames.append(fileName);
+    }
+
+    quint32 pointCount;
+    stream >> pointCount;
+    if (stream.status() != QDataStream::Ok || qint64(pointCount) * serializedPointSize > f.size() - f.pos()) {
+        m_fileNames.clear();
+        return false;
+    }
+    m_points.resize(pointCount);
+    for (Point &p : m_points) {
+        stream >> p.page >> p.file >> p.line >> p.column >> p.h >> p.v >> p.width >> p.height >> p.depth;
+        // finalize() sizes its page tables after the last page
+        if (p.page < 0 || p.page >= pageCount || p.file < 0 || p.file >= m_fileNames.count()) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qCDebug(OkularCoreDebug) << "Discarding corrupted sync index cache" << cacheFile;
+        m_points.clear();
+        m_fileNames.clear();
+        return false;
+    }
+
+    for (int i = 0; i < m_fileNames.count(); ++i) {
+        m_fileIndices.insert(m_fileNames.at(i), i);
+    }
+    finalize();
+    return true;
+}
+
+void SyncIndex::save(const QString &cacheFile, const QString &syncFile) const
+{
+    if (!QDir().mkpath(QFileInfo(cacheFile).absolutePath())) {
+        return;
+    }
+
+    QSaveFile f(cacheFile);
+    if (!f.open(QIODevice::WriteOnly)) {
+        return;
+    }
+
+    const QFileInfo syncInfo(syncFile);
+    QDataStream stream(&f);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+    stream << syncIndexCacheMagic << syncIndexCacheVersion;
+    stream << syncInfo.absoluteFilePath() << qint64(syncInfo.lastModified().toMSecsSinceEpoch()) << qint64(syncInfo.size());
+    stream << m_unitsPerInch << m_fileNames << quint32(m_points.size());
+    for (const Point &p : m_points) {
+        stream << p.page << p.file << p.line << p.column << p.h << p.v << p.width << p.height << p.depth;
+    }
+    f.commit();
+}
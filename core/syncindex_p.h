@@ -0,0 +1,102 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _OKULAR_SYNCINDEX_P_H_
+#define _OKULAR_SYNCINDEX_P_H_
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace Okular
+{
+/**
+ * A compact, sorted index of the source <-> output correspondences of a
+ * SyncTeX or pdfsync file.
+ *
+ * Points are kept sorted by page and vertical position for page -> source
+ * queries, and a second permutation sorted by file and line serves
+ * source -> page queries, so both are answered with a binary search.
+ *
+ * Coordinates are in the units of the sync file; use unitsPerInch() to
+ * convert them to pixels.
+ */
+class SyncIndex
+{
+public:
+    struct Point {
+        qint32 page; // 0-based
+        qint32 file; // index in fileNames()
+        qint32 line;
+        qint32 column;
+        float h;
+        float v; // baseline
+        float width;
+        float height; // above the baseline
+        float depth;  // below the baseline
+    };
+
+    /**
+     * Builds the index for the SyncTeX file of @p outputFile, reusing the
+     * on-disk cache if it is still valid. Returns nullptr if there is no
+     * SyncTeX file or @p abort was set while building.
+     * The points past the @p pageCount pages of the document are dropped.
+     */
+    static std::unique_ptr<SyncIndex> fromSyncTeX(const QString &outputFile, int pageCount, const std::atomic<bool> &abort);
+
+    /**
+     * Builds the index for the pdfsync file of @p outputFile (i.e. @p outputFile + "sync").
+     */
+    static std::unique_ptr<SyncIndex> fromPdfSync(const QString &outputFile, int pageCount, const std::atomic<bool> &abort);
+
+    /**
+     * Returns the point of @p page closest to (@p h, @p v), or nullptr if the page has none.
+     */
+    const Point *findSource(int page, double h, double v) const;
+
+    /**
+     * Returns the first point generated by @p line of @p fileName, or by the
+     * closest following line if that one did not produce output.
+     */
+    const Point *findOutput(const QString &fileName, int line) const;
+
+    /**
+     * Returns all the points of @p page, sorted by vertical position.
+     */
+    QList<Point> pointsOnPage(int page) const;
+
+    QString fileName(int file) const;
+    double unitsPerInch() const;
+    int pageCount() const;
+
+private:
+    SyncIndex() = default;
+
+    void addPoint(const Point &point);
+    int fileIndex(const QString &fileName);
+    void finalize();
+
+    bool load(const QString &cacheFile, const QString &syncFile, int pageCount);
+    void save(const QString &cacheFile, const QString &syncFile) const;
+    static QString cacheFileName(const QString &syncFile);
+
+    std::vector<Point> m_points;           // sorted by page, v, h
+    std::vector<qint32> m_pageOffsets;     // m_points index of the first point of each page, plus the end
+    std::vector<float> m_pageMaxExtent;    // tallest/widest point of each page, bounds the search window
+    std::vector<qint32> m_bySource;        // m_points indices sorted by file, line
+    QStringList m_fileNames;
+    QHash<QString, qint32> m_fileIndices;
+    double m_unitsPerInch = 72.0;
+};
+
+}
+
+#endif
@@ -7,6 +7,7 @@
 #include "textdocumentgenerator.h"
 #include "textdocumentgenerator_p.h"
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFontDatabase>
 #include <QImage>
@@ -17,17 +18,26 @@
 #include <QStack>
 #include <QTextDocumentWriter>
 #include <QTextStream>
+#include <QThread>
 
 #include "action.h"
 #include "annotations.h"
 #include "document_p.h"
 #include "page.h"
+#include "page_p.h"
 #include "textpage.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace Okular;
 
+// how many bands a page is painted in, checking for cancelled requests between them
+static const int paintBands = 4;
+
+// how often the pages converted in the background are shown, in milliseconds
+static const int reportInterval = 250;
+
 /**
  * Generic Converter Implementation
  */
@@ -39,6 +49,8 @@ TextDocumentConverter::TextDocumentConverter()
 
 TextDocumentConverter::~TextDocumentConverter()
 {
+    // converters using convertInBackground() have to stop it in their own destructor already
+    waitForConversion(true);
     delete d_ptr;
 }
 
@@ -74,22 +86,140 @@ TextDocumentGenerator *TextDocumentConverter::generator() const
     return d_ptr->mParent ? d_ptr->mParent->q_func() : nullptr;
 }
 
+bool TextDocumentConverter::isConverting() const
+{
+    return d_ptr->mThread != nullptr;
+}
+
+void TextDocumentConverter::waitForConversion(bool cancel)
+{
+    Q_D(TextDocumentConverter);
+    if (!d->mThread) {
+        return;
+    }
+
+    if (cancel) {
+        d->mCancelled = true;
+        d->mThread->wait();
+        delete d->mThread;
+        d->mThread = nullptr;
+        d->discardQueued();
+    } else {
+        d->mThread->wait();
+        d->report(this, d->mConversion, true);
+    }
+
+    // ignore the reports queued by the thread
+    ++d->mConversion;
+}
+
+QMutex *TextDocumentConverter::documentMutex() const
+{
+    return &d_ptr->mDocumentMutex;
+}
+
+void TextDocumentConverter::convertInBackground(QTextDocument *document, const std::function<bool()> &convertMore, const std::function<void()> &finish)
+{
+    Q_D(TextDocumentConverter);
+    Q_ASSERT(!d->mThread);
+
+    d->mCancelled = false;
+    const int conversion = ++d->mConversion;
+
+    d->mThread = QThread::create([this, d, document, convertMore, finish, conversion] {
+        QElapsedTimer sinceReport;
+        sinceReport.start();
+
+        bool more = true;
+        while (more && !d->mCancelled) {
+            more = convertMore();
+
+            if (sinceReport.elapsed() >= reportInterval) {
+                QMetaObject::invokeMethod(this, [this, d, conversion] { d->report(this, conversion, false); }, Qt::QueuedConnection);
+                sinceReport.restart();
+            }
+        }
+
+        {
+            QMutexLocker locker(&d->mDocumentMutex);
+            if (finish) {
+                finish();
+            }
+            // back to the thread of the generator, which is the one of the converter
+            document->moveToThread(thread());
+        }
+
+        if (!d->mCancelled) {
+            QMetaObject::invokeMethod(this, [this, d, conversion] { d->report(this, conversion, true); }, Qt::QueuedConnection);
+        }
+    });
+    document->moveToThread(d->mThread);
+    d->mThread->start();
+}
+
+bool TextDocumentConverter::isConversionCancelled() const
+{
+    return d_ptr->mCancelled;
+}
+
+void TextDocumentConverter::queueAction(Okular::Action *link, int cursorBegin, int cursorEnd)
+{
+    Q_D(TextDocumentConverter);
+    d->mQueuedActions.append({link, cursorBegin, cursorEnd});
+}
+
+void TextDocumentConverter::queueAnnotation(Okular::Annotation *annotation, int cursorBegin, int cursorEnd)
+{
+    Q_D(TextDocumentConverter);
+    d->mQueuedAnnotations.append({annotation, cursorBegin, cursorEnd});
+}
+
+void TextDocumentConverter::queueTitle(int level, const QString &title, const QTextBlock &position)
+{
+    Q_D(TextDocumentConverter);
+    d->mQueuedTitles.append({level, title, position});
+}
+
+void TextDocumentConverterPrivate::report(TextDocumentConverter *q, int conversion, bool finished)
+{
+    // the document the report is about may be closed already
+    if (conversion != mConversion) {
+        return;
+    }
+
+    if (finished) {
+        mThread->wait();
+        delete mThread;
+        mThread = nullptr;
+    }
+
+    Q_EMIT q->documentExtended(finished);
+}
+
+void TextDocumentConverterPrivate::discardQueued()
+{
+    for (const ActionPosition &position : std::as_const(mQueuedActions)) {
+        delete position.action;
+    }
+    mQueuedActions.clear();
+    for (const AnnotationPosition &position : std::as_const(mQueuedAnnotations)) {
+        delete position.annotation;
+    }
+    mQueuedAnnotations.clear();
+    mQueuedTitles.clear();
+}
+
 /**
  * Generic Generator Implementation
  */
 Okular::TextPage *TextDocumentGeneratorPrivate::createTextPage(int pageNumber) const
 {
-#ifdef OKULAR_TEXTDOCUMENT_THREADED_RENDERING
-    Q_Q(const TextDocumentGenerator);
-#endif
-
     Okular::TextPage *textPage = new Okular::TextPage;
 
     int start, end;
 
-#ifdef OKULAR_TEXTDOCUMENT_THREADED_RENDERING
-    q->userMutex()->lock();
-#endif
+    // the converter may still be adding to the document
+    QMutexLocker locker(documentMutex());
     TextDocumentUtils::calculatePositions(mDocument, pageNumber, start, end);
 
     {
@@ -110,9 +240,6 @@ Okular::TextPage *TextDocumentGeneratorPrivate::createTextPage(int pageNumber) c
             }
         }
     }
-#ifdef OKULAR_TEXTDOCUMENT_THREADED_RENDERING
-    q->userMutex()->unlock();
-#endif
 
     return textPage;
 }
@@ -162,60 +289,54 @@ void TextDocumentGeneratorPrivate::addMetaData(DocumentInfo::Key key, const QStr
     mDocumentInfo.set(key, value);
 }
 
-QList<TextDocumentGeneratorPrivate::LinkInfo> TextDocumentGeneratorPrivate::generateLinkInfos() const
+QList<TextDocumentGeneratorPrivate::LinkInfo> TextDocumentGeneratorPrivate::generateLinkInfos(const LinkPosition &linkPosition) const
 {
     QList<LinkInfo> result;
 
-    for (const LinkPosition &linkPosition : mLinkPositions) {
-        const QList<QRectF> rects = TextDocumentUtils::calculateBoundingRects(mDocument, linkPosition.startPosition, linkPosition.endPosition);
+    const QList<QRectF> rects = TextDocumentUtils::calculateBoundingRects(mDocument, linkPosition.startPosition, linkPosition.endPosition);
 
-        for (int i = 0; i < rects.count(); ++i) {
-            const QRectF &rect = rects[i];
+    for (int i = 0; i < rects.count(); ++i) {
+        const QRectF &rect = rects[i];
 
-            LinkInfo info;
-            info.link = linkPosition.link;
-            info.ownsLink = i == 0;
-            info.page = std::floor(rect.y());
-            info.boundingRect = QRectF(rect.x(), rect.y() - info.page, rect.width(), rect.height());
-            result.append(info);
-        }
+        LinkInfo info;
+        info.link = linkPosition.link;
+        info.ownsLink = i == 0;
+        info.page = std::floor(rect.y());
+        info.boundingRect = QRectF(rect.x(), rect.y() - info.page, rect.width(), rect.height());
+        result.append(info);
     }
 
     return result;
 }
 
-QList<TextDocumentGeneratorPrivate::AnnotationInfo> TextDocumentGeneratorPrivate::generateAnnotationInfos() const
+TextDocumentGeneratorPrivate::AnnotationInfo TextDocumentGeneratorPrivate::generateAnnotationInfo(const AnnotationPosition &annotationPosition) const
 {
-    QList<AnnotationInfo> result;
-
-    for (int i = 0; i < mAnnotationPositions.count(); ++i) {
-        const AnnotationPosition &annotationPosition = mAnnotationPositions[i];
+    AnnotationInfo info;
+    info.annotation = annotationPosition.annotation;
 
-        AnnotationInfo info;
-        info.annotation = annotationPosition.annotation;
+    TextDocumentUtils::calculateBoundingRect(mDocument, annotationPosition.startPosition, annotationPosition.endPosition, info.boundingRect, info.page);
 
-        TextDocumentUtils::calculateBoundingRect(mDocument, annotationPosition.startPosition, annotationPosition.endPosition, info.boundingRect, info.page);
-
-        if (info.page >= 0) {
-            result.append(info);
-        }
-    }
-
-    return result;
+    return info;
 }
 
-void TextDocumentGeneratorPrivate::generateTitleInfos()
+void TextDocumentGeneratorPrivate::generateTitleInfos(bool finished)
 {
-    QStack<QPair<int, QDomNode>> parentNodeStack;
-
-    QDomNode parentNode = mDocumentSynopsis;
+    if (mTitleParents.isEmpty()) {
+        mTitleParents.push(qMakePair(0, QDomNode(mDocumentSynopsis)));
+    }
 
-    parentNodeStack.push(qMakePair(0, parentNode));
+    // while converting, only the pages but the last one are there
+    const int pageCount = finished ? mDocument->pageCount() : mDocument->pageCount() - 1;
 
-    for (int i = 0; i < mTitlePositions.count(); ++i) {
-        const TitlePosition &position = mTitlePositions[i];
+    int added = 0;
+    for (; added < mTitlePositions.count(); ++added) {
+        const TitlePosition &position = mTitlePositions[added];
 
+        // the titles after it wait too, to keep their order
         Okular::DocumentViewport viewport = TextDocumentUtils::calculateViewport(mDocument, position.block);
+        if (viewport.pageNumber >= pageCount) {
+            break;
+        }
 
         QDomElement item = mDocumentSynopsis.createElement(position.title);
         item.setAttribute(QStringLiteral("Viewport"), viewport.toString());
@@ -224,20 +345,123 @@ void TextDocumentGeneratorPrivate::generateTitleInfos()
 
         // we need a parent, which has to be at a higher heading level than this heading level
         // so we just work through the stack
-        while (!parentNodeStack.isEmpty()) {
-            int parentLevel = parentNodeStack.top().first;
+        QDomNode parentNode = mDocumentSynopsis;
+        while (!mTitleParents.isEmpty()) {
+            int parentLevel = mTitleParents.top().first;
             if (parentLevel < headingLevel) {
                 // this is OK as a parent
-                parentNode = parentNodeStack.top().second;
+                parentNode = mTitleParents.top().second;
                 break;
             } else {
                 // we'll need to be further into the stack
-                parentNodeStack.pop();
+                mTitleParents.pop();
             }
         }
         parentNode.appendChild(item);
-        parentNodeStack.push(qMakePair(headingLevel, QDomNode(item)));
+        mTitleParents.push(qMakePair(headingLevel, QDomNode(item)));
     }
+    mTitlePositions.remove(0, added);
+}
+
+void TextDocumentGeneratorPrivate::appendPages(QList<Okular::Page *> &pagesVector, bool finished)
+{
+    // while converting, the last page may still get more contents
+    const int pageCount = finished ? mDocument->pageCount() : mDocument->pageCount() - 1;
+    const QSize size = mDocument->pageSize().toSize();
+
+    for (int i = pagesVector.count(); i < pageCount; ++i) {
+        pagesVector.append(new Okular::Page(i, size.width(), size.height(), Okular::Rotation0));
+    }
+
+    // put the links and annotations on their pages, keeping those on the pages not there yet
+    QList<QList<Okular::ObjectRect *>> objects(pagesVector.count());
+    QList<LinkPosition> pendingLinks;
+    for (const LinkPosition &linkPosition : std::as_const(mLinkPositions)) {
+        const QList<LinkInfo> linkInfos = generateLinkInfos(linkPosition);
+        if (!finished && std::any_of(linkInfos.cbegin(), linkInfos.cend(), [pageCount](const LinkInfo &info) { return info.page >= pageCount; })) {
+            pendingLinks.append(linkPosition);
+            continue;
+        }
+
+        for (const LinkInfo &info : linkInfos) {
+            // in case that the converter report bogus link info data, do not assert here
+            if (info.page < 0 || info.page >= objects.count()) {
+                continue;
+            }
+
+            const QRectF rect = info.boundingRect;
+            if (info.ownsLink) {
+                objects[info.page].append(new Okular::ObjectRect(rect.left(), rect.top(), rect.right(), rect.bottom(), false, Okular::ObjectRect::Action, info.link));
+            } else {
+                objects[info.page].append(new Okular::NonOwningObjectRect(rect.left(), rect.top(), rect.right(), rect.bottom(), false, Okular::ObjectRect::Action, info.link));
+            }
+        }
+    }
+    mLinkPositions = pendingLinks;
+
+    for (int i = 0; i < objects.count(); ++i) {
+        if (!objects.at(i).isEmpty()) {
+            PagePrivate::get(pagesVector[i])->addObjectRects(objects.at(i));
+        }
+    }
+
+    QList<AnnotationPosition> pendingAnnotations;
+    for (const AnnotationPosition &annotationPosition : std::as_const(mAnnotationPositions)) {
+        const AnnotationInfo info = generateAnnotationInfo(annotationPosition);
+        if (!finished && info.page >= pageCount) {
+            pendingAnnotations.append(annotationPosition);
+        } else if (info.page >= 0 && info.page < pagesVector.count()) {
+            pagesVector[info.page]->addAnnotation(info.annotation);
+        }
+    }
+    mAnnotationPositions = pendingAnnotations;
+}
+
+void TextDocumentGeneratorPrivate::documentExtended(bool finished)
+{
+    // the converter may report some of the document before it is loaded
+    if (!mDocument || !m_document) {
+        return;
+    }
+
+    QList<Okular::Page *> pagesVector = m_document->m_pagesVector;
+    const int pageCount = pagesVector.count();
+    {
+        QMutexLocker locker(documentMutex());
+        takeQueued();
+        generateTitleInfos(finished);
+        appendPages(pagesVector, finished);
+    }
+
+    m_document->appendPages(pagesVector.mid(pageCount));
+}
+
+void TextDocumentGeneratorPrivate::takeQueued()
+{
+    TextDocumentConverterPrivate *converter = mConverter->d_ptr;
+
+    for (const TextDocumentConverterPrivate::ActionPosition &position : std::as_const(converter->mQueuedActions)) {
+        addAction(position.action, position.cursorBegin, position.cursorEnd);
+    }
+    converter->mQueuedActions.clear();
+    for (const TextDocumentConverterPrivate::AnnotationPosition &position : std::as_const(converter->mQueuedAnnotations)) {
+        addAnnotation(position.annotation, position.cursorBegin, position.cursorEnd);
+    }
+    converter->mQueuedAnnotations.clear();
+    for (const TextDocumentConverterPrivate::TitlePosition &position : std::as_const(converter->mQueuedTitles)) {
+        addTitle(position.level, position.title, position.block);
+    }
+    converter->mQueuedTitles.clear();
+}
+
+void TextDocumentGeneratorPrivate::stopLoading()
+{
+    mConverter->waitForConversion(true);
+}
+
+QMutex *TextDocumentGeneratorPrivate::documentMutex() const
+{
+    return mConverter->documentMutex();
 }
 
 void TextDocumentGeneratorPrivate::initializeGenerator()
@@ -255,12 +479,14 @@ void TextDocumentGeneratorPrivate::initializeGenerator()
     q->setFeature(Generator::PrintToFile);
 #ifdef OKULAR_TEXTDOCUMENT_THREADED_RENDERING
     q->setFeature(Generator::Threaded);
+    q->setFeature(Generator::SupportsCancelling);
 #endif
 
     QObject::connect(mConverter, &TextDocumentConverter::addAction, q, [this](Action *a, int cb, int ce) { addAction(a, cb, ce); });
     QObject::connect(mConverter, &TextDocumentConverter::addAnnotation, q, [this](Annotation *a, int cb, int ce) { addAnnotation(a, cb, ce); });
     QObject::connect(mConverter, &TextDocumentConverter::addTitle, q, [this](int l, const QString &t, const QTextBlock &b) { addTitle(l, t, b); });
     QObject::connect(mConverter, &TextDocumentConverter::addMetaData, q, [this](DocumentInfo::Key k, const QString &v) { addMetaData(k, v); });
+    QObject::connect(mConverter, &TextDocumentConverter::documentExtended, q, [this](bool finished) { documentExtended(finished); });
 
     QObject::connect(mConverter, &TextDocumentConverter::error, q, &Generator::error);
     QObject::connect(mConverter, &TextDocumentConverter::warning, q, &Generator::warning);
@@ -286,6 +512,9 @@ Document::OpenResult TextDocumentGenerator::loadDocumentWithPassword(const QStri
     const Document::OpenResult openResult = d->mConverter->convertWithPassword(fileName, password);
 
     if (openResult != Document::OpenSuccess) {
+        d->mConverter->waitForConversion(true);
+        d->takeQueued();
+
         d->mDocument = nullptr;
 
         // loading failed, cleanup all the stuff eventually gathered from the converter
@@ -302,49 +531,16 @@ Document::OpenResult TextDocumentGenerator::loadDocumentWithPassword(const QStri
         return openResult;
     }
     d->mDocument = d->mConverter->document();
-    if (d->mDocument) {
-        d->mDocument->setDefaultFont(d->mFont);
-    }
-    d->generateTitleInfos();
-    const QList<TextDocumentGeneratorPrivate::LinkInfo> linkInfos = d->generateLinkInfos();
-    const QList<TextDocumentGeneratorPrivate::AnnotationInfo> annotationInfos = d->generateAnnotationInfos();
-
-    pagesVector.resize(d->mDocument->pageCount());
 
-    const QSize size = d->mDocument->pageSize().toSize();
-
-    QList<QList<Okular::ObjectRect *>> objects(d->mDocument->pageCount());
-    for (const TextDocumentGeneratorPrivate::LinkInfo &info : linkInfos) {
-        // in case that the converter report bogus link info data, do not assert here
-        if (info.page < 0 || info.page >= objects.count()) {
-            continue;
-        }
-
-        const QRectF rect = info.boundingRect;
-        if (info.ownsLink) {
-            objects[info.page].append(new Okular::ObjectRect(rect.left(), rect.top(), rect.right(), rect.bottom(), false, Okular::ObjectRect::Action, info.link));
-        } else {
-            objects[info.page].append(new Okular::NonOwningObjectRect(rect.left(), rect.top(), rect.right(), rect.bottom(), false, Okular::ObjectRect::Action, info.link));
-        }
-    }
-
-    QList<QList<Okular::Annotation *>> annots(d->mDocument->pageCount());
-    for (const TextDocumentGeneratorPrivate::AnnotationInfo &info : annotationInfos) {
-        annots[info.page].append(info.annotation);
-    }
-
-    for (int i = 0; i < d->mDocument->pageCount(); ++i) {
-        Okular::Page *page = new Okular::Page(i, size.width(), size.height(), Okular::Rotation0);
-        pagesVector[i] = page;
-
-        if (!objects.at(i).isEmpty()) {
-            page->setObjectRects(objects.at(i));
-        }
-        QList<Okular::Annotation *>::ConstIterator annIt = annots.at(i).begin(), annEnd = annots.at(i).end();
-        for (; annIt != annEnd; ++annIt) {
-            page->addAnnotation(*annIt);
-        }
+    // the converter may go on converting the rest of the document in the background
+    QMutexLocker locker(d->documentMutex());
+    if (d->mDocument->defaultFont() != d->mFont) {
+        d->mDocument->setDefaultFont(d->mFont);
     }
+    d->takeQueued();
+    const bool finished = !d->mConverter->isConverting();
+    d->generateTitleInfos(finished);
+    d->appendPages(pagesVector, finished);
 
     return openResult;
 }
@@ -352,11 +548,20 @@ Document::OpenResult TextDocumentGenerator::loadDocumentWithPassword(const QStri
 bool TextDocumentGenerator::doCloseDocument()
 {
     Q_D(TextDocumentGenerator);
+    d->mConverter->waitForConversion(true);
     delete d->mDocument;
     d->mDocument = nullptr;
 
     d->mTitlePositions.clear();
+    d->mTitleParents.clear();
+    // those of a conversion cancelled before they got on a page
+    for (const TextDocumentGeneratorPrivate::LinkPosition &linkPos : std::as_const(d->mLinkPositions)) {
+        delete linkPos.link;
+    }
     d->mLinkPositions.clear();
+    for (const TextDocumentGeneratorPrivate::AnnotationPosition &annPos : std::as_const(d->mAnnotationPositions)) {
+        delete annPos.annotation;
+    }
     d->mAnnotationPositions.clear();
     // do not use clear() for the following two, otherwise they change type
     d->mDocumentInfo = Okular::DocumentInfo();
@@ -381,10 +586,6 @@ QImage TextDocumentGeneratorPrivate::image(PixmapRequest *request)
         return QImage();
     }
 
-#ifdef OKULAR_TEXTDOCUMENT_THREADED_RENDERING
-    Q_Q(const TextDocumentGenerator);
-#endif
-
     QImage image(request->width(), request->height(), QImage::Format_ARGB32);
     image.fill(Qt::white);
 
@@ -400,17 +601,26 @@ QImage TextDocumentGeneratorPrivate::image(PixmapRequest *request)
 
     const QRect rect = QRect(0, request->pageNumber() * size.height(), size.width(), size.height());
     p.translate(QPoint(0, request->pageNumber() * size.height() * -1));
-    p.setClipRect(rect);
-#ifdef OKULAR_TEXTDOCUMENT_THREADED_RENDERING
-    q->userMutex()->lock();
-#endif
-    QAbstractTextDocumentLayout::PaintContext context;
-    context.palette.setColor(QPalette::Text, Qt::black);
-    context.clip = rect;
-    mDocument->documentLayout()->draw(&p, context);
-#ifdef OKULAR_TEXTDOCUMENT_THREADED_RENDERING
-    q->userMutex()->unlock();
-#endif
+    {
+        // the converter may still be adding to the document
+        QMutexLocker locker(documentMutex());
+        QAbstractTextDocumentLayout::PaintContext context;
+        context.palette.setColor(QPalette::Text, Qt::black);
+
+        // a band of the page at a time, so that cancelled requests stop early
+        for (int band = 0; band < paintBands; ++band) {
+            if (request->shouldAbortRender()) {
+                return QImage();
+            }
+
+            const int top = rect.height() * band / paintBands;
+            const int bottom = rect.height() * (band + 1) / paintBands;
+            const QRect bandRect(rect.x(), rect.y() + top, rect.width(), bottom - top);
+            p.setClipRect(bandRect);
+            context.clip = bandRect;
+            mDocument->documentLayout()->draw(&p, context);
+        }
+    }
     p.end();
 
     return image;
@@ -429,6 +639,7 @@ Document::PrintError TextDocumentGenerator::print(QPrinter &printer)
         return Document::UnknownPrintError;
     }
 
+    d->mConverter->waitForConversion(false);
     d->mDocument->print(&printer);
 
     return Document::NoPrintError;
@@ -483,6 +694,8 @@ bool TextDocumentGenerator::exportTo(const QString &fileName, const Okular::Expo
         return false;
     }
 
+    d->mConverter->waitForConversion(false);
+
     if (format.mimeType().name() == QLatin1String("application/pdf")) {
         QFile file(fileName);
         if (!file.open(QIODevice::WriteOnly)) {
@@ -525,6 +738,7 @@ bool TextDocumentGenerator::reparseConfig()
     if (newFont != d->mFont) {
         d->mFont = newFont;
         if (d->mDocument) {
+            QMutexLocker locker(d->documentMutex());
             d->mDocument->setDefaultFont(d->mFont);
         }
         return true;
@@ -14,6 +14,9 @@
 #include "generator.h"
 #include "textdocumentsettings.h"
 
+#include <functional>
+
+class QMutex;
 class QTextBlock;
 class QTextDocument;
 
@@ -58,6 +61,24 @@ public:
      */
     QTextDocument *document();
 
+    /**
+     * Returns whether the converter goes on converting the document in the
+     * background after convertWithPassword() returned.
+     *
+     * @see convertInBackground()
+     * @since 26.12
+     */
+    bool isConverting() const;
+
+    /**
+     * Waits for the conversion going on in the background to be done, or stops
+     * it as soon as possible if @p cancel is true, e.g. because the document is
+     * being closed.
+     *
+     * @since 26.12
+     */
+    void waitForConversion(bool cancel);
+
 Q_SIGNALS:
     /**
      * Adds a new link object which is located between cursorBegin and
@@ -83,6 +104,16 @@ Q_SIGNALS:
      */
     void addMetaData(Okular::DocumentInfo::Key key, const QString &value);
 
+    /**
+     * This signal is emitted while the document is converted in the
+     * background, each time more of it is laid out, and with @p finished true
+     * once all of it is.
+     *
+     * @see convertInBackground()
+     * @since 26.12
+     */
+    void documentExtended(bool finished);
+
     /**
      * This signal should be emitted whenever an error occurred in the converter.
      *
@@ -113,6 +144,67 @@ protected:
      */
     void setDocument(QTextDocument *document);
 
+    /**
+     * Returns the mutex to hold while modifying the document after
+     * convertWithPassword() returned. The generator holds it while reading
+     * the document.
+     *
+     * @since 26.12
+     */
+    QMutex *documentMutex() const;
+
+    /**
+     * Goes on converting @p document in a thread once convertWithPassword()
+     * returned, so that its first pages can be shown meanwhile.
+     *
+     * @p convertMore is called in the thread until it returns false, or until
+     * the conversion is cancelled. Then @p finish is called, holding
+     * documentMutex(), whether the conversion was cancelled or not. Both have
+     * to hold documentMutex() while modifying the document, and may only
+     * modify its last page. Converters using it have to call
+     * waitForConversion(true) in their destructor.
+     *
+     * @see isConversionCancelled(), queueAction()
+     * @since 26.12
+     */
+    void convertInBackground(QTextDocument *document, const std::function<bool()> &convertMore, const std::function<void()> &finish = {});
+
+    /**
+     * Returns whether the conversion going on in the background is being
+     * cancelled.
+     *
+     * @since 26.12
+     */
+    bool isConversionCancelled() const;
+
+    /**
+     * Adds a new link object which is located between cursorBegin and
+     * cursorEnd to the generator, once the generator looks at the document
+     * again. Unlike addAction(), this can be called from the thread of
+     * convertInBackground(), holding documentMutex().
+     *
+     * @since 26.12
+     */
+    void queueAction(Okular::Action *link, int cursorBegin, int cursorEnd);
+
+    /**
+     * Like addAnnotation(), but can be called from the thread of
+     * convertInBackground().
+     *
+     * @see queueAction()
+     * @since 26.12
+     */
+    void queueAnnotation(Okular::Annotation *annotation, int cursorBegin, int cursorEnd);
+
+    /**
+     * Like addTitle(), but can be called from the thread of
+     * convertInBackground().
+     *
+     * @see queueAction()
+     * @since 26.12
+     */
+    void queueTitle(int level, const QString &title, const QTextBlock &position);
+
     /**
      * This method can be used to calculate the viewport for a given text block.
      *
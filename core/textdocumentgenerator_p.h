@@ -8,6 +8,8 @@
 #define _OKULAR_TEXTDOCUMENTGENERATOR_P_H_
 
 #include <QAbstractTextDocumentLayout>
+#include <QMutex>
+#include <QStack>
 #include <QTextBlock>
 #include <QTextDocument>
 
@@ -17,6 +19,10 @@
 #include "generator_p.h"
 #include "textdocumentgenerator.h"
 
+#include <atomic>
+
+class QThread;
+
 namespace Okular
 {
 namespace TextDocumentUtils
@@ -159,11 +165,42 @@ public:
     TextDocumentConverterPrivate()
         : mParent(nullptr)
         , mDocument(nullptr)
+        , mThread(nullptr)
+        , mCancelled(false)
+        , mConversion(0)
     {
     }
 
+    void report(TextDocumentConverter *q, int conversion, bool finished);
+    void discardQueued();
+
     TextDocumentGeneratorPrivate *mParent;
     QTextDocument *mDocument;
+    QMutex mDocumentMutex;
+
+    QThread *mThread;
+    std::atomic<bool> mCancelled;
+    int mConversion; // tells the reports of a closed document apart
+
+    // queued while converting in the background, protected by mDocumentMutex
+    struct ActionPosition {
+        Action *action;
+        int cursorBegin;
+        int cursorEnd;
+    };
+    struct AnnotationPosition {
+        Annotation *annotation;
+        int cursorBegin;
+        int cursorEnd;
+    };
+    struct TitlePosition {
+        int level;
+        QString title;
+        QTextBlock block;
+    };
+    QList<ActionPosition> mQueuedActions;
+    QList<AnnotationPosition> mQueuedAnnotations;
+    QList<TitlePosition> mQueuedTitles;
 };
 
 class TextDocumentGeneratorPrivate : public GeneratorPrivate
@@ -203,6 +240,7 @@ public:
 
     /* reimp */ QVariant metaData(const QString &key, const QVariant &option) const override;
     /* reimp */ QImage image(PixmapRequest *) override;
+    /* reimp */ void stopLoading() override;
 
     void calculateBoundingRect(int startPosition, int endPosition, QRectF &rect, int &page) const;
     void calculatePositions(int page, int &start, int &end) const;
@@ -214,35 +252,43 @@ public:
     void addMetaData(const QString &key, const QString &value, const QString &title);
     void addMetaData(DocumentInfo::Key, const QString &value);
 
-    QList<LinkInfo> generateLinkInfos() const;
-    QList<AnnotationInfo> generateAnnotationInfos() const;
-    void generateTitleInfos();
-
-    TextDocumentConverter *mConverter;
-
-    QTextDocument *mDocument;
-    Okular::DocumentInfo mDocumentInfo;
-    Okular::DocumentSynopsis mDocumentSynopsis;
-
     struct TitlePosition {
         int level;
         QString title;
         QTextBlock block;
     };
-    QList<TitlePosition> mTitlePositions;
 
     struct LinkPosition {
         int startPosition;
         int endPosition;
         Action *link;
     };
-    QList<LinkPosition> mLinkPositions;
 
     struct AnnotationPosition {
         int startPosition;
         int endPosition;
         Annotation *annotation;
     };
+
+    QList<LinkInfo> generateLinkInfos(const LinkPosition &linkPosition) const;
+    AnnotationInfo generateAnnotationInfo(const AnnotationPosition &annotationPosition) const;
+    void generateTitleInfos(bool finished);
+    void appendPages(QList<Okular::Page *> &pagesVector, bool finished);
+    void documentExtended(bool finished);
+    void takeQueued();
+    QMutex *documentMutex() const;
+
+    TextDocumentConverter *mConverter;
+
+    QTextDocument *mDocument;
+    Okular::DocumentInfo mDocumentInfo;
+    Okular::DocumentSynopsis mDocumentSynopsis;
+
+    // the titles not in the synopsis yet, and where the next ones go in it
+    QList<TitlePosition> mTitlePositions;
+    QStack<QPair<int, QDomNode>> mTitleParents;
+    // the links and annotations not on a page yet
+    QList<LinkPosition> mLinkPositions;
     QList<AnnotationPosition> mAnnotationPositions;
 
     TextDocumentSettings *mGeneralSettings;
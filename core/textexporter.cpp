@@ -0,0 +1,134 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "textexporter_p.h"
+
+#include <QIODevice>
+#include <QThread>
+
+#include <memory>
+#include <vector>
+
+#include "generator.h"
+#include "generator_p.h"
+#include "page.h"
+#include "textpage.h"
+#include "tracing_p.h"
+
+using namespace Okular;
+
+// how many pages each worker may extract ahead of the page being written
+static const int pagesAheadPerWorker = 2;
+
+TextExporter::TextExporter(Generator *generator, const QList<Page *> &pages)
+    : m_generator(generator)
+    , m_pages(pages)
+    , m_nextPage(0)
+    , m_nextWrittenPage(0)
+    , m_stop(false)
+{
+}
+
+TextExporter::~TextExporter() = default;
+
+bool TextExporter::exportTo(QIODevice *device)
+{
+    // Only the generators with the Threaded feature have textPage() called out of the GUI thread
+    if (!m_generator->hasFeature(Generator::Threaded)) {
+        for (int i = 0; i < m_pages.count(); ++i) {
+            const QByteArray data = extractText(i).toUtf8();
+            if (device->write(data) != data.size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The core extracts text pages in a thread of its own too, the workers take over from it.
+    // None starts meanwhile, that happens in the GUI thread we are blocking.
+    TextPageGenerationThread *textPageThread = m_generator->d_ptr->mTextPageGenerationThread;
+    if (textPageThread) {
+        textPageThread->wait();
+    }
+
+    const int workerCount = qBound(1, QThread::idealThreadCount(), 8);
+    std::vector<std::unique_ptr<QThread>> workers;
+    for (int i = 0; i < qMin<int>(workerCount, m_pages.count()); ++i) {
+        workers.emplace_back(QThread::create([this, workerCount] {
+            QMutexLocker locker(&m_mutex);
+            while (!m_stop && m_nextPage < m_pages.count()) {
+                // don't run too far ahead of the writer
+                if (m_nextPage - m_nextWrittenPage >= workerCount * pagesAheadPerWorker) {
+                    m_pageWritten.wait(&m_mutex);
+                    continue;
+                }
+
+                const int pageNumber = m_nextPage++;
+                locker.unlock();
+                const QString text = extractText(pageNumber);
+                locker.relock();
+
+                m_texts.insert(pageNumber, text);
+                m_pageDone.wakeAll();
+            }
+        }));
+        workers.back()->start();
+    }
+
+    bool success = true;
+    QMutexLocker locker(&m_mutex);
+    while (m_nextWrittenPage < m_pages.count()) {
+        const auto it = m_texts.find(m_nextWrittenPage);
+        if (it == m_texts.end()) {
+            m_pageDone.wait(&m_mutex);
+            continue;
+        }
+
+        const QByteArray data = it.value().toUtf8();
+        m_texts.erase(it);
+        ++m_nextWrittenPage;
+        m_pageWritten.wakeAll();
+
+        locker.unlock();
+        success = device->write(data) == data.size();
+        locker.relock();
+
+        if (!success) {
+            m_stop = true;
+            m_pageWritten.wakeAll();
+            break;
+        }
+    }
+    locker.unlock();
+
+    for (const std::unique_ptr<QThread> &worker : workers) {
+        worker->wait();
+    }
+    m_texts.clear();
+
+    return success;
+}
+
+QString TextExporter::extractText(int pageNumber)
+{
+    Page *page = m_pages.at(pageNumber);
+    const Tracing::Scope scope("text", "export text", {{"page", pageNumber}});
+
+    TextPage *textPage;
+    {
+        QMutexLocker locker(&m_generatorMutex);
+        TextRequest request(page);
+        textPage = m_generator->textPage(&request);
+    }
+    if (!textPage) {
+        return QString();
+    }
+
+    // A page of our own puts the text in reading order, leaving the one of the document alone
+    Page orderedPage(pageNumber, page->width(), page->height(), Rotation0);
+    orderedPage.setTextPage(textPage);
+    return orderedPage.text(nullptr).normalized(QString::NormalizationForm_C);
+}
@@ -0,0 +1,74 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _OKULAR_TEXTEXPORTER_P_H_
+#define _OKULAR_TEXTEXPORTER_P_H_
+
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+
+class QIODevice;
+
+namespace Okular
+{
+class Generator;
+class Page;
+
+/**
+ * Writes the text of all the pages of a document to a device, for the
+ * generators that provide TextPage's but no text export of their own.
+ *
+ * Pages are extracted and put in reading order by a few worker threads,
+ * and written in page order by the calling thread. Only a few pages
+ * ahead of the one being written are kept in memory at any time, and the
+ * text pages are not stored in the pages of the document.
+ *
+ * The workers are only used for the generators with the Threaded feature:
+ * the core already calls their textPage() in a thread while image() runs in
+ * another, so they protect what the two share with userMutex() themselves.
+ * The workers call textPage() one at a time, as the core does; the other
+ * generators get it called in the calling thread.
+ */
+class TextExporter
+{
+public:
+    TextExporter(Generator *generator, const QList<Page *> &pages);
+    ~TextExporter();
+
+    TextExporter(const TextExporter &) = delete;
+    TextExporter &operator=(const TextExporter &) = delete;
+
+    /**
+     * Writes the text as UTF-8 to @p device, which must be open.
+     * Returns false if writing failed.
+     */
+    bool exportTo(QIODevice *device);
+
+private:
+    QString extractText(int pageNumber);
+
+    Generator *m_generator;
+    const QList<Page *> m_pages;
+
+    // textPage() is not reentrant, only one worker calls it at a time; not userMutex(),
+    // which the generators lock in textPage() themselves
+    QMutex m_generatorMutex;
+
+    QMutex m_mutex;
+    QWaitCondition m_pageDone;
+    QWaitCondition m_pageWritten;
+    int m_nextPage; // next page to give to a worker
+    int m_nextWrittenPage; // next page to write
+    QMap<int, QString> m_texts; // extracted pages waiting to be written
+    bool m_stop;
+};
+
+}
+
+#endif
@@ -14,39 +14,15 @@
 #include "misc.h"
 #include "page.h"
 #include "page_p.h"
-#include <unordered_set>
 
-#include <QVarLengthArray>
 #include <QtAlgorithms>
 #include <cstring>
+#include <numeric>
+#include <vector>
 
 using namespace Okular;
 using namespace Qt::Literals::StringLiterals;
 
-// Many of the strings are being reused; especially
-// those less than 2 letters are very common
-// Use the implicit shared bits from QString to
-// not keep multiple same strings around, but just up the
-// refcount a bit
-// The main reason for '2' is that most calls here happens
-// in auxiliary threads that are following a document
-// and keeping the pool thread_local gives quite a bit
-// of advantage here.
-// Some calls though comes from the main thread, so we
-// shouldn't keep all the long strings allocated in the main
-// thread around forever.
-// '2' has been chosen by random testing, and guesswork.
-static QString fromPool(const QString &str)
-{
-    if (str.length() > 2) {
-        return str;
-    }
-
-    thread_local std::unordered_set<QString> pool;
-    auto [iterator, success] = pool.insert(str);
-    return *iterator;
-}
-
 class SearchPoint
 {
 public:
@@ -57,18 +33,18 @@ public:
     }
 
     /** The TextEntity containing the first character of the match. */
-    TextEntity::List::ConstIterator it_begin;
+    TextEntityList::ConstIterator it_begin;
 
     /** The TextEntity containing the last character of the match. */
-    TextEntity::List::ConstIterator it_end;
+    TextEntityList::ConstIterator it_end;
 
-    /** The index of the first character of the match in (*it_begin)->text().
-     *  Satisfies 0 <= offset_begin < (*it_begin)->text().length().
+    /** The index of the first character of the match in it_begin.text().
+     *  Satisfies 0 <= offset_begin < it_begin.text().length().
      */
     int offset_begin;
 
-    /** One plus the index of the last character of the match in (*it_end)->text().
-     *  Satisfies 0 < offset_end <= (*it_end)->text().length().
+    /** One plus the index of the last character of the match in it_end.text().
+     *  Satisfies 0 < offset_end <= it_end.text().length().
      */
     int offset_end;
 };
@@ -132,7 +108,7 @@ static bool doesConsumeY(const NormalizedRect &first, const NormalizedRect &seco
 }
 
 TextEntity::TextEntity(const QString &text, const NormalizedRect &area)
-    : m_text(fromPool(text))
+    : m_text(text)
     , m_area(area)
 {
 }
@@ -156,6 +132,75 @@ NormalizedRect TextEntity::transformedArea(const QTransform &matrix) const
     return transformed_area;
 }
 
+TextEntityList::TextEntityList()
+    : m_offsets(1, 0)
+{
+}
+
+TextEntityList::TextEntityList(const TextEntity::List &list)
+    : TextEntityList()
+{
+    qsizetype length = 0;
+    for (const TextEntity &entity : list) {
+        length += entity.text().length();
+    }
+    m_text.reserve(length);
+    m_offsets.reserve(list.count() + 1);
+    m_boxes.reserve(list.count() * 4);
+
+    for (const TextEntity &entity : list) {
+        append(entity.text(), entity.area());
+    }
+}
+
+TextEntity TextEntityList::at(qsizetype index) const
+{
+    return TextEntity(textAt(index).toString(), areaAt(index));
+}
+
+void TextEntityList::append(const QString &text, const NormalizedRect &area)
+{
+    m_text.append(text);
+    m_offsets.push_back(m_text.length());
+    m_boxes.insert(m_boxes.end(), {float(area.left), float(area.top), float(area.right), float(area.bottom)});
+}
+
+void TextEntityList::removeLast()
+{
+    m_offsets.pop_back();
+    m_text.truncate(m_offsets.back());
+    m_boxes.resize(m_boxes.size() - 4);
+}
+
+void TextEntityList::clear()
+{
+    m_text.clear();
+    m_offsets.assign(1, 0);
+    m_boxes.clear();
+}
+
+void TextEntityList::squeeze()
+{
+    m_text.squeeze();
+    m_offsets.shrink_to_fit();
+    m_boxes.shrink_to_fit();
+}
+
+TextEntity::List TextEntityList::toList() const
+{
+    TextEntity::List list;
+    list.reserve(count());
+    for (qsizetype i = 0; i < count(); ++i) {
+        list.append(TextEntity(textAt(i).toString(), areaAt(i)));
+    }
+    return list;
+}
+
+qint64 TextEntityList::memoryUsage() const
+{
+    return m_text.capacity() * sizeof(QChar) + m_offsets.capacity() * sizeof(quint32) + m_boxes.capacity() * sizeof(float);
+}
+
 TextPagePrivate::TextPagePrivate()
     : m_page(nullptr)
 {
@@ -174,7 +219,7 @@ TextPage::TextPage()
 TextPage::TextPage(const TextEntity::List &words)
     : d(new TextPagePrivate())
 {
-    d->m_words = words;
+    d->m_words = TextEntityList(words);
 }
 
 TextPage::~TextPage()
@@ -186,19 +231,19 @@ void TextPage::append(const QString &text, const NormalizedRect &area)
 {
     if (!text.isEmpty()) {
         if (!d->m_words.isEmpty()) {
-            const TextEntity &lastEntity = d->m_words.last();
+            const TextEntity lastEntity = d->m_words.last();
             // Unicode Normalization Form KC (NFKC) may alter characters, for example ⑥ to 6, so we use NFC
             const QString concatText = lastEntity.text() + text.normalized(QString::NormalizationForm_C);
             if (concatText != concatText.normalized(QString::NormalizationForm_C)) {
                 // If this happens it means that the new text + old one have combined, for example A and ◌̊  form Å
                 NormalizedRect newArea = area | lastEntity.area();
                 d->m_words.removeLast();
-                d->m_words.append(TextEntity(concatText.normalized(QString::NormalizationForm_C), newArea));
+                d->m_words.append(concatText.normalized(QString::NormalizationForm_C), newArea);
                 return;
             }
         }
 
-        d->m_words.append(TextEntity(text.normalized(QString::NormalizationForm_C), area));
+        d->m_words.append(text.normalized(QString::NormalizationForm_C), area);
     }
 }
 
@@ -225,53 +270,38 @@ struct WordWithCharacters {
 typedef QList<WordWithCharacters> WordsWithCharacters;
 
 /**
- * We will divide the whole page in some regions depending on the horizontal and
- * vertical spacing among different regions. Each region will have an area and an
- * associated WordsWithCharacters in sorted order.
+ * The geometries of the words of a page, computed once for the whole layout
+ * analysis instead of every time two words are compared.
  */
-class RegionText
-{
-public:
-    RegionText() { };
-
-    RegionText(const WordsWithCharacters &wordsWithCharacters, const QRect area)
-        : m_region_wordWithCharacters(wordsWithCharacters)
-        , m_area(area)
-    {
-    }
-
-    inline QString string() const
+struct WordGeometries {
+    WordGeometries(const WordsWithCharacters &words, int pageWidth, int pageHeight)
     {
-        QString res;
-        for (const WordWithCharacters &word : m_region_wordWithCharacters) {
-            res += word.text();
+        geometry.reserve(words.count());
+        roundedGeometry.reserve(words.count());
+        sortPosition.reserve(words.count());
+        for (const WordWithCharacters &word : words) {
+            const NormalizedRect area = word.area();
+            geometry.push_back(area.geometry(pageWidth, pageHeight));
+            roundedGeometry.push_back(area.roundedGeometry(pageWidth, pageHeight));
+            sortPosition.push_back(area.roundedGeometry(1000, 1000).topLeft());
         }
-        return res;
     }
 
-    inline WordsWithCharacters text() const
-    {
-        return m_region_wordWithCharacters;
-    }
-
-    inline QRect area() const
-    {
-        return m_area;
-    }
-
-    inline void setArea(const QRect area)
-    {
-        m_area = area;
-    }
-
-    inline void setText(const WordsWithCharacters &wordsWithCharacters)
-    {
-        m_region_wordWithCharacters = wordsWithCharacters;
-    }
+    std::vector<QRect> geometry;
+    std::vector<QRect> roundedGeometry;
+    // where the words are sorted to make lines
+    std::vector<QPoint> sortPosition;
+};
 
-private:
-    WordsWithCharacters m_region_wordWithCharacters;
-    QRect m_area;
+/**
+ * We will divide the whole page in some regions depending on the horizontal and
+ * vertical spacing among different regions. Each region will have an area and the
+ * indexes of its words in the WordsWithCharacters of the page, in sorted order.
+ * Lines of text are kept in the same way.
+ */
+struct TextRegion {
+    std::vector<int> words;
+    QRect area;
 };
 
 std::unique_ptr<RegularAreaRect> TextPage::textArea(const TextSelection &sel) const
@@ -386,14 +416,14 @@ std::unique_ptr<RegularAreaRect> TextPage::textArea(const TextSelection &sel) co
         }
     }
 
-    TextEntity::List::ConstIterator it = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
-    TextEntity::List::ConstIterator start = it, end = itEnd, tmpIt = it; //, tmpItEnd = itEnd;
+    TextEntityList::ConstIterator it = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
+    TextEntityList::ConstIterator start = it, end = itEnd, tmpIt = it; //, tmpItEnd = itEnd;
     const MergeSide side = d->m_page ? (MergeSide)d->m_page->totalOrientation() : MergeRight;
 
     NormalizedRect tmp;
     // case 2(a)
     for (; it != itEnd; ++it) {
-        tmp = it->area();
+        tmp = it.area();
         if (tmp.contains(startC.x, startC.y)) {
             start = it;
         }
@@ -407,7 +437,7 @@ std::unique_ptr<RegularAreaRect> TextPage::textArea(const TextSelection &sel) co
     if (start == it && end == itEnd) {
         for (; it != itEnd; ++it) {
             // is there any text rectangle within the start_end rect
-            tmp = it->area();
+            tmp = it.area();
             if (start_end.intersects(tmp)) {
                 break;
             }
@@ -429,7 +459,7 @@ std::unique_ptr<RegularAreaRect> TextPage::textArea(const TextSelection &sel) co
         // selection type 01
         if (startC.y <= endC.y) {
             for (; it != itEnd; ++it) {
-                rect = it->area();
+                rect = it.area();
                 bool flagV = !rect.isBottom(startC);
 
                 if (flagV && rect.isRight(startC)) {
@@ -445,7 +475,7 @@ std::unique_ptr<RegularAreaRect> TextPage::textArea(const TextSelection &sel) co
             int distance = scaleX + scaleY + 100;
 
             for (; it != itEnd; ++it) {
-                rect = it->area();
+                rect = it.area();
 
                 if (rect.isBottomOrLevel(startC) && rect.isRight(startC)) {
                     QRect entRect = rect.geometry(scaleX, scaleY);
@@ -479,7 +509,7 @@ std::unique_ptr<RegularAreaRect> TextPage::textArea(const TextSelection &sel) co
 
         if (startC.y <= endC.y) {
             for (; itEnd >= it; itEnd--) {
-                rect = itEnd->area();
+                rect = itEnd.area();
                 bool flagV = !rect.isTop(endC);
 
                 if (flagV && rect.isLeft(endC)) {
@@ -492,7 +522,7 @@ std::unique_ptr<RegularAreaRect> TextPage::textArea(const TextSelection &sel) co
         else {
             int distance = scaleX + scaleY + 100;
             for (; itEnd >= it; itEnd--) {
-                rect = itEnd->area();
+                rect = itEnd.area();
 
                 if (rect.isTopOrLevel(endC) && rect.isLeft(endC)) {
                     QRect entRect = rect.geometry(scaleX, scaleY);
@@ -553,9 +583,9 @@ RegularAreaRect *TextPage::findText(int searchID, const QString &query, SearchDi
     if (d->m_words.isEmpty() || query.isEmpty() || (area && area->isNull())) {
         return nullptr;
     }
-    TextEntity::List::ConstIterator start;
+    TextEntityList::ConstIterator start;
     int start_offset = 0;
-    TextEntity::List::ConstIterator end;
+    TextEntityList::ConstIterator end;
     const QMap<int, SearchPoint *>::const_iterator sIt = d->m_searchPoints.constFind(searchID);
     if (sIt == d->m_searchPoints.constEnd()) {
         // if no previous run of this search is found, then set it to start
@@ -605,7 +635,7 @@ RegularAreaRect *TextPage::findText(int searchID, const QString &query, SearchDi
 // we have a '-' just followed by a '\n' character
 // check if the string contains a '-' character
 // if the '-' is the last entry
-static int stringLengthAdaptedWithHyphen(const QString &str, TextEntity::List::ConstIterator it, TextEntity::List::ConstIterator textListEnd)
+static int stringLengthAdaptedWithHyphen(const QString &str, TextEntityList::ConstIterator it, TextEntityList::ConstIterator textListEnd)
 {
     const int len = str.length();
 
@@ -617,14 +647,14 @@ static int stringLengthAdaptedWithHyphen(const QString &str, TextEntity::List::C
         // validity check of it + 1
         if ((it + 1) != textListEnd) {
             // 1. if the next character is '\n'
-            const QString &lookahedStr = (it + 1)->text();
+            const QString lookahedStr = (it + 1).rawText();
             if (lookahedStr.startsWith(QLatin1Char('\n'))) {
                 return len - 1;
             }
 
             // 2. if the next word is in a different line or not
-            const NormalizedRect &hyphenArea = it->area();
-            const NormalizedRect &lookaheadArea = (it + 1)->area();
+            const NormalizedRect hyphenArea = it.area();
+            const NormalizedRect lookaheadArea = (it + 1).area();
 
             // lookahead to check whether both the '-' rect and next character rect overlap
             if (!doesConsumeY(hyphenArea, lookaheadArea, 70)) {
@@ -646,9 +676,10 @@ RegularAreaRect *TextPagePrivate::searchPointToArea(const SearchPoint *sp)
     const QTransform matrix = pagePrivate ? pagePrivate->rotationMatrix() : QTransform();
     RegularAreaRect *ret = new RegularAreaRect;
 
-    for (TextEntity::List::ConstIterator it = sp->it_begin;; it++) {
-        const TextEntity &curEntity = *it;
-        ret->append(curEntity.transformedArea(matrix));
+    for (TextEntityList::ConstIterator it = sp->it_begin;; it++) {
+        NormalizedRect area = it.area();
+        area.transform(matrix);
+        ret->append(area);
 
         if (it == sp->it_end) {
             break;
@@ -659,7 +690,7 @@ RegularAreaRect *TextPagePrivate::searchPointToArea(const SearchPoint *sp)
     return ret;
 }
 
-RegularAreaRect *TextPagePrivate::findTextInternalForward(int searchID, const QString &_query, TextComparisonFunction comparer, TextEntity::List::ConstIterator start, int start_offset, TextEntity::List::ConstIterator end)
+RegularAreaRect *TextPagePrivate::findTextInternalForward(int searchID, const QString &_query, TextComparisonFunction comparer, TextEntityList::ConstIterator start, int start_offset, TextEntityList::ConstIterator end)
 {
     // normalize query search all unicode (including glyphs)
     // Use NFKC for search operations. Use NFC for copy, makeWord, and export operations.
@@ -669,15 +700,15 @@ RegularAreaRect *TextPagePrivate::findTextInternalForward(int searchID, const QS
     // queryLeft is the length of the query we have left to match
     int j = 0, queryLeft = query.length();
 
-    TextEntity::List::ConstIterator it = start;
+    TextEntityList::ConstIterator it = start;
     int offset = start_offset;
 
-    TextEntity::List::ConstIterator it_begin = TextEntity::List::ConstIterator();
+    TextEntityList::ConstIterator it_begin = TextEntityList::ConstIterator();
     int offset_begin = 0; // dummy initial value to suppress compiler warnings
 
     while (it != end) {
-        const TextEntity &curEntity = *it;
-        const QString &str = curEntity.text().normalized(QString::NormalizationForm_KC);
+        // normalized() may hand back the raw text itself, str is only used in this iteration
+        const QString str = it.rawText().normalized(QString::NormalizationForm_KC);
         const int strLen = str.length();
         const int adjustedLen = stringLengthAdaptedWithHyphen(str, it, m_words.constEnd());
         // adjustedLen <= strLen
@@ -688,7 +719,7 @@ RegularAreaRect *TextPagePrivate::findTextInternalForward(int searchID, const QS
             continue;
         }
 
-        if (it_begin == TextEntity::List::ConstIterator()) {
+        if (it_begin == TextEntityList::ConstIterator()) {
             it_begin = it;
             offset_begin = offset;
         }
@@ -717,7 +748,7 @@ RegularAreaRect *TextPagePrivate::findTextInternalForward(int searchID, const QS
             queryLeft = query.length();
             it = it_begin;
             offset = offset_begin + 1;
-            it_begin = TextEntity::List::ConstIterator();
+            it_begin = TextEntityList::ConstIterator();
         } else {
             // we have a match
             // move the current position in the query
@@ -760,7 +791,7 @@ RegularAreaRect *TextPagePrivate::findTextInternalForward(int searchID, const QS
     return nullptr;
 }
 
-RegularAreaRect *TextPagePrivate::findTextInternalBackward(int searchID, const QString &_query, TextComparisonFunction comparer, TextEntity::List::ConstIterator start, int start_offset, TextEntity::List::ConstIterator end)
+RegularAreaRect *TextPagePrivate::findTextInternalBackward(int searchID, const QString &_query, TextComparisonFunction comparer, TextEntityList::ConstIterator start, int start_offset, TextEntityList::ConstIterator end)
 {
     // normalize query to search all unicode (including glyphs)
     // Use NFKC for search operations. Use NFC for copy, makeWord, and export operations.
@@ -771,10 +802,10 @@ RegularAreaRect *TextPagePrivate::findTextInternalBackward(int searchID, const Q
     // queryLeft is the length of the query we have left
     int j = query.length(), queryLeft = query.length();
 
-    TextEntity::List::ConstIterator it = start;
+    TextEntityList::ConstIterator it = start;
     int offset = start_offset;
 
-    TextEntity::List::ConstIterator it_begin = TextEntity::List::ConstIterator();
+    TextEntityList::ConstIterator it_begin = TextEntityList::ConstIterator();
     int offset_begin = 0; // dummy initial value to suppress compiler warnings
 
     while (true) {
@@ -785,8 +816,8 @@ RegularAreaRect *TextPagePrivate::findTextInternalBackward(int searchID, const Q
             it--;
         }
 
-        const TextEntity &curEntity = *it;
-        const QString &str = curEntity.text().normalized(QString::NormalizationForm_KC);
+        // normalized() may hand back the raw text itself, str is only used in this iteration
+        const QString str = it.rawText().normalized(QString::NormalizationForm_KC);
         const int strLen = str.length();
         const int adjustedLen = stringLengthAdaptedWithHyphen(str, it, m_words.constEnd());
         // adjustedLen <= strLen
@@ -795,7 +826,7 @@ RegularAreaRect *TextPagePrivate::findTextInternalBackward(int searchID, const Q
             offset = strLen;
         }
 
-        if (it_begin == TextEntity::List::ConstIterator()) {
+        if (it_begin == TextEntityList::ConstIterator()) {
             it_begin = it;
             offset_begin = offset;
         }
@@ -826,7 +857,7 @@ RegularAreaRect *TextPagePrivate::findTextInternalBackward(int searchID, const Q
             queryLeft = query.length();
             it = it_begin;
             offset = offset_begin - 1;
-            it_begin = TextEntity::List::ConstIterator();
+            it_begin = TextEntityList::ConstIterator();
         } else {
             // we have a match
             // move the current position in the query
@@ -879,51 +910,40 @@ QString TextPage::text(const RegularAreaRect *area, TextAreaInclusionBehaviour b
         return QString();
     }
 
-    TextEntity::List::ConstIterator it = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
+    TextEntityList::ConstIterator it = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
     QString ret;
     if (area) {
         for (; it != itEnd; ++it) {
             if (b == AnyPixelTextAreaInclusionBehaviour) {
-                if (area->intersects(it->area())) {
-                    ret += it->text();
+                if (area->intersects(it.area())) {
+                    ret += it.text();
                 }
             } else {
-                NormalizedPoint center = it->area().center();
+                NormalizedPoint center = it.area().center();
                 if (area->contains(center.x, center.y)) {
-                    ret += it->text();
+                    ret += it.text();
                 }
             }
         }
     } else {
-        for (; it != itEnd; ++it) {
-            ret += it->text();
+        for (qsizetype i = 0; i < d->m_words.count(); ++i) {
+            ret += d->m_words.textAt(i);
         }
     }
     return ret;
 }
 
-static bool compareTinyTextEntityX(const WordWithCharacters &first, const WordWithCharacters &second)
-{
-    QRect firstArea = first.area().roundedGeometry(1000, 1000);
-    QRect secondArea = second.area().roundedGeometry(1000, 1000);
-
-    return firstArea.left() < secondArea.left();
-}
-
-static bool compareTinyTextEntityY(const WordWithCharacters &first, const WordWithCharacters &second)
-{
-    const QRect firstArea = first.area().roundedGeometry(1000, 1000);
-    const QRect secondArea = second.area().roundedGeometry(1000, 1000);
-
-    return firstArea.top() < secondArea.top();
-}
-
 /**
  * Sets a new world list. Deleting the contents of the old one
  */
 void TextPagePrivate::setWordList(const TextEntity::List &list)
 {
-    m_words = list;
+    m_words = TextEntityList(list);
+}
+
+qint64 TextPagePrivate::memoryUsage() const
+{
+    return sizeof(TextPagePrivate) + m_words.memoryUsage();
 }
 
 /**
@@ -1040,7 +1060,7 @@ static WordsWithCharacters makeWordFromCharacters(const TextEntity::List &charac
 /**
  * Create Lines from the words and sort them
  */
-QList<QPair<WordsWithCharacters, QRect>> makeAndSortLines(const WordsWithCharacters &wordsTmp, int pageWidth, int pageHeight)
+static std::vector<TextRegion> makeAndSortLines(const std::vector<int> &wordsTmp, const WordGeometries &geometries)
 {
     /**
      * We cannot assume that the generator will give us texts in the right order.
@@ -1053,31 +1073,24 @@ QList<QPair<WordsWithCharacters, QRect>> makeAndSortLines(const WordsWithCharact
      * 3. Within each line sort the TinyTextEntity 's by x0(left)
      */
 
-    QList<QPair<WordsWithCharacters, QRect>> lines;
-
-    /*
-     Make a new copy of the TextList in the words, so that the wordsTmp and lines do
-     not contain same pointers for all the TinyTextEntity.
-     */
-    QList<WordWithCharacters> words = wordsTmp;
+    std::vector<TextRegion> lines;
 
     // Step 1
-    std::sort(words.begin(), words.end(), compareTinyTextEntityY);
+    std::vector<int> words = wordsTmp;
+    std::sort(words.begin(), words.end(), [&geometries](int first, int second) { return geometries.sortPosition[first].y() < geometries.sortPosition[second].y(); });
 
     // Step 2
-    QList<WordWithCharacters>::Iterator it = words.begin(), itEnd = words.end();
-
     // for every non-space texts(characters/words) in the textList
-    for (; it != itEnd; it++) {
-        const QRect elementArea = (*it).area().roundedGeometry(pageWidth, pageHeight);
+    for (const int word : words) {
+        const QRect elementArea = geometries.roundedGeometry[word];
         bool found = false;
 
-        for (QPair<WordsWithCharacters, QRect> &linesI : lines) {
+        for (TextRegion &line : lines) {
             /* the line area which will be expanded
                line_rects is only necessary to preserve the topmin and bottommax of all
                the texts in the line, left and right is not necessary at all
             */
-            QRect &lineArea = linesI.second;
+            QRect &lineArea = line.area;
             const int text_y1 = elementArea.top(), text_y2 = elementArea.top() + elementArea.height(), text_x1 = elementArea.left(), text_x2 = elementArea.left() + elementArea.width();
             const int line_y1 = lineArea.top(), line_y2 = lineArea.top() + lineArea.height(), line_x1 = lineArea.left(), line_x2 = lineArea.left() + lineArea.width();
 
@@ -1086,8 +1099,7 @@ QList<QPair<WordsWithCharacters, QRect>> makeAndSortLines(const WordsWithCharact
                the text will be added to this line
              */
             if (doesConsumeY(elementArea, lineArea, 70)) {
-                WordsWithCharacters &line = linesI.first;
-                line.append(*it);
+                line.words.push_back(word);
 
                 const int newLeft = line_x1 < text_x1 ? line_x1 : text_x1;
                 const int newRight = line_x2 > text_x2 ? line_x2 : text_x2;
@@ -1096,9 +1108,6 @@ QList<QPair<WordsWithCharacters, QRect>> makeAndSortLines(const WordsWithCharact
 
                 lineArea = QRect(newLeft, newTop, newRight - newLeft, newBottom - newTop);
                 found = true;
-            }
-
-            if (found) {
                 break;
             }
         }
@@ -1107,16 +1116,14 @@ QList<QPair<WordsWithCharacters, QRect>> makeAndSortLines(const WordsWithCharact
            only one element and append it to the lines
          */
         if (!found) {
-            lines.append(QPair<WordsWithCharacters, QRect>({*it}, elementArea));
+            lines.push_back(TextRegion {{word}, elementArea});
         }
     }
 
     // Step 3
-    for (QPair<WordsWithCharacters, QRect> &line : lines) {
-        WordsWithCharacters &list = line.first;
-        std::sort(list.begin(), list.end(), compareTinyTextEntityX);
+    for (TextRegion &line : lines) {
+        std::sort(line.words.begin(), line.words.end(), [&geometries](int first, int second) { return geometries.sortPosition[first].x() < geometries.sortPosition[second].x(); });
     }
-    lines.shrink_to_fit();
 
     return lines;
 }
@@ -1124,7 +1131,7 @@ QList<QPair<WordsWithCharacters, QRect>> makeAndSortLines(const WordsWithCharact
 /**
  * Calculate Statistical information from the lines we made previously
  */
-static void calculateStatisticalInformation(const QList<WordWithCharacters> &words, int pageWidth, int pageHeight, int *word_spacing, int *line_spacing, int *col_spacing)
+static void calculateStatisticalInformation(const std::vector<TextRegion> &sortedLines, int pageWidth, const WordGeometries &geometries, int *word_spacing, int *line_spacing, int *col_spacing)
 {
     /**
      * For the region, defined by line_rects and lines
@@ -1133,33 +1140,20 @@ static void calculateStatisticalInformation(const QList<WordWithCharacters> &wor
      *   word spacing and column spacing.
      */
 
-    /**
-     * Step 0
-     */
-    const QList<QPair<WordsWithCharacters, QRect>> sortedLines = makeAndSortLines(words, pageWidth, pageHeight);
-
     /**
      * Step 1
      */
     QMap<int, int> line_space_stat;
-    for (int i = 0; i < sortedLines.length(); i++) {
-        const QRect rectUpper = sortedLines.at(i).second;
-
-        if (i + 1 == sortedLines.length()) {
-            break;
-        }
-        const QRect rectLower = sortedLines.at(i + 1).second;
+    for (size_t i = 0; i + 1 < sortedLines.size(); i++) {
+        const QRect rectUpper = sortedLines[i].area;
+        const QRect rectLower = sortedLines[i + 1].area;
 
         int linespace = rectLower.top() - (rectUpper.top() + rectUpper.height());
         if (linespace < 0) {
             linespace = -linespace;
         }
 
-        if (line_space_stat.contains(linespace)) {
-            line_space_stat[linespace]++;
-        } else {
-            line_space_stat[linespace] = 1;
-        }
+        line_space_stat[linespace]++;
     }
 
     *line_spacing = 0;
@@ -1181,87 +1175,40 @@ static void calculateStatisticalInformation(const QList<WordWithCharacters> &wor
     // We would like to use QMap instead of QHash as it will keep the keys sorted
     QMap<int, int> hor_space_stat;
     QMap<int, int> col_space_stat;
-    QList<QList<QRect>> space_rects;
-    QList<QRect> max_hor_space_rects;
 
     // Space in every line
-    for (const QPair<WordsWithCharacters, QRect> &sortedLine : sortedLines) {
-        const WordsWithCharacters list = sortedLine.first;
-        QList<QRect> line_space_rects;
-        int maxSpace = 0, minSpace = pageWidth;
+    for (const TextRegion &sortedLine : sortedLines) {
+        const std::vector<int> &list = sortedLine.words;
+        int maxSpace = 0;
 
         // for every TinyTextEntity element in the line
-        WordsWithCharacters::ConstIterator it = list.begin(), itEnd = list.end();
-        QRect max_area1, max_area2;
-        // for every line
-        for (; it != itEnd; it++) {
-            const QRect area1 = (*it).area().roundedGeometry(pageWidth, pageHeight);
-            if (it + 1 == itEnd) {
-                break;
-            }
-
-            const QRect area2 = (*(it + 1)).area().roundedGeometry(pageWidth, pageHeight);
-            int space = area2.left() - area1.right();
+        for (size_t k = 0; k + 1 < list.size(); k++) {
+            const QRect area1 = geometries.roundedGeometry[list[k]];
+            const QRect area2 = geometries.roundedGeometry[list[k + 1]];
+            const int space = area2.left() - area1.right();
 
             if (space > maxSpace) {
-                max_area1 = area1;
-                max_area2 = area2;
                 maxSpace = space;
             }
 
-            if (space < minSpace && space != 0) {
-                minSpace = space;
-            }
-
             // if we found a real space, whose length is not zero and also less than the pageWidth
             if (space != 0 && space != pageWidth) {
                 // increase the count of the space amount
-                if (hor_space_stat.contains(space)) {
-                    hor_space_stat[space]++;
-                } else {
-                    hor_space_stat[space] = 1;
-                }
-
-                int left, right, top, bottom;
-
-                left = area1.right();
-                right = area2.left();
-
-                top = area2.top() < area1.top() ? area2.top() : area1.top();
-                bottom = area2.bottom() > area1.bottom() ? area2.bottom() : area1.bottom();
-
-                QRect rect(left, top, right - left, bottom - top);
-                line_space_rects.append(rect);
+                hor_space_stat[space]++;
             }
         }
 
-        space_rects.append(line_space_rects);
-
-        if (hor_space_stat.contains(maxSpace)) {
-            if (hor_space_stat[maxSpace] != 1) {
-                hor_space_stat[maxSpace]--;
+        const auto maxSpaceIt = hor_space_stat.find(maxSpace);
+        if (maxSpaceIt != hor_space_stat.end()) {
+            if (maxSpaceIt.value() != 1) {
+                maxSpaceIt.value()--;
             } else {
-                hor_space_stat.remove(maxSpace);
+                hor_space_stat.erase(maxSpaceIt);
             }
         }
 
         if (maxSpace != 0) {
-            if (col_space_stat.contains(maxSpace)) {
-                col_space_stat[maxSpace]++;
-            } else {
-                col_space_stat[maxSpace] = 1;
-            }
-
-            // store the max rect of each line
-            const int left = max_area1.right();
-            const int right = max_area2.left();
-            const int top = (max_area1.top() > max_area2.top()) ? max_area2.top() : max_area1.top();
-            const int bottom = (max_area1.bottom() < max_area2.bottom()) ? max_area2.bottom() : max_area1.bottom();
-
-            const QRect rect(left, top, right - left, bottom - top);
-            max_hor_space_rects.append(rect);
-        } else {
-            max_hor_space_rects.append(QRect(0, 0, 0, 0));
+            col_space_stat[maxSpace]++;
         }
     }
 
@@ -1294,54 +1241,74 @@ static void calculateStatisticalInformation(const QList<WordWithCharacters> &wor
     *col_spacing = col_space_stat.key(*col_spacing);
 
     // if there is just one line in a region, there is no point in dividing it
-    if (sortedLines.length() == 1) {
+    if (sortedLines.size() == 1) {
         *word_spacing = *col_spacing;
     }
 }
 
+/**
+ * Adds @p value to the items of @p profile from @p from to @p to, clipped to the size of @p profile.
+ * The profile holds the differences between consecutive items, see accumulateProfile().
+ */
+static void addToProfile(std::vector<int> &profile, int size, int from, int to, int value)
+{
+    from = qMax(from, 0);
+    to = qMin(to, size - 1);
+    if (from <= to) {
+        profile[from] += value;
+        profile[to + 1] -= value;
+    }
+}
+
+/**
+ * Turns the differences collected with addToProfile() into the profile.
+ */
+static void accumulateProfile(std::vector<int> &profile, int size)
+{
+    for (int j = 1; j < size; ++j) {
+        profile[j] += profile[j - 1];
+    }
+}
+
 /**
  * Implements the XY Cut algorithm for textpage segmentation
- * The resulting RegionTextList will contain RegionText whose WordsWithCharacters::word and
- * WordsWithCharacters::characters are reused from wordsWithCharacters (i.e. no new nor delete happens in this function)
+ * The resulting regions refer to the words by their index in wordsWithCharacters
  */
-static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wordsWithCharacters, int pageWidth, int pageHeight)
+static std::vector<TextRegion> XYCutForBoundingBoxes(const WordsWithCharacters &wordsWithCharacters, const WordGeometries &geometries, int pageWidth, int pageHeight)
 {
-    RegionTextList tree;
-    QRect contentRect(0, 0, pageWidth, pageHeight);
-    const RegionText root(wordsWithCharacters, contentRect);
+    std::vector<TextRegion> tree;
+    TextRegion root;
+    root.words.resize(wordsWithCharacters.count());
+    std::iota(root.words.begin(), root.words.end(), 0);
+    root.area = QRect(0, 0, pageWidth, pageHeight);
 
     // start the tree with the root, it is our only region at the start
-    tree.push_back(root);
+    tree.push_back(std::move(root));
+
+    // the projection profiles, reused for all the regions
+    std::vector<int> proj_on_xaxis;
+    std::vector<int> proj_on_yaxis;
 
-    int i = 0;
+    size_t i = 0;
 
     // while traversing the tree has not been ended
-    while (i < tree.length()) {
-        const RegionText node = tree.at(i);
-        QRect regionRect = node.area();
+    while (i < tree.size()) {
+        QRect regionRect = tree[i].area;
 
         /**
          * 1. calculation of projection profiles
          */
         // allocate the size of proj profiles and initialize with 0
-        int size_proj_y = node.area().height();
-        int size_proj_x = node.area().width();
-        // dynamic memory allocation
-        QVarLengthArray<int> proj_on_xaxis(size_proj_x);
-        QVarLengthArray<int> proj_on_yaxis(size_proj_y);
-
-        for (int j = 0; j < size_proj_y; ++j) {
-            proj_on_yaxis[j] = 0;
-        }
-        for (int j = 0; j < size_proj_x; ++j) {
-            proj_on_xaxis[j] = 0;
-        }
+        const int size_proj_y = regionRect.height();
+        const int size_proj_x = regionRect.width();
+        proj_on_xaxis.assign(qMax(size_proj_x, 0) + 1, 0);
+        proj_on_yaxis.assign(qMax(size_proj_y, 0) + 1, 0);
 
-        const QList<WordWithCharacters> list = node.text();
+        const std::vector<int> &list = tree[i].words;
 
         // Calculate tcx and tcy locally for each new region
         int word_spacing, line_spacing, column_spacing;
-        calculateStatisticalInformation(list, pageWidth, pageHeight, &word_spacing, &line_spacing, &column_spacing);
+        calculateStatisticalInformation(makeAndSortLines(list, geometries), pageWidth, geometries, &word_spacing, &line_spacing, &column_spacing);
 
         const int tcx = word_spacing * 2;
         const int tcy = line_spacing * 2;
@@ -1351,23 +1318,17 @@ static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wor
         int count;
 
         // for every text in the region
-        for (const WordWithCharacters &wwc : list) {
-            const QRect entRect = wwc.area().geometry(pageWidth, pageHeight);
+        for (const int word : list) {
+            const QRect entRect = geometries.geometry[word];
 
             // calculate vertical projection profile proj_on_xaxis1
-            for (int k = entRect.left(); k <= entRect.left() + entRect.width(); ++k) {
-                if ((k - regionRect.left()) < size_proj_x && (k - regionRect.left()) >= 0) {
-                    proj_on_xaxis[k - regionRect.left()] += entRect.height();
-                }
-            }
+            addToProfile(proj_on_xaxis, size_proj_x, entRect.left() - regionRect.left(), entRect.left() + entRect.width() - regionRect.left(), entRect.height());
 
             // calculate horizontal projection profile in the same way
-            for (int k = entRect.top(); k <= entRect.top() + entRect.height(); ++k) {
-                if ((k - regionRect.top()) < size_proj_y && (k - regionRect.top()) >= 0) {
-                    proj_on_yaxis[k - regionRect.top()] += entRect.width();
-                }
-            }
+            addToProfile(proj_on_yaxis, size_proj_y, entRect.top() - regionRect.top(), entRect.top() + entRect.height() - regionRect.top(), entRect.width());
         }
+        accumulateProfile(proj_on_xaxis, size_proj_x);
+        accumulateProfile(proj_on_yaxis, size_proj_y);
 
         for (int j = 0; j < size_proj_y; ++j) {
             if (proj_on_yaxis[j] > maxY) {
@@ -1500,62 +1461,37 @@ static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wor
         } else {
             // no cut possible
             // we can now update the node rectangle with the shrunken rectangle
-            RegionText tmpNode = tree.at(i);
-            tmpNode.setArea(regionRect);
-            tree.replace(i, tmpNode);
+            tree[i].area = regionRect;
             i++;
             continue;
         }
 
-        WordsWithCharacters list1, list2;
-
-        // horizontal cut, topRect and bottomRect
-        if (cut_hor) {
-            for (const WordWithCharacters &word : list) {
-                const QRect wordRect = word.area().geometry(pageWidth, pageHeight);
+        // horizontal cut, topRect and bottomRect, or vertical cut, leftRect and rightRect
+        const QRect &firstRect = cut_hor ? topRect : leftRect;
+        const QRect &secondRect = cut_hor ? bottomRect : rightRect;
 
-                if (topRect.intersects(wordRect)) {
-                    list1.append(word);
-                } else {
-                    list2.append(word);
-                }
+        TextRegion node1, node2;
+        node1.area = firstRect;
+        node2.area = secondRect;
+        for (const int word : list) {
+            if (firstRect.intersects(geometries.geometry[word])) {
+                node1.words.push_back(word);
+            } else {
+                node2.words.push_back(word);
             }
-
-            RegionText node1(list1, topRect);
-            RegionText node2(list2, bottomRect);
-
-            tree.replace(i, node1);
-            tree.insert(i + 1, node2);
         }
 
-        // vertical cut, leftRect and rightRect
-        else if (cut_ver) {
-            for (const WordWithCharacters &word : list) {
-                const QRect wordRect = word.area().geometry(pageWidth, pageHeight);
-
-                if (leftRect.intersects(wordRect)) {
-                    list1.append(word);
-                } else {
-                    list2.append(word);
-                }
-            }
-
-            RegionText node1(list1, leftRect);
-            RegionText node2(list2, rightRect);
-
-            tree.replace(i, node1);
-            tree.insert(i + 1, node2);
-        }
+        tree[i] = std::move(node1);
+        tree.insert(tree.begin() + i + 1, std::move(node2));
     }
 
-    tree.shrink_to_fit();
     return tree;
 }
 
 /**
- * Add spaces in between words in a line. It reuses the pointers passed in tree and might add new ones. You will need to take care of deleting them if needed
+ * Add spaces in between words in a line and extract the characters of the words of all the regions
  */
-TextEntity::List addNecessarySpace(RegionTextList tree, int pageWidth, int pageHeight)
+static TextEntity::List addNecessarySpace(const std::vector<TextRegion> &tree, const WordsWithCharacters &wordsWithCharacters, const WordGeometries &geometries, int pageWidth, int pageHeight)
 {
     /**
      * 1. Call makeAndSortLines before adding spaces in between words in a line
@@ -1565,21 +1501,22 @@ TextEntity::List addNecessarySpace(RegionTextList tree, int pageWidth, int pageH
 
     TextEntity::List res;
     // Only change the texts under RegionTexts, not the area
-    for (const RegionText &tmpRegion : std::as_const(tree)) {
+    for (const TextRegion &tmpRegion : tree) {
         // Step 01
-        QList<QPair<WordsWithCharacters, QRect>> sortedLines = makeAndSortLines(tmpRegion.text(), pageWidth, pageHeight);
-        int counter = 0;
-
-        // Step 02
-        for (QPair<WordsWithCharacters, QRect> &sortedLine : sortedLines) {
-            WordsWithCharacters &list = sortedLine.first;
-            for (int k = 0; k < list.length(); k++) {
-                const QRect area1 = list.at(k).area().roundedGeometry(pageWidth, pageHeight);
-                if (k + 1 >= list.length()) {
+        const std::vector<TextRegion> sortedLines = makeAndSortLines(tmpRegion.words, geometries);
+
+        // Step 02 and 03
+        for (const TextRegion &sortedLine : sortedLines) {
+            const std::vector<int> &list = sortedLine.words;
+            for (size_t k = 0; k < list.size(); k++) {
+                res += wordsWithCharacters.at(list[k]).characters;
+
+                if (k + 1 >= list.size()) {
                     break;
                 }
 
-                const QRect area2 = list.at(k + 1).area().roundedGeometry(pageWidth, pageHeight);
+                const QRect area1 = geometries.roundedGeometry[list[k]];
+                const QRect area2 = geometries.roundedGeometry[list[k + 1]];
                 const int space = area2.left() - area1.right();
 
                 if (space != 0) {
@@ -1589,30 +1526,13 @@ TextEntity::List addNecessarySpace(RegionTextList tree, int pageWidth, int pageH
                     const int top = area2.top() < area1.top() ? area2.top() : area1.top();
                     const int bottom = area2.bottom() > area1.bottom() ? area2.bottom() : area1.bottom();
 
-                    const QString spaceStr(QStringLiteral(" "));
                     const QRect rect(QPoint(left, top), QPoint(right, bottom));
-                    const NormalizedRect entRect(rect, pageWidth, pageHeight);
-                    TextEntity ent1 = TextEntity(spaceStr, entRect);
-                    WordWithCharacters word(ent1, QList<TextEntity>() << ent1);
-
-                    list.insert(k + 1, word);
-
-                    // Skip the space
-                    k++;
+                    res.append(TextEntity(QStringLiteral(" "), NormalizedRect(rect, pageWidth, pageHeight)));
                 }
             }
-            counter += list.length();
-        }
-        res.reserve(res.length() + counter);
-
-        for (const QPair<WordsWithCharacters, QRect> &sortedLine : std::as_const(sortedLines)) {
-            for (const WordWithCharacters &word : sortedLine.first) {
-                res += word.characters;
-            }
         }
     }
 
-    // Step 03
     res.shrink_to_fit();
     return res;
 }
@@ -1630,7 +1550,7 @@ void TextPagePrivate::correctTextOrder()
     const int pageWidth = (int)(scalingFactor * m_page->width());
     const int pageHeight = (int)(scalingFactor * m_page->height());
 
-    TextEntity::List characters = m_words;
+    TextEntity::List characters = m_words.toList();
 
     /**
      * Remove spaces from the text
@@ -1641,16 +1561,17 @@ void TextPagePrivate::correctTextOrder()
      * Construct words from characters
      */
     const QList<WordWithCharacters> wordsWithCharacters = makeWordFromCharacters(characters, pageWidth, pageHeight);
+    const WordGeometries geometries(wordsWithCharacters, pageWidth, pageHeight);
 
     /**
      * Make a XY Cut tree for segmentation of the texts
      */
-    RegionTextList tree = XYCutForBoundingBoxes(wordsWithCharacters, pageWidth, pageHeight);
+    const std::vector<TextRegion> tree = XYCutForBoundingBoxes(wordsWithCharacters, geometries, pageWidth, pageHeight);
 
     /**
      * Add spaces to the word
      */
-    const auto listOfCharacters = addNecessarySpace(std::move(tree), pageWidth, pageHeight);
+    const auto listOfCharacters = addNecessarySpace(tree, wordsWithCharacters, geometries, pageWidth, pageHeight);
 
     setWordList(listOfCharacters);
 }
@@ -1663,47 +1584,47 @@ TextEntity::List TextPage::words(const RegularAreaRect *area, TextAreaInclusionB
 
     TextEntity::List ret;
     if (area) {
-        for (const TextEntity &te : std::as_const(d->m_words)) {
+        for (qsizetype i = 0; i < d->m_words.count(); ++i) {
+            const NormalizedRect entityArea = d->m_words.areaAt(i);
+            bool contained;
             if (b == AnyPixelTextAreaInclusionBehaviour) {
-                if (area->intersects(te.area())) {
-                    ret.append(te);
-                }
+                contained = area->intersects(entityArea);
             } else {
-                const NormalizedPoint center = te.area().center();
-                if (area->contains(center.x, center.y)) {
-                    ret.append(te);
-                }
+                const NormalizedPoint center = entityArea.center();
+                contained = area->contains(center.x, center.y);
+            }
+            // The returned entities outlive the page, they need their own copy of the text
+            if (contained) {
+                ret.append(TextEntity(d->m_words.textAt(i).toString(), entityArea));
             }
         }
     } else {
-        for (const TextEntity &te : std::as_const(d->m_words)) {
-            ret.append(te);
-        }
+        ret = d->m_words.toList();
     }
     return ret;
 }
 
 std::unique_ptr<RegularAreaRect> TextPage::wordAt(const NormalizedPoint &p) const
 {
-    TextEntity::List::ConstIterator itBegin = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
-    TextEntity::List::ConstIterator it = itBegin;
-    TextEntity::List::ConstIterator posIt = itEnd;
+    TextEntityList::ConstIterator itBegin = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
+    TextEntityList::ConstIterator it = itBegin;
+    TextEntityList::ConstIterator posIt = itEnd;
     for (; it != itEnd; ++it) {
-        if (it->area().contains(p.x, p.y)) {
+        if (it.area().contains(p.x, p.y)) {
             posIt = it;
             break;
         }
     }
     if (posIt != itEnd) {
-        if (posIt->text().simplified().isEmpty()) {
+        if (posIt.text().trimmed().isEmpty()) {
             auto ret = std::make_unique<RegularAreaRect>();
-            ret->appendShape(posIt->area());
+            ret->appendShape(posIt.area());
             return ret;
         }
         // Find the first TinyTextEntity of the word
         while (posIt != itBegin) {
             --posIt;
-            const QString itText = posIt->text();
+            const QStringView itText = posIt.text();
             if (itText.right(1).at(0).isSpace()) {
                 if (itText.endsWith(QLatin1String("-\n"))) {
                     // Is an hyphenated word
@@ -1713,7 +1634,7 @@ std::unique_ptr<RegularAreaRect> TextPage::wordAt(const NormalizedPoint &p) cons
 
                 if (itText == QLatin1String("\n") && posIt != itBegin) {
                     --posIt;
-                    if (posIt->text().endsWith(QLatin1String("-"))) {
+                    if (posIt.text().endsWith(QLatin1String("-"))) {
                         // Is an hyphenated word
                         // continue searching the start of the word back
                         continue;
@@ -1728,13 +1649,13 @@ std::unique_ptr<RegularAreaRect> TextPage::wordAt(const NormalizedPoint &p) cons
         auto ret = std::make_unique<RegularAreaRect>();
         QString foundWord;
         for (; posIt != itEnd; ++posIt) {
-            const QString itText = posIt->text();
-            if (itText.simplified().isEmpty()) {
+            const QStringView itText = posIt.text();
+            if (itText.trimmed().isEmpty()) {
                 break;
             }
 
-            ret->appendShape(posIt->area());
-            foundWord += posIt->text();
+            ret->appendShape(posIt.area());
+            foundWord += posIt.text();
             if (itText.right(1).at(0).isSpace()) {
                 if (!foundWord.endsWith(QLatin1String("-\n"))) {
                     break;
@@ -1750,13 +1671,13 @@ std::unique_ptr<RegularAreaRect> TextPage::wordAt(const NormalizedPoint &p) cons
 
 std::unique_ptr<RegularAreaRect> TextPage::lineAt(const NormalizedPoint &p) const
 {
-    TextEntity::List::ConstIterator itBegin = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
-    TextEntity::List::ConstIterator it = itBegin;
-    TextEntity::List::ConstIterator posIt = itEnd;
+    TextEntityList::ConstIterator itBegin = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
+    TextEntityList::ConstIterator it = itBegin;
+    TextEntityList::ConstIterator posIt = itEnd;
 
     // Find the text entity at the given point
     for (; it != itEnd; ++it) {
-        if (it->area().contains(p.x, p.y)) {
+        if (it.area().contains(p.x, p.y)) {
             posIt = it;
             break;
         }
@@ -1767,7 +1688,7 @@ std::unique_ptr<RegularAreaRect> TextPage::lineAt(const NormalizedPoint &p) cons
     }
 
     // Get the vertical bounds of the text entity at the click point
-    const NormalizedRect &clickArea = posIt->area();
+    const NormalizedRect &clickArea = posIt.area();
     const double lineTop = clickArea.top;
     const double lineBottom = clickArea.bottom;
     const double lineHeight = lineBottom - lineTop;
@@ -1787,35 +1708,35 @@ std::unique_ptr<RegularAreaRect> TextPage::lineAt(const NormalizedPoint &p) cons
     };
 
     // Find the start of the line by going backwards
-    TextEntity::List::ConstIterator lineStart = posIt;
+    TextEntityList::ConstIterator lineStart = posIt;
     while (lineStart != itBegin) {
-        TextEntity::List::ConstIterator prev = lineStart;
+        TextEntityList::ConstIterator prev = lineStart;
         --prev;
-        if (!isOnSameLine(prev->area())) {
+        if (!isOnSameLine(prev.area())) {
             break;
         }
 
-        if (prev->text().contains(QLatin1Char('\n'))) {
+        if (prev.text().contains(QLatin1Char('\n'))) {
             break;
         }
 
         lineStart = prev;
     }
 
-    TextEntity::List::ConstIterator lineEnd = posIt;
+    TextEntityList::ConstIterator lineEnd = posIt;
     while (lineEnd != itEnd) {
-        if (lineEnd->text().contains(QLatin1Char('\n'))) {
+        if (lineEnd.text().contains(QLatin1Char('\n'))) {
             ++lineEnd;
             break;
         }
 
-        TextEntity::List::ConstIterator next = lineEnd;
+        TextEntityList::ConstIterator next = lineEnd;
         ++next;
         if (next == itEnd) {
             ++lineEnd;
             break;
         }
-        if (!isOnSameLine(next->area())) {
+        if (!isOnSameLine(next.area())) {
             ++lineEnd;
             break;
         }
@@ -1823,33 +1744,33 @@ std::unique_ptr<RegularAreaRect> TextPage::lineAt(const NormalizedPoint &p) cons
         lineEnd = next;
     }
 
-    auto hyphenEnd = [&itEnd](TextEntity::List::ConstIterator start, TextEntity::List::ConstIterator end) -> TextEntity::List::ConstIterator {
-        TextEntity::List::ConstIterator last = end;
+    auto hyphenEnd = [&itEnd](TextEntityList::ConstIterator start, TextEntityList::ConstIterator end) -> TextEntityList::ConstIterator {
+        TextEntityList::ConstIterator last = end;
         --last;
-        if (last->text() == QLatin1String("\n")) {
+        if (last.text() == QLatin1String("\n")) {
             if (last == start) {
                 return itEnd;
             }
             --last;
         }
-        const QString &lastText = last->text();
+        const QStringView lastText = last.text();
         if (lastText.endsWith(QLatin1Char('-')) || lastText.endsWith(QLatin1String("-\n"))) {
             return end;
         }
         return itEnd;
     };
 
-    TextEntity::List::ConstIterator contEnd = lineStart;
+    TextEntityList::ConstIterator contEnd = lineStart;
     if (lineStart != itBegin) {
-        TextEntity::List::ConstIterator checkIt = lineStart;
+        TextEntityList::ConstIterator checkIt = lineStart;
         --checkIt;
         bool prevHyphen = false;
-        const QString &prevText = checkIt->text();
+        const QStringView prevText = checkIt.text();
         if (prevText.endsWith(QLatin1String("-\n")) || prevText.endsWith(QLatin1Char('-'))) {
             prevHyphen = true;
         } else if (prevText == QLatin1String("\n") && checkIt != itBegin) {
             --checkIt;
-            if (checkIt->text().endsWith(QLatin1Char('-'))) {
+            if (checkIt.text().endsWith(QLatin1Char('-'))) {
                 prevHyphen = true;
             }
         }
@@ -1857,8 +1778,8 @@ std::unique_ptr<RegularAreaRect> TextPage::lineAt(const NormalizedPoint &p) cons
         if (prevHyphen) {
             contEnd = lineStart;
             while (contEnd != lineEnd) {
-                const QString &cText = contEnd->text();
-                if (cText.simplified().isEmpty()) {
+                const QStringView cText = contEnd.text();
+                if (cText.trimmed().isEmpty()) {
                     break;
                 }
                 ++contEnd;
@@ -1866,17 +1787,17 @@ std::unique_ptr<RegularAreaRect> TextPage::lineAt(const NormalizedPoint &p) cons
         }
     }
 
-    TextEntity::List::ConstIterator hyphenCont = itEnd;
+    TextEntityList::ConstIterator hyphenCont = itEnd;
     if (lineEnd != itEnd && lineStart != lineEnd) {
         hyphenCont = hyphenEnd(lineStart, lineEnd);
     }
 
-    TextEntity::List::ConstIterator newlineEnd = lineEnd;
+    TextEntityList::ConstIterator newlineEnd = lineEnd;
     if (hyphenCont != itEnd) {
-        TextEntity::List::ConstIterator fragIt = lineEnd;
+        TextEntityList::ConstIterator fragIt = lineEnd;
         while (fragIt != itEnd) {
-            const QString &fText = fragIt->text();
-            if (fText.simplified().isEmpty()) {
+            const QStringView fText = fragIt.text();
+            if (fText.trimmed().isEmpty()) {
                 break;
             }
             ++fragIt;
@@ -1886,44 +1807,44 @@ std::unique_ptr<RegularAreaRect> TextPage::lineAt(const NormalizedPoint &p) cons
 
     if (contEnd != lineStart) {
         bool clickCont = false;
-        for (TextEntity::List::ConstIterator ci = lineStart; ci != contEnd; ++ci) {
+        for (TextEntityList::ConstIterator ci = lineStart; ci != contEnd; ++ci) {
             if (ci == posIt) {
                 clickCont = true;
                 break;
             }
         }
         if (clickCont) {
-            TextEntity::List::ConstIterator prevEntity = lineStart;
+            TextEntityList::ConstIterator prevEntity = lineStart;
             --prevEntity;
-            if (prevEntity->text() == QLatin1String("\n") && prevEntity != itBegin) {
+            if (prevEntity.text() == QLatin1String("\n") && prevEntity != itBegin) {
                 --prevEntity;
             }
-            const NormalizedRect &prevArea = prevEntity->area();
+            const NormalizedRect &prevArea = prevEntity.area();
             NormalizedPoint prevPoint(prevArea.left, (prevArea.top + prevArea.bottom) / 2.0);
             return lineAt(prevPoint);
         }
     }
 
     auto ret = std::make_unique<RegularAreaRect>();
-    TextEntity::List::ConstIterator buildStart = (contEnd != lineStart) ? contEnd : lineStart;
-    TextEntity::List::ConstIterator buildEnd = newlineEnd;
+    TextEntityList::ConstIterator buildStart = (contEnd != lineStart) ? contEnd : lineStart;
+    TextEntityList::ConstIterator buildEnd = newlineEnd;
 
     // Skip bullet chars
-    TextEntity::List::ConstIterator probe = buildStart;
-    while (probe != buildEnd && probe->text().simplified().isEmpty()) {
+    TextEntityList::ConstIterator probe = buildStart;
+    while (probe != buildEnd && probe.text().trimmed().isEmpty()) {
         ++probe;
     }
     if (probe != buildEnd) {
-        TextEntity::List::ConstIterator second = probe;
+        TextEntityList::ConstIterator second = probe;
         ++second;
-        while (second != buildEnd && second->text().simplified().isEmpty()) {
+        while (second != buildEnd && second.text().trimmed().isEmpty()) {
             ++second;
         }
         if (second != buildEnd) {
-            const double gap = second->area().left - probe->area().right;
+            const double gap = second.area().left - probe.area().right;
             if (gap > 0.0) {
-                const double bulletCharW = probe->area().width() / qMax(1, probe->text().length());
-                const double secondCharW = second->area().width() / qMax(1, second->text().length());
+                const double bulletCharW = probe.area().width() / qMax(1, probe.text().length());
+                const double secondCharW = second.area().width() / qMax(1, second.text().length());
                 if (gap > bulletCharW || gap > secondCharW) {
                     buildStart = second;
                 }
@@ -1931,15 +1852,15 @@ std::unique_ptr<RegularAreaRect> TextPage::lineAt(const NormalizedPoint &p) cons
         }
     }
 
-    for (TextEntity::List::ConstIterator lineIt = buildStart; lineIt != buildEnd; ++lineIt) {
-        const QString text = lineIt->text();
-        if (lineIt == buildStart && text.simplified().isEmpty()) {
+    for (TextEntityList::ConstIterator lineIt = buildStart; lineIt != buildEnd; ++lineIt) {
+        const QStringView text = lineIt.text();
+        if (lineIt == buildStart && text.trimmed().isEmpty()) {
             continue;
         }
-        ret->appendShape(lineIt->area());
+        ret->appendShape(lineIt.area());
 
         if (text.contains(QLatin1Char('\n')) && lineIt != buildStart) {
-            TextEntity::List::ConstIterator afterNl = lineIt;
+            TextEntityList::ConstIterator afterNl = lineIt;
             ++afterNl;
             if (afterNl == buildEnd || afterNl == itEnd) {
                 break;
@@ -1948,10 +1869,10 @@ std::unique_ptr<RegularAreaRect> TextPage::lineAt(const NormalizedPoint &p) cons
                 continue;
             }
             if (text == QLatin1String("\n")) {
-                TextEntity::List::ConstIterator beforeNl = lineIt;
+                TextEntityList::ConstIterator beforeNl = lineIt;
                 if (beforeNl != buildStart) {
                     --beforeNl;
-                    if (beforeNl->text().endsWith(QLatin1Char('-'))) {
+                    if (beforeNl.text().endsWith(QLatin1Char('-'))) {
                         continue;
                     }
                 }
@@ -8,15 +8,17 @@
 #ifndef _OKULAR_TEXTPAGE_P_H_
 #define _OKULAR_TEXTPAGE_P_H_
 
+#include "area.h"
 #include "textpage.h"
 #include <QList>
 #include <QMap>
 #include <QPair>
 #include <QTransform>
 
-class SearchPoint;
+#include <iterator>
+#include <vector>
 
-class RegionText;
+class SearchPoint;
 
 namespace Okular
 {
@@ -31,9 +33,213 @@ class Page;
 typedef bool (*TextComparisonFunction)(QStringView from, const QStringView to);
 
 /**
- * A list of RegionText. It keeps a bunch of TextList with their bounding rectangles
+ * The text entities of a page, stored column wise: the texts of all the entities
+ * are kept one after the other in a single UTF-16 buffer, with the offsets where
+ * each one starts and their bounding boxes (as floats) in parallel arrays.
+ *
+ * Entities are handed out by value and own a copy of their text. The hot
+ * paths use textAt(), areaAt() or rawTextAt() instead, which do not copy.
  */
-typedef QList<RegionText> RegionTextList;
+class TextEntityList
+{
+public:
+    class ConstIterator
+    {
+    public:
+        typedef TextEntity value_type;
+        typedef qsizetype difference_type;
+
+        ConstIterator()
+            : m_list(nullptr)
+            , m_index(0)
+        {
+        }
+
+        ConstIterator(const TextEntityList *list, qsizetype index)
+            : m_list(list)
+            , m_index(index)
+        {
+        }
+
+        // There is no operator*() nor operator->(): they would build a whole
+        // TextEntity, copying its text, where the text or the area is enough.
+        QStringView text() const
+        {
+            return m_list->textAt(m_index);
+        }
+        /**
+         * The text of the current entity without copying it, see rawTextAt().
+         */
+        QString rawText() const
+        {
+            return m_list->rawTextAt(m_index);
+        }
+        NormalizedRect area() const
+        {
+            return m_list->areaAt(m_index);
+        }
+
+        qsizetype index() const
+        {
+            return m_index;
+        }
+
+        ConstIterator &operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+        ConstIterator operator++(int)
+        {
+            ConstIterator prev = *this;
+            ++m_index;
+            return prev;
+        }
+        ConstIterator &operator--()
+        {
+            --m_index;
+            return *this;
+        }
+        ConstIterator operator--(int)
+        {
+            ConstIterator prev = *this;
+            --m_index;
+            return prev;
+        }
+        ConstIterator &operator+=(qsizetype n)
+        {
+            m_index += n;
+            return *this;
+        }
+        ConstIterator &operator-=(qsizetype n)
+        {
+            m_index -= n;
+            return *this;
+        }
+        ConstIterator operator+(qsizetype n) const
+        {
+            return ConstIterator(m_list, m_index + n);
+        }
+        ConstIterator operator-(qsizetype n) const
+        {
+            return ConstIterator(m_list, m_index - n);
+        }
+        qsizetype operator-(const ConstIterator &other) const
+        {
+            return m_index - other.m_index;
+        }
+
+        bool operator==(const ConstIterator &other) const
+        {
+            return m_list == other.m_list && m_index == other.m_index;
+        }
+        bool operator!=(const ConstIterator &other) const
+        {
+            return !(*this == other);
+        }
+        bool operator<(const ConstIterator &other) const
+        {
+            return m_index < other.m_index;
+        }
+        bool operator>(const ConstIterator &other) const
+        {
+            return m_index > other.m_index;
+        }
+        bool operator<=(const ConstIterator &other) const
+        {
+            return m_index <= other.m_index;
+        }
+        bool operator>=(const ConstIterator &other) const
+        {
+            return m_index >= other.m_index;
+        }
+
+    private:
+        const TextEntityList *m_list;
+        qsizetype m_index;
+    };
+
+    TextEntityList();
+    explicit TextEntityList(const TextEntity::List &list);
+
+    qsizetype count() const
+    {
+        return qsizetype(m_offsets.size()) - 1;
+    }
+    bool isEmpty() const
+    {
+        return count() == 0;
+    }
+
+    TextEntity at(qsizetype index) const;
+    TextEntity last() const
+    {
+        return at(count() - 1);
+    }
+
+    /**
+     * The text of the entity at @p index, without building the whole entity.
+     */
+    QStringView textAt(qsizetype index) const
+    {
+        return QStringView(m_text).mid(m_offsets[index], m_offsets[index + 1] - m_offsets[index]);
+    }
+
+    /**
+     * The text of the entity at @p index as a QString pointing into the buffer.
+     * It does not own its data: it (and any copy of it) must not outlive the
+     * list nor a change to it, so only use it for transient computations.
+     */
+    QString rawTextAt(qsizetype index) const
+    {
+        return QString::fromRawData(m_text.constData() + m_offsets[index], m_offsets[index + 1] - m_offsets[index]);
+    }
+
+    NormalizedRect areaAt(qsizetype index) const
+    {
+        const float *box = &m_boxes[index * 4];
+        return NormalizedRect(box[0], box[1], box[2], box[3]);
+    }
+
+    void append(const QString &text, const NormalizedRect &area);
+    void removeLast();
+    void clear();
+    void squeeze();
+
+    /**
+     * A copy of the entities, owning their text.
+     */
+    TextEntity::List toList() const;
+
+    /**
+     * The number of bytes used by the entities.
+     */
+    qint64 memoryUsage() const;
+
+    ConstIterator constBegin() const
+    {
+        return ConstIterator(this, 0);
+    }
+    ConstIterator constEnd() const
+    {
+        return ConstIterator(this, count());
+    }
+    ConstIterator begin() const
+    {
+        return constBegin();
+    }
+    ConstIterator end() const
+    {
+        return constEnd();
+    }
+
+private:
+    QString m_text;
+    // where the text of each entity starts in m_text, plus the end of the last one
+    std::vector<quint32> m_offsets;
+    // left, top, right, bottom of each entity
+    std::vector<float> m_boxes;
+};
 
 class TextPagePrivate
 {
@@ -41,11 +247,11 @@ public:
     TextPagePrivate();
     ~TextPagePrivate();
 
-    RegularAreaRect *findTextInternalForward(int searchID, const QString &query, TextComparisonFunction comparer, const TextEntity::List::ConstIterator start, int start_offset, const TextEntity::List::ConstIterator end);
-    RegularAreaRect *findTextInternalBackward(int searchID, const QString &query, TextComparisonFunction comparer, const TextEntity::List::ConstIterator start, int start_offset, const TextEntity::List::ConstIterator end);
+    RegularAreaRect *findTextInternalForward(int searchID, const QString &query, TextComparisonFunction comparer, const TextEntityList::ConstIterator start, int start_offset, const TextEntityList::ConstIterator end);
+    RegularAreaRect *findTextInternalBackward(int searchID, const QString &query, TextComparisonFunction comparer, const TextEntityList::ConstIterator start, int start_offset, const TextEntityList::ConstIterator end);
 
     /**
-     * Copy a TextList to m_words, the pointers of list are adopted
+     * Replaces m_words with the entities of list
      */
     void setWordList(const TextEntity::List &list);
 
@@ -55,8 +261,13 @@ public:
      */
     void correctTextOrder();
 
+    /**
+     * The number of bytes used by the text of the page
+     */
+    qint64 memoryUsage() const;
+
     // variables those can be accessed directly from TextPage
-    TextEntity::List m_words;
+    TextEntityList m_words;
     QMap<int, SearchPoint *> m_searchPoints;
     Page *m_page;
 
@@ -11,6 +11,7 @@
 #include <qmath.h>
 
 #include "tile.h"
+#include "tracing_p.h"
 
 #define TILES_MAXSIZE 2000000
 
@@ -473,6 +474,7 @@ void TilesManager::cleanupPixmapMemory(qulonglong numberOfBytes, const Normalize
         }
 
         qulonglong pixels = tile->pixmap->width() * tile->pixmap->height();
+        Tracing::instant("memory", "evict tile", {{"page", d->pageNumber}, {"bytes", qint64(4 * pixels)}});
         d->totalPixels -= pixels;
         if (numberOfBytes < 4 * pixels) {
             numberOfBytes = 0;
@@ -569,6 +571,8 @@ void TilesManager::Private::split(TileNode &tile, const NormalizedRect &rect)
         return;
     }
 
+    Tracing::instant("render", "split tile", {{"page", pageNumber}, {"pixels", qint64(tile.rect.width() * width * tile.rect.height() * height)}});
+
     tile.nTiles = 4;
     tile.tiles = new TileNode[4];
     double hCenter = (tile.rect.left + tile.rect.right) / 2;
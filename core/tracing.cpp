@@ -0,0 +1,178 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "tracing_p.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+
+#include <atomic>
+
+#include "debug_p.h"
+
+using namespace Okular;
+
+namespace
+{
+/**
+ * Writes the events as a JSON array, closed when the application exits.
+ */
+class TraceWriter
+{
+public:
+    TraceWriter()
+        : m_file(QFile::decodeName(qgetenv("OKULAR_TRACE")))
+        , m_pid(QCoreApplication::applicationPid())
+        , m_firstEvent(true)
+    {
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qCWarning(OkularCoreDebug) << "Could not open the trace file" << m_file.fileName();
+            return;
+        }
+        m_file.write("[\n");
+        m_timer.start();
+    }
+
+    ~TraceWriter()
+    {
+        if (m_file.isOpen()) {
+            m_file.write("\n]\n");
+        }
+    }
+
+    double now() const
+    {
+        return m_timer.nsecsElapsed() / 1000.0;
+    }
+
+    void write(char phase, const char *category, const char *name, double timestamp, Tracing::Arguments arguments, const Tracing::Argument *extraArguments = nullptr, int extraArgumentCount = 0, const void *id = nullptr, double duration = -1)
+    {
+        if (!m_file.isOpen()) {
+            return;
+        }
+
+        // Small ids in the order threads trace something read better than the native ones
+        static std::atomic<int> lastThreadId = 0;
+        thread_local int threadId = 0;
+        const bool newThread = threadId == 0;
+        if (newThread) {
+            threadId = ++lastThreadId;
+        }
+
+        QByteArray event;
+        event.reserve(192);
+        if (newThread) {
+            QString threadName = QThread::currentThread()->objectName();
+            if (threadName.isEmpty()) {
+                const QCoreApplication *application = QCoreApplication::instance();
+                threadName = application && QThread::currentThread() == application->thread() ? QStringLiteral("main") : QString::fromLatin1(QThread::currentThread()->metaObject()->className());
+            }
+            event += R"({"name":"thread_name","ph":"M","pid":)" + QByteArray::number(m_pid) + R"(,"tid":)" + QByteArray::number(threadId) + R"(,"args":{"name":")" + threadName.toUtf8() + "\"}},\n";
+        }
+        event += R"({"name":")" + QByteArray(name) + R"(","cat":")" + category + R"(","ph":")" + phase + R"(","ts":)" + QByteArray::number(timestamp, 'f', 3);
+        if (duration >= 0) {
+            event += R"(,"dur":)" + QByteArray::number(duration, 'f', 3);
+        }
+        if (id) {
+            event += R"(,"id":"0x)" + QByteArray::number(quintptr(id), 16) + '"';
+        }
+        event += R"(,"pid":)" + QByteArray::number(m_pid) + R"(,"tid":)" + QByteArray::number(threadId);
+        if (arguments.size() > 0 || extraArgumentCount > 0) {
+            event += R"(,"args":{)";
+            bool first = true;
+            const auto appendArgument = [&event, &first](const Tracing::Argument &argument) {
+                if (!first) {
+                    event += ',';
+                }
+                first = false;
+                event += '"' + QByteArray(argument.name) + "\":" + QByteArray::number(argument.value);
+            };
+            for (const Tracing::Argument &argument : arguments) {
+                appendArgument(argument);
+            }
+            for (int i = 0; i < extraArgumentCount; ++i) {
+                appendArgument(extraArguments[i]);
+            }
+            event += '}';
+        }
+        event += '}';
+
+        QMutexLocker locker(&m_mutex);
+        if (!m_firstEvent) {
+            m_file.write(",\n");
+        }
+        m_firstEvent = false;
+        m_file.write(event);
+    }
+
+private:
+    QMutex m_mutex;
+    QFile m_file;
+    QElapsedTimer m_timer;
+    const qint64 m_pid;
+    bool m_firstEvent;
+};
+}
+
+Q_GLOBAL_STATIC(TraceWriter, traceWriter)
+
+bool Tracing::isEnabled()
+{
+    static const bool enabled = !qEnvironmentVariableIsEmpty("OKULAR_TRACE");
+    return enabled;
+}
+
+void Tracing::instant(const char *category, const char *name, Arguments arguments)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    traceWriter->write('i', category, name, traceWriter->now(), arguments);
+}
+
+void Tracing::asyncBegin(const char *category, const char *name, const void *id, Arguments arguments)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    traceWriter->write('b', category, name, traceWriter->now(), arguments, nullptr, 0, id);
+}
+
+void Tracing::asyncEnd(const char *category, const char *name, const void *id, Arguments arguments)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    traceWriter->write('e', category, name, traceWriter->now(), arguments, nullptr, 0, id);
+}
+
+Tracing::Scope::Scope(const char *category, const char *name, Arguments arguments)
+    : m_category(category)
+    , m_name(name)
+    , m_argumentCount(0)
+    , m_start(-1)
+{
+    if (!isEnabled()) {
+        return;
+    }
+    for (const Argument &argument : arguments) {
+        if (m_argumentCount < maxArguments) {
+            m_arguments[m_argumentCount++] = argument;
+        }
+    }
+    m_start = traceWriter->now();
+}
+
+Tracing::Scope::~Scope()
+{
+    if (m_start < 0) {
+        return;
+    }
+    traceWriter->write('X', m_category, m_name, m_start, {}, m_arguments, m_argumentCount, nullptr, traceWriter->now() - m_start);
+}
@@ -0,0 +1,79 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _OKULAR_TRACING_P_H_
+#define _OKULAR_TRACING_P_H_
+
+#include <QtGlobal>
+
+#include <initializer_list>
+
+namespace Okular
+{
+/**
+ * Trace events of the rendering, text and search pipelines.
+ *
+ * When the OKULAR_TRACE environment variable names a file, the events are
+ * written to it in the Trace Event Format of Chrome, which can be opened
+ * in about:tracing or ui.perfetto.dev. Otherwise every function returns
+ * right away, so that the events can be left in hot paths.
+ */
+namespace Tracing
+{
+struct Argument {
+    const char *name;
+    qint64 value;
+};
+typedef std::initializer_list<Argument> Arguments;
+
+/**
+ * Whether the events are written.
+ */
+bool isEnabled();
+
+/**
+ * Something happening at a point in time, like a request being queued.
+ */
+void instant(const char *category, const char *name, Arguments arguments = {});
+
+/**
+ * The beginning of something ending in another function or thread, like a
+ * pixmap request from being sent to the generator to being done. @p id
+ * matches it with its end.
+ */
+void asyncBegin(const char *category, const char *name, const void *id, Arguments arguments = {});
+
+/**
+ * The end of what was begun with asyncBegin() with the same @p name and @p id.
+ */
+void asyncEnd(const char *category, const char *name, const void *id, Arguments arguments = {});
+
+/**
+ * Traces from its creation to its destruction, like the extraction of a text page.
+ */
+class Scope
+{
+public:
+    Scope(const char *category, const char *name, Arguments arguments = {});
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    static const int maxArguments = 4;
+
+    const char *m_category;
+    const char *m_name;
+    Argument m_arguments[maxArguments];
+    int m_argumentCount;
+    double m_start; // in microseconds, negative when not tracing
+};
+}
+
+}
+
+#endif
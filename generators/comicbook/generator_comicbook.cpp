@@ -24,6 +24,7 @@ ComicBookGenerator::ComicBookGenerator(QObject *parent, const QVariantList &args
     : Generator(parent, args)
 {
     setFeature(Threaded);
+    setFeature(SupportsCancelling);
     setFeature(PrintNative);
     setFeature(PrintToFile);
 }
@@ -60,6 +61,11 @@ QImage ComicBookGenerator::image(Okular::PixmapRequest *request)
 
     QImage pageImage = mDocument.pageImage(request->pageNumber());
 
+    // decoding may have taken long enough for the page to be scrolled past
+    if (request->shouldAbortRender()) {
+        return QImage();
+    }
+
     return pageImage.scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
 }
 
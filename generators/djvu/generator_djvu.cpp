@@ -65,6 +65,8 @@ DjVuGenerator::DjVuGenerator(QObject *parent, const QVariantList &args)
 {
     setFeature(TextExtraction);
     setFeature(Threaded);
+    setFeature(SupportsCancelling);
+    setFeature(ThreadedLoading);
     setFeature(PrintPostscript);
     if (Okular::FilePrinter::ps2pdfAvailable()) {
         setFeature(PrintToFile);
@@ -107,8 +109,10 @@ bool DjVuGenerator::doCloseDocument()
 
 QImage DjVuGenerator::image(Okular::PixmapRequest *request)
 {
+    Okular::PartialPixmapUpdater updater(this, request);
     userMutex()->lock();
-    QImage img = m_djvu->image(request->pageNumber(), request->width(), request->height(), request->page()->rotation());
+    QImage img = m_djvu->image(
+        request->pageNumber(), request->width(), request->height(), request->page()->rotation(), [request] { return request->shouldAbortRender(); }, [&updater](const QImage &image) { updater.update(image); });
     userMutex()->unlock();
     return img;
 }
@@ -188,6 +192,9 @@ QVariant DjVuGenerator::metaData(const QString &key, const QVariant &option) con
     Q_UNUSED(option)
     if (key == QLatin1String("DocumentTitle")) {
         return m_djvu->metaData(QStringLiteral("title"));
+    } else if (key == QLatin1String("MemoryCaches")) {
+        // does not need the lock, so it does not wait for a page being rendered
+        return QVariantMap {{QStringLiteral("Rendered pages"), m_djvu->cacheMemory()}};
     }
     return QVariant();
 }
@@ -22,6 +22,8 @@
 
 #include <stdio.h>
 
+#include <atomic>
+
 QDebug &operator<<(QDebug &s, const ddjvu_rect_t r)
 {
     s.nospace() << "[" << r.x << "," << r.y << " - " << r.w << "x" << r.h << "]";
@@ -447,6 +449,9 @@ public:
     QList<ddjvu_page_t *> m_pages_cache;
 
     QList<ImageCacheItem *> mImgCache;
+    // kept up to date with mImgCache so it can be read without locking
+    std::atomic<qulonglong> mImgCacheMemory = 0;
+    void updateImgCacheMemory();
 
     QHash<QString, QVariant> m_metaData;
     QDomDocument *m_docBookmarks;
@@ -458,6 +463,15 @@ public:
     static unsigned int s_formatmask[4];
 };
 
+void KDjVu::Private::updateImgCacheMemory()
+{
+    qulonglong memory = 0;
+    for (const ImageCacheItem *item : std::as_const(mImgCache)) {
+        memory += item->img.sizeInBytes();
+    }
+    mImgCacheMemory.store(memory, std::memory_order_relaxed);
+}
+
 unsigned int KDjVu::Private::s_formatmask[4] = {0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000};
 
 QImage KDjVu::Private::generateImageTile(ddjvu_page_t *djvupage, int &res, int width, int row, int xdelta, int height, int col, int ydelta)
@@ -737,6 +751,7 @@ void KDjVu::closeFile()
     // clearing the image cache
     qDeleteAll(d->mImgCache);
     d->mImgCache.clear();
+    d->updateImgCacheMemory();
     // clearing the old metadata
     d->m_metaData.clear();
     // cleaning the page names mapping
@@ -859,7 +874,7 @@ const QList<KDjVu::Page> &KDjVu::pages() const
     return d->m_pages;
 }
 
-QImage KDjVu::image(int page, int width, int height, int rotation)
+QImage KDjVu::image(int page, int width, int height, int rotation, const std::function<bool()> &shouldAbort, const std::function<void(const QImage &)> &partialUpdate)
 {
     if (d->m_cacheEnabled) {
         bool found = false;
@@ -917,16 +932,26 @@ QImage KDjVu::image(int page, int width, int height, int rotation)
         // more than one part -- need to render piece-by-piece and to compose
         // the results
         newimg = QImage(width, height, QImage::Format_RGB32);
+        if (partialUpdate) {
+            // the parts not rendered yet are shown too
+            newimg.fill(Qt::white);
+        }
         QPainter p;
         p.begin(&newimg);
         int parts = xparts * yparts;
         for (int i = 0; i < parts; ++i) {
+            if (shouldAbort && shouldAbort()) {
+                return QImage();
+            }
             const int row = i % xparts;
             const int col = i / xparts;
             int tmpres = 0;
             const QImage tempp = d->generateImageTile(djvupage, tmpres, width, row, xdelta, height, col, ydelta);
             p.drawImage(row * xdelta, col * ydelta, tempp);
             res = qMin(tmpres, res);
+            if (partialUpdate && i < parts - 1) {
+                partialUpdate(newimg);
+            }
         }
         p.end();
     }
@@ -954,6 +979,7 @@ QImage KDjVu::image(int page, int width, int height, int rotation)
         }
         ImageCacheItem *ich = new ImageCacheItem(page, width, height, newimg);
         d->mImgCache.push_front(ich);
+        d->updateImgCacheMemory();
     }
 
     return newimg;
@@ -1072,6 +1098,7 @@ void KDjVu::setCacheEnabled(bool enable)
     if (!d->m_cacheEnabled) {
         qDeleteAll(d->mImgCache);
         d->mImgCache.clear();
+        d->updateImgCacheMemory();
     }
 }
 
@@ -1080,6 +1107,11 @@ bool KDjVu::isCacheEnabled() const
     return d->m_cacheEnabled;
 }
 
+qulonglong KDjVu::cacheMemory() const
+{
+    return d->mImgCacheMemory.load(std::memory_order_relaxed);
+}
+
 int KDjVu::pageNumber(const QString &name) const
 {
     if (!d->m_djvu_document) {
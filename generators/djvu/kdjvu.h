@@ -14,6 +14,8 @@
 #include <QRect>
 #include <QVariant>
 
+#include <functional>
+
 class QDomDocument;
 class QFile;
 
@@ -252,8 +254,12 @@ public:
      * Check if the image for the specified \p page with the specified
      * \p width, \p height and \p rotation is already in cache, and returns
      * it. If not, a null image is returned.
+     *
+     * Big pages are rendered in parts; if \p shouldAbort returns true between
+     * two of them, rendering stops and a null image is returned. After each
+     * part \p partialUpdate gets the page rendered so far.
      */
-    QImage image(int page, int width, int height, int rotation);
+    QImage image(int page, int width, int height, int rotation, const std::function<bool()> &shouldAbort = {}, const std::function<void(const QImage &)> &partialUpdate = {});
 
     /**
      * Export the currently open document as PostScript file \p fileName.
@@ -281,6 +287,12 @@ public:
      * \returns whether the internal rendered pages cache is enabled
      */
     bool isCacheEnabled() const;
+    /**
+     * \returns the memory used by the internal rendered pages cache, in bytes
+     *
+     * Unlike the other methods, it can be called while another thread uses the document.
+     */
+    qulonglong cacheMemory() const;
 
     /**
      * Return the page number of the page whose title is \p name.
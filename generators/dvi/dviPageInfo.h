@@ -13,6 +13,8 @@
 #include <QList>
 #include <QPixmap>
 
+#include <functional>
+
 class dviPageInfo
 {
 public:
@@ -39,6 +41,14 @@ public:
      */
     QList<Hyperlink> hyperLinkList;
     QList<TextBox> textBoxList;
+
+    /** \brief Checked while the page is drawn, drawing stops and img is left null when it returns true
+     */
+    std::function<bool()> shouldAbort;
+
+    /** \brief Called with the page drawn so far every now and then while the page is drawn
+     */
+    std::function<void(const QImage &)> partialUpdate;
 };
 
 /* quick&dirty hack to cheat the dviRenderer class... */
@@ -157,6 +157,12 @@ void dviRenderer::drawPage(RenderedDocumentPagePixmap *page)
     } else {
         qCDebug(OkularDviDebug) << "painter creation failed.";
     }
+    if (page->shouldAbort && page->shouldAbort()) {
+        page->img = QImage();
+        errorMsg.clear();
+        currentlyDrawnPage = nullptr;
+        return;
+    }
     page->img = img;
     // page->setImage(img);
 
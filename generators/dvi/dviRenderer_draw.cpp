@@ -255,7 +255,18 @@ void dviRenderer::draw_part(double current_dimconv, bool is_vfmacro)
     int last_space_index = 0;
     bool space_encountered;
     bool after_space = false;
+    int commandCount = 0;
     for (;;) {
+        // once in a while, see if the page is still wanted and show what is drawn so far
+        if (!is_vfmacro && ++commandCount % 256 == 0) {
+            if (currentlyDrawnPage->shouldAbort && currentlyDrawnPage->shouldAbort()) {
+                return;
+            }
+            if (currentlyDrawnPage->partialUpdate) {
+                currentlyDrawnPage->partialUpdate(*static_cast<QImage *>(foreGroundPainter->device()));
+            }
+        }
+
         space_encountered = false;
         ch = readUINT8();
         if (ch <= (unsigned char)(SETCHAR0 + 127)) {
@@ -614,6 +625,11 @@ void dviRenderer::draw_page()
         PS_interface->restoreBackgroundColor(current_page);
 
         PS_interface->graphics(current_page, resolutionInDPI, dviFile->getMagnification(), foreGroundPainter);
+
+        // the PostScript is often what takes long, show it before the text is drawn
+        if (currentlyDrawnPage->partialUpdate) {
+            currentlyDrawnPage->partialUpdate(*static_cast<QImage *>(foreGroundPainter->device()));
+        }
     }
 
     // Now really write the text
@@ -47,6 +47,7 @@ DviGenerator::DviGenerator(QObject *parent, const QVariantList &args)
     , m_dviRenderer(nullptr)
 {
     setFeature(Threaded);
+    setFeature(SupportsCancelling);
     setFeature(TextExtraction);
     setFeature(FontInfo);
     setFeature(PrintPostscript);
@@ -194,6 +195,9 @@ QImage DviGenerator::image(Okular::PixmapRequest *request)
     pageInfo->height = request->height();
 
     pageInfo->pageNumber = request->pageNumber() + 1;
+    pageInfo->shouldAbort = [request] { return request->shouldAbortRender(); };
+    Okular::PartialPixmapUpdater updater(this, request);
+    pageInfo->partialUpdate = [&updater](const QImage &image) { updater.update(image); };
 
     //  pageInfo->resolution = m_resolution;
 
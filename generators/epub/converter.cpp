@@ -7,7 +7,9 @@
 #include "converter.h"
 
 #include <QAbstractTextDocumentLayout>
+#include <QDomDocument>
 #include <QFileInfo>
+#include <QMutexLocker>
 #include <QRegularExpression>
 #include <QTextDocument>
 #include <QTextDocumentFragment>
@@ -24,13 +26,22 @@
 
 using namespace Epub;
 
+// the chapters converted before the document is shown, the rest is converted in a thread
+static const int pagesBeforeBackground = 4;
+
+static const QSize videoSize(320, 240);
+
 Converter::Converter()
     : mTextDocument(nullptr)
+    , mIterator(nullptr)
+    , mCursor(nullptr)
+    , mFirstChapter(true)
 {
 }
 
 Converter::~Converter()
 {
+    waitForConversion(true);
 }
 
 // join the char * array into one QString
@@ -107,7 +118,7 @@ void Converter::_handle_anchors(const QTextBlock &start, const QString &name)
                     } else { // Outside document link
                         Okular::BrowseAction *action = new Okular::BrowseAction(QUrl(href.toString()));
 
-                        Q_EMIT addAction(action, frag.position(), frag.position() + frag.length());
+                        queueAction(action, frag.position(), frag.position() + frag.length());
                     }
                 }
 
@@ -165,8 +176,10 @@ QTextDocument *Converter::convert(const QString &fileName)
         return nullptr;
     }
     mTextDocument = newDocument;
+    // set before laying out anything, so that the generator does not lay out the document again
+    mTextDocument->setDefaultFont(generator()->generalSettings()->font());
 
-    QTextCursor *_cursor = new QTextCursor(mTextDocument);
+    mCursor = new QTextCursor(mTextDocument);
 
     mLocalLinks.clear();
     mSectionMap.clear();
@@ -184,171 +197,241 @@ QTextDocument *Converter::convert(const QString &fileName)
     _emitData(Okular::DocumentInfo::Copyright, EPUB_RIGHTS);
     Q_EMIT addMetaData(Okular::DocumentInfo::MimeType, QStringLiteral("application/epub+zip"));
 
-    struct eiterator *it;
-
     // iterate over the book
-    it = epub_get_iterator(mTextDocument->getEpub(), EITERATOR_SPINE, 0);
+    mIterator = epub_get_iterator(mTextDocument->getEpub(), EITERATOR_SPINE, 0);
 
     // if the background color of the document is non-white it will be handled by QTextDocument::setHtml()
-    bool firstPage = true;
+    mFirstChapter = true;
+
+    // convert enough to show the first pages, and the rest of the book while they are shown
+    bool more = true;
+    while (more && mTextDocument->pageCount() <= pagesBeforeBackground) {
+        more = convertChapter();
+    }
+
+    if (more) {
+        convertInBackground(
+            mTextDocument,
+            [this] { return convertChapter(); },
+            [this] {
+                if (!isConversionCancelled()) {
+                    convertTableOfContents();
+                    addLocalLinks();
+                }
+                endConversion();
+            });
+    } else {
+        convertTableOfContents();
+        addLocalLinks();
+        endConversion();
+    }
+
+    return mTextDocument;
+}
+
+bool Converter::convertChapter()
+{
+    QString link;
+    QString htmlContent;
+    {
+        QMutexLocker locker(documentMutex());
+        if (!epub_it_get_curr(mIterator)) {
+            return epub_it_get_next(mIterator);
+        }
+
+        link = QString::fromUtf8(epub_it_get_curr_url(mIterator));
+        mTextDocument->setCurrentSubDocument(link);
+        htmlContent = QString::fromUtf8(epub_it_get_curr(mIterator));
+    }
+
     QList<Okular::MovieAnnotation *> movieAnnots;
     QList<Okular::SoundAction *> soundActions;
+    prepareChapter(htmlContent, movieAnnots, soundActions);
 
-    const QSize videoSize(320, 240);
-    do {
-        if (!epub_it_get_curr(it)) {
-            continue;
-        }
+    QMutexLocker locker(documentMutex());
 
-        movieAnnots.clear();
-        soundActions.clear();
+    QTextBlock before;
+    if (mFirstChapter) {
+        mTextDocument->setHtml(htmlContent);
+        mFirstChapter = false;
+        before = mTextDocument->begin();
+    } else {
+        before = mCursor->block();
+        mCursor->insertHtml(htmlContent);
+    }
 
-        const QString link = QString::fromUtf8(epub_it_get_curr_url(it));
-        mTextDocument->setCurrentSubDocument(link);
-        QString htmlContent = QString::fromUtf8(epub_it_get_curr(it));
-
-        // as QTextCharFormat::anchorNames() ignores sections, replace it with <p>
-        static const QRegularExpression sectionStart {QStringLiteral("< *section")};
-        htmlContent.replace(sectionStart, QStringLiteral("<p"));
-        static const QRegularExpression sectionEnd {QStringLiteral("< */ *section")};
-        htmlContent.replace(sectionEnd, QStringLiteral("</p"));
-
-        // convert svg tags to img
-        const int maxHeight = mTextDocument->maxContentHeight();
-        const int maxWidth = mTextDocument->maxContentWidth();
-        QDomDocument dom;
-        if (dom.setContent(htmlContent)) {
-            QDomNodeList svgs = dom.elementsByTagName(QStringLiteral("svg"));
-            if (!svgs.isEmpty()) {
-                QList<QDomNode> imgNodes;
-                for (int i = 0; i < svgs.length(); ++i) {
-                    QDomNodeList images = svgs.at(i).toElement().elementsByTagName(QStringLiteral("image"));
-                    for (int j = 0; j < images.length(); ++j) {
-                        QString lnk = images.at(i).toElement().attribute(QStringLiteral("xlink:href"));
-                        int ht = images.at(i).toElement().attribute(QStringLiteral("height")).toInt();
-                        int wd = images.at(i).toElement().attribute(QStringLiteral("width")).toInt();
-                        QImage img = mTextDocument->loadResource(QTextDocument::ImageResource, QUrl(lnk)).value<QImage>();
-                        if (ht == 0) {
-                            ht = img.height();
-                        }
-                        if (wd == 0) {
-                            wd = img.width();
-                        }
-                        if (ht > maxHeight) {
-                            ht = maxHeight;
-                        }
-                        if (wd > maxWidth) {
-                            wd = maxWidth;
-                        }
-                        mTextDocument->addResource(QTextDocument::ImageResource, QUrl(lnk), img);
-                        QDomDocument newDoc;
-                        newDoc.setContent(QStringLiteral("<img src=\"%1\" height=\"%2\" width=\"%3\" />").arg(lnk).arg(ht).arg(wd));
-                        imgNodes.append(newDoc.documentElement());
-                    }
-                    for (const QDomNode &nd : std::as_const(imgNodes)) {
-                        svgs.at(i).parentNode().replaceChild(nd, svgs.at(i));
-                    }
-                }
-            }
+    QTextCursor csr(before); // a temporary cursor pointing at the begin of the last inserted block
+    int index = 0;
+
+    while (!movieAnnots.isEmpty() && !(csr = mTextDocument->find(QStringLiteral("<video></video>"), csr)).isNull()) {
+        const int posStart = csr.position();
+        const QPoint startPoint = calculateXYPosition(mTextDocument, posStart);
+        QImage img(QStandardPaths::locate(QStandardPaths::GenericDataLocation, QStringLiteral("okular/pics/okular-epub-movie.png")));
+        img = img.scaled(videoSize);
+        csr.insertImage(img);
+        const int posEnd = csr.position();
+        const QRect videoRect(startPoint, videoSize);
+        movieAnnots[index]->setBoundingRectangle(Okular::NormalizedRect(videoRect, mTextDocument->pageSize().width(), mTextDocument->pageSize().height()));
+        queueAnnotation(movieAnnots[index++], posStart, posEnd);
+        csr.movePosition(QTextCursor::NextWord);
+    }
 
-            // handle embedded videos
-            QDomNodeList videoTags = dom.elementsByTagName(QStringLiteral("video"));
-            while (!videoTags.isEmpty()) {
-                QDomNodeList sourceTags = videoTags.at(0).toElement().elementsByTagName(QStringLiteral("source"));
-                if (!sourceTags.isEmpty()) {
-                    QString lnk = sourceTags.at(0).toElement().attribute(QStringLiteral("src"));
+    csr = QTextCursor(before);
+    index = 0;
+    const QString keyToSearch(QStringLiteral("<audio></audio>"));
+    while (!soundActions.isEmpty() && !(csr = mTextDocument->find(keyToSearch, csr)).isNull()) {
+        const int posStart = csr.position() - keyToSearch.size();
+        const QImage img(QStandardPaths::locate(QStandardPaths::GenericDataLocation, QStringLiteral("okular/pics/okular-epub-sound-icon.png")));
+        csr.insertImage(img);
+        const int posEnd = csr.position();
+        queueAction(soundActions[index++], posStart, posEnd);
+        csr.movePosition(QTextCursor::NextWord);
+    }
 
-                    Okular::Movie *movie = new Okular::Movie(mTextDocument->loadResource(EpubDocument::MovieResource, QUrl(lnk)).toString());
-                    movie->setSize(videoSize);
-                    movie->setShowControls(true);
+    mSectionMap.insert(link, before);
 
-                    Okular::MovieAnnotation *annot = new Okular::MovieAnnotation;
-                    annot->setMovie(movie);
+    _handle_anchors(before, link);
 
-                    movieAnnots.push_back(annot);
-                    QDomDocument tempDoc;
-                    tempDoc.setContent(QStringLiteral("<pre>&lt;video&gt;&lt;/video&gt;</pre>"));
-                    videoTags.at(0).parentNode().replaceChild(tempDoc.documentElement(), videoTags.at(0));
-                }
-            }
+    const int page = mTextDocument->pageCount();
 
-            // handle embedded audio
-            QDomNodeList audioTags = dom.elementsByTagName(QStringLiteral("audio"));
-            while (!audioTags.isEmpty()) {
-                QDomElement element = audioTags.at(0).toElement();
-                bool repeat = element.hasAttribute(QStringLiteral("loop"));
-                QString lnk = element.attribute(QStringLiteral("src"));
+    // it will clear the previous format
+    // useful when the last line had a bullet
+    mCursor->insertBlock(QTextBlockFormat());
 
-                Okular::Sound *sound = new Okular::Sound(mTextDocument->loadResource(EpubDocument::AudioResource, QUrl(lnk)).toByteArray());
+    while (mTextDocument->pageCount() == page) {
+        mCursor->insertText(QStringLiteral("\n"));
+    }
 
-                Okular::SoundAction *soundAction = new Okular::SoundAction(1.0, true, repeat, false, sound);
-                soundActions.push_back(soundAction);
+    return epub_it_get_next(mIterator);
+}
 
-                QDomDocument tempDoc;
-                tempDoc.setContent(QStringLiteral("<pre>&lt;audio&gt;&lt;/audio&gt;</pre>"));
-                audioTags.at(0).parentNode().replaceChild(tempDoc.documentElement(), audioTags.at(0));
-            }
-            htmlContent = dom.toString();
-        }
+void Converter::prepareChapter(QString &htmlContent, QList<Okular::MovieAnnotation *> &movieAnnots, QList<Okular::SoundAction *> &soundActions)
+{
+    // as QTextCharFormat::anchorNames() ignores sections, replace it with <p>
+    static const QRegularExpression sectionStart {QStringLiteral("< *section")};
+    htmlContent.replace(sectionStart, QStringLiteral("<p"));
+    static const QRegularExpression sectionEnd {QStringLiteral("< */ *section")};
+    htmlContent.replace(sectionEnd, QStringLiteral("</p"));
+
+    // only parse the chapters that have something to rewrite
+    if (!htmlContent.contains(QLatin1String("<img")) && !htmlContent.contains(QLatin1String("<svg")) && !htmlContent.contains(QLatin1String("<video"))
+        && !htmlContent.contains(QLatin1String("<audio"))) {
+        return;
+    }
 
-        QTextBlock before;
-        if (firstPage) {
-            mTextDocument->setHtml(htmlContent);
-            firstPage = false;
-            before = mTextDocument->begin();
-        } else {
-            before = _cursor->block();
-            _cursor->insertHtml(htmlContent);
-        }
+    QDomDocument dom;
+    if (!dom.setContent(htmlContent)) {
+        return;
+    }
 
-        QTextCursor csr(before); // a temporary cursor pointing at the begin of the last inserted block
-        int index = 0;
-
-        while (!movieAnnots.isEmpty() && !(csr = mTextDocument->find(QStringLiteral("<video></video>"), csr)).isNull()) {
-            const int posStart = csr.position();
-            const QPoint startPoint = calculateXYPosition(mTextDocument, posStart);
-            QImage img(QStandardPaths::locate(QStandardPaths::GenericDataLocation, QStringLiteral("okular/pics/okular-epub-movie.png")));
-            img = img.scaled(videoSize);
-            csr.insertImage(img);
-            const int posEnd = csr.position();
-            const QRect videoRect(startPoint, videoSize);
-            movieAnnots[index]->setBoundingRectangle(Okular::NormalizedRect(videoRect, mTextDocument->pageSize().width(), mTextDocument->pageSize().height()));
-            Q_EMIT addAnnotation(movieAnnots[index++], posStart, posEnd);
-            csr.movePosition(QTextCursor::NextWord);
+    // Images are only decoded when painted, so they neither slow down the
+    // conversion nor stay in memory for the pages never shown. For that,
+    // QTextDocument needs their size up front, and an url that does not
+    // depend on the sub document being converted.
+    const QDomNodeList imgs = dom.elementsByTagName(QStringLiteral("img"));
+    for (int i = 0; i < imgs.length(); ++i) {
+        QDomElement img = imgs.at(i).toElement();
+        const QUrl src(img.attribute(QStringLiteral("src")));
+        if (src.isEmpty() || !src.isRelative()) {
+            continue;
         }
 
-        csr = QTextCursor(before);
-        index = 0;
-        const QString keyToSearch(QStringLiteral("<audio></audio>"));
-        while (!soundActions.isEmpty() && !(csr = mTextDocument->find(keyToSearch, csr)).isNull()) {
-            const int posStart = csr.position() - keyToSearch.size();
-            const QImage img(QStandardPaths::locate(QStandardPaths::GenericDataLocation, QStringLiteral("okular/pics/okular-epub-sound-icon.png")));
-            csr.insertImage(img);
-            const int posEnd = csr.position();
-            qDebug() << posStart << posEnd;
-            ;
-            Q_EMIT addAction(soundActions[index++], posStart, posEnd);
-            csr.movePosition(QTextCursor::NextWord);
+        QMutexLocker locker(documentMutex());
+        const QString path = mTextDocument->resourcePath(src);
+        img.setAttribute(QStringLiteral("src"), EpubDocument::resourceUrl(path).toString());
+        if (!img.hasAttribute(QStringLiteral("width")) && !img.hasAttribute(QStringLiteral("height"))) {
+            const QSize size = mTextDocument->imageSize(path);
+            if (size.isValid()) {
+                img.setAttribute(QStringLiteral("width"), size.width());
+                img.setAttribute(QStringLiteral("height"), size.height());
+            }
         }
+    }
 
-        mSectionMap.insert(link, before);
+    // convert svg tags to img
+    const int maxHeight = mTextDocument->maxContentHeight();
+    const int maxWidth = mTextDocument->maxContentWidth();
+    QDomNodeList svgs = dom.elementsByTagName(QStringLiteral("svg"));
+    while (!svgs.isEmpty()) {
+        QDomElement svg = svgs.at(0).toElement();
+        if (svg.parentNode().isNull()) {
+            break;
+        }
+        const QDomNodeList images = svg.elementsByTagName(QStringLiteral("image"));
+        for (int i = 0; i < images.length(); ++i) {
+            const QDomElement image = images.at(i).toElement();
+            const QString lnk = image.attribute(QStringLiteral("xlink:href"));
+            int ht = image.attribute(QStringLiteral("height")).toInt();
+            int wd = image.attribute(QStringLiteral("width")).toInt();
+
+            QMutexLocker locker(documentMutex());
+            const QString path = mTextDocument->resourcePath(QUrl(lnk));
+            if (ht == 0 || wd == 0) {
+                const QSize size = mTextDocument->imageSize(path);
+                if (ht == 0) {
+                    ht = size.height();
+                }
+                if (wd == 0) {
+                    wd = size.width();
+                }
+            }
+            locker.unlock();
 
-        _handle_anchors(before, link);
+            QDomElement img = dom.createElement(QStringLiteral("img"));
+            img.setAttribute(QStringLiteral("src"), EpubDocument::resourceUrl(path).toString());
+            img.setAttribute(QStringLiteral("height"), qMin(ht, maxHeight));
+            img.setAttribute(QStringLiteral("width"), qMin(wd, maxWidth));
+            svg.parentNode().insertBefore(img, svg);
+        }
+        svg.parentNode().removeChild(svg);
+    }
 
-        const int page = mTextDocument->pageCount();
+    // handle embedded videos
+    QDomNodeList videoTags = dom.elementsByTagName(QStringLiteral("video"));
+    while (!videoTags.isEmpty()) {
+        QDomNodeList sourceTags = videoTags.at(0).toElement().elementsByTagName(QStringLiteral("source"));
+        if (!sourceTags.isEmpty()) {
+            QString lnk = sourceTags.at(0).toElement().attribute(QStringLiteral("src"));
+
+            QMutexLocker locker(documentMutex());
+            Okular::Movie *movie = new Okular::Movie(mTextDocument->loadResource(EpubDocument::MovieResource, QUrl(lnk)).toString());
+            locker.unlock();
+            movie->setSize(videoSize);
+            movie->setShowControls(true);
+
+            Okular::MovieAnnotation *annot = new Okular::MovieAnnotation;
+            annot->setMovie(movie);
+
+            movieAnnots.push_back(annot);
+            QDomDocument tempDoc;
+            tempDoc.setContent(QStringLiteral("<pre>&lt;video&gt;&lt;/video&gt;</pre>"));
+            videoTags.at(0).parentNode().replaceChild(tempDoc.documentElement(), videoTags.at(0));
+        }
+    }
 
-        // it will clear the previous format
-        // useful when the last line had a bullet
-        _cursor->insertBlock(QTextBlockFormat());
+    // handle embedded audio
+    QDomNodeList audioTags = dom.elementsByTagName(QStringLiteral("audio"));
+    while (!audioTags.isEmpty()) {
+        QDomElement element = audioTags.at(0).toElement();
+        bool repeat = element.hasAttribute(QStringLiteral("loop"));
+        QString lnk = element.attribute(QStringLiteral("src"));
 
-        while (mTextDocument->pageCount() == page) {
-            _cursor->insertText(QStringLiteral("\n"));
-        }
+        QMutexLocker locker(documentMutex());
+        Okular::Sound *sound = new Okular::Sound(mTextDocument->loadResource(EpubDocument::AudioResource, QUrl(lnk)).toByteArray());
+        locker.unlock();
 
-    } while (epub_it_get_next(it));
+        Okular::SoundAction *soundAction = new Okular::SoundAction(1.0, true, repeat, false, sound);
+        soundActions.push_back(soundAction);
 
-    epub_free_iterator(it);
+        QDomDocument tempDoc;
+        tempDoc.setContent(QStringLiteral("<pre>&lt;audio&gt;&lt;/audio&gt;</pre>"));
+        audioTags.at(0).parentNode().replaceChild(tempDoc.documentElement(), audioTags.at(0));
+    }
+    htmlContent = dom.toString();
+}
 
+void Converter::convertTableOfContents()
+{
     // handle toc
     struct titerator *tit;
 
@@ -380,17 +463,17 @@ QTextDocument *Converter::convert(const QString &fileName)
                         int size = epub_get_data(mTextDocument->getEpub(), clinkClean, &data);
 
                         if (data) {
-                            _cursor->insertBlock();
+                            mCursor->insertBlock();
 
                             // try to load as image and if not load as html
-                            block = _cursor->block();
+                            block = mCursor->block();
                             QImage image;
                             mSectionMap.insert(link, block);
                             if (image.loadFromData(reinterpret_cast<unsigned char *>(data), size)) {
                                 mTextDocument->addResource(QTextDocument::ImageResource, QUrl(link), image);
-                                _cursor->insertImage(link);
+                                mCursor->insertImage(link);
                             } else {
-                                _cursor->insertHtml(QString::fromUtf8(data));
+                                mCursor->insertHtml(QString::fromUtf8(data));
                                 // Add anchors to hashes
                                 _handle_anchors(block, link);
                             }
@@ -398,7 +481,7 @@ QTextDocument *Converter::convert(const QString &fileName)
                             // Start new file in a new page
                             int page = mTextDocument->pageCount();
                             while (mTextDocument->pageCount() == page) {
-                                _cursor->insertText(QStringLiteral("\n"));
+                                mCursor->insertText(QStringLiteral("\n"));
                             }
                         }
 
@@ -407,7 +490,7 @@ QTextDocument *Converter::convert(const QString &fileName)
                 }
 
                 if (block.isValid()) { // be sure we actually got a block
-                    Q_EMIT addTitle(epub_tit_get_curr_depth(tit), QString::fromUtf8(label), block);
+                    queueTitle(epub_tit_get_curr_depth(tit), QString::fromUtf8(label), block);
                 } else {
                     qDebug() << "Error: no block found for" << link;
                 }
@@ -425,7 +508,10 @@ QTextDocument *Converter::convert(const QString &fileName)
     } else {
         qDebug() << "no toc found";
     }
+}
 
+void Converter::addLocalLinks()
+{
     // adding link actions
     QHashIterator<QString, QList<QPair<int, int>>> hit(mLocalLinks);
     while (hit.hasNext()) {
@@ -439,14 +525,19 @@ QTextDocument *Converter::convert(const QString &fileName)
 
                 Okular::GotoAction *action = new Okular::GotoAction(QString(), viewport);
 
-                Q_EMIT addAction(action, hit.value()[i].first, hit.value()[i].second);
+                queueAction(action, hit.value()[i].first, hit.value()[i].second);
             } else {
                 qDebug() << "Error: no block found for " << hit.key();
             }
         }
     }
+}
 
-    delete _cursor;
+void Converter::endConversion()
+{
+    epub_free_iterator(mIterator);
+    mIterator = nullptr;
 
-    return mTextDocument;
+    delete mCursor;
+    mCursor = nullptr;
 }
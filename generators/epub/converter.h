@@ -13,8 +13,18 @@
 
 #include "epubdocument.h"
 
+namespace Okular
+{
+class MovieAnnotation;
+class SoundAction;
+}
+
 namespace Epub
 {
+/**
+ * Converts the first chapters of the book right away, and the rest of it
+ * in a thread while the first pages are shown.
+ */
 class Converter : public Okular::TextDocumentConverter
 {
     Q_OBJECT
@@ -29,11 +39,22 @@ private:
     void _emitData(Okular::DocumentInfo::Key key, enum epub_metadata type);
     void _handle_anchors(const QTextBlock &start, const QString &name);
     void _insert_local_links(const QString &key, const QPair<int, int> value);
+
+    bool convertChapter();
+    void prepareChapter(QString &htmlContent, QList<Okular::MovieAnnotation *> &movieAnnots, QList<Okular::SoundAction *> &soundActions);
+    void convertTableOfContents();
+    void addLocalLinks();
+    void endConversion();
+
     EpubDocument *mTextDocument;
     QFont mFont;
 
     QHash<QString, QTextBlock> mSectionMap;
     QHash<QString, QList<QPair<int, int>>> mLocalLinks;
+
+    struct eiterator *mIterator;
+    QTextCursor *mCursor;
+    bool mFirstChapter;
 };
 }
 
@@ -5,7 +5,9 @@
 */
 
 #include "epubdocument.h"
+#include <QBuffer>
 #include <QDir>
+#include <QImageReader>
 #include <QTemporaryFile>
 
 #include <QRegularExpression>
@@ -66,6 +68,47 @@ int EpubDocument::maxContentWidth() const
     return pageSize().width() - (2 * padding);
 }
 
+QString EpubDocument::resourcePath(const QUrl &name) const
+{
+    if (name.scheme() == QLatin1String("epub")) {
+        return name.path();
+    }
+    return mCurrentSubDocument.resolved(name).path();
+}
+
+QUrl EpubDocument::resourceUrl(const QString &path)
+{
+    QUrl url;
+    url.setScheme(QStringLiteral("epub"));
+    url.setPath(path);
+    return url;
+}
+
+QSize EpubDocument::imageSize(const QString &path)
+{
+    char *data = nullptr;
+    const int size = epub_get_data(mEpub, path.toUtf8().constData(), &data);
+    if (data == nullptr || size <= 0) {
+        free(data);
+        return QSize();
+    }
+
+    QByteArray bytes = QByteArray::fromRawData(data, size);
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    QSize imageSize = QImageReader(&buffer).size();
+    free(data);
+
+    // as loadResource() scales the image
+    if (imageSize.height() > maxContentHeight()) {
+        imageSize = QSize(imageSize.width() * maxContentHeight() / imageSize.height(), maxContentHeight());
+    }
+    if (imageSize.width() > maxContentWidth()) {
+        imageSize = QSize(maxContentWidth(), imageSize.height() * maxContentWidth() / imageSize.width());
+    }
+    return imageSize;
+}
+
 QString EpubDocument::checkCSS(const QString &c)
 {
     QString css = c;
@@ -101,7 +144,7 @@ QVariant EpubDocument::loadResource(int type, const QUrl &name)
     int size;
     char *data = nullptr;
 
-    QString fileInPath = mCurrentSubDocument.resolved(name).path();
+    QString fileInPath = resourcePath(name);
 
     // Get the data from the epub file
     size = epub_get_data(mEpub, fileInPath.toUtf8().constData(), &data);
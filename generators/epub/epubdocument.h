@@ -28,6 +28,24 @@ public:
     void setCurrentSubDocument(const QString &doc);
     int maxContentHeight() const;
     int maxContentWidth() const;
+
+    /**
+     * Returns the path in the book of the resource @p name, which may be relative to the current sub document.
+     */
+    QString resourcePath(const QUrl &name) const;
+
+    /**
+     * Returns an url for the resource at @p path in the book, that is loaded
+     * whatever the current sub document is.
+     */
+    static QUrl resourceUrl(const QString &path);
+
+    /**
+     * Returns the size the image at @p path in the book is shown at, only
+     * reading its header.
+     */
+    QSize imageSize(const QString &path);
+
     enum Multimedia { MovieResource = QTextDocument::UserResource, AudioResource };
 
 protected:
@@ -20,6 +20,7 @@ FaxGenerator::FaxGenerator(QObject *parent, const QVariantList &args)
     : Generator(parent, args)
 {
     setFeature(Threaded);
+    setFeature(SupportsCancelling);
     setFeature(PrintNative);
     setFeature(PrintToFile);
 }
@@ -62,6 +63,10 @@ bool FaxGenerator::doCloseDocument()
 
 QImage FaxGenerator::image(Okular::PixmapRequest *request)
 {
+    if (request->shouldAbortRender()) {
+        return QImage();
+    }
+
     // perform a smooth scaled generation
     int width = request->width();
     int height = request->height();
@@ -38,6 +38,7 @@ KIMGIOGenerator::KIMGIOGenerator(QObject *parent, const QVariantList &args)
 {
     setFeature(ReadRawData);
     setFeature(Threaded);
+    setFeature(SupportsCancelling);
     setFeature(TiledRendering);
     setFeature(PrintNative);
     setFeature(PrintToFile);
@@ -119,6 +120,11 @@ bool KIMGIOGenerator::doCloseDocument()
 
 QImage KIMGIOGenerator::image(Okular::PixmapRequest *request)
 {
+    // the request may have been cancelled while waiting for the image to be loaded
+    if (request->shouldAbortRender()) {
+        return QImage();
+    }
+
     // perform a smooth scaled generation
     if (request->isTile()) {
         const QRect srcRect = request->normalizedRect().geometry(m_img.width(), m_img.height());
@@ -15,6 +15,7 @@
 #include "generator_pdf.h"
 
 // qt/kde includes
+#include <QApplication>
 #include <QCheckBox>
 #include <QColor>
 #include <QComboBox>
@@ -27,6 +28,7 @@
 #include <QMutex>
 #include <QPainter>
 #include <QPrinter>
+#include <QProgressDialog>
 #include <QStack>
 #include <QTemporaryFile>
 #include <QTextStream>
@@ -63,6 +65,7 @@
 #include "pdfsignatureutils.h"
 #include "popplerembeddedfile.h"
 #include "popplerversion.h"
+#include "rasterprintpipeline.h"
 
 #include <functional>
 
@@ -649,6 +652,9 @@ static QList<Okular::ObjectRect *> generateLinks(std::vector<std::unique_ptr<Pop
  * So, as example, printing while generating a pixmap asynchronously is safe,
  * it might only block the gui thread by 1) waiting for the mutex to unlock
  * in async thread and 2) doing the 'heavy' print operation.
+ * Text extraction, the outline, the document info and the fonts are read from a
+ * second instance of the file with a mutex of its own (see textDocument()), so
+ * they don't wait for pages being rendered or annotations being edited.
  */
 
 K_PLUGIN_CLASS_WITH_JSON(PDFGenerator, "libokularGenerator_poppler.json")
@@ -684,6 +690,7 @@ PDFGenerator::PDFGenerator(QObject *parent, const QVariantList &args)
     setFeature(TiledRendering);
     setFeature(SwapBackingFile);
     setFeature(SupportsCancelling);
+    setFeature(ThreadedLoading);
 
     // You only need to do it once not for each of the documents but it is cheap enough
     // so doing it all the time won't hurt either
@@ -794,8 +801,15 @@ Okular::Document::OpenResult PDFGenerator::init(QList<Okular::Page *> &pagesVect
 
     loadPages(pagesVector, 0, false);
 
-    // update the configuration
-    reparseConfig();
+    // text extraction and the document metadata get an instance of their own, see textDocument()
+    if (!documentFilePath.isEmpty() && !documentHasPassword) {
+        textdoc = Poppler::Document::load(documentFilePath, nullptr, nullptr);
+        if (textdoc && textdoc->isLocked()) {
+            textdoc.reset();
+        }
+    }
+
+    // the configuration is read in the GUI thread, by Document or swapBackingFile()
 
     // create annotation proxy
     annotProxy = new PopplerAnnotationProxy(pdfdoc.get(), userMutex(), &annotationsOnOpenHash);
@@ -835,6 +849,7 @@ PDFGenerator::SwapBackingFileResult PDFGenerator::swapBackingFile(QString const
     if (openResult != Okular::Document::OpenSuccess) {
         return SwapBackingFileError;
     }
+    reparseConfig();
 
     // Recreate links if needed since they are done on image() and image() is not called when swapping the file
     // since the page is already rendered
@@ -857,12 +872,20 @@ PDFGenerator::SwapBackingFileResult PDFGenerator::swapBackingFile(QString const
 
 bool PDFGenerator::doCloseDocument()
 {
+    // a print job waiting for pages renders from pdfdoc
+    if (printPipeline) {
+        printPipeline->stop();
+    }
+
     // remove internal objects
     userMutex()->lock();
     delete annotProxy;
     annotProxy = nullptr;
     pdfdoc = nullptr;
     userMutex()->unlock();
+    textdocMutex.lock();
+    textdoc = nullptr;
+    textdocMutex.unlock();
     docSynopsisDirty = true;
     docSyn.clear();
     docEmbeddedFilesDirty = true;
@@ -986,47 +1009,49 @@ Okular::DocumentInfo PDFGenerator::generateDocumentInfo(const QSet<Okular::Docum
     Okular::DocumentInfo docInfo;
     docInfo.set(Okular::DocumentInfo::MimeType, QStringLiteral("application/pdf"));
 
-    userMutex()->lock();
+    QMutex *mutex = textDocumentMutex();
+    mutex->lock();
 
-    if (pdfdoc) {
+    Poppler::Document *doc = textDocument();
+    if (doc) {
         // compile internal structure reading properties from PDFDoc
         if (keys.contains(Okular::DocumentInfo::Title)) {
-            docInfo.set(Okular::DocumentInfo::Title, pdfdoc->info(QStringLiteral("Title")));
+            docInfo.set(Okular::DocumentInfo::Title, doc->info(QStringLiteral("Title")));
         }
         if (keys.contains(Okular::DocumentInfo::Subject)) {
-            docInfo.set(Okular::DocumentInfo::Subject, pdfdoc->info(QStringLiteral("Subject")));
+            docInfo.set(Okular::DocumentInfo::Subject, doc->info(QStringLiteral("Subject")));
         }
         if (keys.contains(Okular::DocumentInfo::Author)) {
-            docInfo.set(Okular::DocumentInfo::Author, pdfdoc->info(QStringLiteral("Author")));
+            docInfo.set(Okular::DocumentInfo::Author, doc->info(QStringLiteral("Author")));
         }
         if (keys.contains(Okular::DocumentInfo::Keywords)) {
-            docInfo.set(Okular::DocumentInfo::Keywords, pdfdoc->info(QStringLiteral("Keywords")));
+            docInfo.set(Okular::DocumentInfo::Keywords, doc->info(QStringLiteral("Keywords")));
         }
         if (keys.contains(Okular::DocumentInfo::Creator)) {
-            docInfo.set(Okular::DocumentInfo::Creator, pdfdoc->info(QStringLiteral("Creator")));
+            docInfo.set(Okular::DocumentInfo::Creator, doc->info(QStringLiteral("Creator")));
         }
         if (keys.contains(Okular::DocumentInfo::Producer)) {
-            docInfo.set(Okular::DocumentInfo::Producer, pdfdoc->info(QStringLiteral("Producer")));
+            docInfo.set(Okular::DocumentInfo::Producer, doc->info(QStringLiteral("Producer")));
         }
         if (keys.contains(Okular::DocumentInfo::CreationDate)) {
-            docInfo.set(Okular::DocumentInfo::CreationDate, QLocale().toString(pdfdoc->date(QStringLiteral("CreationDate")), QLocale::LongFormat));
+            docInfo.set(Okular::DocumentInfo::CreationDate, QLocale().toString(doc->date(QStringLiteral("CreationDate")), QLocale::LongFormat));
         }
         if (keys.contains(Okular::DocumentInfo::ModificationDate)) {
-            docInfo.set(Okular::DocumentInfo::ModificationDate, QLocale().toString(pdfdoc->date(QStringLiteral("ModDate")), QLocale::LongFormat));
+            docInfo.set(Okular::DocumentInfo::ModificationDate, QLocale().toString(doc->date(QStringLiteral("ModDate")), QLocale::LongFormat));
         }
         if (keys.contains(Okular::DocumentInfo::CustomKeys)) {
             int major, minor;
-            auto version = pdfdoc->getPdfVersion();
+            auto version = doc->getPdfVersion();
             major = version.major;
             minor = version.minor;
             docInfo.set(QStringLiteral("format"), i18nc("PDF v. <version>", "PDF v. %1.%2", major, minor), i18n("Format"));
-            docInfo.set(QStringLiteral("encryption"), pdfdoc->isEncrypted() ? i18n("Encrypted") : i18n("Unencrypted"), i18n("Security"));
-            docInfo.set(QStringLiteral("optimization"), pdfdoc->isLinearized() ? i18n("Yes") : i18n("No"), i18n("Optimized"));
+            docInfo.set(QStringLiteral("encryption"), doc->isEncrypted() ? i18n("Encrypted") : i18n("Unencrypted"), i18n("Security"));
+            docInfo.set(QStringLiteral("optimization"), doc->isLinearized() ? i18n("Yes") : i18n("No"), i18n("Optimized"));
         }
 
-        docInfo.set(Okular::DocumentInfo::Pages, QString::number(pdfdoc->numPages()));
+        docInfo.set(Okular::DocumentInfo::Pages, QString::number(doc->numPages()));
     }
-    userMutex()->unlock();
+    mutex->unlock();
 
     return docInfo;
 }
@@ -1041,9 +1066,9 @@ const Okular::DocumentSynopsis *PDFGenerator::generateDocumentSynopsis()
         return nullptr;
     }
 
-    userMutex()->lock();
-    const QList<Poppler::OutlineItem> outline = pdfdoc->outline();
-    userMutex()->unlock();
+    // the outline items read their children from the document, keep it locked while walking them
+    QMutexLocker locker(textDocumentMutex());
+    const QList<Poppler::OutlineItem> outline = textDocument()->outline();
 
     if (outline.isEmpty()) {
         return nullptr;
@@ -1119,15 +1144,15 @@ Okular::FontInfo::List PDFGenerator::fontsForPage(int page)
     }
 
     QList<Poppler::FontInfo> fonts;
-    userMutex()->lock();
+    textDocumentMutex()->lock();
 
     {
-        std::unique_ptr<Poppler::FontIterator> it = pdfdoc->newFontIterator(page);
+        std::unique_ptr<Poppler::FontIterator> it = textDocument()->newFontIterator(page);
         if (it->hasNext()) {
             fonts = it->next();
         }
     }
-    userMutex()->unlock();
+    textDocumentMutex()->unlock();
 
     for (const Poppler::FontInfo &font : std::as_const(fonts)) {
         Okular::FontInfo of;
@@ -1447,12 +1472,13 @@ Okular::TextPage *PDFGenerator::textPage(Okular::TextRequest *request)
     // build a TextList...
     std::vector<std::unique_ptr<Poppler::TextBox>> textList;
     double pageWidth, pageHeight;
-    userMutex()->lock();
+    QMutex *mutex = textDocumentMutex();
+    mutex->lock();
     if (request->shouldAbortExtraction()) {
-        userMutex()->unlock();
+        mutex->unlock();
         return nullptr;
     }
-    std::unique_ptr<Poppler::Page> pp = pdfdoc->page(page->number());
+    std::unique_ptr<Poppler::Page> pp = textDocument()->page(page->number());
     if (pp) {
         TextExtractionPayload payload(request);
         textList = pp->textList(Poppler::Page::Rotate0, shouldAbortTextExtractionCallback, QVariant::fromValue(&payload));
@@ -1463,7 +1489,7 @@ Okular::TextPage *PDFGenerator::textPage(Okular::TextRequest *request)
         pageWidth = defaultPageWidth;
         pageHeight = defaultPageHeight;
     }
-    userMutex()->unlock();
+    mutex->unlock();
 
     if (textList.empty() && request->shouldAbortExtraction()) {
         return nullptr;
@@ -1475,8 +1501,20 @@ Okular::TextPage *PDFGenerator::textPage(Okular::TextRequest *request)
 
 QByteArray PDFGenerator::requestFontData(const Okular::FontInfo &font)
 {
+    // the fonts were listed from the text document, see fontsForPage()
     Poppler::FontInfo fi = font.nativeId().value<Poppler::FontInfo>();
-    return pdfdoc->fontData(fi);
+    QMutexLocker ml(textDocumentMutex());
+    return textDocument()->fontData(fi);
+}
+
+Poppler::Document *PDFGenerator::textDocument() const
+{
+    return textdoc ? textdoc.get() : pdfdoc.get();
+}
+
+QMutex *PDFGenerator::textDocumentMutex() const
+{
+    return textdoc ? &textdocMutex : userMutex();
 }
 
 void PDFGenerator::okularToPoppler(const Okular::NewSignatureData &oData, Poppler::PDFConverter::NewSignatureData *pData)
@@ -1531,21 +1569,101 @@ Okular::Document::PrintError PDFGenerator::print(QPrinter &printer)
             printer.setFullPage(pdfOptionsPage->ignorePrintMargins());
         }
 
+        const QList<int> pageList = Okular::FilePrinter::pageList(printer, pdfdoc->numPages(), document()->currentPage() + 1, document()->bookmarkedPageList());
+        QList<int> pageNumbers;
+        pageNumbers.reserve(pageList.count());
+        for (const int page : pageList) {
+            pageNumbers << page - 1;
+        }
+
+#ifdef Q_OS_WIN
+        const double dpiX = printer.physicalDpiX();
+        const double dpiY = printer.physicalDpiY();
+#else
+        // UNIX: Same resolution as the postscript rasterizer; see discussion at https://git.reviewboard.kde.org/r/130218/
+        const double dpiX = 300;
+        const double dpiY = 300;
+#endif
+
+        // Poppler documents can't render concurrently, so each worker opens its own copy of the document.
+        // The copies are loaded from pdfdoc saved with its changes, so that the annotations and form
+        // contents not saved yet get printed too. Documents with a password we don't keep around, or
+        // that fail to save, are rendered from pdfdoc on a single worker, which still overlaps
+        // rendering with painting to the printer
+        QTemporaryFile printCopy(QDir::tempPath() + QLatin1String("/okular_print_XXXXXX.pdf"));
+        RasterPrintPipeline::DocumentFactory documentFactory;
+        if (!documentHasPassword && printCopy.open()) {
+            printCopy.close();
+            std::unique_ptr<Poppler::PDFConverter> pdfConv = pdfdoc->pdfConverter();
+            pdfConv->setOutputFileName(printCopy.fileName());
+            pdfConv->setPDFOptions(pdfConv->pdfOptions() | Poppler::PDFConverter::WithChanges);
+
+            userMutex()->lock();
+            const bool converted = pdfConv->convert();
+            userMutex()->unlock();
+
+            if (converted) {
+                const QString filePath = printCopy.fileName();
+                const Poppler::Document::RenderHints renderHints = pdfdoc->renderHints();
+                documentFactory = [filePath, renderHints] {
+                    std::unique_ptr<Poppler::Document> doc = Poppler::Document::load(filePath, nullptr, nullptr);
+                    if (!doc || doc->isLocked()) {
+                        return std::unique_ptr<Poppler::Document>();
+                    }
+                    for (const Poppler::Document::RenderHint hint : {Poppler::Document::Antialiasing,
+                                                                     Poppler::Document::TextAntialiasing,
+                                                                     Poppler::Document::TextHinting,
+                                                                     Poppler::Document::TextSlightHinting,
+                                                                     Poppler::Document::ThinLineSolid,
+                                                                     Poppler::Document::ThinLineShape,
+                                                                     Poppler::Document::IgnorePaperColor,
+                                                                     Poppler::Document::OverprintPreview,
+                                                                     Poppler::Document::HideAnnotations}) {
+                        doc->setRenderHint(hint, renderHints.testFlag(hint));
+                    }
+                    return doc;
+                };
+            }
+        }
+
+        RasterPrintPipeline pipeline(pdfdoc.get(), userMutex(), documentFactory, pageNumbers, dpiX, dpiY);
+        pipeline.start();
+        // closing or reloading the document while we wait for pages stops the pipeline, see doCloseDocument()
+        printPipeline = &pipeline;
+
+        QProgressDialog progress(i18n("Preparing pages for printing..."), i18n("Cancel"), 0, pageNumbers.count(), QApplication::activeWindow());
+        progress.setWindowTitle(i18n("Printing"));
+        progress.setWindowModality(Qt::WindowModal);
+        progress.setMinimumDuration(1000);
+
         QPainter painter;
         painter.begin(&printer);
 
-        QList<int> pageList = Okular::FilePrinter::pageList(printer, pdfdoc->numPages(), document()->currentPage() + 1, document()->bookmarkedPageList());
-        for (int i = 0; i < pageList.count(); ++i) {
+        for (int i = 0; i < pageNumbers.count(); ++i) {
+            progress.setLabelText(i18n("Printing page %1 of %2...", i + 1, pageNumbers.count()));
+            progress.setValue(i);
+
+            RasterPrintPipeline::RenderedPage rendered;
+            while (!progress.wasCanceled() && !pipeline.isCancelled() && !pipeline.takePage(i, &rendered, 100)) {
+                QCoreApplication::processEvents();
+            }
+            if (progress.wasCanceled() || pipeline.isCancelled()) {
+                // the pipeline is cancelled already if the document was closed
+                const bool documentClosed = pipeline.isCancelled() && !progress.wasCanceled();
+                printPipeline = nullptr;
+                pipeline.cancel();
+                printer.abort();
+                painter.end();
+                return documentClosed ? Okular::Document::UnknownPrintError : Okular::Document::NoPrintError;
+            }
+
             if (i != 0) {
                 printer.newPage();
             }
 
-            const int page = pageList.at(i) - 1;
-            userMutex()->lock();
-            std::unique_ptr<Poppler::Page> pp(pdfdoc->page(page));
-            if (pp) {
-                QSizeF pageSize = pp->pageSizeF();      // Unit is 'points' (i.e., 1/72th of an inch)
-                QRect painterWindow = painter.window(); // Unit is 'QPrinter::DevicePixel'
+            if (!rendered.image.isNull()) {
+                const QSizeF pageSize = rendered.pageSize; // Unit is 'points' (i.e., 1/72th of an inch)
+                QRect painterWindow = painter.window();    // Unit is 'QPrinter::DevicePixel'
 
                 // Default: no scaling at all, but we need to go from DevicePixel units to 'points'
                 // Warning: We compute the horizontal scaling, and later assume that the vertical scaling will be the same.
@@ -1560,16 +1678,11 @@ Okular::Document::PrintError PDFGenerator::print(QPrinter &printer)
                     scaling = std::min(horizontalScaling, verticalScaling);
                 }
 
-#ifdef Q_OS_WIN
-                QImage img = pp->renderToImage(printer.physicalDpiX(), printer.physicalDpiY());
-#else
-                // UNIX: Same resolution as the postscript rasterizer; see discussion at https://git.reviewboard.kde.org/r/130218/
-                QImage img = pp->renderToImage(300, 300);
-#endif
-                painter.drawImage(QRectF(QPointF(0, 0), scaling * pp->pageSizeF()), img);
+                painter.drawImage(QRectF(QPointF(0, 0), scaling * pageSize), rendered.image);
             }
-            userMutex()->unlock();
         }
+        printPipeline = nullptr;
+        progress.setValue(pageNumbers.count());
         painter.end();
         return Okular::Document::NoPrintError;
     }
@@ -1663,9 +1776,9 @@ Okular::Document::PrintError PDFGenerator::print(QPrinter &printer)
 QVariant PDFGenerator::metaData(const QString &key, const QVariant &option) const
 {
     if (key == QLatin1String("StartFullScreen")) {
-        QMutexLocker ml(userMutex());
+        QMutexLocker ml(textDocumentMutex());
         // asking for the 'start in fullscreen mode' (pdf property)
-        if (pdfdoc->pageMode() == Poppler::Document::FullScreen) {
+        if (textDocument()->pageMode() == Poppler::Document::FullScreen) {
             return true;
         }
     } else if (key == QLatin1String("NamedViewport") && !option.toString().isEmpty()) {
@@ -1674,9 +1787,9 @@ QVariant PDFGenerator::metaData(const QString &key, const QVariant &option) cons
 
         // asking for the page related to a 'named link destination'. the
         // option is the link name. @see addSynopsisChildren.
-        userMutex()->lock();
-        std::unique_ptr<Poppler::LinkDestination> ld = pdfdoc->linkDestination(optionString);
-        userMutex()->unlock();
+        textDocumentMutex()->lock();
+        std::unique_ptr<Poppler::LinkDestination> ld = textDocument()->linkDestination(optionString);
+        textDocumentMutex()->unlock();
         if (ld) {
             fillViewportFromLinkDestination(viewport, *ld);
         }
@@ -1684,18 +1797,18 @@ QVariant PDFGenerator::metaData(const QString &key, const QVariant &option) cons
             return viewport.toString();
         }
     } else if (key == QLatin1String("DocumentTitle")) {
-        userMutex()->lock();
-        QString title = pdfdoc->info(QStringLiteral("Title"));
-        userMutex()->unlock();
+        textDocumentMutex()->lock();
+        QString title = textDocument()->info(QStringLiteral("Title"));
+        textDocumentMutex()->unlock();
         return title;
     } else if (key == QLatin1String("OpenTOC")) {
-        QMutexLocker ml(userMutex());
-        if (pdfdoc->pageMode() == Poppler::Document::UseOutlines) {
+        QMutexLocker ml(textDocumentMutex());
+        if (textDocument()->pageMode() == Poppler::Document::UseOutlines) {
             return true;
         }
     } else if (key == QLatin1String("DocumentScripts") && option.toString() == QLatin1String("JavaScript")) {
-        QMutexLocker ml(userMutex());
-        return pdfdoc->scripts();
+        QMutexLocker ml(textDocumentMutex());
+        return textDocument()->scripts();
     } else if (key == QLatin1String("HasUnsupportedXfaForm")) {
         QMutexLocker ml(userMutex());
         return pdfdoc->formType() == Poppler::Document::XfaForm;
@@ -17,6 +17,7 @@
 #include <poppler-version.h>
 
 #include <QBitArray>
+#include <QMutex>
 #include <QPointer>
 
 #include <core/annotations.h>
@@ -31,6 +32,7 @@
 
 class PDFOptionsPage;
 class PopplerAnnotationProxy;
+class RasterPrintPipeline;
 
 /**
  * @short A generator that builds contents from a PDF document.
@@ -144,8 +146,17 @@ private:
 
     bool setDocumentRenderHints();
 
+    // the document to extract text and read the metadata from, lock textDocumentMutex() while using it
+    Poppler::Document *textDocument() const;
+    QMutex *textDocumentMutex() const;
+
     // poppler dependent stuff
     std::unique_ptr<Poppler::Document> pdfdoc;
+    // A second instance of the file, so that text extraction, the outline, the document info and
+    // the fonts don't wait for the pages being rendered or the annotations being edited in pdfdoc.
+    // Documents loaded from data or with a password we don't keep around use pdfdoc and userMutex()
+    std::unique_ptr<Poppler::Document> textdoc;
+    mutable QMutex textdocMutex;
 
     void xrefReconstructionHandler();
 
@@ -167,6 +178,8 @@ private:
     QBitArray rectsGenerated;
 
     QPointer<PDFOptionsPage> pdfOptionsPage;
+    // the rasterized print job in progress, if any
+    RasterPrintPipeline *printPipeline = nullptr;
 
     bool documentHasPassword = false;
     QHash<int, Okular::Action *> m_additionalDocumentActions;
@@ -0,0 +1,164 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "rasterprintpipeline.h"
+
+#include <QDeadlineTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <QVariant>
+
+#include <algorithm>
+
+Q_DECLARE_METATYPE(RasterPrintPipeline *)
+
+// Each worker keeps a full page image in flight, with a few more already rendered ones waiting
+// for the painter. At printer resolution a page is tens of MB, so keep this small.
+static const int maxPrintWorkers = 4;
+static const int extraQueuedPages = 2;
+
+static bool shouldAbortPrintRenderCallback(const QVariant &vPayload)
+{
+    auto pipeline = vPayload.value<RasterPrintPipeline *>();
+    return pipeline->isCancelled();
+}
+
+RasterPrintPipeline::RasterPrintPipeline(Poppler::Document *sharedDocument, QMutex *sharedDocumentMutex, const DocumentFactory &documentFactory, const QList<int> &pages, double dpiX, double dpiY)
+    : m_sharedDocument(sharedDocument)
+    , m_sharedDocumentMutex(sharedDocumentMutex)
+    , m_documentFactory(documentFactory)
+    , m_pages(pages)
+    , m_dpiX(dpiX)
+    , m_dpiY(dpiY)
+    , m_capacity(1)
+    , m_cancelled(false)
+    , m_nextToRender(0)
+    , m_nextToTake(0)
+{
+}
+
+RasterPrintPipeline::~RasterPrintPipeline()
+{
+    stop();
+}
+
+void RasterPrintPipeline::start()
+{
+    Q_ASSERT(m_workers.empty());
+
+    // Without per worker documents all renders serialize on the shared document mutex,
+    // more than one worker would only hold more memory
+    int workerCount = 1;
+    if (m_documentFactory) {
+        workerCount = std::clamp(QThread::idealThreadCount(), 1, maxPrintWorkers);
+    }
+    workerCount = std::min<int>(workerCount, std::max<int>(m_pages.count(), 1));
+    m_capacity = workerCount + extraQueuedPages;
+
+    for (int i = 0; i < workerCount; ++i) {
+        std::unique_ptr<QThread> worker(QThread::create([this] { workerLoop(); }));
+        worker->start(QThread::LowPriority);
+        m_workers.push_back(std::move(worker));
+    }
+}
+
+bool RasterPrintPipeline::takePage(int index, RenderedPage *page, int timeout)
+{
+    QMutexLocker locker(&m_mutex);
+    Q_ASSERT(index == m_nextToTake);
+
+    const QDeadlineTimer deadline(timeout);
+    while (!m_rendered.contains(index)) {
+        if (m_cancelled || !m_pageReady.wait(&m_mutex, deadline)) {
+            return false;
+        }
+    }
+
+    *page = m_rendered.take(index);
+    ++m_nextToTake;
+    m_spaceAvailable.wakeAll();
+    return true;
+}
+
+void RasterPrintPipeline::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cancelled = true;
+    m_rendered.clear();
+    m_spaceAvailable.wakeAll();
+    m_pageReady.wakeAll();
+}
+
+bool RasterPrintPipeline::isCancelled() const
+{
+    return m_cancelled;
+}
+
+void RasterPrintPipeline::stop()
+{
+    cancel();
+    for (const std::unique_ptr<QThread> &worker : m_workers) {
+        worker->wait();
+    }
+}
+
+int RasterPrintPipeline::count() const
+{
+    return m_pages.count();
+}
+
+int RasterPrintPipeline::capacity() const
+{
+    return m_capacity;
+}
+
+void RasterPrintPipeline::workerLoop()
+{
+    std::unique_ptr<Poppler::Document> ownDocument;
+    if (m_documentFactory) {
+        ownDocument = m_documentFactory();
+    }
+
+    while (true) {
+        int index;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (!m_cancelled && m_nextToRender < m_pages.count() && m_nextToRender >= m_nextToTake + m_capacity) {
+                m_spaceAvailable.wait(&m_mutex);
+            }
+            if (m_cancelled || m_nextToRender >= m_pages.count()) {
+                return;
+            }
+            index = m_nextToRender++;
+        }
+
+        RenderedPage page;
+        if (ownDocument) {
+            page = renderPage(ownDocument.get(), m_pages.at(index));
+        } else {
+            QMutexLocker documentLocker(m_sharedDocumentMutex);
+            page = renderPage(m_sharedDocument, m_pages.at(index));
+        }
+
+        QMutexLocker locker(&m_mutex);
+        if (m_cancelled) {
+            return;
+        }
+        m_rendered.insert(index, page);
+        m_pageReady.wakeAll();
+    }
+}
+
+RasterPrintPipeline::RenderedPage RasterPrintPipeline::renderPage(Poppler::Document *document, int pageNumber)
+{
+    RenderedPage result;
+    std::unique_ptr<Poppler::Page> pp = document->page(pageNumber);
+    if (pp) {
+        result.pageSize = pp->pageSizeF();
+        result.image = pp->renderToImage(m_dpiX, m_dpiY, -1, -1, -1, -1, Poppler::Page::Rotate0, nullptr, nullptr, shouldAbortPrintRenderCallback, QVariant::fromValue(this));
+    }
+    return result;
+}
@@ -0,0 +1,98 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef OKULAR_RASTERPRINTPIPELINE_H
+#define OKULAR_RASTERPRINTPIPELINE_H
+
+#include <poppler-qt6.h>
+
+#include <QImage>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QSizeF>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QThread;
+
+/**
+ * Renders the pages of a rasterized print job on worker threads.
+ *
+ * Workers render pages ahead of the consumer into a bounded queue, so at most
+ * capacity() images are held in memory at any time. The consumer (the thread
+ * owning the QPainter of the printer) takes the pages out strictly in order
+ * with takePage().
+ *
+ * Each worker renders from its own Poppler::Document if a document factory is
+ * given, otherwise all workers share the given document and serialize on its mutex.
+ */
+class RasterPrintPipeline
+{
+public:
+    using DocumentFactory = std::function<std::unique_ptr<Poppler::Document>()>;
+
+    struct RenderedPage {
+        QImage image;
+        QSizeF pageSize; // in points
+    };
+
+    RasterPrintPipeline(Poppler::Document *sharedDocument, QMutex *sharedDocumentMutex, const DocumentFactory &documentFactory, const QList<int> &pages, double dpiX, double dpiY);
+    ~RasterPrintPipeline();
+
+    RasterPrintPipeline(const RasterPrintPipeline &) = delete;
+    RasterPrintPipeline &operator=(const RasterPrintPipeline &) = delete;
+
+    void start();
+
+    /**
+     * Waits at most @p timeout milliseconds for the page at position @p index of the page list.
+     * Returns false if it is not ready yet. Pages must be taken in order.
+     */
+    bool takePage(int index, RenderedPage *page, int timeout);
+
+    /**
+     * Stops the workers as soon as possible, aborting the renders in flight.
+     */
+    void cancel();
+    bool isCancelled() const;
+
+    /**
+     * Cancels and waits for the workers, so that the shared document can be freed.
+     */
+    void stop();
+
+    int count() const;
+    int capacity() const;
+
+private:
+    void workerLoop();
+    RenderedPage renderPage(Poppler::Document *document, int pageNumber);
+
+    Poppler::Document *m_sharedDocument;
+    QMutex *m_sharedDocumentMutex;
+    DocumentFactory m_documentFactory;
+    const QList<int> m_pages;
+    const double m_dpiX;
+    const double m_dpiY;
+    int m_capacity;
+
+    std::vector<std::unique_ptr<QThread>> m_workers;
+    std::atomic<bool> m_cancelled;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_pageReady;
+    QWaitCondition m_spaceAvailable;
+    QMap<int, RenderedPage> m_rendered;
+    int m_nextToRender;
+    int m_nextToTake;
+};
+
+#endif // OKULAR_RASTERPRINTPIPELINE_H
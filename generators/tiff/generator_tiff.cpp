@@ -93,6 +93,9 @@ public:
     std::unique_ptr<QIODevice> dev;
 };
 
+// how many rows of a page are read between two checks for cancelled requests
+static const uint32_t rowsPerRead = 256;
+
 static QDateTime convertTIFFDateTime(const char *tiffdate)
 {
     if (!tiffdate) {
@@ -161,6 +164,8 @@ TIFFGenerator::TIFFGenerator(QObject *parent, const QVariantList &args)
     , d(new Private)
 {
     setFeature(Threaded);
+    setFeature(SupportsCancelling);
+    setFeature(ThreadedLoading);
     setFeature(PrintNative);
     setFeature(PrintToFile);
     setFeature(ReadRawData);
@@ -238,24 +243,57 @@ QImage TIFFGenerator::image(Okular::PixmapRequest *request)
             orientation = ORIENTATION_TOPLEFT;
         }
 
+        int reqwidth = request->width();
+        int reqheight = request->height();
+        if (rotation % 2 == 1) {
+            std::swap(reqwidth, reqheight);
+        }
+
         QImage img(width, height, QImage::Format_RGB32);
         uint32_t *data = reinterpret_cast<uint32_t *>(img.bits());
+        Okular::PartialPixmapUpdater updater(this, request);
+        if (request->partialUpdatesWanted()) {
+            // the rows not read yet are shown too
+            img.fill(Qt::white);
+        }
 
-        // read data
-        if (TIFFReadRGBAImageOriented(d->tiff, width, height, data, orientation) != 0) {
-            // an image read by ReadRGBAImage is ABGR, we need ARGB, so swap red and blue
-            uint32_t size = width * height;
-            for (uint32_t i = 0; i < size; ++i) {
-                uint32_t red = (data[i] & 0x00FF0000) >> 16;
-                uint32_t blue = (data[i] & 0x000000FF) << 16;
-                data[i] = (data[i] & 0xFF00FF00) + red + blue;
+        // read data, like TIFFReadRGBAImageOriented() but a few rows at a time, so that
+        // cancelled requests stop early and the rows read so far can be shown
+        bool read = false;
+        char errorMessage[1024];
+        TIFFRGBAImage rgbaImage;
+        if (TIFFRGBAImageOK(d->tiff, errorMessage) && TIFFRGBAImageBegin(&rgbaImage, d->tiff, 0, errorMessage)) {
+            rgbaImage.req_orientation = orientation;
+            read = true;
+            for (uint32_t row = 0; read && row < height; row += rowsPerRead) {
+                if (request->shouldAbortRender()) {
+                    TIFFRGBAImageEnd(&rgbaImage);
+                    return QImage();
+                }
+                const uint32_t rows = qMin(rowsPerRead, height - row);
+                rgbaImage.row_offset = row;
+                rgbaImage.col_offset = 0;
+                read = TIFFRGBAImageGet(&rgbaImage, data + row * width, width, rows) != 0;
+
+                // an image read by ReadRGBAImage is ABGR, we need ARGB, so swap red and blue
+                const uint32_t end = (row + rows) * width;
+                for (uint32_t i = row * width; i < end; ++i) {
+                    uint32_t red = (data[i] & 0x00FF0000) >> 16;
+                    uint32_t blue = (data[i] & 0x000000FF) << 16;
+                    data[i] = (data[i] & 0xFF00FF00) + red + blue;
+                }
+
+                if (read && row + rows < height && updater.shouldUpdate()) {
+                    updater.update(img.scaled(reqwidth, reqheight, Qt::IgnoreAspectRatio, Qt::FastTransformation));
+                }
             }
-
-            int reqwidth = request->width();
-            int reqheight = request->height();
-            if (rotation % 2 == 1) {
-                std::swap(reqwidth, reqheight);
+            TIFFRGBAImageEnd(&rgbaImage);
+        }
+        if (read) {
+            if (request->shouldAbortRender()) {
+                return QImage();
             }
+
             return img.scaled(reqwidth, reqheight, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
         }
     }
@@ -6,25 +6,34 @@
 
 #include "converter.h"
 
+#include <QMutexLocker>
 #include <QTextFrame>
 
 #include "document.h"
 
 using namespace Txt;
 
+// the pages laid out before the document is shown, the rest is laid out in a thread
+static const int pagesBeforeBackground = 4;
+
 Converter::Converter()
+    : mTextDocument(nullptr)
 {
 }
 
 Converter::~Converter()
 {
+    waitForConversion(true);
 }
 
 QTextDocument *Converter::convert(const QString &fileName)
 {
     Document *textDocument = new Document(fileName);
+    mTextDocument = textDocument;
 
     textDocument->setPageSize(QSizeF(600, 800));
+    // set before laying out anything, so that the generator does not lay out the document again
+    textDocument->setDefaultFont(generator()->generalSettings()->font());
 
     QTextFrameFormat frameFormat;
     frameFormat.setMargin(20);
@@ -34,5 +43,24 @@ QTextDocument *Converter::convert(const QString &fileName)
 
     Q_EMIT addMetaData(Okular::DocumentInfo::MimeType, QStringLiteral("text/plain"));
 
+    // lay out enough to show the first pages, and the rest of the file while they are shown
+    bool more = true;
+    while (more && textDocument->pageCount() <= pagesBeforeBackground) {
+        more = textDocument->appendChunk();
+    }
+
+    if (more) {
+        convertInBackground(textDocument, [this] { return convertChunk(); });
+    }
+
     return textDocument;
 }
+
+bool Converter::convertChunk()
+{
+    QMutexLocker locker(documentMutex());
+    const bool more = mTextDocument->appendChunk();
+    // lay out the chunk now rather than when the generator next looks at the document
+    mTextDocument->pageCount();
+    return more;
+}
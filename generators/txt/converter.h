@@ -12,6 +12,12 @@
 
 namespace Txt
 {
+class Document;
+
+/**
+ * Lays out the first pages of the file right away, and the rest of it in
+ * a thread while the first pages are shown.
+ */
 class Converter : public Okular::TextDocumentConverter
 {
     Q_OBJECT
@@ -21,6 +27,11 @@ public:
     ~Converter() override;
 
     QTextDocument *convert(const QString &fileName) override;
+
+private:
+    bool convertChunk();
+
+    Document *mTextDocument;
 };
 }
 
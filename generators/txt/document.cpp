@@ -6,41 +6,89 @@
 
 #include "document.h"
 
-#include <QDataStream>
-#include <QFile>
+#include <QTextCursor>
 
 #include <QDebug>
-#include <QStringDecoder>
 
 #include "debug_txt.h"
 
 using namespace Txt;
 
+// how much of the file the encoding is detected on
+static const qint64 encodingPrefixSize = 64 * 1024;
+
+// how much of the file is decoded and laid out at once
+static const qint64 chunkSize = 256 * 1024;
+
 Document::Document(const QString &fileName)
+    : mFile(fileName)
+    , mCarriageReturn(false)
 {
 #ifdef TXT_DEBUG
     qCDebug(OkularTxtDebug) << "Opening file" << fileName;
 #endif
 
-    QFile plainFile(fileName);
-    if (!plainFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qCDebug(OkularTxtDebug) << "Can't open file" << plainFile.fileName();
+    // the text is only ever appended, no need to keep a copy of it for undoing
+    setUndoRedoEnabled(false);
+
+    if (!mFile.open(QIODevice::ReadOnly)) {
+        qCDebug(OkularTxtDebug) << "Can't open file" << mFile.fileName();
         return;
     }
 
-    const QByteArray buffer = plainFile.readAll();
-    setPlainText(toUnicode(buffer));
+    const auto encoding = QStringConverter::encodingForHtml(mFile.peek(encodingPrefixSize));
+    mDecoder = QStringDecoder(encoding.value_or(QStringConverter::Encoding::Utf8));
 }
 
 Document::~Document()
 {
 }
 
-QString Document::toUnicode(const QByteArray &array)
+bool Document::appendChunk()
 {
-    auto encoding = QStringConverter::encodingForHtml(array);
-    QStringDecoder decoder {encoding.value_or(QStringConverter::Encoding::Utf8)};
-    return decoder.decode(array);
+    if (!mFile.isOpen()) {
+        return false;
+    }
+
+    // read until nothing comes anymore, the file may also have been truncated meanwhile
+    QByteArray data = mFile.read(chunkSize);
+    const bool atEnd = data.isEmpty();
+    data.prepend(mRemainder);
+    mRemainder.clear();
+    if (!atEnd) {
+        const qsizetype lineEnd = data.lastIndexOf('\n');
+        if (lineEnd >= 0) {
+            mRemainder = data.mid(lineEnd + 1);
+            data.truncate(lineEnd + 1);
+        }
+    }
+
+    QString text = mDecoder.decode(data);
+
+    // as QIODevice::Text did when reading all the file at once
+    if (mCarriageReturn) {
+        if (!text.startsWith(QLatin1Char('\n'))) {
+            text.prepend(QLatin1Char('\r'));
+        }
+        mCarriageReturn = false;
+    }
+    if (!atEnd && text.endsWith(QLatin1Char('\r'))) {
+        text.chop(1);
+        mCarriageReturn = true;
+    }
+    text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+
+    if (!text.isEmpty()) {
+        QTextCursor cursor(this);
+        cursor.movePosition(QTextCursor::End);
+        cursor.insertText(text);
+    }
+
+    if (atEnd) {
+        mFile.close();
+        return false;
+    }
+    return true;
 }
 
 Q_LOGGING_CATEGORY(OkularTxtDebug, "org.kde.okular.generators.txt", QtWarningMsg)
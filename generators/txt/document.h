@@ -7,10 +7,18 @@
 #ifndef _TXT_DOCUMENT_H_
 #define _TXT_DOCUMENT_H_
 
+#include <QByteArray>
+#include <QFile>
+#include <QStringDecoder>
 #include <QTextDocument>
 
 namespace Txt
 {
+/**
+ * The text of a file, read in chunks rather than all at once, so that a
+ * huge file can be shown before all of it is laid out. All of the text
+ * still ends up in the document.
+ */
 class Document : public QTextDocument
 {
     Q_OBJECT
@@ -19,8 +27,17 @@ public:
     explicit Document(const QString &fileName);
     ~Document() override;
 
+    /**
+     * Appends the next chunk of the file, ending at a line end when
+     * possible, and returns whether some of the file is still to be read.
+     */
+    bool appendChunk();
+
 private:
-    QString toUnicode(const QByteArray &array);
+    QFile mFile;
+    QByteArray mRemainder; // read already, after the last line end of the previous chunk
+    QStringDecoder mDecoder;
+    bool mCarriageReturn; // the last chunk ended within a \r\n
 };
 }
 
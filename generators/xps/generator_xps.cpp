@@ -1319,7 +1319,7 @@ XpsPage::~XpsPage()
     delete m_pageImage;
 }
 
-bool XpsPage::renderToImage(QImage *p)
+bool XpsPage::renderToImage(QImage *p, const std::function<bool()> &shouldAbort, const std::function<void(const QImage &)> &partialUpdate)
 {
     if ((m_pageImage == nullptr) || (m_pageImage->size() != p->size())) {
         delete m_pageImage;
@@ -1333,7 +1333,16 @@ bool XpsPage::renderToImage(QImage *p)
     if (!m_pageIsRendered) {
         m_pageImage->fill(qRgba(255, 255, 255, 255));
         QPainter painter(m_pageImage);
-        renderToPainter(&painter);
+        // the checks between elements are also when the page drawn so far is shown
+        const auto checkpoint = [this, &shouldAbort, &partialUpdate] {
+            if (partialUpdate) {
+                partialUpdate(*m_pageImage);
+            }
+            return shouldAbort && shouldAbort();
+        };
+        if (!renderToPainter(&painter, checkpoint)) {
+            return false;
+        }
         m_pageIsRendered = true;
     }
 
@@ -1342,7 +1351,7 @@ bool XpsPage::renderToImage(QImage *p)
     return true;
 }
 
-bool XpsPage::renderToPainter(QPainter *painter)
+bool XpsPage::renderToPainter(QPainter *painter, const std::function<bool()> &shouldAbort)
 {
     painter->setWorldTransform(QTransform().scale((qreal)painter->device()->width() / size().width(), (qreal)painter->device()->height() / size().height()));
     const KZipFileEntry *pageFile = static_cast<const KZipFileEntry *>(m_file->xpsArchive()->directory()->entry(m_fileName));
@@ -1370,6 +1379,12 @@ bool XpsPage::renderToPainter(QPainter *painter)
             processEndElement(painter, node);
             node.children.clear();
             m_nodes.top().children.append(node);
+
+            // every element drawn is a chance to give up on a page nobody wants anymore
+            if (shouldAbort && shouldAbort()) {
+                m_nodes.clear();
+                return false;
+            }
         }
     }
 
@@ -1962,6 +1977,7 @@ XpsGenerator::XpsGenerator(QObject *parent, const QVariantList &args)
     setFeature(PrintNative);
     setFeature(PrintToFile);
     setFeature(Threaded);
+    setFeature(SupportsCancelling);
     userMutex();
 }
 
@@ -2008,7 +2024,10 @@ QImage XpsGenerator::image(Okular::PixmapRequest *request)
     QSize size((int)request->width(), (int)request->height());
     QImage image(size, QImage::Format_RGB32);
     XpsPage *pageToRender = m_xpsFile->page(request->page()->number());
-    pageToRender->renderToImage(&image);
+    Okular::PartialPixmapUpdater updater(this, request);
+    if (!pageToRender->renderToImage(&image, [request] { return request->shouldAbortRender(); }, [&updater](const QImage &page) { updater.update(page); })) {
+        return QImage();
+    }
     return image;
 }
 
@@ -20,6 +20,8 @@
 
 #include <kzip.h>
 
+#include <functional>
+
 typedef enum { abtCommand, abtNumber, abtComma, abtEOF } AbbPathTokenType;
 
 class AbbPathToken
@@ -109,8 +111,10 @@ public:
     XpsPage &operator=(const XpsPage &) = delete;
 
     QSizeF size() const;
-    bool renderToImage(QImage *p);
-    bool renderToPainter(QPainter *painter);
+    // rendering stops, returning false, as soon as @p shouldAbort returns true;
+    // @p partialUpdate gets the page drawn so far every now and then
+    bool renderToImage(QImage *p, const std::function<bool()> &shouldAbort = {}, const std::function<void(const QImage &)> &partialUpdate = {});
+    bool renderToPainter(QPainter *painter, const std::function<bool()> &shouldAbort = {});
     Okular::TextPage *textPage();
 
     QImage loadImageFromFile(const QString &filename);
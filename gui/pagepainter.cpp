@@ -8,6 +8,7 @@
 
 // qt / kde includes
 #include <QApplication>
+#include <QCache>
 #include <QDebug>
 #include <QIcon>
 #include <QPainter>
@@ -37,6 +38,59 @@ Q_GLOBAL_STATIC_WITH_ARGS(QPixmap, busyPixmap, (QIcon::fromTheme(QLatin1String("
 
 #define TEXTANNOTATION_ICONSIZE 24
 
+// The buffered annotations of a whole page at a scale, composited over the page by paintCroppedPageOnPainter()
+struct AnnotationOverlay {
+    quint64 annotationsRevision;
+    QImage multiplied; // the highlights, to multiply with the page; null if there are none
+    QImage drawn; // the other annotations, to draw over the page; null if there are none
+};
+
+// a page is painted at several sizes at once, e.g. in the main view and as a thumbnail
+struct AnnotationOverlayKey {
+    const Okular::Page *page;
+    QSize dScaledSize;
+    double dpr;
+    double pageScale;
+
+    bool operator==(const AnnotationOverlayKey &other) const = default;
+};
+
+static size_t qHash(const AnnotationOverlayKey &key, size_t seed = 0)
+{
+    return qHashMulti(seed, key.page, key.dScaledSize.width(), key.dScaledSize.height(), key.dpr, key.pageScale);
+}
+
+// the overlays of the pages painted last, in bytes
+static const qsizetype annotationOverlayCacheSize = 64 * 1024 * 1024;
+typedef QCache<AnnotationOverlayKey, AnnotationOverlay> AnnotationOverlayCache;
+Q_GLOBAL_STATIC_WITH_ARGS(AnnotationOverlayCache, annotationOverlays, (annotationOverlayCacheSize))
+
+// the stamps painted last, scaled to their size on screen, in bytes
+static const qsizetype stampCacheSize = 16 * 1024 * 1024;
+typedef QCache<QString, QPixmap> StampCache;
+Q_GLOBAL_STATIC_WITH_ARGS(StampCache, stampPixmaps, (stampCacheSize))
+
+/**
+ * Whether @p ann is drawn on the back buffer rather than with a painter.
+ */
+static bool isBufferedAnnotation(const Okular::Annotation *ann)
+{
+    const Okular::Annotation::SubType type = ann->subType();
+    return type == Okular::Annotation::ALine || type == Okular::Annotation::AHighlight || type == Okular::Annotation::AInk /*|| (type == Annotation::AGeom && ann->style().opacity() < 0.99)*/;
+}
+
+/**
+ * Whether the buffered annotation @p ann is multiplied with the page rather than drawn over it.
+ */
+static bool isMultipliedAnnotation(const Okular::Annotation *ann)
+{
+    if (ann->subType() != Okular::Annotation::AHighlight) {
+        return false;
+    }
+    const Okular::HighlightAnnotation::HighlightType type = static_cast<const Okular::HighlightAnnotation *>(ann)->highlightType();
+    return type == Okular::HighlightAnnotation::Highlight || type == Okular::HighlightAnnotation::Squiggly;
+}
+
 inline QPen buildPen(const Okular::Annotation *ann, double width, const QColor &color)
 {
     QColor c = color;
@@ -45,6 +99,23 @@ inline QPen buildPen(const Okular::Annotation *ann, double width, const QColor &
     return p;
 }
 
+/**
+ * Draws the @p dSource part of @p pixmap, as if it was scaled to @p dScaledWidth x @p dScaledHeight, on @p target.
+ * Only the pixels needed are scaled, so zooming into a page costs as much as the visible area.
+ */
+static void drawScaledPixmap(QPainter *painter, const QRectF &target, const QPixmap &pixmap, const QRect dSource, int dScaledWidth, int dScaledHeight)
+{
+    if (pixmap.width() == dScaledWidth && pixmap.height() == dScaledHeight) {
+        painter->drawPixmap(target, pixmap, dSource);
+        return;
+    }
+
+    const double xScale = pixmap.width() / (double)dScaledWidth;
+    const double yScale = pixmap.height() / (double)dScaledHeight;
+    const QRectF source(dSource.x() * xScale, dSource.y() * yScale, dSource.width() * xScale, dSource.height() * yScale);
+    painter->drawPixmap(target, pixmap, source);
+}
+
 void PagePainter::paintPageOnPainter(QPainter *destPainter, const Okular::Page *page, Okular::DocumentObserver *observer, int flags, int scaledWidth, int scaledHeight, const QRect limits)
 {
     paintCroppedPageOnPainter(destPainter, page, observer, flags, scaledWidth, scaledHeight, limits, Okular::NormalizedRect(0, 0, 1, 1), nullptr);
@@ -199,8 +270,7 @@ void PagePainter::paintCroppedPageOnPainter(QPainter *destPainter,
                     }
                 }
                 if (intersects) {
-                    const Okular::Annotation::SubType type = ann->subType();
-                    if (type == Okular::Annotation::ALine || type == Okular::Annotation::AHighlight || type == Okular::Annotation::AInk /*|| (type == Annotation::AGeom && ann->style().opacity() < 0.99)*/) {
+                    if (isBufferedAnnotation(ann)) {
                         bufferedAnnotations.append(ann);
                     } else {
                         unbufferedAnnotations.append(ann);
@@ -244,7 +314,7 @@ void PagePainter::paintCroppedPageOnPainter(QPainter *destPainter,
                 }
             }
         } else {
-            destPainter->drawPixmap(limits, pixmap.scaled(dScaledWidth, dScaledHeight), dLimitsInPixmap);
+            drawScaledPixmap(destPainter, limits, pixmap, dLimitsInPixmap, dScaledWidth, dScaledHeight);
         }
 
         // 4A.2. active painter is the one passed to this method
@@ -283,7 +353,7 @@ void PagePainter::paintCroppedPageOnPainter(QPainter *destPainter,
         } else {
             // 4B.1. draw the page pixmap: normal or scaled
 
-            p.drawPixmap(QRectF(0, 0, limits.width(), limits.height()), pixmap.scaled(dScaledWidth, dScaledHeight), dLimitsInPixmap);
+            drawScaledPixmap(&p, QRectF(0, 0, limits.width(), limits.height()), pixmap, dLimitsInPixmap, dScaledWidth, dScaledHeight);
         }
 
         p.end();
@@ -370,99 +440,22 @@ void PagePainter::paintCroppedPageOnPainter(QPainter *destPainter,
         const double yOffset = (double)limits.top() / (double)scaledHeight + crop.top;
         const double yScale = (double)scaledHeight / (double)limits.height();
 
-        // paint all buffered annotations in the page
-        for (Okular::Annotation *a : std::as_const(bufferedAnnotations)) {
-            const Okular::Annotation::SubType type = a->subType();
-            QColor acolor = a->style().color();
-            if (!acolor.isValid()) {
-                acolor = Qt::yellow;
-            }
-            acolor.setAlphaF(a->style().opacity());
-
-            // draw LineAnnotation MISSING: caption, dash pattern, endings for multipoint lines
-            if (type == Okular::Annotation::ALine) {
-                const LineAnnotPainter linepainter {static_cast<Okular::LineAnnotation *>(a), {page->width(), page->height()}, pageScale, {xScale, 0., 0., yScale, -xOffset * xScale, -yOffset * yScale}};
-                linepainter.draw(backImage);
-            }
-            // draw HighlightAnnotation MISSING: under/strike width, feather, capping
-            else if (type == Okular::Annotation::AHighlight) {
-                // get the annotation
-                const Okular::HighlightAnnotation *ha = static_cast<Okular::HighlightAnnotation *>(a);
-                const Okular::HighlightAnnotation::HighlightType hlType = ha->highlightType();
-
-                // draw each quad of the annotation
-                const int quads = ha->highlightQuads().size();
-                for (int q = 0; q < quads; q++) {
-                    NormalizedPath path;
-                    const Okular::HighlightAnnotation::Quad &quad = ha->highlightQuads()[q];
-                    // normalize page point to image
-                    for (int i = 0; i < 4; i++) {
-                        const Okular::NormalizedPoint point( //
-                            (quad.transformedPoint(i).x - xOffset) * xScale,
-                            (quad.transformedPoint(i).y - yOffset) * yScale);
-                        path.append(point);
-                    }
-                    // draw the normalized path into image
-                    switch (hlType) {
-                    // highlight the whole rect
-                    case Okular::HighlightAnnotation::Highlight:
-                        drawShapeOnImage(backImage, path, true, Qt::NoPen, acolor, pageScale, Multiply);
-                        break;
-                    // highlight the bottom part of the rect
-                    case Okular::HighlightAnnotation::Squiggly:
-                        path[3].x = (path[0].x + path[3].x) / 2.0;
-                        path[3].y = (path[0].y + path[3].y) / 2.0;
-                        path[2].x = (path[1].x + path[2].x) / 2.0;
-                        path[2].y = (path[1].y + path[2].y) / 2.0;
-                        drawShapeOnImage(backImage, path, true, Qt::NoPen, acolor, pageScale, Multiply);
-                        break;
-                    // make a line at 3/4 of the height
-                    case Okular::HighlightAnnotation::Underline:
-                        path[0].x = (3 * path[0].x + path[3].x) / 4.0;
-                        path[0].y = (3 * path[0].y + path[3].y) / 4.0;
-                        path[1].x = (3 * path[1].x + path[2].x) / 4.0;
-                        path[1].y = (3 * path[1].y + path[2].y) / 4.0;
-                        path.pop_back();
-                        path.pop_back();
-                        drawShapeOnImage(backImage, path, false, QPen(acolor, 2), QBrush(), pageScale);
-                        break;
-                    // make a line at 1/2 of the height
-                    case Okular::HighlightAnnotation::StrikeOut:
-                        path[0].x = (path[0].x + path[3].x) / 2.0;
-                        path[0].y = (path[0].y + path[3].y) / 2.0;
-                        path[1].x = (path[1].x + path[2].x) / 2.0;
-                        path[1].y = (path[1].y + path[2].y) / 2.0;
-                        path.pop_back();
-                        path.pop_back();
-                        drawShapeOnImage(backImage, path, false, QPen(acolor, 2), QBrush(), pageScale);
-                        break;
-                    }
-                }
+        // paint all buffered annotations in the page, from the overlay of the page at this scale when there is one
+        const AnnotationOverlay *overlay = bufferedAnnotations.isEmpty() ? nullptr : annotationOverlay(page, dScaledWidth, dScaledHeight, dpr, pageScale);
+        if (overlay) {
+            const QRectF target(0, 0, limits.width(), limits.height());
+            QPainter painter(&backImage);
+            if (!overlay->multiplied.isNull()) {
+                painter.setCompositionMode(QPainter::CompositionMode_Multiply);
+                painter.drawImage(target, overlay->multiplied, dLimitsInPixmap);
             }
-            // draw InkAnnotation MISSING:invar width, PENTRACER
-            else if (type == Okular::Annotation::AInk) {
-                // get the annotation
-                Okular::InkAnnotation *ia = static_cast<Okular::InkAnnotation *>(a);
-
-                // draw each ink path
-                const QList<QList<Okular::NormalizedPoint>> transformedInkPaths = ia->transformedInkPaths();
-
-                const QPen inkPen = buildPen(a, a->style().width(), acolor);
-
-                for (const QList<Okular::NormalizedPoint> &inkPath : transformedInkPaths) {
-                    // normalize page point to image
-                    NormalizedPath path;
-                    for (const Okular::NormalizedPoint &inkPoint : inkPath) {
-                        const Okular::NormalizedPoint point( //
-                            (inkPoint.x - xOffset) * xScale,
-                            (inkPoint.y - yOffset) * yScale);
-                        path.append(point);
-                    }
-                    // draw the normalized path into image
-                    drawShapeOnImage(backImage, path, false, inkPen, QBrush(), pageScale);
-                }
+            if (!overlay->drawn.isNull()) {
+                painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+                painter.drawImage(target, overlay->drawn, dLimitsInPixmap);
             }
-        } // end current annotation drawing
+        } else {
+            drawBufferedAnnotations(backImage, backImage, bufferedAnnotations, page, pageScale, xOffset, xScale, yOffset, yScale);
+        }
         if (viewPortPoint) {
             QPainter painter(&backImage);
             painter.translate(-limits.left(), -limits.top());
@@ -577,14 +570,14 @@ void PagePainter::paintCroppedPageOnPainter(QPainter *destPainter,
             Okular::StampAnnotation *stamp = static_cast<Okular::StampAnnotation *>(a);
 
             // get pixmap and alpha blend it if needed
-            const QPixmap stampPixmap = Okular::AnnotationUtils::loadStamp(stamp->stampIconName(), annotBoundary.size() * dpr);
-            if (!stampPixmap.isNull()) // should never happen but can happen on huge sizes
+            const QPixmap pixmap = stampPixmap(stamp->stampIconName(), QSize(annotBoundary.width() * dpr, annotBoundary.height() * dpr));
+            if (!pixmap.isNull()) // should never happen but can happen on huge sizes
             {
                 // Draw pixmap with opacity:
                 mixedPainter->save();
                 mixedPainter->setOpacity(mixedPainter->opacity() * opacity / 255.0);
 
-                mixedPainter->drawPixmap(annotRect.topLeft(), stampPixmap.scaled(annotBoundary.width() * dpr, annotBoundary.height() * dpr), dInnerRect.toAlignedRect());
+                mixedPainter->drawPixmap(annotRect.topLeft(), pixmap, dInnerRect.toAlignedRect());
 
                 mixedPainter->restore();
             }
@@ -921,6 +914,175 @@ void PagePainter::hueShiftNegative(QImage *image)
     }
 }
 
+void PagePainter::drawBufferedAnnotations(QImage &multiplyImage,
+                                          QImage &image,
+                                          const QList<Okular::Annotation *> &annotations,
+                                          const Okular::Page *page,
+                                          double pageScale,
+                                          double xOffset,
+                                          double xScale,
+                                          double yOffset,
+                                          double yScale)
+{
+    for (const Okular::Annotation *a : annotations) {
+        const Okular::Annotation::SubType type = a->subType();
+        QColor acolor = a->style().color();
+        if (!acolor.isValid()) {
+            acolor = Qt::yellow;
+        }
+        acolor.setAlphaF(a->style().opacity());
+
+        // draw LineAnnotation MISSING: caption, dash pattern, endings for multipoint lines
+        if (type == Okular::Annotation::ALine) {
+            const LineAnnotPainter linepainter {static_cast<const Okular::LineAnnotation *>(a), {page->width(), page->height()}, pageScale, {xScale, 0., 0., yScale, -xOffset * xScale, -yOffset * yScale}};
+            linepainter.draw(image);
+        }
+        // draw HighlightAnnotation MISSING: under/strike width, feather, capping
+        else if (type == Okular::Annotation::AHighlight) {
+            // get the annotation
+            const Okular::HighlightAnnotation *ha = static_cast<const Okular::HighlightAnnotation *>(a);
+            const Okular::HighlightAnnotation::HighlightType hlType = ha->highlightType();
+
+            // draw each quad of the annotation
+            const int quads = ha->highlightQuads().size();
+            for (int q = 0; q < quads; q++) {
+                NormalizedPath path;
+                const Okular::HighlightAnnotation::Quad &quad = ha->highlightQuads()[q];
+                // normalize page point to image
+                for (int i = 0; i < 4; i++) {
+                    const Okular::NormalizedPoint point( //
+                        (quad.transformedPoint(i).x - xOffset) * xScale,
+                        (quad.transformedPoint(i).y - yOffset) * yScale);
+                    path.append(point);
+                }
+                // draw the normalized path into image
+                switch (hlType) {
+                // highlight the whole rect
+                case Okular::HighlightAnnotation::Highlight:
+                    drawShapeOnImage(multiplyImage, path, true, Qt::NoPen, acolor, pageScale, Multiply);
+                    break;
+                // highlight the bottom part of the rect
+                case Okular::HighlightAnnotation::Squiggly:
+                    path[3].x = (path[0].x + path[3].x) / 2.0;
+                    path[3].y = (path[0].y + path[3].y) / 2.0;
+                    path[2].x = (path[1].x + path[2].x) / 2.0;
+                    path[2].y = (path[1].y + path[2].y) / 2.0;
+                    drawShapeOnImage(multiplyImage, path, true, Qt::NoPen, acolor, pageScale, Multiply);
+                    break;
+                // make a line at 3/4 of the height
+                case Okular::HighlightAnnotation::Underline:
+                    path[0].x = (3 * path[0].x + path[3].x) / 4.0;
+                    path[0].y = (3 * path[0].y + path[3].y) / 4.0;
+                    path[1].x = (3 * path[1].x + path[2].x) / 4.0;
+                    path[1].y = (3 * path[1].y + path[2].y) / 4.0;
+                    path.pop_back();
+                    path.pop_back();
+                    drawShapeOnImage(image, path, false, QPen(acolor, 2), QBrush(), pageScale);
+                    break;
+                // make a line at 1/2 of the height
+                case Okular::HighlightAnnotation::StrikeOut:
+                    path[0].x = (path[0].x + path[3].x) / 2.0;
+                    path[0].y = (path[0].y + path[3].y) / 2.0;
+                    path[1].x = (path[1].x + path[2].x) / 2.0;
+                    path[1].y = (path[1].y + path[2].y) / 2.0;
+                    path.pop_back();
+                    path.pop_back();
+                    drawShapeOnImage(image, path, false, QPen(acolor, 2), QBrush(), pageScale);
+                    break;
+                }
+            }
+        }
+        // draw InkAnnotation MISSING:invar width, PENTRACER
+        else if (type == Okular::Annotation::AInk) {
+            // get the annotation
+            const Okular::InkAnnotation *ia = static_cast<const Okular::InkAnnotation *>(a);
+
+            // draw each ink path
+            const QList<QList<Okular::NormalizedPoint>> transformedInkPaths = ia->transformedInkPaths();
+
+            const QPen inkPen = buildPen(a, a->style().width(), acolor);
+
+            for (const QList<Okular::NormalizedPoint> &inkPath : transformedInkPaths) {
+                // normalize page point to image
+                NormalizedPath path;
+                for (const Okular::NormalizedPoint &inkPoint : inkPath) {
+                    const Okular::NormalizedPoint point( //
+                        (inkPoint.x - xOffset) * xScale,
+                        (inkPoint.y - yOffset) * yScale);
+                    path.append(point);
+                }
+                // draw the normalized path into image
+                drawShapeOnImage(image, path, false, inkPen, QBrush(), pageScale);
+            }
+        }
+    }
+}
+
+const AnnotationOverlay *PagePainter::annotationOverlay(const Okular::Page *page, int dScaledWidth, int dScaledHeight, double dpr, double pageScale)
+{
+    const quint64 revision = page->d->m_annotationsRevision;
+    const AnnotationOverlayKey key {page, QSize(dScaledWidth, dScaledHeight), dpr, pageScale};
+    if (const AnnotationOverlay *overlay = annotationOverlays->object(key)) {
+        if (overlay->annotationsRevision == revision) {
+            return overlay;
+        }
+    }
+
+    // a page zoomed in that much is painted in tiles, drawing the visible annotations only is cheaper
+    const qsizetype layerCost = qsizetype(dScaledWidth) * dScaledHeight * 4;
+    if (layerCost * 4 > annotationOverlayCacheSize) {
+        return nullptr;
+    }
+
+    QList<Okular::Annotation *> annotations;
+    bool anyMultiplied = false;
+    bool anyDrawn = false;
+    for (Okular::Annotation *ann : std::as_const(page->m_annotations)) {
+        if ((ann->flags() & (Okular::Annotation::Hidden | Okular::Annotation::ExternallyDrawn)) || !isBufferedAnnotation(ann)) {
+            continue;
+        }
+        annotations.append(ann);
+        if (isMultipliedAnnotation(ann)) {
+            anyMultiplied = true;
+        } else {
+            anyDrawn = true;
+        }
+    }
+
+    // Multiplying with white is a no-op, so multiplying the page with a white layer where the
+    // highlights are multiplied gives the same result as multiplying them with the page directly
+    AnnotationOverlay *overlay = new AnnotationOverlay {revision, QImage(), QImage()};
+    if (anyMultiplied) {
+        overlay->multiplied = QImage(dScaledWidth, dScaledHeight, QImage::Format_ARGB32_Premultiplied);
+        overlay->multiplied.setDevicePixelRatio(dpr);
+        overlay->multiplied.fill(Qt::white);
+    }
+    if (anyDrawn) {
+        overlay->drawn = QImage(dScaledWidth, dScaledHeight, QImage::Format_ARGB32_Premultiplied);
+        overlay->drawn.setDevicePixelRatio(dpr);
+        overlay->drawn.fill(Qt::transparent);
+    }
+    drawBufferedAnnotations(overlay->multiplied, overlay->drawn, annotations, page, pageScale, 0, 1, 0, 1);
+
+    annotationOverlays->insert(key, overlay, (anyMultiplied + anyDrawn) * layerCost);
+    return overlay;
+}
+
+QPixmap PagePainter::stampPixmap(const QString &name, const QSize &size)
+{
+    const QString key = name + QLatin1Char('@') + QString::number(size.width()) + QLatin1Char('x') + QString::number(size.height());
+    if (const QPixmap *pixmap = stampPixmaps->object(key)) {
+        return *pixmap;
+    }
+
+    QPixmap pixmap = Okular::AnnotationUtils::loadStamp(name, size);
+    if (!pixmap.isNull()) {
+        pixmap = pixmap.scaled(size);
+        stampPixmaps->insert(key, new QPixmap(pixmap), qsizetype(pixmap.width()) * pixmap.height() * pixmap.depth() / 8);
+    }
+    return pixmap;
+}
+
 void PagePainter::drawShapeOnImage(QImage &image, const NormalizedPath &normPath, bool closeShape, const QPen &pen, const QBrush &brush, double penWidthMultiplier, RasterOperation op
                                    // float antiAliasRadius
 )
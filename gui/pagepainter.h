@@ -16,6 +16,7 @@
 
 class QPainter;
 class QRect;
+struct AnnotationOverlay;
 namespace Okular
 {
 class DocumentObserver;
@@ -122,6 +123,31 @@ private:
      */
     static void drawEllipseOnImage(QImage &image, const NormalizedPath &rect, const QPen &pen, const QBrush &brush, double penWidthMultiplier, RasterOperation op = Normal);
 
+    /**
+     * Draw the buffered @p annotations of @p page: the highlights multiplied with @p multiplyImage, the others on @p image.
+     * The coordinates of the page are normalized to the images as x' = (x - @p xOffset) * @p xScale, y' = (y - @p yOffset) * @p yScale.
+     */
+    static void drawBufferedAnnotations(QImage &multiplyImage,
+                                        QImage &image,
+                                        const QList<Okular::Annotation *> &annotations,
+                                        const Okular::Page *page,
+                                        double pageScale,
+                                        double xOffset,
+                                        double xScale,
+                                        double yOffset,
+                                        double yScale);
+
+    /**
+     * The buffered annotations of the whole @p page drawn at @p dScaledWidth x @p dScaledHeight device pixels,
+     * cached until the annotations of the page change. @c nullptr if the page is too big to cache it.
+     */
+    static const AnnotationOverlay *annotationOverlay(const Okular::Page *page, int dScaledWidth, int dScaledHeight, double dpr, double pageScale);
+
+    /**
+     * The stamp @p name scaled to @p size, cached as long as it is painted often enough.
+     */
+    static QPixmap stampPixmap(const QString &name, const QSize &size);
+
     friend class LineAnnotPainter;
 };
 
@@ -7,7 +7,9 @@
 #include "tocmodel.h"
 
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QList>
+#include <QTimer>
 #include <QTreeView>
 #include <qdom.h>
 
@@ -26,13 +28,18 @@ struct TOCItem {
     TOCItem(const TOCItem &) = delete;
     TOCItem &operator=(const TOCItem &) = delete;
 
+    const Okular::DocumentViewport &resolvedViewport();
+    bool hasPendingChildren() const;
+
     QString text;
     Okular::DocumentViewport viewport;
+    QString viewportName; // resolved into viewport on first use
     QString extFileName;
     QString url;
     bool highlight : 1;
     TOCItem *parent;
     QList<TOCItem *> children;
+    QDomNode nextChild; // first synopsis child without an item yet
     TOCModelPrivate *model;
 };
 
@@ -42,21 +49,33 @@ public:
     explicit TOCModelPrivate(TOCModel *qq);
     ~TOCModelPrivate();
 
-    void addChildren(const QDomNode &parentNode, TOCItem *parentItem);
+    void addChildren(TOCItem *parentItem, int maxCount);
+    void addAllChildren(TOCItem *parentItem);
+    void populateSlice();
     QModelIndex indexForItem(TOCItem *item) const;
-    void findViewport(const Okular::DocumentViewport &viewport, TOCItem *item, QList<TOCItem *> &list) const;
+    void findViewport(const Okular::DocumentViewport &viewport, TOCItem *item, QList<TOCItem *> &list);
 
     TOCModel *q;
     TOCItem *root;
     bool dirty : 1;
+    bool expandOpenItems : 1;
     Okular::Document *document;
-    QList<TOCItem *> itemsToOpen;
+    // keeps the nodes of the items still to be created alive
+    QDomDocument synopsis;
+    // items whose children are still to be created in the background
+    QList<TOCItem *> pendingItems;
+    QTimer *populateTimer;
     QList<TOCItem *> currentPage;
     TOCModel *m_oldModel;
     QList<QModelIndex> m_oldTocExpandedIndexes;
     Q_DISABLE_COPY(TOCModelPrivate)
 };
 
+// how long a single background population step may block the event loop
+static const int populateSliceMsecs = 10;
+// how many items are created at most when the view asks for the children of an item
+static const int fetchChunkSize = 500;
+
 TOCItem::TOCItem()
     : highlight(false)
     , parent(nullptr)
@@ -67,6 +86,7 @@ TOCItem::TOCItem()
 TOCItem::TOCItem(TOCItem *_parent, const QDomElement &e)
     : highlight(false)
     , parent(_parent)
+    , nextChild(e.firstChild())
 {
     parent->children.append(this);
     model = parent->model;
@@ -77,12 +97,9 @@ TOCItem::TOCItem(TOCItem *_parent, const QDomElement &e)
         // if the node has a viewport, set it
         viewport = Okular::DocumentViewport(e.attribute(QStringLiteral("Viewport")));
     } else if (e.hasAttribute(QStringLiteral("ViewportName"))) {
-        // if the node references a viewport, get the reference and set it
-        const QString &page = e.attribute(QStringLiteral("ViewportName"));
-        QString viewport_string = model->document->metaData(QStringLiteral("NamedViewport"), page).toString();
-        if (!viewport_string.isEmpty()) {
-            viewport = Okular::DocumentViewport(viewport_string);
-        }
+        // if the node references a viewport, remember the reference, resolving
+        // it asks the generator and that is too slow to do for every entry upfront
+        viewportName = e.attribute(QStringLiteral("ViewportName"));
     }
 
     extFileName = e.attribute(QStringLiteral("ExternalFileName"));
@@ -94,14 +111,37 @@ TOCItem::~TOCItem()
     qDeleteAll(children);
 }
 
+const Okular::DocumentViewport &TOCItem::resolvedViewport()
+{
+    if (!viewportName.isEmpty()) {
+        const QString viewport_string = model->document->metaData(QStringLiteral("NamedViewport"), viewportName).toString();
+        if (!viewport_string.isEmpty()) {
+            viewport = Okular::DocumentViewport(viewport_string);
+        }
+        viewportName.clear();
+    }
+    return viewport;
+}
+
+bool TOCItem::hasPendingChildren() const
+{
+    return !nextChild.isNull();
+}
+
 TOCModelPrivate::TOCModelPrivate(TOCModel *qq)
     : q(qq)
     , root(new TOCItem)
     , dirty(false)
+    , expandOpenItems(false)
     , document(nullptr)
+    , populateTimer(new QTimer(qq))
     , m_oldModel(nullptr)
 {
     root->model = this;
+
+    populateTimer->setSingleShot(true);
+    populateTimer->setInterval(0);
+    QObject::connect(populateTimer, &QTimer::timeout, q, [this] { populateSlice(); });
 }
 
 TOCModelPrivate::~TOCModelPrivate()
@@ -110,20 +150,31 @@ TOCModelPrivate::~TOCModelPrivate()
     delete m_oldModel;
 }
 
-void TOCModelPrivate::addChildren(const QDomNode &parentNode, TOCItem *parentItem)
+void TOCModelPrivate::addChildren(TOCItem *parentItem, int maxCount)
 {
-    TOCItem *currentItem = nullptr;
-    QDomNode n = parentNode.firstChild();
-    while (!n.isNull()) {
-        // convert the node to an element (sure it is)
-        QDomElement e = n.toElement();
+    if (!parentItem->hasPendingChildren()) {
+        return;
+    }
 
-        // insert the entry as top level (listview parented) or 2nd+ level
-        currentItem = new TOCItem(parentItem, e);
+    // count the entries first, they are inserted with a single notification
+    int count = 0;
+    for (QDomNode n = parentItem->nextChild; !n.isNull() && count < maxCount; n = n.nextSibling()) {
+        ++count;
+    }
 
-        // descend recursively and advance to the next node
-        if (e.hasChildNodes()) {
-            addChildren(n, currentItem);
+    const int first = parentItem->children.count();
+    QList<TOCItem *> opened;
+    q->beginInsertRows(indexForItem(parentItem), first, first + count - 1);
+    for (int i = 0; i < count; ++i) {
+        // convert the node to an element (sure it is)
+        const QDomElement e = parentItem->nextChild.toElement();
+        parentItem->nextChild = parentItem->nextChild.nextSibling();
+
+        // insert the entry as top level (listview parented) or 2nd+ level,
+        // its own children are created when needed
+        TOCItem *currentItem = new TOCItem(parentItem, e);
+        if (currentItem->hasPendingChildren()) {
+            pendingItems.append(currentItem);
         }
 
         // open/keep close the item
@@ -132,12 +183,53 @@ void TOCModelPrivate::addChildren(const QDomNode &parentNode, TOCItem *parentIte
             isOpen = QVariant(e.attribute(QStringLiteral("Open"))).toBool();
         }
         if (isOpen) {
-            itemsToOpen.append(currentItem);
+            opened.append(currentItem);
         }
+    }
+    q->endInsertRows();
 
-        n = n.nextSibling();
+    if (parentItem == root) {
         Q_EMIT q->countChanged();
     }
+
+    if (expandOpenItems) {
+        for (TOCItem *item : std::as_const(opened)) {
+            // TODO misusing parent() here, fix
+            QMetaObject::invokeMethod(q->QObject::parent(), "expand", Qt::QueuedConnection, Q_ARG(QModelIndex, indexForItem(item)));
+        }
+    }
+
+    if (!pendingItems.isEmpty() && !populateTimer->isActive()) {
+        populateTimer->start();
+    }
+}
+
+void TOCModelPrivate::addAllChildren(TOCItem *parentItem)
+{
+    while (parentItem->hasPendingChildren()) {
+        addChildren(parentItem, fetchChunkSize);
+    }
+}
+
+void TOCModelPrivate::populateSlice()
+{
+    // Create the rest of the tree in the background, so searching and
+    // expanding everything eventually see all of it
+    QElapsedTimer timer;
+    timer.start();
+    while (!pendingItems.isEmpty() && !timer.hasExpired(populateSliceMsecs)) {
+        TOCItem *item = pendingItems.first();
+        if (item->hasPendingChildren()) {
+            addChildren(item, fetchChunkSize);
+        }
+        if (!item->hasPendingChildren()) {
+            pendingItems.removeFirst();
+        }
+    }
+
+    if (!pendingItems.isEmpty()) {
+        populateTimer->start();
+    }
 }
 
 QModelIndex TOCModelPrivate::indexForItem(TOCItem *item) const
@@ -151,20 +243,22 @@ QModelIndex TOCModelPrivate::indexForItem(TOCItem *item) const
     return QModelIndex();
 }
 
-void TOCModelPrivate::findViewport(const Okular::DocumentViewport &viewport, TOCItem *item, QList<TOCItem *> &list) const
+void TOCModelPrivate::findViewport(const Okular::DocumentViewport &viewport, TOCItem *item, QList<TOCItem *> &list)
 {
     TOCItem *todo = item;
 
     while (todo) {
-        const TOCItem *current = todo;
+        TOCItem *current = todo;
         todo = nullptr;
         TOCItem *pos = nullptr;
 
-        for (TOCItem *child : current->children) {
-            if (child->viewport.isValid()) {
-                if (child->viewport.pageNumber <= viewport.pageNumber) {
+        addAllChildren(current);
+        for (TOCItem *child : std::as_const(current->children)) {
+            const Okular::DocumentViewport &childViewport = child->resolvedViewport();
+            if (childViewport.isValid()) {
+                if (childViewport.pageNumber <= viewport.pageNumber) {
                     pos = child;
-                    if (child->viewport.pageNumber == viewport.pageNumber) {
+                    if (childViewport.pageNumber == viewport.pageNumber) {
                         break;
                     }
                 } else {
@@ -251,12 +345,12 @@ QVariant TOCModel::data(const QModelIndex &index, int role) const
     case HighlightRole:
         return item->highlight;
     case PageRole:
-        if (item->viewport.isValid()) {
+        if (item->resolvedViewport().isValid()) {
             return item->viewport.pageNumber + 1;
         }
         break;
     case PageLabelRole:
-        if (item->viewport.isValid() && item->viewport.pageNumber < int(d->document->pages())) {
+        if (item->resolvedViewport().isValid() && item->viewport.pageNumber < int(d->document->pages())) {
             return d->document->page(item->viewport.pageNumber)->label();
         }
         break;
@@ -271,7 +365,19 @@ bool TOCModel::hasChildren(const QModelIndex &parent) const
     }
 
     TOCItem *item = static_cast<TOCItem *>(parent.internalPointer());
-    return !item->children.isEmpty();
+    return !item->children.isEmpty() || item->hasPendingChildren();
+}
+
+bool TOCModel::canFetchMore(const QModelIndex &parent) const
+{
+    const TOCItem *item = parent.isValid() ? static_cast<TOCItem *>(parent.internalPointer()) : d->root;
+    return item->hasPendingChildren();
+}
+
+void TOCModel::fetchMore(const QModelIndex &parent)
+{
+    TOCItem *item = parent.isValid() ? static_cast<TOCItem *>(parent.internalPointer()) : d->root;
+    d->addChildren(item, fetchChunkSize);
 }
 
 QVariant TOCModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -319,13 +425,17 @@ int TOCModel::rowCount(const QModelIndex &parent) const
 
 static QModelIndex indexForIndex(const QModelIndex &oldModelIndex, QAbstractItemModel *newModel)
 {
-    QModelIndex newModelIndex;
+    QModelIndex newParentIndex;
     if (oldModelIndex.parent().isValid()) {
-        newModelIndex = newModel->index(oldModelIndex.row(), oldModelIndex.column(), indexForIndex(oldModelIndex.parent(), newModel));
-    } else {
-        newModelIndex = newModel->index(oldModelIndex.row(), oldModelIndex.column());
+        newParentIndex = indexForIndex(oldModelIndex.parent(), newModel);
+        if (!newParentIndex.isValid()) {
+            return QModelIndex();
+        }
     }
-    return newModelIndex;
+    while (oldModelIndex.row() >= newModel->rowCount(newParentIndex) && newModel->canFetchMore(newParentIndex)) {
+        newModel->fetchMore(newParentIndex);
+    }
+    return newModel->index(oldModelIndex.row(), oldModelIndex.column(), newParentIndex);
 }
 
 void TOCModel::fill(const Okular::DocumentSynopsis *toc)
@@ -335,32 +445,25 @@ void TOCModel::fill(const Okular::DocumentSynopsis *toc)
     }
 
     clear();
-    Q_EMIT layoutAboutToBeChanged();
-    d->addChildren(*toc, d->root);
+    d->synopsis = *toc;
+    d->root->nextChild = d->synopsis.firstChild();
     d->dirty = true;
-    Q_EMIT layoutChanged();
-    if (equals(d->m_oldModel)) {
+    // only the first level is created now, the rest when the view asks for it
+    // or in the background
+    const bool restoreOldState = equals(d->m_oldModel);
+    d->expandOpenItems = !restoreOldState;
+    d->addChildren(d->root, fetchChunkSize);
+    if (restoreOldState) {
         for (const QModelIndex &oldIndex : std::as_const(d->m_oldTocExpandedIndexes)) {
             const QModelIndex idx = indexForIndex(oldIndex, this);
             if (!idx.isValid()) {
                 continue;
             }
 
-            // TODO misusing parent() here, fix
-            QMetaObject::invokeMethod(QObject::parent(), "expand", Qt::QueuedConnection, Q_ARG(QModelIndex, idx));
-        }
-    } else {
-        for (TOCItem *item : std::as_const(d->itemsToOpen)) {
-            const QModelIndex idx = d->indexForItem(item);
-            if (!idx.isValid()) {
-                continue;
-            }
-
             // TODO misusing parent() here, fix
             QMetaObject::invokeMethod(QObject::parent(), "expand", Qt::QueuedConnection, Q_ARG(QModelIndex, idx));
         }
     }
-    d->itemsToOpen.clear();
     delete d->m_oldModel;
     d->m_oldModel = nullptr;
     d->m_oldTocExpandedIndexes.clear();
@@ -373,8 +476,12 @@ void TOCModel::clear()
     }
 
     beginResetModel();
+    d->populateTimer->stop();
+    d->pendingItems.clear();
     qDeleteAll(d->root->children);
     d->root->children.clear();
+    d->root->nextChild.clear();
+    d->synopsis.clear();
     d->currentPage.clear();
     endResetModel();
     d->dirty = false;
@@ -414,6 +521,21 @@ bool TOCModel::isEmpty() const
     return d->root->children.isEmpty();
 }
 
+static bool sameOutline(const QDomNode &parentA, const QDomNode &parentB)
+{
+    QDomNode a = parentA.firstChild();
+    QDomNode b = parentB.firstChild();
+    for (; !a.isNull() && !b.isNull(); a = a.nextSibling(), b = b.nextSibling()) {
+        if (a.nodeName() != b.nodeName() || a.hasChildNodes() != b.hasChildNodes()) {
+            return false;
+        }
+        if (!sameOutline(a, b)) {
+            return false;
+        }
+    }
+    return a.isNull() && b.isNull();
+}
+
 bool TOCModel::equals(const TOCModel *model) const
 {
     if (model) {
@@ -459,8 +581,8 @@ Okular::DocumentViewport TOCModel::viewportForIndex(const QModelIndex &index) co
         return Okular::DocumentViewport();
     }
 
-    const TOCItem *item = static_cast<TOCItem *>(index.internalPointer());
-    return item->viewport;
+    TOCItem *item = static_cast<TOCItem *>(index.internalPointer());
+    return item->resolvedViewport();
 }
 
 QString TOCModel::urlForIndex(const QModelIndex &index) const
@@ -473,24 +595,9 @@ QString TOCModel::urlForIndex(const QModelIndex &index) const
     return item->url;
 }
 
-bool TOCModel::checkequality(const TOCModel *model, const QModelIndex &parentA, const QModelIndex &parentB) const
+bool TOCModel::checkequality(const TOCModel *model) const
 {
-    if (rowCount(parentA) != model->rowCount(parentB)) {
-        return false;
-    }
-    for (int i = 0; i < rowCount(parentA); i++) {
-        QModelIndex indxA = index(i, 0, parentA);
-        QModelIndex indxB = model->index(i, 0, parentB);
-        if (indxA.data() != indxB.data()) {
-            return false;
-        }
-        if (hasChildren(indxA) != model->hasChildren(indxB)) {
-            return false;
-        }
-        if (!checkequality(model, indxA, indxB)) {
-            return false;
-        }
-    }
-    return true;
+    // compare the synopses rather than the items, which may not all exist yet
+    return sameOutline(d->synopsis, model->d->synopsis);
 }
 #include "moc_tocmodel.cpp"
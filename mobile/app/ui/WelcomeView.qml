@@ -40,7 +40,7 @@ FormCard.FormCard {
         spacing: Kirigami.Units.gridUnit
 
         Kirigami.PlaceholderMessage {
-            text: i18n("No document open")
+            text: document.openingStatus || i18n("No document open")
             helpfulAction: openDocumentAction
             Layout.fillWidth: true
         }
@@ -39,6 +39,12 @@ DocumentItem::DocumentItem(QObject *parent)
     connect(m_document, &Okular::Document::error, this, &DocumentItem::error);
     connect(m_document, &Okular::Document::warning, this, &DocumentItem::warning);
     connect(m_document, &Okular::Document::notice, this, &DocumentItem::notice);
+    connect(m_document, &Okular::Document::documentOpened, this, &DocumentItem::documentOpened);
+    connect(m_document, &Okular::Document::openFinished, this, &DocumentItem::openFinished);
+    connect(m_document, &Okular::Document::openProgress, this, [this](const QString &message) {
+        m_openingStatus = message;
+        Q_EMIT openingStatusChanged();
+    });
 }
 
 DocumentItem::~DocumentItem()
@@ -67,11 +73,17 @@ void DocumentItem::openUrl(const QUrl &url, const QString &password)
 
     const QString path = realUrl.isLocalFile() ? realUrl.toLocalFile() : QStringLiteral("-");
 
-    const Okular::Document::OpenResult res = m_document->openDocument(path, realUrl, db.mimeTypeForUrl(realUrl), password);
-
+    // the pages are shown as soon as documentOpened() tells they are known
     m_tocModel->clear();
-    m_tocModel->fill(m_document->documentSynopsis());
-    m_tocModel->setCurrentViewport(m_document->viewport());
+    m_document->openDocumentAsync(path, realUrl, db.mimeTypeForUrl(realUrl), password);
+}
+
+void DocumentItem::documentOpened(Okular::Document::OpenResult res)
+{
+    if (res != Okular::Document::OpenSuccess) {
+        m_openingStatus.clear();
+        Q_EMIT openingStatusChanged();
+    }
 
     m_matchingPages.clear();
     for (uint i = 0; i < m_document->pages(); ++i) {
@@ -101,6 +113,16 @@ void DocumentItem::openUrl(const QUrl &url, const QString &password)
     }
 }
 
+void DocumentItem::openFinished()
+{
+    // the table of contents can be slow to build, it waits for the first pages to be shown
+    m_tocModel->fill(m_document->documentSynopsis());
+    m_tocModel->setCurrentViewport(m_document->viewport());
+
+    m_openingStatus.clear();
+    Q_EMIT openingStatusChanged();
+}
+
 QString DocumentItem::windowTitleForDocument() const
 {
     // If 'DocumentTitle' should be used, check if the document has one. If
@@ -57,6 +57,11 @@ class DocumentItem : public QObject
      */
     Q_PROPERTY(bool needsPassword READ needsPassword NOTIFY needsPasswordChanged)
 
+    /**
+     * What is being done while the document opens, empty once it is open
+     */
+    Q_PROPERTY(QString openingStatus READ openingStatus NOTIFY openingStatusChanged)
+
     /**
      * How many pages there are in the document
      */
@@ -116,6 +121,11 @@ public:
         return m_needsPassword;
     }
 
+    QString openingStatus() const
+    {
+        return m_openingStatus;
+    }
+
     int pageCount() const;
 
     bool supportsSearching() const;
@@ -160,6 +170,7 @@ Q_SIGNALS:
     void pageCountChanged();
     void openedChanged();
     void needsPasswordChanged();
+    void openingStatusChanged();
     void searchInProgressChanged();
     void matchingPagesChanged();
     void currentPageChanged();
@@ -194,6 +205,8 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void searchFinished(int id, Okular::Document::SearchStatus endStatus);
+    void documentOpened(Okular::Document::OpenResult result);
+    void openFinished();
 
 private:
     void openUrl(const QUrl &url, const QString &password);
@@ -206,6 +219,7 @@ private:
     QVariantList m_matchingPages;
     bool m_searchInProgress;
     bool m_needsPassword = false;
+    QString m_openingStatus;
 };
 
 class Observer : public QObject, public Okular::DocumentObserver
@@ -8,10 +8,12 @@
 #include "documentitem.h"
 
 #include <QPainter>
+#include <QSGNode>
 #include <QQuickWindow>
 #include <QSGSimpleTextureNode>
 #include <QStyleOptionGraphicsItem>
 #include <QTimer>
+#include <QtMath>
 
 #include <core/bookmarkmanager.h>
 #include <core/generator.h>
@@ -23,12 +25,16 @@
 
 #define REDRAW_TIMEOUT 250
 
+// the page is painted and uploaded in square tiles of this many logical pixels
+static const int tileSize = 256;
+
 PageItem::PageItem(QQuickItem *parent)
     : QQuickItem(parent)
     , Okular::View(QStringLiteral("PageView"))
     , m_page(nullptr)
     , m_bookmarked(false)
     , m_isThumbnail(false)
+    , m_tilesScaleChanged(false)
 {
     setFlag(QQuickItem::ItemHasContents, true);
 
@@ -267,6 +273,9 @@ void PageItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeomet
     QQuickItem::geometryChange(newGeometry, oldGeometry);
 
     if (changed) {
+        // stretch the tiles we have until they are painted again
+        update();
+
         // Why aren't they automatically emitted?
         Q_EMIT widthChanged();
         Q_EMIT heightChanged();
@@ -275,26 +284,92 @@ void PageItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeomet
 
 QSGNode *PageItem::updatePaintNode(QSGNode *node, QQuickItem::UpdatePaintNodeData * /*data*/)
 {
-    if (!window() || m_buffer.isNull()) {
+    if (!window() || m_tiles.isEmpty()) {
         delete node;
+        m_tileNodes.clear();
+        m_staleTileNodes.clear();
         return nullptr;
     }
-    QSGSimpleTextureNode *n = static_cast<QSGSimpleTextureNode *>(node);
-    if (!n) {
-        n = new QSGSimpleTextureNode();
-        n->setOwnsTexture(true);
+
+    if (!node) {
+        // a new node tree, e.g. after the scene graph was invalidated, has to get all the tiles
+        node = new QSGNode();
+        m_tileNodes.clear();
+        m_staleTileNodes.clear();
+        for (auto it = m_tiles.cbegin(); it != m_tiles.cend(); ++it) {
+            m_dirtyTiles.insert(it.key());
+        }
+    }
+
+    if (m_tilesScaleChanged) {
+        for (const TileNode &tileNode : std::as_const(m_tileNodes)) {
+            m_staleTileNodes.append(tileNode);
+        }
+        m_tileNodes.clear();
+        m_tilesScaleChanged = false;
+    }
+
+    // tiles scrolled out of view
+    for (auto it = m_tileNodes.begin(); it != m_tileNodes.end();) {
+        if (!m_tiles.contains(it.key())) {
+            node->removeChildNode(it->node);
+            delete it->node;
+            it = m_tileNodes.erase(it);
+        } else {
+            ++it;
+        }
     }
 
-    n->setTexture(window()->createTextureFromImage(m_buffer));
-    n->setRect(boundingRect());
-    return n;
+    // only the tiles painted since the last frame are uploaded, the nodes are reused
+    for (const QPoint &tile : std::as_const(m_dirtyTiles)) {
+        const auto image = m_tiles.constFind(tile);
+        if (image == m_tiles.cend()) {
+            continue;
+        }
+
+        TileNode &tileNode = m_tileNodes[tile];
+        if (!tileNode.node) {
+            tileNode.node = new QSGSimpleTextureNode();
+            tileNode.node->setOwnsTexture(true);
+            node->appendChildNode(tileNode.node);
+        }
+        tileNode.node->setTexture(window()->createTextureFromImage(*image));
+
+        const QRect rect = tileRect(tile);
+        tileNode.normalizedRect = QRectF(rect.x() / m_tilesSize.width(), rect.y() / m_tilesSize.height(), rect.width() / m_tilesSize.width(), rect.height() / m_tilesSize.height());
+    }
+    m_dirtyTiles.clear();
+
+    // the previous tiles are not needed anymore once the visible ones are all there
+    if (m_tileNodes.size() == m_tiles.size()) {
+        for (const TileNode &tileNode : std::as_const(m_staleTileNodes)) {
+            node->removeChildNode(tileNode.node);
+            delete tileNode.node;
+        }
+        m_staleTileNodes.clear();
+    }
+
+    // while zooming the tiles are stretched to the new size until they are painted again
+    const auto place = [this](const TileNode &tileNode) {
+        const QRectF &rect = tileNode.normalizedRect;
+        tileNode.node->setRect(QRectF(rect.x() * width(), rect.y() * height(), rect.width() * width(), rect.height() * height()));
+    };
+    for (const TileNode &tileNode : std::as_const(m_staleTileNodes)) {
+        place(tileNode);
+    }
+    for (const TileNode &tileNode : std::as_const(m_tileNodes)) {
+        place(tileNode);
+    }
+
+    return node;
 }
 
 void PageItem::requestPixmap()
 {
     if (!m_documentItem || !m_page || !window() || width() <= 0 || height() < 0) {
-        if (!m_buffer.isNull()) {
-            m_buffer = QImage();
+        if (!m_tiles.isEmpty()) {
+            m_tiles.clear();
+            m_dirtyTiles.clear();
             update();
         }
         return;
@@ -313,8 +388,14 @@ void PageItem::requestPixmap()
     // Ideally we would do one or the other but for now this is good enough
     paint();
     {
+        // Like PageView, give the visible part of the page, so that the document
+        // switches to tiles for pages zoomed in a lot and renders only those in view
+        const QRectF visible = visibleRect();
         auto request = new Okular::PixmapRequest(observer, m_viewPort.pageNumber, width(), height(), dpr, priority, Okular::PixmapRequest::Asynchronous);
-        request->setNormalizedRect(Okular::NormalizedRect(0, 0, 1, 1));
+        request->setNormalizedRect(Okular::NormalizedRect(visible.left() / width(), visible.top() / height(), visible.right() / width(), visible.bottom() / height()));
+        if (m_page->hasTilesManager(observer)) {
+            request->setTile(true);
+        }
         const Okular::Document::PixmapRequestFlag prf = Okular::Document::NoOption;
         m_documentItem.data()->document()->requestPixmaps({request}, prf);
     }
@@ -322,21 +403,87 @@ void PageItem::requestPixmap()
 
 void PageItem::paint()
 {
+    paintVisibleTiles(true);
+}
+
+void PageItem::paintVisibleTiles(bool repaint)
+{
+    if (!m_documentItem || !m_page || !window() || width() <= 0 || height() <= 0) {
+        return;
+    }
+
+    if (m_tilesSize != size()) {
+        m_tiles.clear();
+        m_dirtyTiles.clear();
+        m_tilesSize = size();
+        m_tilesScaleChanged = true;
+        repaint = true;
+    }
+
     Observer *observer = m_isThumbnail ? m_documentItem.data()->thumbnailObserver() : m_documentItem.data()->pageviewObserver();
     const int flags = PagePainter::Accessibility | PagePainter::Highlights | PagePainter::Annotations;
-
     const qreal dpr = window()->devicePixelRatio();
-    const QRect limits(QPoint(0, 0), QSize(width() * dpr, height() * dpr));
-    QPixmap pix(limits.size());
-    pix.setDevicePixelRatio(dpr);
-    QPainter p(&pix);
-    p.setRenderHint(QPainter::Antialiasing, false);
-    PagePainter::paintPageOnPainter(&p, m_page, observer, flags, width(), height(), limits);
-    p.end();
 
-    m_buffer = pix.toImage();
+    const QRectF visible = visibleRect();
+    QSet<QPoint> visibleTiles;
+    if (!visible.isEmpty()) {
+        const int lastColumn = qCeil(visible.right() / tileSize) - 1;
+        const int lastRow = qCeil(visible.bottom() / tileSize) - 1;
+        for (int row = qFloor(visible.top() / tileSize); row <= lastRow; ++row) {
+            for (int column = qFloor(visible.left() / tileSize); column <= lastColumn; ++column) {
+                visibleTiles.insert(QPoint(column, row));
+            }
+        }
+    }
+
+    bool changed = false;
+    for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+        if (!visibleTiles.contains(it.key())) {
+            m_dirtyTiles.remove(it.key());
+            it = m_tiles.erase(it);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+
+    for (const QPoint &tile : std::as_const(visibleTiles)) {
+        if (!repaint && m_tiles.contains(tile)) {
+            continue;
+        }
+
+        const QRect limits = tileRect(tile);
+        QImage image(qCeil(limits.width() * dpr), qCeil(limits.height() * dpr), QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(dpr);
+        image.fill(Qt::transparent);
+        QPainter p(&image);
+        p.setRenderHint(QPainter::Antialiasing, false);
+        p.translate(-limits.topLeft());
+        PagePainter::paintPageOnPainter(&p, m_page, observer, flags, width(), height(), limits);
+        p.end();
+
+        m_tiles.insert(tile, image);
+        m_dirtyTiles.insert(tile);
+        changed = true;
+    }
 
-    update();
+    if (changed) {
+        update();
+    }
+}
+
+QRectF PageItem::visibleRect() const
+{
+    QRectF rect = boundingRect();
+    if (m_flickable) {
+        rect &= mapRectFromItem(m_flickable.data(), QRectF(0, 0, m_flickable.data()->width(), m_flickable.data()->height()));
+    }
+    return rect;
+}
+
+QRect PageItem::tileRect(const QPoint &tile) const
+{
+    return QRect(tile.x() * tileSize, tile.y() * tileSize, tileSize, tileSize) & QRect(0, 0, qCeil(m_tilesSize.width()), qCeil(m_tilesSize.height()));
 }
 
 // Protected slots
@@ -378,6 +525,7 @@ void PageItem::contentXChanged()
     }
 
     m_viewPort.rePos.normalizedX = m_flickable.data()->property("contentX").toReal() / (width() - m_flickable.data()->width());
+    scrolled();
 }
 
 void PageItem::contentYChanged()
@@ -387,6 +535,21 @@ void PageItem::contentYChanged()
     }
 
     m_viewPort.rePos.normalizedY = m_flickable.data()->property("contentY").toReal() / (height() - m_flickable.data()->height());
+    scrolled();
+}
+
+void PageItem::scrolled()
+{
+    // paint the tiles coming into view from the pixmap we have
+    paintVisibleTiles(false);
+
+    // and ask for the ones of the page that are not rendered yet
+    if (m_page && m_documentItem) {
+        Observer *observer = m_isThumbnail ? m_documentItem.data()->thumbnailObserver() : m_documentItem.data()->pageviewObserver();
+        if (m_page->hasTilesManager(observer)) {
+            m_redrawTimer->start();
+        }
+    }
 }
 
 void PageItem::setIsThumbnail(bool thumbnail)
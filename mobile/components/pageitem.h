@@ -7,14 +7,18 @@
 #ifndef QPAGEITEM_H
 #define QPAGEITEM_H
 
+#include <QHash>
 #include <QImage>
+#include <QPoint>
 #include <QPointer>
+#include <QSet>
 #include <QQuickItem>
 #include <qqmlregistration.h>
 
 #include <core/document.h>
 #include <core/view.h>
 
+class QSGSimpleTextureNode;
 class QTimer;
 
 class DocumentItem;
@@ -139,8 +143,17 @@ private Q_SLOTS:
     void contentYChanged();
 
 private:
+    struct TileNode {
+        QSGSimpleTextureNode *node = nullptr;
+        QRectF normalizedRect;
+    };
+
     void paint();
+    void paintVisibleTiles(bool repaint);
+    void scrolled();
     void refreshPage();
+    QRectF visibleRect() const;
+    QRect tileRect(const QPoint &tile) const;
 
     const Okular::Page *m_page;
     bool m_bookmarked;
@@ -149,7 +162,16 @@ private:
     QTimer *m_redrawTimer;
     QPointer<QQuickItem> m_flickable;
     Okular::DocumentViewport m_viewPort;
-    QImage m_buffer;
+
+    // The page is painted in tiles, only the visible ones, keyed by their column and row
+    QHash<QPoint, QImage> m_tiles;
+    QSet<QPoint> m_dirtyTiles; // painted but not uploaded yet
+    QSizeF m_tilesSize; // the item size the tiles were painted for
+    bool m_tilesScaleChanged;
+
+    // The scene graph side, only used in updatePaintNode()
+    QHash<QPoint, TileNode> m_tileNodes;
+    QList<TileNode> m_staleTileNodes; // tiles of the previous size, shown stretched until the new ones are uploaded
 };
 
 #endif
@@ -9,8 +9,13 @@
 
 #include "annotationmodel.h"
 
+#include <algorithm>
+
+#include <QElapsedTimer>
 #include <QList>
 #include <QPointer>
+#include <QSet>
+#include <QTimer>
 
 #include <KLocalizedString>
 #include <QIcon>
@@ -64,14 +69,21 @@ public:
     void notifyPageChanged(int page, int flags) override;
 
     QModelIndex indexForItem(AnnItem *item) const;
-    void rebuildTree(const QList<Okular::Page *> &pages);
+    void populate(int maxMsecs);
     AnnItem *findItem(int page, int *index) const;
 
     AnnotationModel *q;
     AnnItem *root;
     QPointer<Okular::Document> document;
+    // pages from nextPage on have not been scanned for annotations yet
+    int nextPage;
+    int pageCount;
+    QTimer *populateTimer;
 };
 
+// how long a single population step may block the event loop
+static const int populateSliceMsecs = 10;
+
 AnnItem::AnnItem()
     : parent(nullptr)
     , annotation(nullptr)
@@ -105,7 +117,13 @@ AnnItem::~AnnItem()
 AnnotationModelPrivate::AnnotationModelPrivate(AnnotationModel *qq)
     : q(qq)
     , root(new AnnItem)
+    , nextPage(0)
+    , pageCount(0)
+    , populateTimer(new QTimer(qq))
 {
+    populateTimer->setSingleShot(true);
+    populateTimer->setInterval(0);
+    QObject::connect(populateTimer, &QTimer::timeout, q, [this] { populate(populateSliceMsecs); });
 }
 
 AnnotationModelPrivate::~AnnotationModelPrivate()
@@ -129,6 +147,15 @@ static void updateAnnotationPointer(AnnItem *item, const QList<Okular::Page *> &
 
 void AnnotationModelPrivate::notifySetup(const QList<Okular::Page *> &pages, int setupFlags)
 {
+    if ((setupFlags & Okular::DocumentObserver::PagesAppended) && !(setupFlags & Okular::DocumentObserver::DocumentChanged)) {
+        // scan the new pages as well
+        pageCount = pages.count();
+        if (!populateTimer->isActive()) {
+            populateTimer->start();
+        }
+        return;
+    }
+
     if (!(setupFlags & Okular::DocumentObserver::DocumentChanged)) {
         if (setupFlags & Okular::DocumentObserver::UrlChanged) {
             // Here with UrlChanged and no document changed it means we
@@ -140,12 +167,20 @@ void AnnotationModelPrivate::notifySetup(const QList<Okular::Page *> &pages, int
         return;
     }
 
+    // Documents with thousands of annotations would block here for a long
+    // time, so start empty and add the pages in small steps from the event loop
     q->beginResetModel();
     qDeleteAll(root->children);
     root->children.clear();
-
-    rebuildTree(pages);
+    nextPage = 0;
+    pageCount = pages.count();
     q->endResetModel();
+
+    if (pageCount > 0) {
+        populateTimer->start();
+    } else {
+        populateTimer->stop();
+    }
 }
 
 void AnnotationModelPrivate::notifyPageChanged(int page, int flags)
@@ -155,6 +190,11 @@ void AnnotationModelPrivate::notifyPageChanged(int page, int flags)
         return;
     }
 
+    // not scanned yet, populate() will pick up the current annotations
+    if (page >= nextPage) {
+        return;
+    }
+
     const QList<Okular::Annotation *> annots = filterOutWidgetAnnotations(document->page(page)->annotations());
     int annItemIndex = -1;
     AnnItem *annItem = findItem(page, &annItemIndex);
@@ -172,10 +212,7 @@ void AnnotationModelPrivate::notifyPageChanged(int page, int flags)
     // case 2: no existing branch
     //         => add a new branch, and add the annotations for the page
     if (!annItem) {
-        int i = 0;
-        while (i < root->children.count() && root->children.at(i)->page < page) {
-            ++i;
-        }
+        const int i = annItemIndex;
 
         AnnItem *newAnnItem = new AnnItem();
         newAnnItem->page = page;
@@ -191,16 +228,9 @@ void AnnotationModelPrivate::notifyPageChanged(int page, int flags)
     // case 3: existing branch, less annotations than items
     //         => lookup and remove the annotations
     if (annItem->children.count() > annots.count()) {
+        const QSet<const Okular::Annotation *> current(annots.cbegin(), annots.cend());
         for (int i = annItem->children.count(); i > 0; --i) {
-            const Okular::Annotation *ref = annItem->children.at(i - 1)->annotation;
-            bool found = false;
-            for (const Okular::Annotation *annot : annots) {
-                if (annot == ref) {
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
+            if (!current.contains(annItem->children.at(i - 1)->annotation)) {
                 q->beginRemoveRows(indexForItem(annItem), i - 1, i - 1);
                 delete annItem->children.at(i - 1);
                 annItem->children.removeAt(i - 1);
@@ -212,15 +242,13 @@ void AnnotationModelPrivate::notifyPageChanged(int page, int flags)
     // case 4: existing branch, less items than annotations
     //         => lookup and add annotations if not in the branch
     if (annots.count() > annItem->children.count()) {
+        QSet<const Okular::Annotation *> known;
+        for (const AnnItem *child : std::as_const(annItem->children)) {
+            known.insert(child->annotation);
+        }
         for (Okular::Annotation *ref : annots) {
-            bool found = false;
-            int count = annItem->children.count();
-            for (int i = 0; !found && i < count; ++i) {
-                if (ref == annItem->children.at(i)->annotation) {
-                    found = true;
-                }
-            }
-            if (!found) {
+            if (!known.contains(ref)) {
+                const int count = annItem->children.count();
                 q->beginInsertRows(indexForItem(annItem), count, count);
                 new AnnItem(annItem, ref);
                 q->endInsertRows();
@@ -248,38 +276,58 @@ QModelIndex AnnotationModelPrivate::indexForItem(AnnItem *item) const
     return QModelIndex();
 }
 
-void AnnotationModelPrivate::rebuildTree(const QList<Okular::Page *> &pages)
+void AnnotationModelPrivate::populate(int maxMsecs)
 {
-    if (pages.isEmpty()) {
+    if (!document) {
         return;
     }
 
-    for (int i = 0; i < pages.count(); ++i) {
-        const QList<Okular::Annotation *> annots = filterOutWidgetAnnotations(pages.at(i)->annotations());
+    QElapsedTimer timer;
+    timer.start();
+
+    // Gather the branches of this step first, so they are inserted with a
+    // single notification: the proxy models rebuild themselves on each of them
+    QList<AnnItem *> newItems;
+    while (nextPage < pageCount && !timer.hasExpired(maxMsecs)) {
+        const int page = nextPage++;
+        const QList<Okular::Annotation *> annots = filterOutWidgetAnnotations(document->page(page)->annotations());
         if (annots.isEmpty()) {
             continue;
         }
 
-        AnnItem *annItem = new AnnItem(root, i);
+        AnnItem *annItem = new AnnItem();
+        annItem->page = page;
+        annItem->parent = root;
         for (Okular::Annotation *annot : annots) {
             new AnnItem(annItem, annot);
         }
+        newItems.append(annItem);
+    }
+
+    // branches are sorted by page, and all the existing ones come before nextPage
+    if (!newItems.isEmpty()) {
+        const int first = root->children.count();
+        q->beginInsertRows(QModelIndex(), first, first + newItems.count() - 1);
+        root->children.append(newItems);
+        q->endInsertRows();
+    }
+
+    if (nextPage < pageCount) {
+        populateTimer->start();
     }
 }
 
 AnnItem *AnnotationModelPrivate::findItem(int page, int *index) const
 {
-    for (int i = 0; i < root->children.count(); ++i) {
-        AnnItem *tmp = root->children.at(i);
-        if (tmp->page == page) {
-            if (index) {
-                *index = i;
-            }
-            return tmp;
-        }
-    }
+    // the branches are sorted by page; if there is none for the page, *index
+    // is set to the position where it would go
+    const auto it = std::lower_bound(root->children.cbegin(), root->children.cend(), page, [](const AnnItem *item, int page) { return item->page < page; });
+    const int i = it - root->children.cbegin();
     if (index) {
-        *index = -1;
+        *index = i;
+    }
+    if (it != root->children.cend() && (*it)->page == page) {
+        return *it;
     }
     return nullptr;
 }
@@ -372,6 +420,18 @@ bool AnnotationModel::hasChildren(const QModelIndex &parent) const
     return !item->children.isEmpty();
 }
 
+bool AnnotationModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && d->nextPage < d->pageCount;
+}
+
+void AnnotationModel::fetchMore(const QModelIndex &parent)
+{
+    if (!parent.isValid()) {
+        d->populate(populateSliceMsecs);
+    }
+}
+
 QVariant AnnotationModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     if (orientation != Qt::Horizontal) {
@@ -6,18 +6,24 @@
 
 #include "dlgperformance.h"
 
+#include <KFormat>
 #include <KLocalizedString>
 
 #include <QCheckBox>
 #include <QComboBox>
 #include <QFormLayout>
 #include <QLabel>
+#include <QTimer>
 
+#include "part.h"
 #include "settings_core.h"
 
-DlgPerformance::DlgPerformance(QWidget *parent)
+DlgPerformance::DlgPerformance(QWidget *parent, Okular::Part *part)
     : QWidget(parent)
     , m_memoryExplanationLabel(new QLabel(this))
+    , m_part(part)
+    , m_memoryUsageLabel(nullptr)
+    , m_memoryUsageTimer(nullptr)
 {
     QFormLayout *layout = new QFormLayout(this);
 
@@ -47,6 +53,18 @@ DlgPerformance::DlgPerformance(QWidget *parent)
     connect(m_memoryLevel, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &DlgPerformance::slotMemoryLevelSelected);
     // END Radio buttons: memory usage
 
+    // BEGIN Label: memory in use
+    if (m_part) {
+        m_memoryUsageLabel = new QLabel(this);
+        m_memoryUsageLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+        layout->addRow(i18nc("@label Config dialog, performance page", "Memory in use:"), m_memoryUsageLabel);
+
+        m_memoryUsageTimer = new QTimer(this);
+        m_memoryUsageTimer->setInterval(1000);
+        connect(m_memoryUsageTimer, &QTimer::timeout, this, &DlgPerformance::slotUpdateMemoryUsage);
+    }
+    // END Label: memory in use
+
     layout->addRow(new QLabel(this));
 
     // BEGIN Checkboxes: rendering options
@@ -88,3 +106,72 @@ void DlgPerformance::slotMemoryLevelSelected(int which)
         break;
     }
 }
+
+void DlgPerformance::slotUpdateMemoryUsage()
+{
+    const QVariantMap statistics = m_part->memoryStatistics();
+    const KFormat format;
+    QStringList lines;
+
+    const QVariantMap observers = statistics.value(QStringLiteral("observers")).toMap();
+    for (auto it = observers.cbegin(); it != observers.cend(); ++it) {
+        QString name;
+        if (it.key() == QLatin1String("pageView")) {
+            name = i18nc("@label the main view of the document", "Pages");
+        } else if (it.key() == QLatin1String("thumbnails")) {
+            name = i18nc("@label", "Thumbnails");
+        } else if (it.key() == QLatin1String("presentation")) {
+            name = i18nc("@label", "Presentation");
+        } else {
+            name = i18nc("@label other views of the document", "Other views");
+        }
+        const QVariantMap memory = it.value().toMap();
+        lines << i18nc("@label %1 is a view, %2 and %3 are sizes in bytes",
+                       "%1: %2 in pixmaps, %3 in tiles",
+                       name,
+                       format.formatByteSize(memory.value(QStringLiteral("pixmapBytes")).toULongLong()),
+                       format.formatByteSize(memory.value(QStringLiteral("tileBytes")).toULongLong()));
+    }
+
+    lines << i18ncp("@label %2 is a size in bytes",
+                    "Text: %1 page, %2",
+                    "Text: %1 pages, %2",
+                    statistics.value(QStringLiteral("textPages")).toInt(),
+                    format.formatByteSize(statistics.value(QStringLiteral("textPageBytes")).toULongLong()));
+
+    const QVariantMap generatorCaches = statistics.value(QStringLiteral("generatorCaches")).toMap();
+    for (auto it = generatorCaches.cbegin(); it != generatorCaches.cend(); ++it) {
+        lines << i18nc("@label %1 is the name of a cache, %2 a size in bytes", "%1: %2", it.key(), format.formatByteSize(it.value().toULongLong()));
+    }
+
+    lines << i18nc("@label", "Requests: %1 queued, %2 rendering", statistics.value(QStringLiteral("queuedRequests")).toInt(), statistics.value(QStringLiteral("executingRequests")).toInt());
+
+    const int renderedPixmaps = statistics.value(QStringLiteral("renderedPixmaps")).toInt();
+    if (renderedPixmaps > 0) {
+        lines << i18ncp("@label %2 is a duration, %3 the name of the backend",
+                        "Rendering: %2 on average over %1 page (%3)",
+                        "Rendering: %2 on average over %1 pages (%3)",
+                        renderedPixmaps,
+                        i18nc("@label a duration in milliseconds", "%1 ms", QString::number(statistics.value(QStringLiteral("averageRenderTime")).toDouble(), 'f', 1)),
+                        statistics.value(QStringLiteral("generator")).toString());
+    }
+
+    m_memoryUsageLabel->setText(lines.join(QLatin1Char('\n')));
+}
+
+void DlgPerformance::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if (m_memoryUsageTimer) {
+        slotUpdateMemoryUsage();
+        m_memoryUsageTimer->start();
+    }
+}
+
+void DlgPerformance::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    if (m_memoryUsageTimer) {
+        m_memoryUsageTimer->stop();
+    }
+}
@@ -10,19 +10,34 @@
 #include <QWidget>
 
 class QLabel;
+class QTimer;
+
+namespace Okular
+{
+class Part;
+}
 
 class DlgPerformance : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit DlgPerformance(QWidget *parent = nullptr);
+    explicit DlgPerformance(QWidget *parent = nullptr, Okular::Part *part = nullptr);
 
 protected Q_SLOTS:
     void slotMemoryLevelSelected(int which);
+    void slotUpdateMemoryUsage();
 
 protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
     QLabel *m_memoryExplanationLabel;
+
+    // what the document holds in memory, refreshed while the page is shown
+    Okular::Part *m_part;
+    QLabel *m_memoryUsageLabel;
+    QTimer *m_memoryUsageTimer;
 };
 
 #endif
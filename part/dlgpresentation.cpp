@@ -61,6 +61,13 @@ DlgPresentation::DlgPresentation(QWidget *parent)
     tapNavigation->addItem(i18nc("@item:inlistbox Config dialog, presentation page, tap navigation", "Disabled"));
     tapNavigation->setObjectName(QStringLiteral("kcfg_SlidesTapNavigation"));
     layout->addRow(i18nc("@label:listbox Config dialog, presentation page, tap navigation", "Touch navigation:"), tapNavigation);
+
+    // Spinbox: Slides rendered ahead
+    QSpinBox *preloadPages = new QSpinBox(this);
+    KLocalization::setupSpinBoxFormatString(preloadPages, ki18ncp("@label:spinbox Prepare upcoming slides: n slides", "%v slide", "%v slides"));
+    preloadPages->setObjectName(QStringLiteral("kcfg_SlidesPreloadPages"));
+    preloadPages->setToolTip(i18nc("@info:tooltip Config dialog, presentation page", "How many of the upcoming slides are kept fully rendered, so that changing slides is instant. Higher values use more memory."));
+    layout->addRow(i18nc("@label:spinbox Config dialog, presentation page", "Prepare upcoming slides:"), preloadPages);
     // END Navigation section
 
     layout->addRow(new QLabel(this));
@@ -0,0 +1,141 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "fadetransitionrenderer.h"
+
+#include <QPainter>
+#include <QPixmap>
+#include <QThread>
+
+FadeTransitionRenderer::FadeTransitionRenderer()
+    : m_thread(nullptr)
+    , m_front(0)
+    , m_pendingOpacity(-1)
+    , m_busy(false)
+    , m_backReady(false)
+    , m_quit(false)
+{
+}
+
+FadeTransitionRenderer::~FadeTransitionRenderer()
+{
+    if (!m_thread) {
+        return;
+    }
+
+    m_mutex.lock();
+    m_quit = true;
+    m_wakeUp.wakeOne();
+    m_mutex.unlock();
+
+    m_thread->wait();
+    delete m_thread;
+}
+
+void FadeTransitionRenderer::prepareBuffer(QImage *buffer, const QSize &size, qreal dpr)
+{
+    if (buffer->size() != size || buffer->format() != QImage::Format_ARGB32_Premultiplied) {
+        *buffer = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    }
+    buffer->setDevicePixelRatio(dpr);
+}
+
+void FadeTransitionRenderer::start(const QPixmap &from, const QPixmap &to)
+{
+    // most presentations never fade, only start the worker for the first fade
+    if (!m_thread) {
+        m_thread = QThread::create([this] { run(); });
+        m_thread->start();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_pendingOpacity = -1;
+    while (m_busy) {
+        m_idle.wait(&m_mutex);
+    }
+    m_backReady = false;
+
+    // The worker is idle and has nothing to do, the buffers are ours until the next request
+    const QSize size = to.size();
+    const qreal dpr = to.devicePixelRatio();
+    for (QImage *buffer : {&m_from, &m_to, &m_frames[0], &m_frames[1]}) {
+        prepareBuffer(buffer, size, dpr);
+    }
+
+    QPainter p;
+    m_from.fill(Qt::transparent);
+    if (!from.isNull()) {
+        p.begin(&m_from);
+        p.setCompositionMode(QPainter::CompositionMode_Source);
+        p.drawPixmap(0, 0, from);
+        p.end();
+    }
+    p.begin(&m_to);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    p.drawPixmap(0, 0, to);
+    p.end();
+
+    // Until the first frame is ready the old slide stays on screen
+    p.begin(&m_frames[m_front]);
+    p.setCompositionMode(QPainter::CompositionMode_Source);
+    p.drawImage(0, 0, m_from);
+    p.end();
+}
+
+void FadeTransitionRenderer::requestFrame(qreal opacity)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pendingOpacity = qBound<qreal>(0, opacity, 1);
+    m_backReady = false;
+    m_wakeUp.wakeOne();
+}
+
+bool FadeTransitionRenderer::takeFrame()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_backReady) {
+        return false;
+    }
+    m_front = 1 - m_front;
+    m_backReady = false;
+    return true;
+}
+
+const QImage &FadeTransitionRenderer::frame() const
+{
+    return m_frames[m_front];
+}
+
+void FadeTransitionRenderer::run()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_quit) {
+        if (m_pendingOpacity < 0) {
+            m_wakeUp.wait(&m_mutex);
+            continue;
+        }
+
+        const qreal opacity = m_pendingOpacity;
+        m_pendingOpacity = -1;
+        m_busy = true;
+        QImage &target = m_frames[1 - m_front];
+        locker.unlock();
+
+        QPainter p(&target);
+        p.setCompositionMode(QPainter::CompositionMode_Source);
+        p.drawImage(0, 0, m_from);
+        p.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        p.setOpacity(opacity);
+        p.drawImage(0, 0, m_to);
+        p.end();
+
+        locker.relock();
+        m_busy = false;
+        // A newer request or a new transition supersedes this frame
+        m_backReady = m_pendingOpacity < 0;
+        m_idle.wakeAll();
+    }
+}
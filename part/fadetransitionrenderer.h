@@ -0,0 +1,78 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _OKULAR_FADETRANSITIONRENDERER_H_
+#define _OKULAR_FADETRANSITIONRENDERER_H_
+
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QPixmap;
+class QThread;
+
+/**
+ * Computes the frames of a fade transition on a worker thread.
+ *
+ * The two slides and two frame buffers (the one on screen and the one being
+ * composed) are allocated once and reused for every step and every transition
+ * of the same size, so stepping a fade never allocates.
+ *
+ * The worker thread is started by the first start().
+ *
+ * All the methods are meant to be called from the GUI thread.
+ */
+class FadeTransitionRenderer
+{
+public:
+    FadeTransitionRenderer();
+    ~FadeTransitionRenderer();
+
+    FadeTransitionRenderer(const FadeTransitionRenderer &) = delete;
+    FadeTransitionRenderer &operator=(const FadeTransitionRenderer &) = delete;
+
+    /**
+     * Starts a fade from @p from to @p to, discarding any frame in progress.
+     */
+    void start(const QPixmap &from, const QPixmap &to);
+
+    /**
+     * Asks the worker to compose the frame at @p opacity of the new slide.
+     * Must only be called after start() or after takeFrame() returned true.
+     */
+    void requestFrame(qreal opacity);
+
+    /**
+     * Returns true and makes it the one returned by frame() if the requested frame is finished.
+     */
+    bool takeFrame();
+
+    /**
+     * The last frame taken with takeFrame().
+     */
+    const QImage &frame() const;
+
+private:
+    void run();
+    static void prepareBuffer(QImage *buffer, const QSize &size, qreal dpr);
+
+    QThread *m_thread;
+    QMutex m_mutex;
+    QWaitCondition m_wakeUp;
+    QWaitCondition m_idle;
+
+    QImage m_from;
+    QImage m_to;
+    QImage m_frames[2];
+    int m_front;
+
+    qreal m_pendingOpacity; // < 0 if there is nothing to compose
+    bool m_busy;
+    bool m_backReady;
+    bool m_quit;
+};
+
+#endif
@@ -29,6 +29,10 @@ MagnifierView::~MagnifierView()
 
 void MagnifierView::notifySetup(const QList<Okular::Page *> &pages, int setupFlags)
 {
+    if (setupFlags & Okular::DocumentObserver::PagesAppended) {
+        m_pages = pages;
+    }
+
     if (!(setupFlags & Okular::DocumentObserver::DocumentChanged)) {
         return;
     }
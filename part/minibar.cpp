@@ -71,8 +71,8 @@ int MiniBarLogic::currentPage() const
 
 void MiniBarLogic::notifySetup(const QList<Okular::Page *> &pageVector, int setupFlags)
 {
-    // only process data when document changes
-    if (!(setupFlags & Okular::DocumentObserver::DocumentChanged)) {
+    // only process data when document changes, or gets more pages while loading
+    if (!(setupFlags & (Okular::DocumentObserver::DocumentChanged | Okular::DocumentObserver::PagesAppended))) {
         return;
     }
 
@@ -127,6 +127,11 @@ void MiniBarLogic::notifySetup(const QList<Okular::Page *> &pageVector, int setu
 
         miniBar->setEnabled(true);
     }
+
+    // the current page stays, with a next one now
+    if (!(setupFlags & Okular::DocumentObserver::DocumentChanged)) {
+        notifyCurrentPageChanged(-1, m_document->viewport().pageNumber);
+    }
 }
 
 void MiniBarLogic::notifyCurrentPageChanged(int previousPage, int currentPage)
@@ -80,6 +80,7 @@
 #include "pageviewannotator.h"
 #include "pageviewmouseannotation.h"
 #include "pageviewutils.h"
+#include "renderaheadpredictor.h"
 #include "toggleactionmenu.h"
 #if HAVE_SPEECH
 #include "tts.h"
@@ -160,6 +161,10 @@ public:
     QList<PageViewItem *> visibleItems;
     MagnifierView *magnifierView = nullptr;
 
+    // where the user is going, to render pages before they get there
+    RenderAheadPredictor renderAhead;
+    QSet<int> previouslyVisiblePages;
+
     // view layout (columns in Settings), zoom and mouse
     PageView::ZoomMode zoomMode = PageView::ZoomFitWidth;
     float zoomFactor = 1.0;
@@ -1179,6 +1184,33 @@ void PageView::createAnnotationsVideoWidgets(PageViewItem *item, const QList<Oku
 }
 
 // BEGIN DocumentObserver inherited methods
+bool PageView::createItem(const Okular::Page *page, bool allowfillforms)
+{
+    bool hasformwidgets = false;
+
+    PageViewItem *item = new PageViewItem(page);
+    d->items.push_back(item);
+#ifdef PAGEVIEW_DEBUG
+    qCDebug(OkularUiDebug).nospace() << "cropped geom for " << d->items.last()->pageNumber() << " is " << d->items.last()->croppedGeometry();
+#endif
+    const QList<Okular::FormField *> pageFields = page->formFields();
+    for (Okular::FormField *ff : pageFields) {
+        FormWidgetIface *w = FormWidgetFactory::createWidget(ff, this);
+        if (w) {
+            w->setPageItem(item);
+            w->setFormWidgetsController(d->formWidgetsController());
+            w->setVisibility(false);
+            w->setCanBeFilled(allowfillforms);
+            item->formWidgets().insert(w);
+            hasformwidgets = true;
+        }
+    }
+
+    createAnnotationsVideoWidgets(item, page->annotations());
+
+    return hasformwidgets;
+}
+
 void PageView::notifySetup(const QList<Okular::Page *> &pageSet, int setupFlags)
 {
     bool documentChanged = setupFlags & Okular::DocumentObserver::DocumentChanged;
@@ -1250,9 +1282,33 @@ void PageView::notifySetup(const QList<Okular::Page *> &pageSet, int setupFlags)
         }
     }
 
+    // pages appended to a document that is still loading, keep the items of the others
+    if ((setupFlags & Okular::DocumentObserver::PagesAppended) && !documentChanged && !d->items.isEmpty()) {
+        bool hasformwidgets = false;
+        for (int i = d->items.count(); i < pageSet.count(); ++i) {
+            if (createItem(pageSet[i], allowfillforms)) {
+                hasformwidgets = true;
+            }
+        }
+        if (hasformwidgets) {
+            updateActionState(true, true);
+        }
+
+        d->dirtyLayout = true;
+        QMetaObject::invokeMethod(this, "slotRelayoutPages", Qt::QueuedConnection);
+        return;
+    }
+
     // mouseAnnotation must not access our PageViewItem widgets any longer
     d->mouseAnnotation->reset();
 
+    const RenderAheadPredictor::Statistics renderAheadStats = d->renderAhead.statistics();
+    if (renderAheadStats.hits + renderAheadStats.misses > 0) {
+        qCDebug(OkularUiDebug) << "render ahead: pages ready when shown" << renderAheadStats.hits << "not ready" << renderAheadStats.misses << "direction changes" << renderAheadStats.directionChanges;
+    }
+    d->renderAhead = RenderAheadPredictor();
+    d->previouslyVisiblePages.clear();
+
     // delete all widgets (one for each page in pageSet)
     qDeleteAll(d->items);
     d->items.clear();
@@ -1267,25 +1323,9 @@ void PageView::notifySetup(const QList<Okular::Page *> &pageSet, int setupFlags)
     bool hasformwidgets = false;
     // create children widgets
     for (const Okular::Page *page : pageSet) {
-        PageViewItem *item = new PageViewItem(page);
-        d->items.push_back(item);
-#ifdef PAGEVIEW_DEBUG
-        qCDebug(OkularUiDebug).nospace() << "cropped geom for " << d->items.last()->pageNumber() << " is " << d->items.last()->croppedGeometry();
-#endif
-        const QList<Okular::FormField *> pageFields = page->formFields();
-        for (Okular::FormField *ff : pageFields) {
-            FormWidgetIface *w = FormWidgetFactory::createWidget(ff, this);
-            if (w) {
-                w->setPageItem(item);
-                w->setFormWidgetsController(d->formWidgetsController());
-                w->setVisibility(false);
-                w->setCanBeFilled(allowfillforms);
-                item->formWidgets().insert(w);
-                hasformwidgets = true;
-            }
+        if (createItem(page, allowfillforms)) {
+            hasformwidgets = true;
         }
-
-        createAnnotationsVideoWidgets(item, page->annotations());
     }
 
     // invalidate layout so relayout/repaint will happen on next viewport change
@@ -1469,6 +1509,11 @@ void PageView::slotRealNotifyViewportChanged(bool smoothMove)
 #ifdef PAGEVIEW_DEBUG
     qCDebug(OkularUiDebug) << "document viewport changed";
 #endif
+    // moving to another page tells in which direction pages are going to be needed
+    if (!d->visibleItems.isEmpty()) {
+        d->renderAhead.addPageChange(d->visibleItems.first()->pageNumber(), vp.pageNumber);
+    }
+
     // relayout in "Single Pages" mode or if a relayout is pending
     d->blockPixmapsRequest = true;
     if (!getContinuousMode() || d->dirtyLayout) {
@@ -4739,6 +4784,9 @@ void PageView::slotRelayoutPages()
         return;
     }
 
+    // positions before and after the relayout can't be compared
+    d->renderAhead.reset();
+
     int viewportWidth = viewport()->width(), viewportHeight = viewport()->height(), fullWidth = 0, fullHeight = 0;
 
     // handle the 'center first page in row' stuff
@@ -4964,10 +5012,21 @@ void PageView::slotRequestVisiblePixmaps(int newValue)
     const double viewportCenterX = (viewportRect.left() + viewportRect.right()) / 2.0;
     const double viewportCenterY = (viewportRect.top() + viewportRect.bottom()) / 2.0;
     double focusedX = 0.5, focusedY = 0.0, minDistance = -1.0;
-    // Margin (in pixels) around the viewport to preload
-    const int pixelsToExpand = 512;
+
+    // Margins (in pixels) around the viewport to preload, the one in the reading
+    // direction grows with the scrolling speed
+    if (isEvent) {
+        d->renderAhead.addPosition(verticalScrollBar()->value());
+    }
+    const int direction = d->renderAhead.direction();
+    const int pixelsAhead = d->renderAhead.pixelsAhead(viewport()->height());
+    const int pixelsBehind = d->renderAhead.pixelsBehind();
+    const int pixelsAbove = direction < 0 ? pixelsAhead : pixelsBehind;
+    const int pixelsBelow = direction < 0 ? pixelsBehind : pixelsAhead;
+    const int pixelsAside = qMin(pixelsAbove, pixelsBelow);
 
     // iterate over all items
+    QSet<int> visiblePages;
     d->visibleItems.clear();
     QList<Okular::PixmapRequest *> requestedPixmaps;
     QList<Okular::VisiblePageRect *> visibleRects;
@@ -5014,13 +5073,18 @@ void PageView::slotRequestVisiblePixmaps(int newValue)
         qWarning() << "checking for text for page" << i->pageNumber() << "=" << i->page()->hasTextPage();
 #endif
 
+        // count whether pages coming into view were ready
+        visiblePages.insert(i->pageNumber());
+        if (!d->previouslyVisiblePages.contains(i->pageNumber())) {
+            d->renderAhead.pageShown(i->page()->hasPixmap(this, i->uncroppedWidth(), i->uncroppedHeight(), i->page()->hasTilesManager(this) ? vItem->rect : Okular::NormalizedRect()));
+        }
+
         Okular::NormalizedRect expandedVisibleRect = vItem->rect;
         if (i->page()->hasTilesManager(this) && Okular::Settings::memoryLevel() != Okular::Settings::EnumMemoryLevel::Low) {
-            double rectMargin = pixelsToExpand / (double)i->uncroppedHeight();
-            expandedVisibleRect.left = qMax(0.0, vItem->rect.left - rectMargin);
-            expandedVisibleRect.top = qMax(0.0, vItem->rect.top - rectMargin);
-            expandedVisibleRect.right = qMin(1.0, vItem->rect.right + rectMargin);
-            expandedVisibleRect.bottom = qMin(1.0, vItem->rect.bottom + rectMargin);
+            expandedVisibleRect.left = qMax(0.0, vItem->rect.left - pixelsAside / (double)i->uncroppedWidth());
+            expandedVisibleRect.top = qMax(0.0, vItem->rect.top - pixelsAbove / (double)i->uncroppedHeight());
+            expandedVisibleRect.right = qMin(1.0, vItem->rect.right + pixelsAside / (double)i->uncroppedWidth());
+            expandedVisibleRect.bottom = qMin(1.0, vItem->rect.bottom + pixelsBelow / (double)i->uncroppedHeight());
         }
 
         // if the item has not the right pixmap, add a request for it
@@ -5061,39 +5125,44 @@ void PageView::slotRequestVisiblePixmaps(int newValue)
         }
     }
 
-    // if preloading is enabled, add the pages before and after in preloading
+    d->previouslyVisiblePages = visiblePages;
+
+    // if preloading is enabled, add the pages ahead and behind in preloading
     if (!d->visibleItems.isEmpty() && Okular::SettingsCore::memoryLevel() != Okular::SettingsCore::EnumMemoryLevel::Low) {
         // as the requests are done in the order as they appear in the list,
-        // request first the next page and then the previous
+        // request first the pages ahead in the reading direction, nearest first.
+        // Requests not repeated here are dropped from the queue by requestPixmaps(),
+        // so going back the other way cancels the preloads queued for the old direction
 
-        int pagesToPreload = viewColumns();
+        int pagesAhead = viewColumns();
+        // once the direction is known only what is within the margin is kept behind
+        int pagesBehind = direction == 0 ? viewColumns() : 0;
 
         // if the greedy option is set, preload all pages
         if (Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Greedy) {
-            pagesToPreload = d->items.count();
+            pagesAhead = d->items.count();
+            pagesBehind = d->items.count();
         }
 
-        const QRectF adjustedViewportRect = viewportRect.adjusted(0, -pixelsToExpand, 0, pixelsToExpand);
+        const QRectF adjustedViewportRect = viewportRect.adjusted(0, -pixelsAbove, 0, pixelsBelow);
         const QRect expandedViewportRect(adjustedViewportRect.x(), adjustedViewportRect.y(), adjustedViewportRect.width(), adjustedViewportRect.height());
-
-        for (int j = 1; j <= pagesToPreload; j++) {
-            // add the page after the 'visible series' in preload
-            const int tailRequest = d->visibleItems.last()->pageNumber() + j;
-            if (tailRequest < (int)d->items.count()) {
-                slotRequestPreloadPixmap(this, d->items[tailRequest], expandedViewportRect, &requestedPixmaps);
-            }
-
-            // add the page before the 'visible series' in preload
-            const int headRequest = d->visibleItems.first()->pageNumber() - j;
-            if (headRequest >= 0) {
-                slotRequestPreloadPixmap(this, d->items[headRequest], expandedViewportRect, &requestedPixmaps);
-            }
-
-            // stop if we've already reached both ends of the document
-            if (headRequest < 0 && tailRequest >= (int)d->items.count()) {
-                break;
+        // in single page mode the hidden pages have no meaningful geometry
+        const bool continuous = getContinuousMode();
+
+        const int forward = direction < 0 ? -1 : 1;
+        const int firstAhead = forward > 0 ? d->visibleItems.last()->pageNumber() + 1 : d->visibleItems.first()->pageNumber() - 1;
+        const int firstBehind = forward > 0 ? d->visibleItems.first()->pageNumber() - 1 : d->visibleItems.last()->pageNumber() + 1;
+        const auto preloadPages = [&](int firstPage, int step, int pageCount) {
+            for (int j = 0, page = firstPage; page >= 0 && page < (int)d->items.count(); ++j, page += step) {
+                // beyond the fixed amount of pages, keep going while they are within the margin
+                if (j >= pageCount && !(continuous && expandedViewportRect.intersects(d->items[page]->croppedGeometry()))) {
+                    break;
+                }
+                slotRequestPreloadPixmap(this, d->items[page], expandedViewportRect, &requestedPixmaps);
             }
-        }
+        };
+        preloadPages(firstAhead, forward, pagesAhead);
+        preloadPages(firstBehind, -forward, pagesBehind);
     }
 
     // send requests to the document
@@ -5114,6 +5183,11 @@ void PageView::slotRequestVisiblePixmaps(int newValue)
     d->document->setVisiblePageRects(visibleRects, this);
 }
 
+RenderAheadPredictor::Statistics PageView::renderAheadStatistics() const
+{
+    return d->renderAhead.statistics();
+}
+
 void PageView::slotAutoScroll()
 {
     // the first time create the timer
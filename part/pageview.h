@@ -24,6 +24,7 @@
 #include "core/observer.h"
 #include "core/view.h"
 #include "pageviewutils.h"
+#include "renderaheadpredictor.h"
 #include <QAbstractScrollArea>
 #include <QList>
 
@@ -119,6 +120,9 @@ public:
     KActionCollection *actionCollection() const;
     QAction *toggleFormsAction() const;
 
+    // how well pages are rendered ahead of the user, for tuning
+    RenderAheadPredictor::Statistics renderAheadStatistics() const;
+
     int contentAreaWidth() const;
     int contentAreaHeight() const;
     QPoint contentAreaPosition() const;
@@ -262,6 +266,9 @@ private:
 
     void createAnnotationsVideoWidgets(PageViewItem *item, const QList<Okular::Annotation *> &annotations);
 
+    // create the item of a page and its form and video widgets, returns whether there are form widgets
+    bool createItem(const Okular::Page *page, bool allowfillforms);
+
     // Update speed of animated smooth scroll transitions
     void updateSmoothScrollAnimationSpeed();
 
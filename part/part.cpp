@@ -127,6 +127,7 @@
 #include "thumbnaillist.h"
 #include "toc.h"
 
+#include <algorithm>
 #include <memory>
 #include <type_traits>
 
@@ -363,6 +364,8 @@ Part::Part(QObject *parent, const QVariantList &args)
     connect(m_document, &Document::linkPresentation, this, &Part::slotShowPresentation);
     connect(m_document, &Document::linkEndPresentation, this, &Part::slotHidePresentation);
     connect(m_document, &Document::openUrl, this, &Part::openUrlFromDocument);
+    connect(m_document, &Document::documentOpened, this, &Part::documentOpened);
+    connect(m_document, &Document::openFinished, this, &Part::updateContentMessages);
     connect(m_document->bookmarkManager(), &BookmarkManager::openUrl, this, &Part::openUrlFromBookmarks);
     connect(m_document, &Document::close, this, &Part::close);
     connect(m_document, &Document::requestPrint, this, &Part::slotPrint);
@@ -1103,6 +1106,11 @@ bool Part::activateTabIfAlreadyOpenFile() const
     return Okular::Settings::self()->switchToTabIfOpen();
 }
 
+void Part::setInBackground(bool background)
+{
+    m_document->setInBackground(background);
+}
+
 void Part::setModified(bool modified)
 {
     KParts::ReadWritePart::setModified(modified);
@@ -1303,6 +1311,44 @@ QString Part::documentMetaData(const QString &metaData) const
     return info.get(metaData);
 }
 
+QVariantMap Part::memoryStatistics() const
+{
+    const Okular::MemoryStatistics statistics = m_document->memoryStatistics();
+
+    QVariantMap observers;
+    for (const Okular::MemoryStatistics::ObserverMemory &memory : statistics.observers) {
+        QString name = QStringLiteral("other");
+        if (memory.observer == m_pageView.data()) {
+            name = QStringLiteral("pageView");
+        } else if (memory.observer == m_thumbnailList.data()) {
+            name = QStringLiteral("thumbnails");
+        } else if (memory.observer == m_presentationWidget.data()) {
+            name = QStringLiteral("presentation");
+        }
+        QVariantMap observer = observers.value(name).toMap();
+        observer[QStringLiteral("pixmapBytes")] = observer.value(QStringLiteral("pixmapBytes")).toULongLong() + memory.pixmapBytes;
+        observer[QStringLiteral("tileBytes")] = observer.value(QStringLiteral("tileBytes")).toULongLong() + memory.tileBytes;
+        observers[name] = observer;
+    }
+
+    QVariantMap generatorCaches;
+    for (auto it = statistics.generatorCaches.cbegin(); it != statistics.generatorCaches.cend(); ++it) {
+        generatorCaches.insert(it.key(), it.value());
+    }
+
+    return QVariantMap {
+        {QStringLiteral("observers"), observers},
+        {QStringLiteral("textPages"), statistics.textPages},
+        {QStringLiteral("textPageBytes"), statistics.textPageBytes},
+        {QStringLiteral("generatorCaches"), generatorCaches},
+        {QStringLiteral("queuedRequests"), statistics.queuedRequests},
+        {QStringLiteral("executingRequests"), statistics.executingRequests},
+        {QStringLiteral("generator"), statistics.generatorName},
+        {QStringLiteral("renderedPixmaps"), statistics.renderedPixmaps},
+        {QStringLiteral("averageRenderTime"), statistics.averageRenderTime},
+    };
+}
+
 bool Part::slotImportPSFile()
 {
     QString app = QStandardPaths::findExecutable(QStringLiteral("ps2pdf"));
@@ -1559,6 +1605,14 @@ bool Part::openFile()
         mimes << pathMime;
     }
 
+    // the rest happens in documentOpened()
+    if (canOpenAsynchronously(mimes)) {
+        m_openingAsynchronously = true;
+        m_asyncOpenMimes = mimes;
+        openNextMimeAsynchronously();
+        return true;
+    }
+
     QMimeType mime;
     Document::OpenResult openResult = Document::OpenError;
     bool isCompressedFile = false;
@@ -1567,43 +1621,81 @@ bool Part::openFile()
         openResult = doOpenFile(mime, fileNameToOpen, &isCompressedFile);
     }
 
-    bool canSearch = m_document->supportsSearching();
-    Q_EMIT mimeTypeChanged(mime);
+    return finishOpenFile(mime, fileNameToOpen, isCompressedFile, openResult);
+}
 
-    // update one-time actions
-    const bool ok = openResult == Document::OpenSuccess;
-    Q_EMIT enableCloseAction(ok);
-    m_find->setEnabled(ok && canSearch);
-    m_findNext->setEnabled(ok && canSearch);
-    m_findPrev->setEnabled(ok && canSearch);
-    if (m_save) {
-        m_save->setEnabled(ok && !(isstdin || mime.inherits(QStringLiteral("inode/directory"))));
+bool Part::canOpenAsynchronously(const QList<QMimeType> &mimes) const
+{
+    // the shell takes the result later, the reloads, swaps, archives and
+    // compressed files go through doOpenFile()
+    if (m_embedMode != NativeShellMode || m_swapInsteadOfOpening || m_isReloading || m_viewportDirty.pageNumber != -1) {
+        return false;
     }
-    if (m_saveAs) {
-        m_saveAs->setEnabled(ok && !(isstdin || mime.inherits(QStringLiteral("inode/directory"))));
+    return std::ranges::none_of(mimes, [](const QMimeType &mime) {
+        return mime.inherits(QStringLiteral("application/vnd.kde.okular-archive")) || compressionTypeFor(mime.name()) != KCompressionDevice::None;
+    });
+}
+
+void Part::openNextMimeAsynchronously()
+{
+    m_asyncOpenMime = m_asyncOpenMimes.takeFirst();
+    isDocumentArchive = false;
+    m_documentOpenWithPassword = false;
+    m_document->openDocumentAsync(localFilePath(), url(), m_asyncOpenMime);
+}
+
+void Part::documentOpened(Document::OpenResult openResult)
+{
+    if (!m_openingAsynchronously) {
+        return;
     }
-    Q_EMIT enablePrintAction(ok && m_document->printingSupport() != Okular::Document::NoPrinting);
-    m_printPreview->setEnabled(ok && m_document->printingSupport() != Okular::Document::NoPrinting);
-    m_showProperties->setEnabled(ok);
-    if (m_openContainingFolder) {
-        m_openContainingFolder->setEnabled(ok);
+
+    if (openResult == Document::OpenError && !m_asyncOpenMimes.isEmpty()) {
+        openNextMimeAsynchronously();
+        return;
     }
-    bool hasEmbeddedFiles = ok && m_document->embeddedFiles() && m_document->embeddedFiles()->count() > 0;
-    if (m_showEmbeddedFiles) {
-        m_showEmbeddedFiles->setEnabled(hasEmbeddedFiles);
+    m_openingAsynchronously = false;
+    m_asyncOpenMimes.clear();
+
+    const QString fileNameToOpen = localFilePath();
+    bool isCompressedFile = false;
+    if (openResult == Document::OpenNeedsPassword) {
+        // asking for the password, from the wallet too, is left to the synchronous opening
+        openResult = doOpenFile(m_asyncOpenMime, fileNameToOpen, &isCompressedFile);
+    } else if (openResult == Document::OpenSuccess) {
+        m_fileLastModified = QFileInfo(fileNameToOpen).lastModified();
+        m_warnedAboutModifyingUnsaveableDocument = false;
     }
-    m_topMessage->setVisible(hasEmbeddedFiles && Okular::Settings::showEmbeddedContentMessages());
-    m_migrationMessage->setVisible(m_document->isDocdataMigrationNeeded());
 
+    const QUrl openedUrl = url();
+    if (finishOpenFile(m_asyncOpenMime, fileNameToOpen, isCompressedFile, openResult)) {
+        setWindowTitleFromDocument();
+        return;
+    }
+
+    // what openUrl() does when openFile() fails
+    if (m_urlWithFragment.isValid() && m_urlWithFragment.isLocalFile()) {
+        tryOpeningUrlWithFragmentAsName();
+        return;
+    }
+    resetStartArguments();
+    /* TRANSLATORS: Adding the reason (%2) why the opening failed (if any). */
+    QString errorMessageString = i18n("Could not open %1. %2", openedUrl.toDisplayString(), QStringLiteral("\n%1").arg(m_document->openError()));
+    KMessageBox::error(widget(), errorMessageString);
+    Q_EMIT openUrlFailed(openedUrl);
+}
+
+void Part::updateContentMessages()
+{
     // Warn the user that XFA forms are not supported yet (NOTE: poppler generator only)
-    if (ok && Okular::Settings::showEmbeddedContentMessages() && m_document->metaData(QStringLiteral("HasUnsupportedXfaForm")).toBool() == true) {
+    if (Okular::Settings::showEmbeddedContentMessages() && m_document->metaData(QStringLiteral("HasUnsupportedXfaForm")).toBool() == true) {
         m_formsMessage->setText(i18n("This document has XFA forms, which are currently <b>unsupported</b>."));
         m_formsMessage->setIcon(QIcon::fromTheme(QStringLiteral("dialog-warning")));
         m_formsMessage->setMessageType(KMessageWidget::Warning);
         m_formsMessage->setVisible(true);
     }
     // m_pageView->toggleFormsAction() may be null on dummy mode
-    else if (ok && Okular::Settings::showEmbeddedContentMessages() && m_pageView->toggleFormsAction() && m_pageView->toggleFormsAction()->isEnabled()) {
+    else if (Okular::Settings::showEmbeddedContentMessages() && m_pageView->toggleFormsAction() && m_pageView->toggleFormsAction()->isEnabled()) {
         m_formsMessage->setText(i18n("This document has forms. Click on the button to interact with them, or use View -> Show Forms."));
         m_formsMessage->setMessageType(KMessageWidget::Information);
         m_formsMessage->setVisible(true);
@@ -1611,59 +1703,98 @@ bool Part::openFile()
         m_formsMessage->setVisible(false);
     }
 
-    if (ok) {
-        auto refreshMessage = [this]() {
-            KMessageWidget::MessageType messageType;
-            QString message;
+    auto refreshMessage = [this]() {
+        KMessageWidget::MessageType messageType;
+        QString message;
 
-            std::tie(messageType, message) = SignatureGuiUtils::documentSignatureMessageWidgetText(m_document);
+        std::tie(messageType, message) = SignatureGuiUtils::documentSignatureMessageWidgetText(m_document);
 
-            if (!message.isEmpty()) {
-                if (m_embedMode == PrintPreviewMode) {
-                    if (Okular::Settings::showEmbeddedContentMessages()) {
-                        m_signatureMessage->setText(i18n("All editing and interactive features for this document are disabled. Please save a copy and reopen to edit this document."));
-                        m_signatureMessage->setVisible(true);
-                    }
-                } else {
-                    if (Okular::Settings::showEmbeddedContentMessages() || messageType > KMessageWidget::Information) {
-                        m_signatureMessage->setMessageType(messageType);
-                        m_signatureMessage->setText(message);
-                        m_signatureMessage->setVisible(true);
-                    }
+        if (!message.isEmpty()) {
+            if (m_embedMode == PrintPreviewMode) {
+                if (Okular::Settings::showEmbeddedContentMessages()) {
+                    m_signatureMessage->setText(i18n("All editing and interactive features for this document are disabled. Please save a copy and reopen to edit this document."));
+                    m_signatureMessage->setVisible(true);
                 }
-            }
-        };
-        refreshMessage();
-        for (uint i = 0; i < m_document->pages(); i++) {
-            const QList<Okular::FormField *> formFields = m_document->page(i)->formFields();
-            for (Okular::FormField *f : formFields) {
-                if (f->type() == Okular::FormField::FormSignature) {
-                    static_cast<Okular::FormFieldSignature *>(f)->subscribeUpdates(refreshMessage);
+            } else {
+                if (Okular::Settings::showEmbeddedContentMessages() || messageType > KMessageWidget::Information) {
+                    m_signatureMessage->setMessageType(messageType);
+                    m_signatureMessage->setText(message);
+                    m_signatureMessage->setVisible(true);
                 }
             }
         }
+    };
+    refreshMessage();
+    for (uint i = 0; i < m_document->pages(); i++) {
+        const QList<Okular::FormField *> formFields = m_document->page(i)->formFields();
+        for (Okular::FormField *f : formFields) {
+            if (f->type() == Okular::FormField::FormSignature) {
+                static_cast<Okular::FormFieldSignature *>(f)->subscribeUpdates(refreshMessage);
+            }
+        }
+    }
 
-        m_printMightDifferMessage->setVisible(false);
+    m_printMightDifferMessage->setVisible(false);
 
-        QList<Document::DocumentAdditionalActionType> actionTypes = m_document->documentAdditionalActionTypes();
-        if (actionTypes.contains(Document::PrintDocumentStart) || actionTypes.contains(Document::PrintDocumentFinish)) {
-            m_printMightDifferMessage->setVisible(true);
-        }
+    QList<Document::DocumentAdditionalActionType> actionTypes = m_document->documentAdditionalActionTypes();
+    if (actionTypes.contains(Document::PrintDocumentStart) || actionTypes.contains(Document::PrintDocumentFinish)) {
+        m_printMightDifferMessage->setVisible(true);
+    }
 
-        for (uint i = 0; (i < m_document->pages()) && m_printMightDifferMessage->isHidden(); i++) {
-            const auto pageAnnots = m_document->page(i)->annotations();
-            for (auto *annot : pageAnnots) {
-                if (annot->flags() & Okular::Annotation::DenyPrint && !(annot->flags() & Okular::Annotation::Hidden)) {
-                    m_printMightDifferMessage->setVisible(true);
-                    break;
-                }
-                if (!(annot->flags() & Okular::Annotation::DenyPrint) && (annot->flags() & Okular::Annotation::Hidden)) {
-                    m_printMightDifferMessage->setVisible(true);
-                    break;
-                }
+    for (uint i = 0; (i < m_document->pages()) && m_printMightDifferMessage->isHidden(); i++) {
+        const auto pageAnnots = m_document->page(i)->annotations();
+        for (auto *annot : pageAnnots) {
+            if (annot->flags() & Okular::Annotation::DenyPrint && !(annot->flags() & Okular::Annotation::Hidden)) {
+                m_printMightDifferMessage->setVisible(true);
+                break;
+            }
+            if (!(annot->flags() & Okular::Annotation::DenyPrint) && (annot->flags() & Okular::Annotation::Hidden)) {
+                m_printMightDifferMessage->setVisible(true);
+                break;
             }
         }
     }
+}
+
+bool Part::finishOpenFile(const QMimeType &mime, const QString &fileNameToOpen, bool isCompressedFile, Document::OpenResult openResult)
+{
+    const bool isstdin = url().isLocalFile() && url().fileName() == QLatin1String("-");
+    bool canSearch = m_document->supportsSearching();
+    Q_EMIT mimeTypeChanged(mime);
+
+    // update one-time actions
+    const bool ok = openResult == Document::OpenSuccess;
+    Q_EMIT enableCloseAction(ok);
+    m_find->setEnabled(ok && canSearch);
+    m_findNext->setEnabled(ok && canSearch);
+    m_findPrev->setEnabled(ok && canSearch);
+    if (m_save) {
+        m_save->setEnabled(ok && !(isstdin || mime.inherits(QStringLiteral("inode/directory"))));
+    }
+    if (m_saveAs) {
+        m_saveAs->setEnabled(ok && !(isstdin || mime.inherits(QStringLiteral("inode/directory"))));
+    }
+    Q_EMIT enablePrintAction(ok && m_document->printingSupport() != Okular::Document::NoPrinting);
+    m_printPreview->setEnabled(ok && m_document->printingSupport() != Okular::Document::NoPrinting);
+    m_showProperties->setEnabled(ok);
+    if (m_openContainingFolder) {
+        m_openContainingFolder->setEnabled(ok);
+    }
+    bool hasEmbeddedFiles = ok && m_document->embeddedFiles() && m_document->embeddedFiles()->count() > 0;
+    if (m_showEmbeddedFiles) {
+        m_showEmbeddedFiles->setEnabled(hasEmbeddedFiles);
+    }
+    m_topMessage->setVisible(hasEmbeddedFiles && Okular::Settings::showEmbeddedContentMessages());
+    m_migrationMessage->setVisible(m_document->isDocdataMigrationNeeded());
+
+    // an asynchronous opening restores the annotations and forms after this, see openFinished()
+    if (!ok) {
+        m_formsMessage->setVisible(false);
+    } else if (!m_document->isOpening()) {
+        updateContentMessages();
+    } else {
+        m_printMightDifferMessage->setVisible(false);
+    }
 
     if (m_showPresentation) {
         m_showPresentation->setEnabled(ok);
@@ -1974,6 +2105,8 @@ bool Part::closeUrl(bool promptToSave)
         factory()->removeClient(m_generatorGuiClient);
     }
     m_generatorGuiClient = nullptr;
+    m_openingAsynchronously = false;
+    m_asyncOpenMimes.clear();
     m_document->closeDocument();
     m_fileLastModified = QDateTime();
     updateViewActions();
@@ -3039,7 +3172,7 @@ void Part::slotPreferences()
 KConfigDialog *Part::realSlotPreferences()
 {
     // Create dialog
-    PreferencesDialog *dialog = new PreferencesDialog(m_pageView, Okular::Settings::self(), m_embedMode, m_document->editorCommandOverride());
+    PreferencesDialog *dialog = new PreferencesDialog(m_pageView, Okular::Settings::self(), m_embedMode, m_document->editorCommandOverride(), this);
     m_document->fillConfigDialog(dialog);
 
     dialog->setAttribute(Qt::WA_DeleteOnClose);
@@ -3063,7 +3196,7 @@ void Part::slotSetChangeColors(bool active)
 void Part::slotAccessibilityPreferences()
 {
     // Create dialog
-    PreferencesDialog *dialog = new PreferencesDialog(m_pageView, Okular::Settings::self(), m_embedMode, m_document->editorCommandOverride());
+    PreferencesDialog *dialog = new PreferencesDialog(m_pageView, Okular::Settings::self(), m_embedMode, m_document->editorCommandOverride(), this);
     m_document->fillConfigDialog(dialog);
 
     dialog->setAttribute(Qt::WA_DeleteOnClose);
@@ -3076,7 +3209,7 @@ void Part::slotAccessibilityPreferences()
 void Part::slotAnnotationPreferences()
 {
     // Create dialog
-    PreferencesDialog *dialog = new PreferencesDialog(m_pageView, Okular::Settings::self(), m_embedMode, m_document->editorCommandOverride());
+    PreferencesDialog *dialog = new PreferencesDialog(m_pageView, Okular::Settings::self(), m_embedMode, m_document->editorCommandOverride(), this);
     m_document->fillConfigDialog(dialog);
 
     dialog->setAttribute(Qt::WA_DeleteOnClose);
@@ -151,6 +151,11 @@ public:
     bool openNewFilesInTabs() const override;
     QWidget *getSideContainer() const override;
     Q_INVOKABLE bool activateTabIfAlreadyOpenFile() const;
+    /**
+     * Puts the document in the background when the part is in a tab that
+     * is not shown, see Okular::Document::setInBackground().
+     */
+    Q_INVOKABLE void setInBackground(bool background);
 
     void setModified(bool modified) override;
 
@@ -167,6 +172,12 @@ public Q_SLOTS: // dbus
     Q_SCRIPTABLE uint currentPage();
     Q_SCRIPTABLE QString currentDocument();
     Q_SCRIPTABLE QString documentMetaData(const QString &metaData) const;
+    /**
+     * What the document holds in memory, see Okular::Document::memoryStatistics().
+     * The pixmaps are under "observers", by view: "pageView", "thumbnails",
+     * "presentation" or "other".
+     */
+    Q_SCRIPTABLE QVariantMap memoryStatistics() const;
     Q_SCRIPTABLE void slotPreferences();
     Q_SCRIPTABLE void slotFind();
     Q_SCRIPTABLE void slotPrintPreview();
@@ -202,6 +213,12 @@ Q_SIGNALS:
      * \param pageNumber page to show (1-indexed)
      */
     void requestOpenNewlySignedFile(const QString &path, int pageNumber);
+    /**
+     * Emitted when the document openUrl() started opening asynchronously
+     * failed to open, after the user was told.
+     * \param url the url that failed to open
+     */
+    void openUrlFailed(const QUrl &url);
 
 protected:
     // reimplemented from KParts::ReadWritePart
@@ -303,6 +320,12 @@ private:
     KMainWindow *findMainWindow();
     bool eventFilter(QObject *watched, QEvent *event) override;
     Document::OpenResult doOpenFile(const QMimeType &mime, const QString &fileNameToOpen, bool *isCompressedFile);
+    bool canOpenAsynchronously(const QList<QMimeType> &mimes) const;
+    void openNextMimeAsynchronously();
+    void documentOpened(Document::OpenResult openResult);
+    bool finishOpenFile(const QMimeType &mime, const QString &fileNameToOpen, bool isCompressedFile, Document::OpenResult openResult);
+    /** Shows the messages about the forms, signatures and annotations of the opened document. */
+    void updateContentMessages();
     bool openUrl(const QUrl &url, bool swapInsteadOfOpening);
 
     void setupViewerActions();
@@ -357,6 +380,10 @@ private:
     bool m_documentOpenWithPassword;
     bool m_swapInsteadOfOpening; // if set, the next open operation will replace the backing file (used when reloading just saved files)
     bool m_warnedAboutModifyingUnsaveableDocument = false;
+    // the mime types left to try and the one tried by the asynchronous opening of openFile()
+    bool m_openingAsynchronously = false;
+    QList<QMimeType> m_asyncOpenMimes;
+    QMimeType m_asyncOpenMime;
 
     // main widgets
     Sidebar *m_sidebar;
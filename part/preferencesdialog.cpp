@@ -20,13 +20,13 @@
 
 #include <QLabel>
 
-PreferencesDialog::PreferencesDialog(QWidget *parent, KConfigSkeleton *skeleton, Okular::EmbedMode embedMode, const QString &editCmd)
+PreferencesDialog::PreferencesDialog(QWidget *parent, KConfigSkeleton *skeleton, Okular::EmbedMode embedMode, const QString &editCmd, Okular::Part *part)
     : KConfigDialog(parent, QStringLiteral("preferences"), skeleton)
 {
     setWindowModality(Qt::ApplicationModal);
 
     m_general = new DlgGeneral(this, embedMode);
-    m_performance = new DlgPerformance(this);
+    m_performance = new DlgPerformance(this, part);
     m_accessibility = new DlgAccessibility(this);
     m_accessibilityPage = nullptr;
     m_presentation = nullptr;
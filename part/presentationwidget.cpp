@@ -63,6 +63,7 @@
 #include "core/movie.h"
 #include "core/page.h"
 #include "drawingtoolactions.h"
+#include "fadetransitionrenderer.h"
 #include "gui/debug_ui.h"
 #include "gui/guiutils.h"
 #include "gui/pagepainter.h"
@@ -148,6 +149,8 @@ PresentationWidget::PresentationWidget(QWidget *parent, Okular::Document *doc, D
     , m_drawingEngine(nullptr)
     , m_screenInhibitCookie(0)
     , m_sleepInhibitFd(-1)
+    , m_fadeRenderer(new FadeTransitionRenderer)
+    , m_fadeFrameShown(false)
     , m_parentWidget(parent)
     , m_document(doc)
     , m_frameIndex(-1)
@@ -311,6 +314,7 @@ PresentationWidget::~PresentationWidget()
     }
 
     delete m_drawingEngine;
+    delete m_fadeRenderer;
 
     // delete frames
     qDeleteAll(m_frames);
@@ -322,20 +326,26 @@ void PresentationWidget::notifySetup(const QList<Okular::Page *> &pageSet, int s
 {
     // same document, nothing to change - here we assume the document sets up
     // us with the whole document set as first notifySetup()
-    if (!(setupFlags & Okular::DocumentObserver::DocumentChanged)) {
+    const bool pagesAppended = (setupFlags & Okular::DocumentObserver::PagesAppended) && !(setupFlags & Okular::DocumentObserver::DocumentChanged);
+    if (!(setupFlags & Okular::DocumentObserver::DocumentChanged) && !pagesAppended) {
         return;
     }
 
-    // delete previous frames (if any (shouldn't be))
-    qDeleteAll(m_frames);
-    if (!m_frames.isEmpty()) {
-        qCWarning(OkularUiDebug) << "Frames setup changed while a Presentation is in progress.";
+    // a document still loading keeps the frames of its first pages
+    if (!pagesAppended) {
+        // delete previous frames (if any (shouldn't be))
+        m_renderedSlides.clear();
+        qDeleteAll(m_frames);
+        if (!m_frames.isEmpty()) {
+            qCWarning(OkularUiDebug) << "Frames setup changed while a Presentation is in progress.";
+        }
+        m_frames.clear();
     }
-    m_frames.clear();
 
     // create the new frames
     float screenRatio = (float)m_height / (float)m_width;
-    for (const Okular::Page *page : pageSet) {
+    for (int i = m_frames.count(); i < pageSet.count(); ++i) {
+        const Okular::Page *page = pageSet[i];
         PresentationFrame *frame = new PresentationFrame(page);
         const QList<Okular::Annotation *> annotations = page->annotations();
         for (Okular::Annotation *a : annotations) {
@@ -397,9 +407,19 @@ void PresentationWidget::notifyPageChanged(int pageNumber, int changedFlags)
         return;
     }
 
+    if (!(changedFlags & (DocumentObserver::Pixmap | DocumentObserver::Annotations | DocumentObserver::Highlights))) {
+        return;
+    }
+
+    // the composed slide is outdated
+    m_renderedSlides.remove(pageNumber);
+
     // check if it's the last requested pixmap. if so update the widget.
-    if ((changedFlags & (DocumentObserver::Pixmap | DocumentObserver::Annotations | DocumentObserver::Highlights)) && pageNumber == m_frameIndex) {
+    if (pageNumber == m_frameIndex) {
         generatePage(changedFlags & (DocumentObserver::Annotations | DocumentObserver::Highlights));
+    } else if (isInPreloadWindow(pageNumber)) {
+        // a preloaded page is ready, compose it now so showing it later is only a blit
+        precomposeSlide(pageNumber);
     }
 }
 
@@ -450,9 +470,21 @@ void PresentationWidget::notifyCurrentPageChanged(int previousPage, int currentP
         m_pagesEdit->setText(QString::number(m_frameIndex + 1));
         m_pagesEdit->blockSignals(signalsBlocked);
 
+        // forget the composed slides we moved away from
+        for (auto it = m_renderedSlides.begin(); it != m_renderedSlides.end();) {
+            if (isInPreloadWindow(it.key())) {
+                ++it;
+            } else {
+                it = m_renderedSlides.erase(it);
+            }
+        }
+
         // if pixmap not inside the Okular::Page we request it and wait for
         // notifyPixmapChanged call or else we can proceed to pixmap generation
-        if (!frame->page->hasPixmap(this, ceil(pixW * devicePixelRatioF()), ceil(pixH * devicePixelRatioF()))) {
+        if (m_renderedSlides.contains(m_frameIndex)) {
+            generatePage();
+            requestPixmaps();
+        } else if (!frame->page->hasPixmap(this, ceil(pixW * devicePixelRatioF()), ceil(pixH * devicePixelRatioF()))) {
             requestPixmaps();
         } else {
             // make the background pixmap
@@ -489,13 +521,30 @@ void PresentationWidget::notifyCurrentPageChanged(int previousPage, int currentP
 
 bool PresentationWidget::canUnloadPixmap(int pageNumber) const
 {
-    if (Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Low || Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Normal) {
+    if (Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Low) {
         // can unload all pixmaps except for the currently visible one
         return pageNumber != m_frameIndex;
     } else {
-        // can unload all pixmaps except for the currently visible one, previous and next
-        return qAbs(pageNumber - m_frameIndex) <= 1;
+        // can unload all pixmaps except for the currently visible one, the previous and the preloaded ones
+        return !isInPreloadWindow(pageNumber);
+    }
+}
+
+int PresentationWidget::preloadWindow() const
+{
+    if (Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Low) {
+        return 0;
+    }
+    return Okular::Settings::slidesPreloadPages();
+}
+
+bool PresentationWidget::isInPreloadWindow(int page) const
+{
+    if (m_frameIndex < 0) {
+        return false;
     }
+    const int previousPages = preloadWindow() > 0 ? 1 : 0;
+    return page >= m_frameIndex - previousPages && page <= m_frameIndex + preloadWindow();
 }
 
 void PresentationWidget::setupActions()
@@ -846,6 +895,9 @@ void PresentationWidget::paintEvent(QPaintEvent *pe)
         return;
     }
 
+    // while fading the frames are composed off screen by m_fadeRenderer
+    const bool fadeFrameShown = m_fadeFrameShown && m_transitionTimer->isActive();
+
     // blit the pixmap to the screen
     QPainter painter(this);
     for (const QRect &r : pe->region()) {
@@ -861,7 +913,11 @@ void PresentationWidget::paintEvent(QPaintEvent *pe)
             QPainter pixPainter(&backPixmap);
 
             // first draw the background on the backbuffer
-            pixPainter.drawPixmap(QPoint(0, 0), m_lastRenderedPixmap, dR);
+            if (fadeFrameShown) {
+                pixPainter.drawImage(QPoint(0, 0), m_fadeRenderer->frame(), dR);
+            } else {
+                pixPainter.drawPixmap(QPoint(0, 0), m_lastRenderedPixmap, dR);
+            }
 
             // then blend the overlay (a piece of) over the background
             QRect ovr = m_overlayGeometry.intersected(r);
@@ -874,8 +930,12 @@ void PresentationWidget::paintEvent(QPaintEvent *pe)
             painter.drawPixmap(r.topLeft(), backPixmap, dBackPixmapRect);
         } else {
 #endif
-            // copy the rendered pixmap to the screen
-            painter.drawPixmap(r.topLeft(), m_lastRenderedPixmap, dR);
+            // copy the rendered pixmap (or the fade frame) to the screen
+            if (fadeFrameShown) {
+                painter.drawImage(r.topLeft(), m_fadeRenderer->frame(), dR);
+            } else {
+                painter.drawPixmap(r.topLeft(), m_lastRenderedPixmap, dR);
+            }
         }
     }
 
@@ -941,6 +1001,7 @@ void PresentationWidget::resizeEvent(QResizeEvent *re)
     if (m_transitionTimer->isActive()) {
         m_transitionTimer->stop();
     }
+    m_fadeFrameShown = false;
 
     generatePage(true /* no transitions */);
     // END Content area
@@ -1082,6 +1143,9 @@ void PresentationWidget::changePage(int newPage)
         return;
     }
 
+    // a fade in progress is about the slide being left
+    m_fadeFrameShown = false;
+
     // switch to newPage
     m_document->setViewportPage(newPage, this);
 
@@ -1092,27 +1156,23 @@ void PresentationWidget::changePage(int newPage)
 
 void PresentationWidget::generatePage(bool disableTransition)
 {
-    if (m_lastRenderedPixmap.isNull()) {
+    // QPixmap is implicitly shared, the previous page keeps the old contents
+    m_previousPagePixmap = m_lastRenderedPixmap;
+
+    if (m_frameIndex >= 0 && m_frameIndex < (int)m_document->pages()) {
+        // generate a normal pixmap with extended margin filling
+        m_lastRenderedPixmap = renderedSlide(m_frameIndex);
+    } else {
         qreal dpr = devicePixelRatioF();
         m_lastRenderedPixmap = QPixmap(m_width * dpr, m_height * dpr);
         m_lastRenderedPixmap.setDevicePixelRatio(dpr);
-        m_previousPagePixmap = QPixmap();
-    } else {
-        m_previousPagePixmap = m_lastRenderedPixmap;
-    }
 
-    // opens the painter over the pixmap
-    QPainter pixmapPainter;
-    pixmapPainter.begin(&m_lastRenderedPixmap);
-    // generate welcome page
-    if (m_frameIndex == -1) {
-        generateIntroPage(pixmapPainter);
-    }
-    // generate a normal pixmap with extended margin filling
-    if (m_frameIndex >= 0 && m_frameIndex < (int)m_document->pages()) {
-        generateContentsPage(m_frameIndex, pixmapPainter);
+        // generate welcome page
+        if (m_frameIndex == -1) {
+            QPainter pixmapPainter(&m_lastRenderedPixmap);
+            generateIntroPage(pixmapPainter);
+        }
     }
-    pixmapPainter.end();
 
     // generate the top-right corner overlay
 #ifdef ENABLE_PROGRESS_OVERLAY
@@ -1219,6 +1279,46 @@ void PresentationWidget::generateContentsPage(int pageNum, QPainter &p)
     }
 }
 
+QPixmap PresentationWidget::renderSlide(int pageNum)
+{
+    const qreal dpr = devicePixelRatioF();
+    QPixmap slide(m_width * dpr, m_height * dpr);
+    slide.setDevicePixelRatio(dpr);
+
+    QPainter p(&slide);
+    generateContentsPage(pageNum, p);
+    p.end();
+    return slide;
+}
+
+QPixmap PresentationWidget::renderedSlide(int pageNum)
+{
+    auto it = m_renderedSlides.constFind(pageNum);
+    if (it != m_renderedSlides.constEnd()) {
+        return *it;
+    }
+
+    const QPixmap slide = renderSlide(pageNum);
+    // only keep it if it is complete, otherwise it is composed again when the pixmap arrives
+    const QRect &geom = m_frames[pageNum]->geometry;
+    if (m_frames[pageNum]->page->hasPixmap(this, ceil(geom.width() * devicePixelRatioF()), ceil(geom.height() * devicePixelRatioF()))) {
+        m_renderedSlides.insert(pageNum, slide);
+    }
+    return slide;
+}
+
+void PresentationWidget::precomposeSlide(int pageNum)
+{
+    if (pageNum < 0 || pageNum >= m_frames.count() || m_width <= 0 || m_renderedSlides.contains(pageNum)) {
+        return;
+    }
+
+    const QRect &geom = m_frames[pageNum]->geometry;
+    if (m_frames[pageNum]->page->hasPixmap(this, ceil(geom.width() * devicePixelRatioF()), ceil(geom.height() * devicePixelRatioF()))) {
+        m_renderedSlides.insert(pageNum, renderSlide(pageNum));
+    }
+}
+
 // from Arthur - Qt4 - (is defined elsewhere as 'qt_div_255' to not break final compilation)
 inline int qt_div255(int x)
 {
@@ -1455,12 +1555,15 @@ void PresentationWidget::requestPixmaps()
     QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
     // request the pixmap
     QList<Okular::PixmapRequest *> requests;
-    requests.push_back(new Okular::PixmapRequest(this, m_frameIndex, pixW, pixH, dpr, PRESENTATION_PRIO, Okular::PixmapRequest::NoFeature));
+    // an already composed slide doesn't need its page pixmap anymore
+    if (!m_renderedSlides.contains(m_frameIndex)) {
+        requests.push_back(new Okular::PixmapRequest(this, m_frameIndex, pixW, pixH, dpr, PRESENTATION_PRIO, Okular::PixmapRequest::NoFeature));
+    }
     // restore cursor
     QApplication::restoreOverrideCursor();
-    // ask for next and previous page if not in low memory usage setting
+    // ask for the upcoming pages and the previous one if not in low memory usage setting
     if (Okular::SettingsCore::memoryLevel() != Okular::SettingsCore::EnumMemoryLevel::Low) {
-        int pagesToPreload = 1;
+        int pagesToPreload = std::max(preloadWindow(), 1);
 
         // If greedy, preload everything
         if (Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Greedy) {
@@ -1478,11 +1581,13 @@ void PresentationWidget::requestPixmaps()
                 pixH = nextFrame->geometry.height();
                 if (!nextFrame->page->hasPixmap(this, pixW, pixH)) {
                     requests.push_back(new Okular::PixmapRequest(this, tailRequest, pixW, pixH, dpr, PRESENTATION_PRELOAD_PRIO, requestFeatures));
+                } else if (j <= preloadWindow()) {
+                    precomposeSlide(tailRequest);
                 }
             }
 
             int headRequest = m_frameIndex - j;
-            if (headRequest >= 0) {
+            if (headRequest >= 0 && (j == 1 || Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Greedy)) {
                 PresentationFrame *prevFrame = m_frames[headRequest];
                 pixW = prevFrame->geometry.width();
                 pixH = prevFrame->geometry.height();
@@ -1522,6 +1627,7 @@ void PresentationWidget::slotNextPage()
 #endif
         if (m_transitionTimer->isActive()) {
             m_transitionTimer->stop();
+            m_fadeFrameShown = false;
             m_lastRenderedPixmap = m_currentPagePixmap;
             update();
         }
@@ -1546,6 +1652,7 @@ void PresentationWidget::slotPrevPage()
 #endif
         if (m_transitionTimer->isActive()) {
             m_transitionTimer->stop();
+            m_fadeFrameShown = false;
             m_lastRenderedPixmap = m_currentPagePixmap;
             update();
         }
@@ -1573,21 +1680,18 @@ void PresentationWidget::slotTransitionStep()
 {
     switch (m_currentTransition.type()) {
     case Okular::PageTransition::Fade: {
-        QPainter pixmapPainter;
-        m_currentPixmapOpacity += 1.0 / m_transitionSteps;
-        m_lastRenderedPixmap = QPixmap(m_lastRenderedPixmap.size());
-        m_lastRenderedPixmap.setDevicePixelRatio(devicePixelRatioF());
-        m_lastRenderedPixmap.fill(Qt::transparent);
-        pixmapPainter.begin(&m_lastRenderedPixmap);
-        pixmapPainter.setCompositionMode(QPainter::CompositionMode_Source);
-        pixmapPainter.setOpacity(1 - m_currentPixmapOpacity);
-        pixmapPainter.drawPixmap(0, 0, m_previousPagePixmap);
-        pixmapPainter.setOpacity(m_currentPixmapOpacity);
-        pixmapPainter.drawPixmap(0, 0, m_currentPagePixmap);
+        // the worker is still composing the frame, try again at the next tick
+        if (!m_fadeRenderer->takeFrame()) {
+            break;
+        }
         update();
         if (m_currentPixmapOpacity >= 1) {
+            // m_lastRenderedPixmap already is the new slide
+            m_fadeFrameShown = false;
             return;
         }
+        m_currentPixmapOpacity += 1.0 / m_transitionSteps;
+        m_fadeRenderer->requestFrame(m_currentPixmapOpacity);
     } break;
     default: {
         if (m_transitionRects.empty()) {
@@ -1673,6 +1777,7 @@ void PresentationWidget::invalidatePixmaps()
 {
     // force the regeneration of the pixmap
     m_lastRenderedPixmap = QPixmap();
+    m_renderedSlides.clear();
     if (m_frameIndex != -1) {
         // ugliness alarm!
         const_cast<Okular::Page *>(m_frames[m_frameIndex]->page)->deletePixmap(this);
@@ -1926,6 +2031,9 @@ const Okular::PageTransition PresentationWidget::defaultTransition(int type) con
 /** ONLY the TRANSITIONS GENERATION function from here on **/
 void PresentationWidget::initTransition(const Okular::PageTransition *transition)
 {
+    // only the fade below shows the frames of m_fadeRenderer
+    m_fadeFrameShown = false;
+
     // if it's just a 'replace' transition, repaint the screen
     if (transition->type() == Okular::PageTransition::Replace) {
         update();
@@ -2223,20 +2331,15 @@ void PresentationWidget::initTransition(const Okular::PageTransition *transition
 
     case Okular::PageTransition::Fade: {
         const int FADE_TRANSITION_FPS = 20;
-        const int steps = totalTime * FADE_TRANSITION_FPS;
+        const int steps = std::max<int>(totalTime * FADE_TRANSITION_FPS, 1);
         m_transitionSteps = steps;
-        QPainter pixmapPainter;
         m_currentPixmapOpacity = (double)1 / steps;
         m_transitionDelay = (int)(totalTime * 1000) / steps;
-        m_lastRenderedPixmap = QPixmap(m_lastRenderedPixmap.size());
-        m_lastRenderedPixmap.fill(Qt::transparent);
-        pixmapPainter.begin(&m_lastRenderedPixmap);
-        pixmapPainter.setCompositionMode(QPainter::CompositionMode_Source);
-        pixmapPainter.setOpacity(1 - m_currentPixmapOpacity);
-        pixmapPainter.drawPixmap(0, 0, m_previousPagePixmap);
-        pixmapPainter.setOpacity(m_currentPixmapOpacity);
-        pixmapPainter.drawPixmap(0, 0, m_currentPagePixmap);
-        pixmapPainter.end();
+        // frames are composed on a worker thread into reused buffers,
+        // the old slide stays on screen until the first one is ready
+        m_fadeRenderer->start(m_previousPagePixmap, m_currentPagePixmap);
+        m_fadeRenderer->requestFrame(m_currentPixmapOpacity);
+        m_fadeFrameShown = true;
         update();
     } break;
     // implement missing transitions (a binary raster engine needed here)
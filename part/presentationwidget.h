@@ -11,6 +11,7 @@
 #include "core/observer.h"
 #include "core/pagetransition.h"
 #include <QDomElement>
+#include <QHash>
 #include <QList>
 #include <QPixmap>
 #include <QStringList>
@@ -23,6 +24,7 @@ class QGestureEvent;
 class KActionCollection;
 class KSelectAction;
 class SmoothPathEngine;
+class FadeTransitionRenderer;
 struct PresentationFrame;
 class PresentationSearchBar;
 class DrawingToolActions;
@@ -96,6 +98,12 @@ private:
     /** @returns Configure -> Presentation -> Preferred screen */
     QScreen *defaultScreen() const;
     void requestPixmaps();
+    /** @returns how many slides after the current one are kept rendered */
+    int preloadWindow() const;
+    bool isInPreloadWindow(int page) const;
+    QPixmap renderSlide(int page);
+    QPixmap renderedSlide(int page);
+    void precomposeSlide(int page);
     /** @param newScreen must be valid. */
     void setScreen(const QScreen *newScreen);
     void inhibitPowerManagement();
@@ -110,6 +118,8 @@ private:
     int m_height;
     QPixmap m_lastRenderedPixmap;
     QPixmap m_lastRenderedOverlay;
+    // slides around the current one composed ahead of time, ready to be shown
+    QHash<int, QPixmap> m_renderedSlides;
     QRect m_overlayGeometry;
     const Okular::Action *m_pressedLink;
     bool m_handCursor;
@@ -130,6 +140,8 @@ private:
     QPixmap m_currentPagePixmap;
     QPixmap m_previousPagePixmap;
     double m_currentPixmapOpacity;
+    FadeTransitionRenderer *m_fadeRenderer;
+    bool m_fadeFrameShown;
 
     // misc stuff
     QWidget *m_parentWidget;
@@ -0,0 +1,115 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "renderaheadpredictor.h"
+
+#include <QtGlobal>
+
+#include <cmath>
+
+// margin kept ready around the viewport when not moving
+static const int basePreloadPixels = 512;
+// how long before reaching them pages should be ready when scrolling
+static const double lookAheadSeconds = 0.6;
+// never look further ahead than this many viewports, a scrollbar drag is not a reading speed
+static const int maxViewportsAhead = 4;
+// without new samples for this long the view is considered still
+static const int idleMsecs = 300;
+// samples further apart than this do not belong to the same movement
+static const int maxSampleGapMsecs = 500;
+
+RenderAheadPredictor::RenderAheadPredictor()
+    : m_lastPosition(0)
+    , m_velocity(0)
+    , m_direction(0)
+{
+}
+
+void RenderAheadPredictor::reset()
+{
+    m_lastSample.invalidate();
+    m_velocity = 0;
+}
+
+void RenderAheadPredictor::addPosition(int position)
+{
+    if (m_lastSample.isValid()) {
+        if (m_lastSample.elapsed() > maxSampleGapMsecs) {
+            m_velocity = 0;
+        } else {
+            const qint64 msecs = qMax<qint64>(m_lastSample.elapsed(), 1);
+            const double velocity = (position - m_lastPosition) * 1000.0 / msecs;
+            // smooth out the steps of wheel scrolling
+            m_velocity = (m_velocity + velocity) / 2;
+        }
+
+        if (position != m_lastPosition) {
+            setDirection(position > m_lastPosition ? 1 : -1);
+        }
+    }
+
+    m_lastPosition = position;
+    m_lastSample.start();
+}
+
+void RenderAheadPredictor::addPageChange(int fromPage, int toPage)
+{
+    if (fromPage != toPage) {
+        setDirection(toPage > fromPage ? 1 : -1);
+    }
+
+    // the view is going to jump, don't take that as scrolling
+    m_lastSample.invalidate();
+    m_velocity = 0;
+}
+
+void RenderAheadPredictor::setDirection(int direction)
+{
+    if (m_direction != 0 && m_direction != direction) {
+        ++m_statistics.directionChanges;
+        m_velocity = 0;
+    }
+    m_direction = direction;
+}
+
+int RenderAheadPredictor::direction() const
+{
+    return m_direction;
+}
+
+double RenderAheadPredictor::speed() const
+{
+    if (!m_lastSample.isValid() || m_lastSample.elapsed() > idleMsecs) {
+        return 0;
+    }
+    return std::abs(m_velocity);
+}
+
+int RenderAheadPredictor::pixelsAhead(int viewportHeight) const
+{
+    const double ahead = basePreloadPixels + speed() * lookAheadSeconds;
+    return qMin<double>(ahead, qMax(basePreloadPixels, maxViewportsAhead * viewportHeight));
+}
+
+int RenderAheadPredictor::pixelsBehind() const
+{
+    // keep a little behind so that small corrections do not need new renders
+    return m_direction == 0 ? basePreloadPixels : basePreloadPixels / 4;
+}
+
+void RenderAheadPredictor::pageShown(bool ready)
+{
+    if (ready) {
+        ++m_statistics.hits;
+    } else {
+        ++m_statistics.misses;
+    }
+}
+
+RenderAheadPredictor::Statistics RenderAheadPredictor::statistics() const
+{
+    return m_statistics;
+}
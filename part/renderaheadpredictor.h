@@ -0,0 +1,86 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _OKULAR_RENDERAHEADPREDICTOR_H_
+#define _OKULAR_RENDERAHEADPREDICTOR_H_
+
+#include <QElapsedTimer>
+
+/**
+ * Guesses where the user is going to from the recent movements of the
+ * page view, so that pages are rendered before they scroll into view.
+ *
+ * Scrolling is sampled as the vertical position of the viewport; jumps
+ * coming from the document viewport (e.g. changing page in single page
+ * mode) only give the direction.
+ */
+class RenderAheadPredictor
+{
+public:
+    struct Statistics {
+        // pages that scrolled into view with their pixmap ready or not
+        int hits = 0;
+        int misses = 0;
+        // times the reading direction was reversed, dropping what was queued ahead
+        int directionChanges = 0;
+    };
+
+    RenderAheadPredictor();
+
+    /**
+     * Forgets the scrolling samples, e.g. because the layout changed.
+     * The reading direction and the statistics are kept.
+     */
+    void reset();
+
+    /**
+     * The viewport top moved to @p position, in content coordinates.
+     */
+    void addPosition(int position);
+
+    /**
+     * The document viewport was moved from @p fromPage to @p toPage.
+     */
+    void addPageChange(int fromPage, int toPage);
+
+    /**
+     * 1 when moving forward in the document, -1 when moving backwards, 0 if not known.
+     */
+    int direction() const;
+
+    /**
+     * Recent speed in pixels per second, 0 when the view stopped moving.
+     */
+    double speed() const;
+
+    /**
+     * How many pixels past the viewport should be ready in the reading direction.
+     */
+    int pixelsAhead(int viewportHeight) const;
+
+    /**
+     * How many pixels before the viewport should be ready, against the reading direction.
+     */
+    int pixelsBehind() const;
+
+    /**
+     * Records whether a page that just became visible had its pixmap ready.
+     */
+    void pageShown(bool ready);
+
+    Statistics statistics() const;
+
+private:
+    void setDirection(int direction);
+
+    QElapsedTimer m_lastSample;
+    int m_lastPosition;
+    double m_velocity; // pixels per second, smoothed
+    int m_direction;
+    Statistics m_statistics;
+};
+
+#endif
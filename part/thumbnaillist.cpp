@@ -9,6 +9,7 @@
 // qt/kde includes
 #include <QAction>
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QIcon>
 #include <QPainter>
 #include <QResizeEvent>
@@ -33,8 +34,13 @@
 #include "gui/priorities.h"
 #include "settings.h"
 
+#include <algorithm>
+
 class ThumbnailWidget;
 
+// how long after the last movement of the main view thumbnails are requested again
+#define MAIN_VIEW_SETTLE_DELAY 300
+
 ThumbnailsBox::ThumbnailsBox(QWidget *parent)
     : QWidget(parent)
 {
@@ -70,6 +76,8 @@ public:
     QList<ThumbnailWidget *> m_thumbnails;
     QList<ThumbnailWidget *> m_visibleThumbnails;
     int m_vectorIndex;
+    // last time the visible area of the main view changed
+    QElapsedTimer m_mainViewMoved;
     // Grabbing variables
     QPoint m_mouseGrabPos;
     ThumbnailWidget *m_mouseGrabItem;
@@ -278,6 +286,12 @@ ThumbnailList::~ThumbnailList()
 // BEGIN DocumentObserver inherited methods
 void ThumbnailList::notifySetup(const QList<Okular::Page *> &pages, int setupFlags)
 {
+    // pages appended to a document that is still loading, keep the thumbnails of the others
+    if ((setupFlags & Okular::DocumentObserver::PagesAppended) && !(setupFlags & Okular::DocumentObserver::DocumentChanged) && !d->m_thumbnails.isEmpty()) {
+        appendThumbnails(pages);
+        return;
+    }
+
     // if there was a widget selected, save its pagenumber to restore
     // its selection (if available in the new set of pages)
     int prevPage = -1;
@@ -352,6 +366,33 @@ void ThumbnailList::notifySetup(const QList<Okular::Page *> &pages, int setupFla
     d->delayedRequestVisiblePixmaps(200);
 }
 
+void ThumbnailList::appendThumbnails(const QList<Okular::Page *> &pages)
+{
+    // as in notifySetup(), all the pages are shown unless some have search results
+    const bool skipCheck = std::none_of(pages.cbegin(), pages.cend(), [](const Okular::Page *page) { return page->hasHighlights(SW_SEARCH_ID); });
+
+    const int width = viewport()->width();
+    const int spacing = this->style()->layoutSpacing(QSizePolicy::Frame, QSizePolicy::Frame, Qt::Vertical);
+    int height = widget()->height() + spacing;
+    for (int i = d->m_thumbnails.last()->pageNumber() + 1; i < pages.count(); ++i) {
+        const Okular::Page *page = pages[i];
+        if (skipCheck || page->hasHighlights(SW_SEARCH_ID)) {
+            ThumbnailWidget *t = new ThumbnailWidget(d, page);
+            t->move(0, height);
+            d->m_thumbnails.push_back(t);
+            t->resizeFitWidth(width);
+            height += t->height() + spacing;
+        }
+    }
+
+    height -= spacing;
+    widget()->resize(width, height);
+    verticalScrollBar()->setEnabled(viewport()->height() < height);
+
+    // the new thumbnails may be visible already
+    d->delayedRequestVisiblePixmaps(200);
+}
+
 void ThumbnailList::notifyCurrentPageChanged(int previousPage, int currentPage)
 {
     Q_UNUSED(previousPage)
@@ -417,6 +458,8 @@ void ThumbnailList::notifyContentsCleared(int changedFlags)
 
 void ThumbnailList::notifyVisibleRectsChanged()
 {
+    d->m_mainViewMoved.start();
+
     const QList<Okular::VisiblePageRect *> &visibleRects = d->m_document->visiblePageRects();
     QList<ThumbnailWidget *>::const_iterator tIt = d->m_thumbnails.constBegin(), tEnd = d->m_thumbnails.constEnd();
     QList<Okular::VisiblePageRect *>::const_iterator vEnd = visibleRects.end();
@@ -655,6 +698,10 @@ void ThumbnailListPrivate::slotRequestVisiblePixmaps()
         return;
     }
 
+    // while the main view is being scrolled leave the generator to it and
+    // come back once it settles
+    const bool mainViewScrolling = m_mainViewMoved.isValid() && !m_mainViewMoved.hasExpired(MAIN_VIEW_SETTLE_DELAY);
+
     // scroll from the top to the last visible thumbnail
     m_visibleThumbnails.clear();
     QList<Okular::PixmapRequest *> requestedPixmaps;
@@ -669,13 +716,26 @@ void ThumbnailListPrivate::slotRequestVisiblePixmaps()
         // add ThumbnailWidget to visible list
         m_visibleThumbnails.push_back(t);
         // if pixmap not present add it to requests
-        if (!t->page()->hasPixmap(q, t->pixmapWidth(), t->pixmapHeight())) {
-            Okular::PixmapRequest *p = new Okular::PixmapRequest(q, t->pageNumber(), t->pixmapWidth(), t->pixmapHeight(), devicePixelRatioF(), THUMBNAILS_PRIO, Okular::PixmapRequest::Asynchronous);
+        if (!mainViewScrolling && !t->page()->hasPixmap(q, t->pixmapWidth(), t->pixmapHeight())) {
+            // thumbnails come after everything the main view needs, including its preloading,
+            // and are taken from the main view pixmaps when those are already there
+            Okular::PixmapRequest *p = new Okular::PixmapRequest(q,
+                                                                 t->pageNumber(),
+                                                                 t->pixmapWidth(),
+                                                                 t->pixmapHeight(),
+                                                                 devicePixelRatioF(),
+                                                                 THUMBNAILS_PRELOAD_PRIO,
+                                                                 Okular::PixmapRequest::Asynchronous | Okular::PixmapRequest::AllowDownscale);
             requestedPixmaps.push_back(p);
         }
     }
 
-    // actually request pixmaps
+    if (mainViewScrolling) {
+        delayedRequestVisiblePixmaps(MAIN_VIEW_SETTLE_DELAY);
+        return;
+    }
+
+    // actually request pixmaps, all the visible ones in a single batch
     if (!requestedPixmaps.isEmpty()) {
         m_document->requestPixmaps(requestedPixmaps);
     }
@@ -65,6 +65,8 @@ Q_SIGNALS:
     void rightClick(const Okular::Page *, const QPoint);
 
 private:
+    void appendThumbnails(const QList<Okular::Page *> &pages);
+
     friend class ThumbnailListPrivate;
     ThumbnailListPrivate *d;
 };
@@ -63,9 +63,12 @@ TOC::~TOC()
     m_document->removeObserver(this);
 }
 
-void TOC::notifySetup(const QList<Okular::Page *> & /*pages*/, int setupFlags)
+void TOC::notifySetup(const QList<Okular::Page *> &pages, int setupFlags)
 {
-    if (!(setupFlags & Okular::DocumentObserver::DocumentChanged)) {
+    Q_UNUSED(pages)
+
+    // pages appended while loading the document may come with more titles
+    if (!(setupFlags & (Okular::DocumentObserver::DocumentChanged | Okular::DocumentObserver::PagesAppended))) {
         return;
     }
 
@@ -196,6 +199,9 @@ void TOC::expandRecursively()
     while (!worklist.isEmpty()) {
         QModelIndex index = worklist.takeLast();
         m_treeView->expand(index);
+        while (m_model->canFetchMore(index)) {
+            m_model->fetchMore(index);
+        }
         for (int i = 0; i < m_model->rowCount(index); i++) {
             worklist += m_model->index(i, 0, index);
         }
@@ -219,6 +225,20 @@ void TOC::collapseRecursively()
 
 void TOC::expandAll()
 {
+    // the model creates its items as they are needed, make sure all of them exist
+    QList<QModelIndex> worklist = {QModelIndex()};
+    while (!worklist.isEmpty()) {
+        const QModelIndex index = worklist.takeLast();
+        while (m_model->canFetchMore(index)) {
+            m_model->fetchMore(index);
+        }
+        for (int i = 0; i < m_model->rowCount(index); i++) {
+            const QModelIndex child = m_model->index(i, 0, index);
+            if (m_model->hasChildren(child)) {
+                worklist += child;
+            }
+        }
+    }
     m_treeView->expandAll();
 }
 
@@ -466,6 +466,8 @@ void Shell::openUrl(const QUrl &url, const QString &serializedOptions)
     if (!activePart->url().isEmpty()) {
         if (m_unique) {
             applyOptionsToPart(activePart, serializedOptions);
+            // the tab is kept whatever happens to the new url
+            m_tabs[activeTab].openingUrl.clear();
             activePart->openUrl(url);
         } else {
             if (qobject_cast<Okular::ViewerInterface *>(activePart)->openNewFilesInTabs()) {
@@ -481,6 +483,8 @@ void Shell::openUrl(const QUrl &url, const QString &serializedOptions)
         m_tabWidget->setTabToolTip(activeTab, url.fileName());
 
         applyOptionsToPart(activePart, serializedOptions);
+        m_tabs[activeTab].openingUrl = url;
+        m_tabs[activeTab].previousActivePart = nullptr;
         bool openOk = activePart->openUrl(url);
         const bool isstdin = url.fileName() == QLatin1String("-") || url.scheme() == QLatin1String("fd");
         if (!isstdin) {
@@ -488,6 +492,7 @@ void Shell::openUrl(const QUrl &url, const QString &serializedOptions)
                 m_recent->addUrl(url);
             } else {
                 m_recent->removeUrl(url);
+                m_tabs[activeTab].openingUrl.clear();
                 closeTab(activeTab);
             }
         }
@@ -888,6 +893,11 @@ void Shell::setActiveTab(int tab)
 
     m_tabWidget->setCurrentIndex(tab);
 
+    // the documents of the other tabs give back their memory to this one
+    for (int i = 0; i < m_tabs.size(); ++i) {
+        QMetaObject::invokeMethod(m_tabs[i].part, "setInBackground", Q_ARG(bool, i != tab));
+    }
+
     // NOTE : createGUI(...) breaks the visibility of the sidebar, so we need
     // to save and restore it
     const bool isSidebarVisible = m_sidebar->isVisible();
@@ -993,6 +1003,8 @@ void Shell::openNewTab(const QUrl &url, const QString &serializedOptions)
 
     setActiveTab(m_tabs.size() - 1);
 
+    m_tabs[newIndex].openingUrl = url;
+    m_tabs[newIndex].previousActivePart = activePart;
     if (part->openUrl(url)) {
         m_recent->addUrl(url);
     } else {
@@ -1028,6 +1040,7 @@ void Shell::connectPart(const KParts::ReadWritePart *part)
     connect(part, SIGNAL(enableCloseAction(bool)), this, SLOT(setCloseEnabled(bool)));            // clazy:exclude=old-style-connect
     connect(part, SIGNAL(mimeTypeChanged(QMimeType)), this, SLOT(setTabIcon(QMimeType)));         // clazy:exclude=old-style-connect
     connect(part, SIGNAL(urlsDropped(QList<QUrl>)), this, SLOT(handleDroppedUrls(QList<QUrl>)));  // clazy:exclude=old-style-connect
+    connect(part, SIGNAL(openUrlFailed(QUrl)), this, SLOT(handleOpenUrlFailed()));                // clazy:exclude=old-style-connect
     connect(part, SIGNAL(maxRecentItemsChanged(int)), this, SLOT(triggerUpdateRecentItems(int))); // clazy:exclude=old-style-connect
 
     // clang-format off
@@ -1058,6 +1071,11 @@ void Shell::setCloseEnabled(bool enabled)
     int i = findTabIndex(sender());
     if (i != -1) {
         m_tabs[i].closeEnabled = enabled;
+        // the part only enables closing once it opened a document
+        if (enabled) {
+            m_tabs[i].openingUrl.clear();
+            m_tabs[i].previousActivePart = nullptr;
+        }
         if (i == m_tabWidget->currentIndex()) {
             m_closeAction->setEnabled(enabled);
         }
@@ -1134,6 +1152,31 @@ void Shell::handleDroppedUrls(const QList<QUrl> &urls)
     }
 }
 
+void Shell::handleOpenUrlFailed()
+{
+    // the part opened the document asynchronously, so openUrl() succeeded before;
+    // only the tabs made for the url go away, as when openUrl() fails
+    const int tab = findTabIndex(sender());
+    if (tab == -1 || m_tabs[tab].openingUrl.isEmpty()) {
+        return;
+    }
+    const QUrl url = m_tabs[tab].openingUrl;
+    const int previousActiveTab = findTabIndex(m_tabs[tab].previousActivePart.data());
+    m_tabs[tab].openingUrl.clear();
+    m_tabs[tab].previousActivePart = nullptr;
+
+    const bool isstdin = url.fileName() == QLatin1String("-") || url.scheme() == QLatin1String("fd");
+    if (isstdin) {
+        return;
+    }
+
+    m_recent->removeUrl(url);
+    if (previousActiveTab != -1 && previousActiveTab != tab) {
+        setActiveTab(previousActiveTab);
+    }
+    closeTab(tab);
+}
+
 void Shell::moveTabData(int from, int to)
 {
     m_tabs.move(from, to);
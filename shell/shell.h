@@ -17,6 +17,7 @@
 #include <QList>
 #include <QMimeDatabase>
 #include <QMimeType>
+#include <QPointer>
 #include <kparts/mainwindow.h>
 #include <kparts/readwritepart.h>
 
@@ -116,6 +117,7 @@ private Q_SLOTS:
     void setCloseEnabled(bool enabled);
     void setTabIcon(const QMimeType &mimeType);
     void handleDroppedUrls(const QList<QUrl> &urls);
+    void handleOpenUrlFailed();
     void triggerUpdateRecentItems(const int maxItems);
 
     /**
@@ -191,6 +193,10 @@ private:
         KParts::ReadWritePart *part;
         bool printEnabled;
         bool closeEnabled;
+        // While the part opens a url for a new tab: the url, and the tab to go
+        // back to when the opening fails, see handleOpenUrlFailed()
+        QUrl openingUrl;
+        QPointer<KParts::ReadWritePart> previousActivePart;
     };
     QList<TabState> m_tabs;
     QList<QUrl> m_closedTabUrls;
@@ -0,0 +1,411 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Renders pages of documents to image files, without any user interface
+
+#include <KLocalizedString>
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QMimeDatabase>
+#include <QMutex>
+#include <QPixmap>
+#include <QQueue>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <QWaitCondition>
+
+#include <climits>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "core/document.h"
+#include "core/generator.h"
+#include "core/observer.h"
+#include "core/page.h"
+#include "core/utils.h"
+#include "settings_core.h"
+
+struct RenderOptions {
+    QString outputDir;
+    QString format;
+    QString password;
+    QString pages; // e.g. "1-3,7,10-", empty for all the pages
+    double dpi = 0;
+    int width = 0; // bounding box of the images, used instead of the dpi when set
+    int height = 0;
+};
+
+/**
+ * Encodes and saves the rendered pages with a few threads, so that the
+ * generators don't wait for the PNG compression.
+ */
+class ImageWriterPool
+{
+public:
+    explicit ImageWriterPool(int threadCount)
+        : m_busy(0)
+        , m_quit(false)
+        , m_failures(0)
+    {
+        for (int i = 0; i < threadCount; ++i) {
+            m_threads.emplace_back(QThread::create([this] { run(); }));
+            m_threads.back()->start();
+        }
+    }
+
+    ~ImageWriterPool()
+    {
+        m_mutex.lock();
+        m_quit = true;
+        m_wakeUp.wakeAll();
+        m_mutex.unlock();
+
+        for (const std::unique_ptr<QThread> &thread : m_threads) {
+            thread->wait();
+        }
+    }
+
+    void write(const QImage &image, const QString &fileName, const QByteArray &format)
+    {
+        QMutexLocker locker(&m_mutex);
+        // don't pile up images faster than they can be written
+        while (m_queue.count() >= 2 * int(m_threads.size())) {
+            m_idle.wait(&m_mutex);
+        }
+        m_queue.enqueue({image, fileName, format});
+        m_wakeUp.wakeOne();
+    }
+
+    /**
+     * Waits until all the images are written, returns how many could not be written.
+     */
+    int finish()
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_queue.isEmpty() || m_busy > 0) {
+            m_idle.wait(&m_mutex);
+        }
+        return m_failures;
+    }
+
+private:
+    struct Job {
+        QImage image;
+        QString fileName;
+        QByteArray format;
+    };
+
+    void run()
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_quit) {
+            if (m_queue.isEmpty()) {
+                m_wakeUp.wait(&m_mutex);
+                continue;
+            }
+
+            const Job job = m_queue.dequeue();
+            ++m_busy;
+            m_idle.wakeAll();
+            locker.unlock();
+
+            QImageWriter writer(job.fileName, job.format);
+            const bool written = writer.write(job.image);
+            if (!written) {
+                QTextStream(stderr) << i18n("Could not write %1: %2", job.fileName, writer.errorString()) << Qt::endl;
+            }
+
+            locker.relock();
+            --m_busy;
+            if (!written) {
+                ++m_failures;
+            }
+            m_idle.wakeAll();
+        }
+    }
+
+    std::vector<std::unique_ptr<QThread>> m_threads;
+    QMutex m_mutex;
+    QWaitCondition m_wakeUp;
+    QWaitCondition m_idle;
+    QQueue<Job> m_queue;
+    int m_busy;
+    bool m_quit;
+    int m_failures;
+};
+
+/**
+ * Opens a document and renders its pages one after the other. The
+ * generators render in a thread of their own, so several documents
+ * are rendered in parallel by running several DocumentRenderer.
+ */
+class DocumentRenderer : public QObject, public Okular::DocumentObserver
+{
+    Q_OBJECT
+
+public:
+    DocumentRenderer(const QString &file, const RenderOptions &options, ImageWriterPool *writers)
+        : m_file(file)
+        , m_options(options)
+        , m_writers(writers)
+        , m_document(nullptr)
+        , m_current(-1)
+        , m_failed(false)
+    {
+        m_document.addObserver(this);
+    }
+
+    ~DocumentRenderer() override
+    {
+        m_document.closeDocument();
+        m_document.removeObserver(this);
+    }
+
+    void start()
+    {
+        const QFileInfo info(m_file);
+        QElapsedTimer timer;
+        timer.start();
+
+        const QUrl url = QUrl::fromLocalFile(info.absoluteFilePath());
+        if (m_document.openDocument(info.absoluteFilePath(), url, QMimeDatabase().mimeTypeForFile(info), m_options.password) != Okular::Document::OpenSuccess) {
+            QTextStream(stderr) << i18n("Could not open %1", m_file) << Qt::endl;
+            finish(true);
+            return;
+        }
+
+        QTextStream(stdout) << i18nc("%1 is a file, %2 a number of pages, %3 a number of milliseconds", "%1: opened, %2 pages, %3 ms", m_file, m_document.pages(), timer.elapsed()) << Qt::endl;
+
+        if (!parsePages(m_options.pages, m_document.pages(), &m_pages)) {
+            QTextStream(stderr) << i18n("Invalid page range %1 for %2", m_options.pages, m_file) << Qt::endl;
+            finish(true);
+            return;
+        }
+
+        m_documentDpi = Okular::Utils::realDpi(nullptr);
+        m_baseName = QDir(m_options.outputDir.isEmpty() ? info.absolutePath() : m_options.outputDir).filePath(info.completeBaseName());
+        m_total.start();
+        renderNextPage();
+    }
+
+    void notifyPageChanged(int page, int flags) override
+    {
+        if (page != m_current || !(flags & Okular::DocumentObserver::Pixmap)) {
+            return;
+        }
+
+        Okular::Page *p = m_document.page(page);
+        const QPixmap *pixmap = p->pixmap(this);
+        if (!pixmap) {
+            // a partial update, wait for the whole page
+            return;
+        }
+
+        const qint64 msecs = m_pageTimer.elapsed();
+        if (pixmap->isNull()) {
+            QTextStream(stderr) << i18n("%1: could not render page %2", m_file, page + 1) << Qt::endl;
+            m_failed = true;
+        } else {
+            const int digits = QString::number(m_document.pages()).size();
+            const QString fileName = QStringLiteral("%1-%2.%3").arg(m_baseName).arg(page + 1, digits, 10, QLatin1Char('0')).arg(m_options.format);
+            QTextStream(stdout) << i18nc("%1 is a file, %2 a page number, %3 x %4 a size in pixels, %5 a number of milliseconds",
+                                         "%1: page %2, %3x%4, %5 ms",
+                                         m_file,
+                                         page + 1,
+                                         pixmap->width(),
+                                         pixmap->height(),
+                                         msecs)
+                                << Qt::endl;
+            m_writers->write(pixmap->toImage(), fileName, m_options.format.toLatin1());
+        }
+
+        // the image has been copied, don't keep the pixmap around
+        p->deletePixmap(this);
+        m_current = -1;
+
+        // not from here, the generators that don't render in a thread of their own call us from requestPixmaps()
+        QTimer::singleShot(0, this, &DocumentRenderer::renderNextPage);
+    }
+
+    bool canUnloadPixmap(int page) const override
+    {
+        return page != m_current;
+    }
+
+Q_SIGNALS:
+    void finished(bool failed);
+
+private:
+    static bool parsePages(const QString &ranges, int pageCount, QList<int> *pages)
+    {
+        if (ranges.isEmpty()) {
+            for (int i = 0; i < pageCount; ++i) {
+                pages->append(i);
+            }
+            return true;
+        }
+
+        const QStringList parts = ranges.split(QLatin1Char(','), Qt::SkipEmptyParts);
+        for (const QString &part : parts) {
+            const int dash = part.indexOf(QLatin1Char('-'));
+            bool okFirst = true, okLast = true;
+            const int first = dash == 0 ? 1 : part.left(dash).toInt(&okFirst);
+            const int last = dash == -1 ? first : (dash == part.size() - 1 ? pageCount : part.mid(dash + 1).toInt(&okLast));
+            if (!okFirst || !okLast || first < 1 || last < first) {
+                return false;
+            }
+            for (int i = first; i <= qMin(last, pageCount); ++i) {
+                pages->append(i - 1);
+            }
+        }
+        return true;
+    }
+
+    QSize pixmapSize(const Okular::Page *page) const
+    {
+        if (m_options.width > 0 || m_options.height > 0) {
+            QSizeF size(page->width(), page->height());
+            size.scale(m_options.width > 0 ? m_options.width : INT_MAX, m_options.height > 0 ? m_options.height : INT_MAX, Qt::KeepAspectRatio);
+            return QSize(qMax(1, qRound(size.width())), qMax(1, qRound(size.height())));
+        }
+
+        // the size of the pages is given in pixels at the dpi the document was opened with
+        return QSize(qMax(1, qRound(page->width() * m_options.dpi / m_documentDpi.width())), qMax(1, qRound(page->height() * m_options.dpi / m_documentDpi.height())));
+    }
+
+    void renderNextPage()
+    {
+        if (m_pages.isEmpty()) {
+            QTextStream(stdout) << i18nc("%1 is a file, %2 a number of milliseconds", "%1: done in %2 ms", m_file, m_total.elapsed()) << Qt::endl;
+            finish(m_failed);
+            return;
+        }
+
+        m_current = m_pages.takeFirst();
+        const QSize size = pixmapSize(m_document.page(m_current));
+        m_pageTimer.start();
+        m_document.requestPixmaps({new Okular::PixmapRequest(this, m_current, size.width(), size.height(), 1, 1, Okular::PixmapRequest::Asynchronous)});
+    }
+
+    void finish(bool failed)
+    {
+        // don't destroy the document from one of its notifications
+        QTimer::singleShot(0, this, [this, failed] { Q_EMIT finished(failed); });
+    }
+
+    const QString m_file;
+    const RenderOptions m_options;
+    ImageWriterPool *m_writers;
+    Okular::Document m_document;
+    QSizeF m_documentDpi;
+    QString m_baseName;
+    QList<int> m_pages; // left to render
+    int m_current; // being rendered, -1 if none
+    bool m_failed;
+    QElapsedTimer m_pageTimer;
+    QElapsedTimer m_total;
+};
+
+int main(int argc, char **argv)
+{
+    // Nothing is ever shown, don't require a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("okular-render"));
+    KLocalizedString::setApplicationDomain("okular");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(i18n("Renders pages of documents to image files"));
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("d") << QStringLiteral("output-dir"), i18n("Directory to write the images to, next to the documents if not given"), QStringLiteral("directory")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("p") << QStringLiteral("pages"), i18n("Pages to render, e.g. 1-3,7,10- (all the pages if not given)"), QStringLiteral("ranges")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("r") << QStringLiteral("dpi"), i18n("Resolution of the images (150 if not given)"), QStringLiteral("dpi"), QStringLiteral("150")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("W") << QStringLiteral("width"), i18n("Largest width of the images, instead of a resolution"), QStringLiteral("pixels")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("H") << QStringLiteral("height"), i18n("Largest height of the images, instead of a resolution"), QStringLiteral("pixels")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("f") << QStringLiteral("format"), i18n("Image format, e.g. png or webp (png if not given)"), QStringLiteral("format"), QStringLiteral("png")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("j") << QStringLiteral("jobs"), i18n("Number of documents rendered at the same time"), QStringLiteral("count")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("password"), i18n("Password of the documents"), QStringLiteral("password")));
+    parser.addPositionalArgument(QStringLiteral("files"), i18n("Documents to render"));
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    RenderOptions options;
+    options.outputDir = parser.value(QStringLiteral("output-dir"));
+    options.pages = parser.value(QStringLiteral("pages"));
+    options.password = parser.value(QStringLiteral("password"));
+    options.format = parser.value(QStringLiteral("format")).toLower();
+    options.dpi = parser.value(QStringLiteral("dpi")).toDouble();
+    options.width = parser.value(QStringLiteral("width")).toInt();
+    options.height = parser.value(QStringLiteral("height")).toInt();
+    const int jobs = parser.isSet(QStringLiteral("jobs")) ? parser.value(QStringLiteral("jobs")).toInt() : QThread::idealThreadCount();
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty() || options.dpi <= 0 || options.width < 0 || options.height < 0 || jobs < 1) {
+        parser.showHelp(1);
+    }
+
+    if (!QImageWriter::supportedImageFormats().contains(options.format.toLatin1())) {
+        err << i18n("Unsupported image format %1", options.format) << Qt::endl;
+        return 1;
+    }
+
+    if (!options.outputDir.isEmpty() && !QDir().mkpath(options.outputDir)) {
+        err << i18n("Could not create the directory %1", options.outputDir) << Qt::endl;
+        return 1;
+    }
+
+    Okular::SettingsCore::instance(QStringLiteral("okular-render"));
+    // Big renders are dropped to save memory otherwise, and each page is freed as soon as it is written anyway
+    Okular::SettingsCore::setMemoryLevel(Okular::SettingsCore::EnumMemoryLevel::Greedy);
+
+    ImageWriterPool writers(qMax(1, QThread::idealThreadCount()));
+    QStringList queue = files;
+    int running = 0;
+    int failures = 0;
+
+    std::function<void()> startNext = [&] {
+        while (running < jobs && !queue.isEmpty()) {
+            DocumentRenderer *renderer = new DocumentRenderer(queue.takeFirst(), options, &writers);
+            ++running;
+            QObject::connect(renderer, &DocumentRenderer::finished, &app, [&, renderer](bool failed) {
+                if (failed) {
+                    ++failures;
+                }
+                delete renderer;
+                --running;
+                startNext();
+                if (running == 0) {
+                    app.quit();
+                }
+            });
+            renderer->start();
+        }
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    QTimer::singleShot(0, &app, startNext);
+    app.exec();
+
+    failures += writers.finish();
+    QTextStream(stdout) << i18nc("%1 is a number of documents, %2 a number of milliseconds", "%1 documents in %2 ms", files.count(), timer.elapsed()) << Qt::endl;
+
+    return failures ? 1 : 0;
+}
+
+#include "render.moc"
@@ -0,0 +1,99 @@
+/*
+    SPDX-FileCopyrightText: 2026 The Okular authors
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Writes the text of documents to plain text files, without any user interface
+
+#include <KLocalizedString>
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMimeDatabase>
+#include <QTextStream>
+#include <QUrl>
+
+#include "core/document.h"
+#include "settings_core.h"
+
+int main(int argc, char **argv)
+{
+    // Nothing is ever shown, don't require a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("okular-totext"));
+    KLocalizedString::setApplicationDomain("okular");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(i18n("Exports the text of documents to plain text files"));
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("o") << QStringLiteral("output"), i18n("File to write the text to, only when exporting a single document"), QStringLiteral("file")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("d") << QStringLiteral("output-dir"), i18n("Directory to write the text files to, next to the documents if not given"), QStringLiteral("directory")));
+    parser.addOption(QCommandLineOption(QStringList() << QStringLiteral("password"), i18n("Password of the documents"), QStringLiteral("password")));
+    parser.addPositionalArgument(QStringLiteral("files"), i18n("Documents to export"));
+    parser.process(app);
+
+    const QStringList files = parser.positionalArguments();
+    if (files.isEmpty() || (parser.isSet(QStringLiteral("output")) && files.count() > 1)) {
+        parser.showHelp(1);
+    }
+
+    const QString outputDir = parser.value(QStringLiteral("output-dir"));
+    if (!outputDir.isEmpty() && !QDir().mkpath(outputDir)) {
+        QTextStream(stderr) << i18n("Could not create the directory %1", outputDir) << Qt::endl;
+        return 1;
+    }
+
+    Okular::SettingsCore::instance(QStringLiteral("okular-totext"));
+    Okular::Document document(nullptr);
+    QMimeDatabase db;
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    int failures = 0;
+
+    for (const QString &file : files) {
+        const QFileInfo info(file);
+        QString outputFile = parser.value(QStringLiteral("output"));
+        if (outputFile.isEmpty()) {
+            const QDir dir = outputDir.isEmpty() ? info.absoluteDir() : QDir(outputDir);
+            outputFile = dir.filePath(info.completeBaseName() + QStringLiteral(".txt"));
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        const QUrl url = QUrl::fromLocalFile(info.absoluteFilePath());
+        if (document.openDocument(info.absoluteFilePath(), url, db.mimeTypeForFile(info), parser.value(QStringLiteral("password"))) != Okular::Document::OpenSuccess) {
+            err << i18n("Could not open %1", file) << Qt::endl;
+            ++failures;
+            continue;
+        }
+
+        if (!document.canExportToText()) {
+            err << i18n("%1 has no text to export", file) << Qt::endl;
+            ++failures;
+        } else if (!document.exportToText(outputFile)) {
+            err << i18n("Could not write the text of %1 to %2", file, outputFile) << Qt::endl;
+            ++failures;
+        } else {
+            out << i18nc("%1 is a file, %2 another file, %3 a number of pages, %4 a number of milliseconds",
+                         "%1 -> %2 (%3 pages, %4 ms)",
+                         file,
+                         outputFile,
+                         document.pages(),
+                         timer.elapsed())
+                << Qt::endl;
+        }
+
+        document.closeDocument();
+    }
+
+    return failures ? 1 : 0;
+}